@@ -7,9 +7,19 @@ CURRENT_REQUEST_VERSION = 1
 MAX_REQUEST_DATA_SIZE = 32
 MAX_PACKET_SIZE = 48
 
+# Version 2 adds bulk reads, watch lists and larger datagrams
+BULK_REQUEST_VERSION = 2
+MAX_DATAGRAM_DATA_SIZE = 0x8000
+MAX_DATAGRAM_SIZE = 16 + MAX_DATAGRAM_DATA_SIZE
+# Watch lists are dropped by the server unless renewed within this many seconds
+WATCH_TIMEOUT = 30
+
 class RequestType(enum.IntEnum):
     ReadMemory = 1,
-    WriteMemory = 2
+    WriteMemory = 2,
+    ReadMemoryBulk = 3,
+    WatchMemory = 4,
+    WatchUpdate = 5
 
 CITRA_PORT = 45987
 
@@ -17,17 +27,19 @@ class Citra:
     def __init__(self, address="127.0.0.1", port=CITRA_PORT):
         self.socket = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
         self.address = address
+        self.watched_ranges = {}
 
     def is_connected(self):
         return self.socket is not None
 
-    def _generate_header(self, request_type, data_size):
+    def _generate_header(self, request_type, data_size, version=CURRENT_REQUEST_VERSION):
         request_id = random.getrandbits(32)
-        return (struct.pack("IIII", CURRENT_REQUEST_VERSION, request_id, request_type, data_size), request_id)
+        return (struct.pack("IIII", version, request_id, request_type, data_size), request_id)
 
-    def _read_and_validate_header(self, raw_reply, expected_id, expected_type):
+    def _read_and_validate_header(self, raw_reply, expected_id, expected_type,
+                                  version=CURRENT_REQUEST_VERSION):
         reply_version, reply_id, reply_type, reply_data_size = struct.unpack("IIII", raw_reply[:4*4])
-        if (CURRENT_REQUEST_VERSION == reply_version and
+        if (version == reply_version and
             expected_id == reply_id and
             expected_type == reply_type and
             reply_data_size == len(raw_reply[4*4:])):
@@ -90,6 +102,89 @@ class Citra:
                 return False
         return True
 
+    def read_memory_bulk(self, ranges):
+        """
+        Reads several (address, size) ranges in a single round-trip.
+        Their total size must fit in MAX_DATAGRAM_DATA_SIZE.
+
+        >>> c.read_memory_bulk([(0x100000, 4), (0x100000, 2)])
+        [b'\\x07\\x00\\x00\\xeb', b'\\x07\\x00']
+        """
+        request_data = b"".join(struct.pack("II", address, size) for address, size in ranges)
+        request, request_id = self._generate_header(RequestType.ReadMemoryBulk, len(request_data),
+                                                    BULK_REQUEST_VERSION)
+        self.socket.sendto(request + request_data, (self.address, CITRA_PORT))
+
+        raw_reply = self.socket.recv(MAX_DATAGRAM_SIZE)
+        reply_data = self._read_and_validate_header(raw_reply, request_id,
+                                                    RequestType.ReadMemoryBulk,
+                                                    BULK_REQUEST_VERSION)
+        if not reply_data:
+            return None
+        result = []
+        for _, size in ranges:
+            result.append(reply_data[:size])
+            reply_data = reply_data[size:]
+        return result
+
+    def watch_memory(self, ranges):
+        """
+        Subscribes to changes of several (address, size) ranges. Once per emulated frame in which
+        some changed, the server sends an update, read with read_watch_update. Returns the ID of
+        the watch list, or None on failure. The server drops the watch list unless it is renewed
+        with renew_watch within WATCH_TIMEOUT seconds.
+        """
+        request_data = b"".join(struct.pack("II", address, size) for address, size in ranges)
+        request, request_id = self._generate_header(RequestType.WatchMemory, len(request_data),
+                                                    BULK_REQUEST_VERSION)
+        self.socket.sendto(request + request_data, (self.address, CITRA_PORT))
+
+        raw_reply = self.socket.recv(MAX_DATAGRAM_SIZE)
+        reply_data = self._read_and_validate_header(raw_reply, request_id,
+                                                    RequestType.WatchMemory,
+                                                    BULK_REQUEST_VERSION)
+        if not reply_data:
+            return None
+        self.watched_ranges[request_id] = ranges
+        return request_id
+
+    def renew_watch(self, watch_id):
+        """
+        Keeps a watch list set up by watch_memory alive. Its acknowledgement is skipped by
+        read_watch_update.
+        """
+        ranges = self.watched_ranges[watch_id]
+        request_data = b"".join(struct.pack("II", address, size) for address, size in ranges)
+        request = struct.pack("IIII", BULK_REQUEST_VERSION, watch_id, RequestType.WatchMemory,
+                              len(request_data))
+        self.socket.sendto(request + request_data, (self.address, CITRA_PORT))
+
+    def unwatch_memory(self, watch_id):
+        request = struct.pack("IIII", BULK_REQUEST_VERSION, watch_id, RequestType.WatchMemory, 0)
+        self.socket.sendto(request, (self.address, CITRA_PORT))
+        self.watched_ranges.pop(watch_id, None)
+
+    def read_watch_update(self):
+        """
+        Waits for the next watch update. Returns the watch list ID, the frame count, and a
+        dictionary of the changed ranges by their index in the watch list.
+        """
+        raw_reply = self.socket.recv(MAX_DATAGRAM_SIZE)
+        version, watch_id, reply_type, size = struct.unpack("IIII", raw_reply[:4*4])
+        if reply_type != RequestType.WatchUpdate or watch_id not in self.watched_ranges:
+            return None
+        ranges = self.watched_ranges[watch_id]
+        reply_data = raw_reply[4*4:]
+        frame, = struct.unpack("I", reply_data[:4])
+        reply_data = reply_data[4:]
+        changes = {}
+        while reply_data:
+            index, = struct.unpack("I", reply_data[:4])
+            range_size = ranges[index][1]
+            changes[index] = reply_data[4:4 + range_size]
+            reply_data = reply_data[4 + range_size:]
+        return watch_id, frame, changes
+
 if "__main__" == __name__:
     import doctest
     doctest.testmod(extraglobs={'c': Citra()})
@@ -2,7 +2,10 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
+#include <cstring>
 #include "audio_core/dsp_interface.h"
 #include "audio_core/sink.h"
 #include "audio_core/sink_details.h"
@@ -17,7 +20,7 @@ DspInterface::DspInterface() = default;
 DspInterface::~DspInterface() = default;
 
 void DspInterface::SetSink(const std::string& sink_id, const std::string& audio_device) {
-    sink = CreateSinkFromID(Settings::values.sink_id, Settings::values.audio_device_id);
+    sink = CreateSinkFromID(sink_id, audio_device);
     sink->SetCallback(
         [this](s16* buffer, std::size_t num_frames) { OutputCallback(buffer, num_frames); });
     time_stretcher.SetOutputSampleRate(sink->GetNativeSampleRate());
@@ -38,11 +41,15 @@ void DspInterface::EnableStretching(bool enable) {
     perform_time_stretching = enable;
 }
 
+const SampleRing& DspInterface::GetSampleRing() const {
+    return sample_ring;
+}
+
 void DspInterface::OutputFrame(StereoFrame16 frame) {
     if (!sink)
         return;
 
-    fifo.Push(frame.data(), frame.size());
+    PushToSink(frame[0].data(), frame.size());
 
     if (Core::System::GetInstance().VideoDumper().IsDumping()) {
         Core::System::GetInstance().VideoDumper().AddAudioFrame(std::move(frame));
@@ -53,28 +60,61 @@ void DspInterface::OutputSample(std::array<s16, 2> sample) {
     if (!sink)
         return;
 
-    fifo.Push(&sample, 1);
+    PushToSink(sample.data(), 1);
 
     if (Core::System::GetInstance().VideoDumper().IsDumping()) {
         Core::System::GetInstance().VideoDumper().AddAudioSample(std::move(sample));
     }
 }
 
-void DspInterface::OutputCallback(s16* buffer, std::size_t num_frames) {
-    std::size_t frames_written;
-    if (perform_time_stretching) {
-        const std::vector<s16> in{fifo.Pop()};
-        const std::size_t num_in{in.size() / 2};
-        frames_written = time_stretcher.Process(in.data(), num_in, buffer, num_frames);
-    } else if (flushing_time_stretcher) {
-        time_stretcher.Flush();
-        frames_written = time_stretcher.Process(nullptr, 0, buffer, num_frames);
-        frames_written += fifo.Pop(buffer, num_frames - frames_written);
-        flushing_time_stretcher = false;
-    } else {
-        frames_written = fifo.Pop(buffer, num_frames);
+void DspInterface::PushToSink(const s16* frames, std::size_t num_frames) {
+    if (flushing_time_stretcher) {
+        FlushResidualStretcherAudio();
+    }
+
+    if (!perform_time_stretching) {
+        sample_ring.Push(frames, num_frames);
+        return;
+    }
+
+    // Stage the input until the sink has asked for more audio. The stretcher picks its ratio
+    // from the number of frames in versus the number of frames the sink consumed meanwhile.
+    stretcher_input.Stage(frames, num_frames, sample_ring);
+
+    const std::size_t requested =
+        std::min(frames_requested.exchange(0), stretcher_output.size() / 2);
+    if (requested == 0) {
+        return;
     }
 
+    const std::size_t frames_out = time_stretcher.Process(
+        stretcher_input.Data(), stretcher_input.Size(), stretcher_output.data(), requested);
+    stretcher_input.Clear();
+    sample_ring.Push(stretcher_output.data(), frames_out);
+}
+
+void DspInterface::FlushResidualStretcherAudio() {
+    time_stretcher.Flush();
+    while (true) {
+        const std::size_t frames_out = time_stretcher.Process(
+            nullptr, 0, stretcher_output.data(), stretcher_output.size() / 2);
+        if (frames_out == 0) {
+            break;
+        }
+        sample_ring.Push(stretcher_output.data(), frames_out);
+    }
+
+    // Anything still staged never reached the stretcher and is passed through as-is.
+    sample_ring.Push(stretcher_input.Data(), stretcher_input.Size());
+    stretcher_input.Clear();
+    flushing_time_stretcher = false;
+}
+
+void DspInterface::OutputCallback(s16* buffer, std::size_t num_frames) {
+    frames_requested.fetch_add(num_frames, std::memory_order_relaxed);
+
+    const std::size_t frames_written = sample_ring.Pop(buffer, num_frames);
+
     if (frames_written > 0) {
         std::memcpy(&last_frame[0], buffer + 2 * (frames_written - 1), 2 * sizeof(s16));
     }
@@ -8,9 +8,9 @@
 #include <vector>
 #include <boost/serialization/access.hpp>
 #include "audio_core/audio_types.h"
+#include "audio_core/sample_ring.h"
 #include "audio_core/time_stretch.h"
 #include "common/common_types.h"
-#include "common/ring_buffer.h"
 #include "core/memory.h"
 
 namespace Service::DSP {
@@ -99,21 +99,32 @@ public:
     Sink& GetSink();
     /// Enable/Disable audio stretching.
     void EnableStretching(bool enable);
+    /// Get the ring feeding the sink, mainly to query its underrun/overrun counters.
+    const SampleRing& GetSampleRing() const;
 
 protected:
     void OutputFrame(StereoFrame16 frame);
     void OutputSample(std::array<s16, 2> sample);
 
 private:
+    /// Runs on the emulation thread: time-stretches (if enabled) and queues frames for the sink.
+    void PushToSink(const s16* frames, std::size_t num_frames);
     void FlushResidualStretcherAudio();
+    /// Runs on the realtime audio thread. Must not allocate or block.
     void OutputCallback(s16* buffer, std::size_t num_frames);
 
     std::unique_ptr<Sink> sink;
     std::atomic<bool> perform_time_stretching = false;
     std::atomic<bool> flushing_time_stretcher = false;
-    Common::RingBuffer<s16, 0x2000, 2> fifo;
+    /// Frames requested by the sink since the producer last ran the time stretcher.
+    std::atomic<std::size_t> frames_requested = 0;
+    SampleRing sample_ring;
     std::array<s16, 2> last_frame{};
+
+    // The following are only touched by the producer (emulation) thread.
     TimeStretcher time_stretcher;
+    StagingBuffer stretcher_input;
+    std::array<s16, 2 * SampleRing::capacity> stretcher_output{};
 
     template <class Archive>
     void serialize(Archive& ar, const unsigned int) {}
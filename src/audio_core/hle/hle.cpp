@@ -442,6 +442,7 @@ bool DspHle::Impl::Tick() {
 }
 
 void DspHle::Impl::AudioTickCallback(s64 cycles_late) {
+    Core::PerfTimer perf_timer{Core::PerfCategory::Audio};
     if (Tick()) {
         // TODO(merry): Signal all the other interrupts as appropriate.
         if (auto service = dsp_dsp.lock()) {
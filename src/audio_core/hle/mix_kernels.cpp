@@ -0,0 +1,218 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstddef>
+#include "audio_core/hle/mix_kernels.h"
+
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
+
+namespace AudioCore::HLE::MixKernels {
+
+static_assert(samples_per_frame % 4 == 0, "Kernels process four samples per iteration");
+
+namespace Reference {
+
+static s16 ClampToS16(s32 value) {
+    return static_cast<s16>(std::clamp(value, -32768, 32767));
+}
+
+static std::array<s16, 2> AddAndClampToS16(const std::array<s16, 2>& a,
+                                           const std::array<s16, 2>& b) {
+    return {ClampToS16(static_cast<s32>(a[0]) + static_cast<s32>(b[0])),
+            ClampToS16(static_cast<s32>(a[1]) + static_cast<s32>(b[1]))};
+}
+
+void DownmixStereoAndMix(StereoFrame16& accumulator, const QuadFrame32& samples, float gain) {
+    std::transform(accumulator.begin(), accumulator.end(), samples.begin(), accumulator.begin(),
+                   [gain](const std::array<s16, 2>& acc,
+                          const std::array<s32, 4>& sample) -> std::array<s16, 2> {
+                       // Downmix to stereo
+                       s16 left = ClampToS16(static_cast<s32>(gain * sample[0] + gain * sample[2]));
+                       s16 right =
+                           ClampToS16(static_cast<s32>(gain * sample[1] + gain * sample[3]));
+                       // Mix into current frame
+                       return AddAndClampToS16(acc, {left, right});
+                   });
+}
+
+void DownmixMonoAndMix(StereoFrame16& accumulator, const QuadFrame32& samples, float gain) {
+    std::transform(accumulator.begin(), accumulator.end(), samples.begin(), accumulator.begin(),
+                   [gain](const std::array<s16, 2>& acc,
+                          const std::array<s32, 4>& sample) -> std::array<s16, 2> {
+                       // Downmix to mono
+                       s16 mono = ClampToS16(static_cast<s32>((gain * sample[0] + gain * sample[1] +
+                                                               gain * sample[2] + gain * sample[3]) /
+                                                              2));
+                       // Mix into current frame
+                       return AddAndClampToS16(acc, {mono, mono});
+                   });
+}
+
+void MixStereoIntoQuad(QuadFrame32& dest, const StereoFrame16& samples,
+                       const std::array<float, 4>& gains) {
+    for (std::size_t i = 0; i < samples_per_frame; i++) {
+        dest[i][0] += static_cast<s32>(gains[0] * samples[i][0]);
+        dest[i][1] += static_cast<s32>(gains[1] * samples[i][1]);
+        dest[i][2] += static_cast<s32>(gains[2] * samples[i][0]);
+        dest[i][3] += static_cast<s32>(gains[3] * samples[i][1]);
+    }
+}
+
+void QuadToChannelMajor(QuadFrame32ChannelMajor& dest, const QuadFrame32& src) {
+    for (std::size_t sample = 0; sample < samples_per_frame; sample++) {
+        for (std::size_t channel = 0; channel < 4; channel++) {
+            dest[channel][sample] = src[sample][channel];
+        }
+    }
+}
+
+void ChannelMajorToQuad(QuadFrame32& dest, const QuadFrame32ChannelMajor& src) {
+    for (std::size_t sample = 0; sample < samples_per_frame; sample++) {
+        for (std::size_t channel = 0; channel < 4; channel++) {
+            dest[sample][channel] = src[channel][sample];
+        }
+    }
+}
+
+} // namespace Reference
+
+#ifdef ARCHITECTURE_x86_64
+
+// The float arithmetic below is performed in the same order as the reference implementation,
+// with truncating conversions (cvttps) and saturating packs/adds standing in for ClampToS16.
+// This keeps the output bit-exact.
+
+static __m128 LoadScaledQuad(const std::array<s32, 4>& sample, __m128 gain) {
+    const __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sample.data()));
+    return _mm_mul_ps(gain, _mm_cvtepi32_ps(raw));
+}
+
+static __m128i* AsVector(std::array<s16, 2>* frame) {
+    return reinterpret_cast<__m128i*>(frame->data());
+}
+
+void DownmixStereoAndMix(StereoFrame16& accumulator, const QuadFrame32& samples, float gain) {
+    const __m128 g = _mm_set1_ps(gain);
+    for (std::size_t i = 0; i < samples_per_frame; i += 4) {
+        const __m128 p0 = LoadScaledQuad(samples[i + 0], g);
+        const __m128 p1 = LoadScaledQuad(samples[i + 1], g);
+        const __m128 p2 = LoadScaledQuad(samples[i + 2], g);
+        const __m128 p3 = LoadScaledQuad(samples[i + 3], g);
+
+        // {front left, front right} + {back left, back right} for two samples at a time
+        const __m128 front01 = _mm_shuffle_ps(p0, p1, _MM_SHUFFLE(1, 0, 1, 0));
+        const __m128 back01 = _mm_shuffle_ps(p0, p1, _MM_SHUFFLE(3, 2, 3, 2));
+        const __m128 front23 = _mm_shuffle_ps(p2, p3, _MM_SHUFFLE(1, 0, 1, 0));
+        const __m128 back23 = _mm_shuffle_ps(p2, p3, _MM_SHUFFLE(3, 2, 3, 2));
+        const __m128i stereo01 = _mm_cvttps_epi32(_mm_add_ps(front01, back01));
+        const __m128i stereo23 = _mm_cvttps_epi32(_mm_add_ps(front23, back23));
+
+        const __m128i mixed = _mm_packs_epi32(stereo01, stereo23);
+        __m128i* acc = AsVector(&accumulator[i]);
+        _mm_storeu_si128(acc, _mm_adds_epi16(_mm_loadu_si128(acc), mixed));
+    }
+}
+
+void DownmixMonoAndMix(StereoFrame16& accumulator, const QuadFrame32& samples, float gain) {
+    const __m128 g = _mm_set1_ps(gain);
+    const __m128 half = _mm_set1_ps(0.5f);
+    for (std::size_t i = 0; i < samples_per_frame; i += 4) {
+        __m128 c0 = LoadScaledQuad(samples[i + 0], g);
+        __m128 c1 = LoadScaledQuad(samples[i + 1], g);
+        __m128 c2 = LoadScaledQuad(samples[i + 2], g);
+        __m128 c3 = LoadScaledQuad(samples[i + 3], g);
+        // After transposing, c<n> holds channel n of four consecutive samples.
+        _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+        // Division by two is exact, so multiplying by one half gives the same result.
+        const __m128 sum = _mm_add_ps(_mm_add_ps(_mm_add_ps(c0, c1), c2), c3);
+        const __m128i mono = _mm_cvttps_epi32(_mm_mul_ps(sum, half));
+
+        const __m128i packed = _mm_packs_epi32(mono, mono);
+        const __m128i mixed = _mm_unpacklo_epi16(packed, packed);
+        __m128i* acc = AsVector(&accumulator[i]);
+        _mm_storeu_si128(acc, _mm_adds_epi16(_mm_loadu_si128(acc), mixed));
+    }
+}
+
+void MixStereoIntoQuad(QuadFrame32& dest, const StereoFrame16& samples,
+                       const std::array<float, 4>& gains) {
+    const __m128 g = _mm_loadu_ps(gains.data());
+    const auto mix_one = [&g](std::array<s32, 4>& out, __m128i stereo_pair) {
+        __m128i* dest_vector = reinterpret_cast<__m128i*>(out.data());
+        const __m128i scaled = _mm_cvttps_epi32(_mm_mul_ps(g, _mm_cvtepi32_ps(stereo_pair)));
+        _mm_storeu_si128(dest_vector, _mm_add_epi32(_mm_loadu_si128(dest_vector), scaled));
+    };
+
+    for (std::size_t i = 0; i < samples_per_frame; i += 4) {
+        const __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples[i].data()));
+        // Sign-extend the four stereo samples to 32 bits.
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(raw, raw), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(raw, raw), 16);
+
+        // Each destination sample is {left, right, left, right}.
+        mix_one(dest[i + 0], _mm_shuffle_epi32(lo, _MM_SHUFFLE(1, 0, 1, 0)));
+        mix_one(dest[i + 1], _mm_shuffle_epi32(lo, _MM_SHUFFLE(3, 2, 3, 2)));
+        mix_one(dest[i + 2], _mm_shuffle_epi32(hi, _MM_SHUFFLE(1, 0, 1, 0)));
+        mix_one(dest[i + 3], _mm_shuffle_epi32(hi, _MM_SHUFFLE(3, 2, 3, 2)));
+    }
+}
+
+static void Transpose4x4(const void* r0, const void* r1, const void* r2, const void* r3,
+                         void* w0, void* w1, void* w2, void* w3) {
+    // Shuffles in the float domain only move bits, so this is safe for integer data.
+    __m128 v0 = _mm_loadu_ps(static_cast<const float*>(r0));
+    __m128 v1 = _mm_loadu_ps(static_cast<const float*>(r1));
+    __m128 v2 = _mm_loadu_ps(static_cast<const float*>(r2));
+    __m128 v3 = _mm_loadu_ps(static_cast<const float*>(r3));
+    _MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+    _mm_storeu_ps(static_cast<float*>(w0), v0);
+    _mm_storeu_ps(static_cast<float*>(w1), v1);
+    _mm_storeu_ps(static_cast<float*>(w2), v2);
+    _mm_storeu_ps(static_cast<float*>(w3), v3);
+}
+
+void QuadToChannelMajor(QuadFrame32ChannelMajor& dest, const QuadFrame32& src) {
+    for (std::size_t i = 0; i < samples_per_frame; i += 4) {
+        Transpose4x4(src[i + 0].data(), src[i + 1].data(), src[i + 2].data(), src[i + 3].data(),
+                     &dest[0][i], &dest[1][i], &dest[2][i], &dest[3][i]);
+    }
+}
+
+void ChannelMajorToQuad(QuadFrame32& dest, const QuadFrame32ChannelMajor& src) {
+    for (std::size_t i = 0; i < samples_per_frame; i += 4) {
+        Transpose4x4(&src[0][i], &src[1][i], &src[2][i], &src[3][i], dest[i + 0].data(),
+                     dest[i + 1].data(), dest[i + 2].data(), dest[i + 3].data());
+    }
+}
+
+#else
+
+void DownmixStereoAndMix(StereoFrame16& accumulator, const QuadFrame32& samples, float gain) {
+    Reference::DownmixStereoAndMix(accumulator, samples, gain);
+}
+
+void DownmixMonoAndMix(StereoFrame16& accumulator, const QuadFrame32& samples, float gain) {
+    Reference::DownmixMonoAndMix(accumulator, samples, gain);
+}
+
+void MixStereoIntoQuad(QuadFrame32& dest, const StereoFrame16& samples,
+                       const std::array<float, 4>& gains) {
+    Reference::MixStereoIntoQuad(dest, samples, gains);
+}
+
+void QuadToChannelMajor(QuadFrame32ChannelMajor& dest, const QuadFrame32& src) {
+    Reference::QuadToChannelMajor(dest, src);
+}
+
+void ChannelMajorToQuad(QuadFrame32& dest, const QuadFrame32ChannelMajor& src) {
+    Reference::ChannelMajorToQuad(dest, src);
+}
+
+#endif // ARCHITECTURE_x86_64
+
+} // namespace AudioCore::HLE::MixKernels
@@ -0,0 +1,56 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include "audio_core/audio_types.h"
+#include "common/common_types.h"
+#include "common/swap.h"
+
+/**
+ * Whole-frame mixing kernels used by the HLE DSP. On x86_64 these are implemented with SSE2;
+ * other architectures use the scalar reference loops. Both produce bit-identical output.
+ */
+namespace AudioCore::HLE::MixKernels {
+
+/// Shared memory layout of an intermediate mix: channel-major rather than sample-major.
+using QuadFrame32ChannelMajor = s32_le[4][samples_per_frame];
+
+/**
+ * Downmixes a quadraphonic frame to stereo with `gain` applied, then accumulates it into
+ * `accumulator` with saturation to the s16 range.
+ */
+void DownmixStereoAndMix(StereoFrame16& accumulator, const QuadFrame32& samples, float gain);
+
+/**
+ * Downmixes a quadraphonic frame to mono with `gain` applied, then accumulates it into both
+ * channels of `accumulator` with saturation to the s16 range.
+ */
+void DownmixMonoAndMix(StereoFrame16& accumulator, const QuadFrame32& samples, float gain);
+
+/**
+ * Upmixes a stereo frame to quadraphonic using per-channel `gains` ({front left, front right,
+ * back left, back right}), then accumulates it into `dest`.
+ */
+void MixStereoIntoQuad(QuadFrame32& dest, const StereoFrame16& samples,
+                       const std::array<float, 4>& gains);
+
+/// Converts a sample-major quadraphonic frame into the channel-major shared memory layout.
+void QuadToChannelMajor(QuadFrame32ChannelMajor& dest, const QuadFrame32& src);
+
+/// Converts a channel-major shared memory frame into a sample-major quadraphonic frame.
+void ChannelMajorToQuad(QuadFrame32& dest, const QuadFrame32ChannelMajor& src);
+
+namespace Reference {
+// Scalar implementations. These define the expected output of the kernels above.
+void DownmixStereoAndMix(StereoFrame16& accumulator, const QuadFrame32& samples, float gain);
+void DownmixMonoAndMix(StereoFrame16& accumulator, const QuadFrame32& samples, float gain);
+void MixStereoIntoQuad(QuadFrame32& dest, const StereoFrame16& samples,
+                       const std::array<float, 4>& gains);
+void QuadToChannelMajor(QuadFrame32ChannelMajor& dest, const QuadFrame32& src);
+void ChannelMajorToQuad(QuadFrame32& dest, const QuadFrame32ChannelMajor& src);
+} // namespace Reference
+
+} // namespace AudioCore::HLE::MixKernels
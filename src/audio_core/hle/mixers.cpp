@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <cstddef>
+#include "audio_core/hle/mix_kernels.h"
 #include "audio_core/hle/mixers.h"
 #include "common/assert.h"
 #include "common/logging/log.h"
@@ -84,32 +85,12 @@ void Mixers::ParseConfig(DspConfiguration& config) {
     config.dirty_raw = 0;
 }
 
-static s16 ClampToS16(s32 value) {
-    return static_cast<s16>(std::clamp(value, -32768, 32767));
-}
-
-static std::array<s16, 2> AddAndClampToS16(const std::array<s16, 2>& a,
-                                           const std::array<s16, 2>& b) {
-    return {ClampToS16(static_cast<s32>(a[0]) + static_cast<s32>(b[0])),
-            ClampToS16(static_cast<s32>(a[1]) + static_cast<s32>(b[1]))};
-}
-
 void Mixers::DownmixAndMixIntoCurrentFrame(float gain, const QuadFrame32& samples) {
     // TODO(merry): Limiter. (Currently we're performing final mixing assuming a disabled limiter.)
 
     switch (state.output_format) {
     case OutputFormat::Mono:
-        std::transform(
-            current_frame.begin(), current_frame.end(), samples.begin(), current_frame.begin(),
-            [gain](const std::array<s16, 2>& accumulator,
-                   const std::array<s32, 4>& sample) -> std::array<s16, 2> {
-                // Downmix to mono
-                s16 mono = ClampToS16(static_cast<s32>(
-                    (gain * sample[0] + gain * sample[1] + gain * sample[2] + gain * sample[3]) /
-                    2));
-                // Mix into current frame
-                return AddAndClampToS16(accumulator, {mono, mono});
-            });
+        MixKernels::DownmixMonoAndMix(current_frame, samples, gain);
         return;
 
     case OutputFormat::Surround:
@@ -117,16 +98,7 @@ void Mixers::DownmixAndMixIntoCurrentFrame(float gain, const QuadFrame32& sample
         // fallthrough
 
     case OutputFormat::Stereo:
-        std::transform(
-            current_frame.begin(), current_frame.end(), samples.begin(), current_frame.begin(),
-            [gain](const std::array<s16, 2>& accumulator,
-                   const std::array<s32, 4>& sample) -> std::array<s16, 2> {
-                // Downmix to stereo
-                s16 left = ClampToS16(static_cast<s32>(gain * sample[0] + gain * sample[2]));
-                s16 right = ClampToS16(static_cast<s32>(gain * sample[1] + gain * sample[3]));
-                // Mix into current frame
-                return AddAndClampToS16(accumulator, {left, right});
-            });
+        MixKernels::DownmixStereoAndMix(current_frame, samples, gain);
         return;
     }
 
@@ -138,21 +110,11 @@ void Mixers::AuxReturn(const IntermediateMixSamples& read_samples) {
     // QuadFrame32.
 
     if (state.mixer1_enabled) {
-        for (std::size_t sample = 0; sample < samples_per_frame; sample++) {
-            for (std::size_t channel = 0; channel < 4; channel++) {
-                state.intermediate_mix_buffer[1][sample][channel] =
-                    read_samples.mix1.pcm32[channel][sample];
-            }
-        }
+        MixKernels::ChannelMajorToQuad(state.intermediate_mix_buffer[1], read_samples.mix1.pcm32);
     }
 
     if (state.mixer2_enabled) {
-        for (std::size_t sample = 0; sample < samples_per_frame; sample++) {
-            for (std::size_t channel = 0; channel < 4; channel++) {
-                state.intermediate_mix_buffer[2][sample][channel] =
-                    read_samples.mix2.pcm32[channel][sample];
-            }
-        }
+        MixKernels::ChannelMajorToQuad(state.intermediate_mix_buffer[2], read_samples.mix2.pcm32);
     }
 }
 
@@ -164,21 +126,13 @@ void Mixers::AuxSend(IntermediateMixSamples& write_samples,
     state.intermediate_mix_buffer[0] = input[0];
 
     if (state.mixer1_enabled) {
-        for (std::size_t sample = 0; sample < samples_per_frame; sample++) {
-            for (std::size_t channel = 0; channel < 4; channel++) {
-                write_samples.mix1.pcm32[channel][sample] = input[1][sample][channel];
-            }
-        }
+        MixKernels::QuadToChannelMajor(write_samples.mix1.pcm32, input[1]);
     } else {
         state.intermediate_mix_buffer[1] = input[1];
     }
 
     if (state.mixer2_enabled) {
-        for (std::size_t sample = 0; sample < samples_per_frame; sample++) {
-            for (std::size_t channel = 0; channel < 4; channel++) {
-                write_samples.mix2.pcm32[channel][sample] = input[2][sample][channel];
-            }
-        }
+        MixKernels::QuadToChannelMajor(write_samples.mix2.pcm32, input[2]);
     } else {
         state.intermediate_mix_buffer[2] = input[2];
     }
@@ -0,0 +1,137 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include "common/common_types.h"
+#include "common/ring_buffer.h"
+
+namespace AudioCore {
+
+/**
+ * Fixed-capacity single-producer single-consumer ring of interleaved stereo PCM16 frames.
+ * The producer is the emulation thread (DspInterface::OutputFrame) and the consumer is the
+ * realtime audio sink callback. Neither side allocates or takes a lock.
+ */
+class SampleRing {
+public:
+    /// Capacity in stereo frames.
+    static constexpr std::size_t capacity = 0x2000;
+
+    /**
+     * Pushes frames into the ring. Frames that do not fit are dropped and counted as an overrun.
+     * @param frames Interleaved stereo samples
+     * @param num_frames Number of stereo frames in `frames`
+     * @returns Number of frames actually pushed
+     */
+    std::size_t Push(const s16* frames, std::size_t num_frames) {
+        const std::size_t pushed = ring.Push(frames, num_frames);
+        if (pushed < num_frames) {
+            RecordOverrun(num_frames - pushed);
+        }
+        return pushed;
+    }
+
+    /**
+     * Pops frames out of the ring. A request that cannot be fully served counts as an underrun.
+     * @param out Destination for interleaved stereo samples
+     * @param num_frames Number of stereo frames requested
+     * @returns Number of frames actually popped
+     */
+    std::size_t Pop(s16* out, std::size_t num_frames) {
+        const std::size_t popped = ring.Pop(out, num_frames);
+        if (popped < num_frames) {
+            underrun_count.fetch_add(1, std::memory_order_relaxed);
+            underrun_frames.fetch_add(num_frames - popped, std::memory_order_relaxed);
+        }
+        return popped;
+    }
+
+    /// @returns Number of frames currently queued
+    std::size_t Size() const {
+        return ring.Size();
+    }
+
+    /// Number of Pop calls that could not be fully satisfied
+    u64 GetUnderrunCount() const {
+        return underrun_count.load(std::memory_order_relaxed);
+    }
+    /// Total number of frames missing from short Pop calls
+    u64 GetUnderrunFrames() const {
+        return underrun_frames.load(std::memory_order_relaxed);
+    }
+    /**
+     * Counts frames that were dropped before they could be pushed, so that every frame lost on the
+     * way to the sink shows up in the overrun counters.
+     */
+    void RecordOverrun(std::size_t num_frames) {
+        overrun_count.fetch_add(1, std::memory_order_relaxed);
+        overrun_frames.fetch_add(num_frames, std::memory_order_relaxed);
+    }
+
+    /// Number of Push calls that had to drop frames
+    u64 GetOverrunCount() const {
+        return overrun_count.load(std::memory_order_relaxed);
+    }
+    /// Total number of frames dropped by Push calls
+    u64 GetOverrunFrames() const {
+        return overrun_frames.load(std::memory_order_relaxed);
+    }
+
+private:
+    Common::RingBuffer<s16, capacity, 2> ring;
+
+    std::atomic<u64> underrun_count{0};
+    std::atomic<u64> underrun_frames{0};
+    std::atomic<u64> overrun_count{0};
+    std::atomic<u64> overrun_frames{0};
+};
+
+/**
+ * Frames collected on the producer thread until the time stretcher runs. Frames that do not fit
+ * are dropped and counted as an overrun of the ring they are headed to.
+ */
+class StagingBuffer {
+public:
+    /**
+     * Appends frames to the buffer.
+     * @param frames Interleaved stereo samples
+     * @param num_frames Number of stereo frames in `frames`
+     * @param ring Ring whose overrun counters account for the dropped frames
+     * @returns Number of frames actually staged
+     */
+    std::size_t Stage(const s16* frames, std::size_t num_frames, SampleRing& ring) {
+        const std::size_t to_stage = std::min(num_frames, SampleRing::capacity - size);
+        std::memcpy(buffer.data() + 2 * size, frames, 2 * sizeof(s16) * to_stage);
+        size += to_stage;
+        if (to_stage < num_frames) {
+            ring.RecordOverrun(num_frames - to_stage);
+        }
+        return to_stage;
+    }
+
+    const s16* Data() const {
+        return buffer.data();
+    }
+
+    /// @returns Number of frames currently staged
+    std::size_t Size() const {
+        return size;
+    }
+
+    void Clear() {
+        size = 0;
+    }
+
+private:
+    std::array<s16, 2 * SampleRing::capacity> buffer{};
+    std::size_t size = 0;
+};
+
+} // namespace AudioCore
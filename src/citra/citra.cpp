@@ -2,6 +2,9 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <iostream>
 #include <memory>
 #include <regex>
@@ -36,14 +39,17 @@
 #include "core/frontend/applets/default_applets.h"
 #include "core/frontend/framebuffer_layout.h"
 #include "core/frontend/scope_acquire_context.h"
+#include "core/game_scanner.h"
 #include "core/gdbstub/gdbstub.h"
 #include "core/hle/service/am/am.h"
 #include "core/hle/service/cfg/cfg.h"
 #include "core/loader/loader.h"
+#include "core/loader/smdh.h"
 #include "core/movie.h"
 #include "core/settings.h"
 #include "network/network.h"
 #include "video_core/renderer_base.h"
+#include "video_core/video_core.h"
 
 #undef _UNICODE
 #include <getopt.h>
@@ -67,12 +73,36 @@ static void PrintHelp(const char* argv0) {
                  " Nickname, password, address and port for multiplayer\n"
                  "-r, --movie-record=[file]  Record a movie (game inputs) to the given file\n"
                  "-p, --movie-play=[file]    Playback the movie (game inputs) from the given file\n"
+                 "-s, --movie-seek=FRAME     Seek the movie being played back to FRAME\n"
                  "-d, --dump-video=[file]    Dumps audio and video to the given video file\n"
+                 "-t, --max-throughput[=N]   Run unthrottled, presenting one frame out of N\n"
+                 "-b, --perf-breakdown=FILE  Write the host time of each frame by subsystem\n"
+                 "-l, --list-games=DIR       List the games found in DIR and its subdirectories\n"
                  "-f, --fullscreen     Start in fullscreen mode\n"
                  "-h, --help           Display this help and exit\n"
                  "-v, --version        Output version information and exit\n";
 }
 
+/// Prints one tab-separated line per game: title ID, file type, size, short title and path.
+static void ListGames(const std::string& directory) {
+    Core::GameScanner scanner;
+    const auto games = scanner.ScanDirectory(directory, 256);
+    for (const Core::GameEntry& game : games) {
+        std::string title;
+        if (Loader::IsValidSMDH(game.smdh)) {
+            Loader::SMDH smdh;
+            std::memcpy(&smdh, game.smdh.data(), sizeof(Loader::SMDH));
+            const auto short_title = smdh.GetShortTitle(Loader::SMDH::TitleLanguage::English);
+            title = Common::UTF16ToUTF8(std::u16string(
+                reinterpret_cast<const char16_t*>(short_title.data()),
+                std::find(short_title.begin(), short_title.end(), u'\0') - short_title.begin()));
+        }
+        std::cout << fmt::format("{:016X}\t{}\t{}\t{}\t{}\n", game.program_id,
+                                 Loader::GetFileTypeString(game.file_type), game.size, title,
+                                 game.path);
+    }
+}
+
 static void PrintVersion() {
     std::cout << "Citra " << Common::g_scm_branch << " " << Common::g_scm_desc << std::endl;
 }
@@ -179,6 +209,10 @@ static void InitializeLogging() {
     const std::string& log_dir = FileUtil::GetUserPath(FileUtil::UserPath::LogDir);
     FileUtil::CreateFullPath(log_dir);
     Log::AddBackend(std::make_unique<Log::FileBackend>(log_dir + LOG_FILE));
+    if (Settings::values.log_binary) {
+        Log::AddBackend(std::make_unique<Log::BinaryFileBackend>(log_dir + BINARY_LOG_FILE));
+    }
+    Log::SetDeferredFormatting(Settings::values.log_deferred_formatting);
 #ifdef _WIN32
     Log::AddBackend(std::make_unique<Log::DebuggerBackend>());
 #endif
@@ -193,6 +227,7 @@ int main(int argc, char** argv) {
     u32 gdb_port = static_cast<u32>(Settings::values.gdbstub_port);
     std::string movie_record;
     std::string movie_play;
+    u64 movie_seek = 0;
     std::string dump_video;
 
     InitializeLogging();
@@ -221,11 +256,13 @@ int main(int argc, char** argv) {
         {"multiplayer", required_argument, 0, 'm'}, {"movie-record", required_argument, 0, 'r'},
         {"movie-play", required_argument, 0, 'p'},  {"dump-video", required_argument, 0, 'd'},
         {"fullscreen", no_argument, 0, 'f'},        {"help", no_argument, 0, 'h'},
-        {"version", no_argument, 0, 'v'},           {0, 0, 0, 0},
+        {"version", no_argument, 0, 'v'},           {"list-games", required_argument, 0, 'l'},
+        {"movie-seek", required_argument, 0, 's'},  {"max-throughput", optional_argument, 0, 't'},
+        {"perf-breakdown", required_argument, 0, 'b'}, {0, 0, 0, 0},
     };
 
     while (optind < argc) {
-        int arg = getopt_long(argc, argv, "g:i:m:r:p:fhv", long_options, &option_index);
+        int arg = getopt_long(argc, argv, "g:i:m:r:p:s:l:t::b:fhv", long_options, &option_index);
         if (arg != -1) {
             switch (static_cast<char>(arg)) {
             case 'g':
@@ -243,9 +280,13 @@ int main(int argc, char** argv) {
                 const auto cia_progress = [](std::size_t written, std::size_t total) {
                     LOG_INFO(Frontend, "{:02d}%", (written * 100 / total));
                 };
-                if (Service::AM::InstallCIA(std::string(optarg), cia_progress) !=
+                Service::AM::InstallStatistics statistics;
+                if (Service::AM::InstallCIA(std::string(optarg), cia_progress, &statistics) !=
                     Service::AM::InstallStatus::Success)
                     errno = EINVAL;
+                else
+                    LOG_INFO(Frontend, "Installed at {:.1f} MiB/s",
+                             statistics.GetThroughput() / (1024 * 1024));
                 if (errno != 0)
                     exit(1);
                 break;
@@ -288,9 +329,39 @@ int main(int argc, char** argv) {
             case 'p':
                 movie_play = optarg;
                 break;
+            case 's':
+                errno = 0;
+                movie_seek = strtoull(optarg, &endarg, 0);
+                if (endarg == optarg)
+                    errno = EINVAL;
+                if (errno != 0) {
+                    perror("--movie-seek");
+                    exit(1);
+                }
+                break;
             case 'd':
                 dump_video = optarg;
                 break;
+            case 't':
+                Settings::values.max_throughput = true;
+                if (optarg) {
+                    errno = 0;
+                    const unsigned long interval = strtoul(optarg, &endarg, 0);
+                    if (endarg == optarg || interval == 0 || interval > 0xFFFF)
+                        errno = EINVAL;
+                    if (errno != 0) {
+                        perror("--max-throughput");
+                        exit(1);
+                    }
+                    Settings::values.max_throughput_present_interval = static_cast<u16>(interval);
+                }
+                break;
+            case 'b':
+                Settings::values.perf_breakdown_file = optarg;
+                break;
+            case 'l':
+                ListGames(optarg);
+                return 0;
             case 'f':
                 fullscreen = true;
                 LOG_INFO(Frontend, "Starting in fullscreen mode...");
@@ -402,6 +473,9 @@ int main(int argc, char** argv) {
 
     if (!movie_play.empty()) {
         Core::Movie::GetInstance().StartPlayback(movie_play);
+        if (movie_seek != 0 && !system.SendSignal(Core::System::Signal::MovieSeek, movie_seek)) {
+            LOG_ERROR(Frontend, "Could not seek the movie to frame {}", movie_seek);
+        }
     }
     if (!movie_record.empty()) {
         Core::Movie::GetInstance().StartRecording(movie_record);
@@ -415,17 +489,39 @@ int main(int argc, char** argv) {
     std::thread render_thread([&emu_window] { emu_window->Present(); });
 
     std::atomic_bool stop_run;
-    Core::System::GetInstance().Renderer().Rasterizer()->LoadDiskResources(
-        stop_run, [](VideoCore::LoadCallbackStage stage, std::size_t value, std::size_t total) {
-            LOG_DEBUG(Frontend, "Loading stage {} progress {} {}", static_cast<u32>(stage), value,
-                      total);
-        });
+    VideoCore::RunOnGPUThread([&stop_run] {
+        Core::System::GetInstance().Renderer().Rasterizer()->LoadDiskResources(
+            stop_run, [](VideoCore::LoadCallbackStage stage, std::size_t value, std::size_t total) {
+                LOG_DEBUG(Frontend, "Loading stage {} progress {} {}", static_cast<u32>(stage),
+                          value, total);
+            });
+    });
+
+    // Max throughput mode reports the emulated frames per host second, to size test machines
+    constexpr std::chrono::seconds throughput_report_interval{10};
+    auto last_throughput_report = std::chrono::steady_clock::now();
 
     while (emu_window->IsOpen()) {
         system.RunLoop();
+
+        if (Settings::values.max_throughput) {
+            const auto now = std::chrono::steady_clock::now();
+            if (now - last_throughput_report >= throughput_report_interval) {
+                const auto results = system.GetAndResetPerfStats();
+                LOG_INFO(Frontend, "Throughput: {:.1f} emulated frames per second ({:.0f}%)",
+                         results.system_fps, results.emulation_speed * 100.0);
+                last_throughput_report = now;
+            }
+        }
     }
     render_thread.join();
 
+    if (Settings::values.max_throughput) {
+        LOG_INFO(Frontend, "Throughput: {} emulated frames at {:.1f} frames per second overall",
+                 system.perf_stats->GetTotalSystemFrames(),
+                 system.perf_stats->GetOverallSystemFps());
+    }
+
     Core::Movie::GetInstance().Shutdown();
     if (system.VideoDumper().IsDumping()) {
         system.VideoDumper().StopDumping();
@@ -106,9 +106,14 @@ void Config::ReadValues() {
     Settings::values.use_cpu_jit = sdl2_config->GetBoolean("Core", "use_cpu_jit", true);
     Settings::values.cpu_clock_percentage =
         sdl2_config->GetInteger("Core", "cpu_clock_percentage", 100);
+    Settings::values.enable_cpu_multithread =
+        sdl2_config->GetBoolean("Core", "enable_cpu_multithread", false);
+    Settings::values.skip_idle_loops = sdl2_config->GetBoolean("Core", "skip_idle_loops", true);
 
     // Renderer
     Settings::values.use_gles = sdl2_config->GetBoolean("Renderer", "use_gles", false);
+    Settings::values.use_null_renderer =
+        sdl2_config->GetBoolean("Renderer", "use_null_renderer", false);
     Settings::values.use_hw_renderer = sdl2_config->GetBoolean("Renderer", "use_hw_renderer", true);
     Settings::values.use_hw_shader = sdl2_config->GetBoolean("Renderer", "use_hw_shader", true);
 #ifdef __APPLE__
@@ -121,6 +126,8 @@ void Config::ReadValues() {
     Settings::values.shaders_accurate_mul =
         sdl2_config->GetBoolean("Renderer", "shaders_accurate_mul", true);
     Settings::values.use_shader_jit = sdl2_config->GetBoolean("Renderer", "use_shader_jit", true);
+    Settings::values.use_asynchronous_gpu_emulation =
+        sdl2_config->GetBoolean("Renderer", "use_asynchronous_gpu_emulation", false);
     Settings::values.resolution_factor =
         static_cast<u16>(sdl2_config->GetInteger("Renderer", "resolution_factor", 1));
     Settings::values.use_disk_shader_cache =
@@ -131,6 +138,10 @@ void Config::ReadValues() {
         sdl2_config->GetBoolean("Renderer", "use_frame_limit_alternate", false);
     Settings::values.frame_limit_alternate =
         static_cast<u16>(sdl2_config->GetInteger("Renderer", "frame_limit_alternate", 200));
+    Settings::values.max_throughput =
+        sdl2_config->GetBoolean("Renderer", "max_throughput", false);
+    Settings::values.max_throughput_present_interval = static_cast<u16>(
+        sdl2_config->GetInteger("Renderer", "max_throughput_present_interval", 60));
     Settings::values.use_vsync_new =
         static_cast<u16>(sdl2_config->GetInteger("Renderer", "use_vsync_new", 1));
     Settings::values.texture_filter_name =
@@ -183,6 +194,8 @@ void Config::ReadValues() {
     Settings::values.custom_textures = sdl2_config->GetBoolean("Utility", "custom_textures", false);
     Settings::values.preload_textures =
         sdl2_config->GetBoolean("Utility", "preload_textures", false);
+    Settings::values.custom_textures_memory_budget = static_cast<u32>(
+        sdl2_config->GetInteger("Utility", "custom_textures_memory_budget", 0));
 
     // Audio
     Settings::values.enable_dsp_lle = sdl2_config->GetBoolean("Audio", "enable_dsp_lle", false);
@@ -256,10 +269,14 @@ void Config::ReadValues() {
 
     // Miscellaneous
     Settings::values.log_filter = sdl2_config->GetString("Miscellaneous", "log_filter", "*:Info");
+    Settings::values.log_deferred_formatting =
+        sdl2_config->GetBoolean("Miscellaneous", "log_deferred_formatting", false);
+    Settings::values.log_binary = sdl2_config->GetBoolean("Miscellaneous", "log_binary", false);
 
     // Debugging
     Settings::values.record_frame_times =
         sdl2_config->GetBoolean("Debugging", "record_frame_times", false);
+    Settings::values.perf_breakdown_file = sdl2_config->Get("Debugging", "perf_breakdown_file", "");
     Settings::values.use_gdbstub = sdl2_config->GetBoolean("Debugging", "use_gdbstub", false);
     Settings::values.gdbstub_port =
         static_cast<u16>(sdl2_config->GetInteger("Debugging", "gdbstub_port", 24689));
@@ -296,6 +313,8 @@ void Config::ReadValues() {
         sdl2_config->GetString("Video Dumping", "video_encoder_options", default_video_options);
     Settings::values.video_bitrate =
         sdl2_config->GetInteger("Video Dumping", "video_bitrate", 2500000);
+    Settings::values.video_frame_queue_depth = static_cast<u32>(
+        sdl2_config->GetInteger("Video Dumping", "video_frame_queue_depth", 4));
 
     Settings::values.audio_encoder =
         sdl2_config->GetString("Video Dumping", "audio_encoder", "libvorbis");
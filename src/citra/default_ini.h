@@ -97,11 +97,28 @@ use_cpu_jit =
 # Range is any positive integer (but we suspect 25 - 400 is a good idea) Default is 100
 cpu_clock_percentage =
 
+# Whether to run each emulated CPU core on its own host thread. Requires the JIT.
+# Faster on hosts with several cores, but no longer deterministic, and games that rely on
+# exclusive memory accesses between cores may break.
+# 0 (default): Run all cores on the emulation thread, 1: Run each core on its own thread
+enable_cpu_multithread =
+
+# Whether to skip ahead to the next scheduled event when the guest spins in a loop that has no
+# side effects, such as polling a flag. Lowers host CPU usage without changing emulated timing.
+# Not applied while the cores run on their own threads.
+# 0: Run idle loops, 1 (default): Skip idle loops
+skip_idle_loops =
+
 [Renderer]
 # Whether to render using GLES or OpenGL
 # 0 (default): OpenGL, 1: GLES
 use_gles =
 
+# Whether to emulate the GPU without displaying anything, e.g. for headless runs. This always uses
+# software rendering and needs no graphics driver.
+# 0 (default): Off, 1: On
+use_null_renderer =
+
 # Whether to use software or hardware rendering.
 # 0: Software, 1 (default): Hardware
 use_hw_renderer =
@@ -122,6 +139,11 @@ shaders_accurate_mul =
 # 0: Interpreter (slow), 1 (default): JIT (fast)
 use_shader_jit =
 
+# Whether to process GPU commands on a thread of their own, so that CPU emulation does not wait for
+# draws to finish. Results only become visible to the CPU at memory flushes and GPU interrupts.
+# 0 (default): Off (synchronous, most accurate), 1: On (faster)
+use_asynchronous_gpu_emulation =
+
 # Forces VSync on the display thread. Usually doesn't impact performance, but on some drivers it can
 # so only turn this off if you notice a speed difference.
 # 0: Off, 1 (default): On
@@ -148,6 +170,15 @@ frame_limit =
 # 0: Off (default), 1: On
 use_frame_limit_alternate =
 
+# Runs as fast as possible for automated testing. Emulated timing is kept, but only every
+# max_throughput_present_interval-th frame is presented, and audio is discarded.
+# 0 (default): Off, 1: On
+max_throughput =
+
+# Number of emulated frames per presented frame in max throughput mode
+# 1 - 65535: 60 (default)
+max_throughput_present_interval =
+
 # Alternate speed limit to be used instead of frame_limit if use_frame_limit_alternate is enabled
 # 5 - 995: Speed limit as a percentage of target game speed. 0 for unthrottled. 200 (default)
 frame_limit_alternate =
@@ -210,6 +241,7 @@ upright_screen =
 dump_textures =
 
 # Reads PNG files from load/textures/[Title ID]/ and replaces textures.
+# A textures.pack file made by citra-texture-pack in that directory is read as well.
 # 0 (default): Off, 1: On
 custom_textures =
 
@@ -217,6 +249,11 @@ custom_textures =
 # 0 (default): Off, 1: On
 preload_textures =
 
+# Memory in MiB for custom textures that are not preloaded. The least recently used ones are
+# unloaded beyond it, and loaded again when needed.
+# 0 (default): No limit, otherwise: Memory budget in MiB
+custom_textures_memory_budget =
+
 [Audio]
 # Whether or not to enable DSP LLE
 # 0 (default): No, 1: Yes
@@ -303,9 +340,19 @@ camera_inner_flip =
 # Examples: *:Debug Kernel.SVC:Trace Service.*:Critical
 log_filter = *:Info
 
+# Defer formatting of log messages to the logging thread. Makes verbose filters much cheaper.
+# 0 (default): Off, 1: On
+log_deferred_formatting =
+
+# Also write a compact binary log (citra_log.bin), to be decoded with citra-log-decoder.
+# 0 (default): Off, 1: On
+log_binary =
+
 [Debugging]
 # Record frame time data, can be found in the log directory. Boolean value
 record_frame_times =
+# Write the host time of each frame, broken down by subsystem, to this file. Empty (default): Off
+perf_breakdown_file =
 # Port for listening to GDB connections.
 use_gdbstub=false
 gdbstub_port=24689
@@ -339,6 +386,9 @@ video_encoder_options =
 # Video bitrate, default: 2500000
 video_bitrate =
 
+# Number of frames that can wait to be encoded before the game waits for the encoder, default: 4
+video_frame_queue_depth =
+
 # Audio encoder used, default: libvorbis
 audio_encoder =
 
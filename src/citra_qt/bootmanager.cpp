@@ -17,6 +17,7 @@
 #include "common/scm_rev.h"
 #include "core/3ds.h"
 #include "core/core.h"
+#include "core/dumping/image_dumper.h"
 #include "core/frontend/scope_acquire_context.h"
 #include "core/settings.h"
 #include "input_common/keyboard.h"
@@ -45,10 +46,13 @@ void EmuThread::run() {
 
     emit LoadProgress(VideoCore::LoadCallbackStage::Prepare, 0, 0);
 
-    Core::System::GetInstance().Renderer().Rasterizer()->LoadDiskResources(
-        stop_run, [this](VideoCore::LoadCallbackStage stage, std::size_t value, std::size_t total) {
-            emit LoadProgress(stage, value, total);
-        });
+    VideoCore::RunOnGPUThread([this] {
+        Core::System::GetInstance().Renderer().Rasterizer()->LoadDiskResources(
+            stop_run,
+            [this](VideoCore::LoadCallbackStage stage, std::size_t value, std::size_t total) {
+                emit LoadProgress(stage, value, total);
+            });
+    });
 
     emit LoadProgress(VideoCore::LoadCallbackStage::Complete, 0, 0);
 
@@ -129,8 +133,8 @@ void OpenGLWindow::Present() {
         return;
 
     context->makeCurrent(this);
-    if (VideoCore::g_renderer) {
-        VideoCore::g_renderer->TryPresent(100);
+    if (auto* renderer = VideoCore::GetRenderer()) {
+        renderer->TryPresent(100);
     }
     context->swapBuffers(this);
     auto f = context->versionFunctions<QOpenGLFunctions_3_3_Core>();
@@ -413,12 +417,23 @@ void GRenderWindow::CaptureScreenshot(u32 res_scale, const QString& screenshot_p
     VideoCore::RequestScreenshot(
         screenshot_image.bits(),
         [=] {
-            const std::string std_screenshot_path = screenshot_path.toStdString();
-            if (screenshot_image.mirrored(false, true).save(screenshot_path)) {
-                LOG_INFO(Frontend, "Screenshot saved to \"{}\"", std_screenshot_path);
-            } else {
-                LOG_ERROR(Frontend, "Failed to save screenshot to \"{}\"", std_screenshot_path);
-            }
+            // Encoding is left to the image dumper, so that it does not stall rendering
+            Core::ImageDumper::Image image;
+            image.path = screenshot_path.toStdString();
+            image.pixels.assign(screenshot_image.constBits(),
+                                screenshot_image.constBits() + layout.width * layout.height * 4);
+            image.width = layout.width;
+            image.height = layout.height;
+            image.format = Core::ImageDumper::PixelFormat::BGRX8;
+            image.flip = true;
+            image.callback = [path = image.path](bool success) {
+                if (success) {
+                    LOG_INFO(Frontend, "Screenshot saved to \"{}\"", path);
+                } else {
+                    LOG_ERROR(Frontend, "Failed to save screenshot to \"{}\"", path);
+                }
+            };
+            Core::System::GetInstance().ImageDumper().Queue(std::move(image));
         },
         layout);
 }
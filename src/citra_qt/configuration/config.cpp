@@ -284,6 +284,8 @@ void Config::ReadUtilityValues() {
         ReadSetting(QStringLiteral("custom_textures"), false).toBool();
     Settings::values.preload_textures =
         ReadSetting(QStringLiteral("preload_textures"), false).toBool();
+    Settings::values.custom_textures_memory_budget =
+        ReadSetting(QStringLiteral("custom_textures_memory_budget"), 0).toUInt();
 
     qt_config->endGroup();
 }
@@ -294,6 +296,10 @@ void Config::ReadCoreValues() {
     Settings::values.use_cpu_jit = ReadSetting(QStringLiteral("use_cpu_jit"), true).toBool();
     Settings::values.cpu_clock_percentage =
         ReadSetting(QStringLiteral("cpu_clock_percentage"), 100).toInt();
+    Settings::values.enable_cpu_multithread =
+        ReadSetting(QStringLiteral("enable_cpu_multithread"), false).toBool();
+    Settings::values.skip_idle_loops =
+        ReadSetting(QStringLiteral("skip_idle_loops"), true).toBool();
 
     qt_config->endGroup();
 }
@@ -322,6 +328,8 @@ void Config::ReadDebuggingValues() {
     // Intentionally not using the QT default setting as this is intended to be changed in the ini
     Settings::values.record_frame_times =
         qt_config->value(QStringLiteral("record_frame_times"), false).toBool();
+    Settings::values.perf_breakdown_file =
+        qt_config->value(QStringLiteral("perf_breakdown_file"), QString{}).toString().toStdString();
     Settings::values.use_gdbstub = ReadSetting(QStringLiteral("use_gdbstub"), false).toBool();
     Settings::values.gdbstub_port = ReadSetting(QStringLiteral("gdbstub_port"), 24689).toInt();
 
@@ -379,6 +387,9 @@ void Config::ReadMiscellaneousValues() {
         ReadSetting(QStringLiteral("log_filter"), QStringLiteral("*:Info"))
             .toString()
             .toStdString();
+    Settings::values.log_deferred_formatting =
+        ReadSetting(QStringLiteral("log_deferred_formatting"), false).toBool();
+    Settings::values.log_binary = ReadSetting(QStringLiteral("log_binary"), false).toBool();
 
     qt_config->endGroup();
 }
@@ -488,6 +499,8 @@ void Config::ReadRendererValues() {
     Settings::values.shaders_accurate_mul =
         ReadSetting(QStringLiteral("shaders_accurate_mul"), true).toBool();
     Settings::values.use_shader_jit = ReadSetting(QStringLiteral("use_shader_jit"), true).toBool();
+    Settings::values.use_asynchronous_gpu_emulation =
+        ReadSetting(QStringLiteral("use_asynchronous_gpu_emulation"), false).toBool();
     Settings::values.use_disk_shader_cache =
         ReadSetting(QStringLiteral("use_disk_shader_cache"), true).toBool();
     Settings::values.use_vsync_new = ReadSetting(QStringLiteral("use_vsync_new"), true).toBool();
@@ -498,6 +511,10 @@ void Config::ReadRendererValues() {
         ReadSetting(QStringLiteral("use_frame_limit_alternate"), false).toBool();
     Settings::values.frame_limit_alternate =
         ReadSetting(QStringLiteral("frame_limit_alternate"), 200).toInt();
+    Settings::values.max_throughput =
+        ReadSetting(QStringLiteral("max_throughput"), false).toBool();
+    Settings::values.max_throughput_present_interval =
+        ReadSetting(QStringLiteral("max_throughput_present_interval"), 60).toInt();
 
     Settings::values.bg_red = ReadSetting(QStringLiteral("bg_red"), 0.0).toFloat();
     Settings::values.bg_green = ReadSetting(QStringLiteral("bg_green"), 0.0).toFloat();
@@ -573,6 +590,8 @@ void Config::ReadVideoDumpingValues() {
 
     Settings::values.video_bitrate =
         ReadSetting(QStringLiteral("video_bitrate"), 2500000).toULongLong();
+    Settings::values.video_frame_queue_depth =
+        ReadSetting(QStringLiteral("video_frame_queue_depth"), 4).toUInt();
 
     Settings::values.audio_encoder =
         ReadSetting(QStringLiteral("audio_encoder"), QStringLiteral("libvorbis"))
@@ -844,6 +863,8 @@ void Config::SaveUtilityValues() {
     WriteSetting(QStringLiteral("dump_textures"), Settings::values.dump_textures, false);
     WriteSetting(QStringLiteral("custom_textures"), Settings::values.custom_textures, false);
     WriteSetting(QStringLiteral("preload_textures"), Settings::values.preload_textures, false);
+    WriteSetting(QStringLiteral("custom_textures_memory_budget"),
+                 Settings::values.custom_textures_memory_budget, 0);
 
     qt_config->endGroup();
 }
@@ -854,6 +875,9 @@ void Config::SaveCoreValues() {
     WriteSetting(QStringLiteral("use_cpu_jit"), Settings::values.use_cpu_jit, true);
     WriteSetting(QStringLiteral("cpu_clock_percentage"), Settings::values.cpu_clock_percentage,
                  100);
+    WriteSetting(QStringLiteral("enable_cpu_multithread"),
+                 Settings::values.enable_cpu_multithread, false);
+    WriteSetting(QStringLiteral("skip_idle_loops"), Settings::values.skip_idle_loops, true);
 
     qt_config->endGroup();
 }
@@ -877,6 +901,8 @@ void Config::SaveDebuggingValues() {
 
     // Intentionally not using the QT default setting as this is intended to be changed in the ini
     qt_config->setValue(QStringLiteral("record_frame_times"), Settings::values.record_frame_times);
+    qt_config->setValue(QStringLiteral("perf_breakdown_file"),
+                        QString::fromStdString(Settings::values.perf_breakdown_file));
     WriteSetting(QStringLiteral("use_gdbstub"), Settings::values.use_gdbstub, false);
     WriteSetting(QStringLiteral("gdbstub_port"), Settings::values.gdbstub_port, 24689);
 
@@ -922,6 +948,9 @@ void Config::SaveMiscellaneousValues() {
 
     WriteSetting(QStringLiteral("log_filter"), QString::fromStdString(Settings::values.log_filter),
                  QStringLiteral("*:Info"));
+    WriteSetting(QStringLiteral("log_deferred_formatting"),
+                 Settings::values.log_deferred_formatting, false);
+    WriteSetting(QStringLiteral("log_binary"), Settings::values.log_binary, false);
 
     qt_config->endGroup();
 }
@@ -997,6 +1026,8 @@ void Config::SaveRendererValues() {
     WriteSetting(QStringLiteral("shaders_accurate_mul"), Settings::values.shaders_accurate_mul,
                  true);
     WriteSetting(QStringLiteral("use_shader_jit"), Settings::values.use_shader_jit, true);
+    WriteSetting(QStringLiteral("use_asynchronous_gpu_emulation"),
+                 Settings::values.use_asynchronous_gpu_emulation, false);
     WriteSetting(QStringLiteral("use_disk_shader_cache"), Settings::values.use_disk_shader_cache,
                  true);
     WriteSetting(QStringLiteral("use_vsync_new"), Settings::values.use_vsync_new, true);
@@ -1006,6 +1037,9 @@ void Config::SaveRendererValues() {
                  Settings::values.use_frame_limit_alternate, false);
     WriteSetting(QStringLiteral("frame_limit_alternate"), Settings::values.frame_limit_alternate,
                  200);
+    WriteSetting(QStringLiteral("max_throughput"), Settings::values.max_throughput, false);
+    WriteSetting(QStringLiteral("max_throughput_present_interval"),
+                 Settings::values.max_throughput_present_interval, 60);
 
     // Cast to double because Qt's written float values are not human-readable
     WriteSetting(QStringLiteral("bg_red"), (double)Settings::values.bg_red, 0.0);
@@ -1067,6 +1101,8 @@ void Config::SaveVideoDumpingValues() {
                  DEFAULT_VIDEO_ENCODER_OPTIONS);
     WriteSetting(QStringLiteral("video_bitrate"),
                  static_cast<unsigned long long>(Settings::values.video_bitrate), 2500000);
+    WriteSetting(QStringLiteral("video_frame_queue_depth"),
+                 Settings::values.video_frame_queue_depth, 4);
     WriteSetting(QStringLiteral("audio_encoder"),
                  QString::fromStdString(Settings::values.audio_encoder),
                  QStringLiteral("libvorbis"));
@@ -31,6 +31,7 @@
 #include "core/file_sys/archive_extsavedata.h"
 #include "core/file_sys/archive_source_sd_savedata.h"
 #include "core/hle/service/fs/archive.h"
+#include "core/loader/loader.h"
 
 GameListSearchField::KeyReleaseEater::KeyReleaseEater(GameList* gamelist, QObject* parent)
     : QObject(parent), gamelist{gamelist} {}
@@ -711,9 +712,14 @@ void GameList::LoadInterfaceLayout() {
     header->resizeSection(COLUMN_NAME, header->width());
 }
 
-const QStringList GameList::supported_file_extensions = {
-    QStringLiteral("3ds"), QStringLiteral("3dsx"), QStringLiteral("elf"), QStringLiteral("axf"),
-    QStringLiteral("cci"), QStringLiteral("cxi"),  QStringLiteral("app")};
+const QStringList GameList::supported_file_extensions = [] {
+    QStringList extensions;
+    for (const std::string_view extension : Loader::SupportedFileExtensions) {
+        extensions.append(
+            QString::fromLatin1(extension.data(), static_cast<int>(extension.size())));
+    }
+    return extensions;
+}();
 
 void GameList::RefreshGameDirectory() {
     if (!UISettings::values.game_dirs.isEmpty() && current_worker != nullptr) {
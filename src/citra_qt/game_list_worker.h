@@ -16,6 +16,7 @@
 #include <QVector>
 #include "citra_qt/compatibility_list.h"
 #include "common/common_types.h"
+#include "core/game_scanner.h"
 
 class QStandardItem;
 
@@ -61,4 +62,5 @@ private:
 
     QStringList watch_list;
     std::atomic_bool stop_processing;
+    Core::GameScanner scanner;
 };
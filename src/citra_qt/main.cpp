@@ -76,6 +76,8 @@
 #include "core/frontend/applets/default_applets.h"
 #include "core/frontend/scope_acquire_context.h"
 #include "core/gdbstub/gdbstub.h"
+#include "core/hle/kernel/ipc_debugger/profiler.h"
+#include "core/hle/kernel/kernel.h"
 #include "core/hle/service/fs/archive.h"
 #include "core/hle/service/nfc/nfc.h"
 #include "core/loader/loader.h"
@@ -143,6 +145,10 @@ static void InitializeLogging() {
     const std::string& log_dir = FileUtil::GetUserPath(FileUtil::UserPath::LogDir);
     FileUtil::CreateFullPath(log_dir);
     Log::AddBackend(std::make_unique<Log::FileBackend>(log_dir + LOG_FILE));
+    if (Settings::values.log_binary) {
+        Log::AddBackend(std::make_unique<Log::BinaryFileBackend>(log_dir + BINARY_LOG_FILE));
+    }
+    Log::SetDeferredFormatting(Settings::values.log_deferred_formatting);
 #ifdef _WIN32
     Log::AddBackend(std::make_unique<Log::DebuggerBackend>());
 #endif
@@ -774,6 +780,8 @@ void GMainWindow::ConnectMenuEvents() {
     });
     connect(ui->action_Capture_Screenshot, &QAction::triggered, this,
             &GMainWindow::OnCaptureScreenshot);
+    connect(ui->action_Dump_IPC_Profile, &QAction::triggered, this,
+            &GMainWindow::OnDumpIPCProfile);
 
 #ifdef ENABLE_FFMPEG_VIDEO_DUMPER
     connect(ui->action_Dump_Video, &QAction::triggered, [this] {
@@ -1158,6 +1166,7 @@ void GMainWindow::ShutdownGame() {
     ui->action_Enable_Frame_Advancing->setChecked(false);
     ui->action_Advance_Frame->setEnabled(false);
     ui->action_Capture_Screenshot->setEnabled(false);
+    ui->action_Dump_IPC_Profile->setEnabled(false);
     render_window->hide();
     loading_screen->hide();
     loading_screen->Clear();
@@ -1569,6 +1578,7 @@ void GMainWindow::OnStartGame() {
     ui->action_Report_Compatibility->setEnabled(true);
     ui->action_Enable_Frame_Advancing->setEnabled(true);
     ui->action_Capture_Screenshot->setEnabled(true);
+    ui->action_Dump_IPC_Profile->setEnabled(true);
 
     discord_rpc->Update();
 
@@ -2007,6 +2017,18 @@ void GMainWindow::OnCaptureScreenshot() {
     OnStartGame();
 }
 
+void GMainWindow::OnDumpIPCProfile() {
+    const QString path = QFileDialog::getSaveFileName(this, tr("Dump IPC Profile"), QString(),
+                                                      tr("JSON File (*.json)"));
+    if (path.isEmpty())
+        return;
+    const std::string json = Core::System::GetInstance().Kernel().GetIPCProfiler().DumpJson();
+    if (FileUtil::WriteStringToFile(true, path.toStdString(), json) != json.size()) {
+        QMessageBox::critical(this, tr("Dump IPC Profile"),
+                              tr("Could not write the IPC profile to %1.").arg(path));
+    }
+}
+
 #ifdef ENABLE_FFMPEG_VIDEO_DUMPER
 void GMainWindow::OnStartVideoDumping() {
     DumpingDialog dialog(this);
@@ -6,6 +6,8 @@
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <cstring>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <regex>
@@ -17,15 +19,42 @@
 #else
 #define _SH_DENYWR 0
 #endif
+#if __has_include(<fmt/args.h>)
+#include <fmt/args.h>
+#endif
 #include "common/assert.h"
 #include "common/logging/backend.h"
+#include "common/logging/binary_log.h"
 #include "common/logging/log.h"
 #include "common/logging/text_formatter.h"
+#include "common/ring_buffer.h"
 #include "common/string_util.h"
 #include "common/threadsafe_queue.h"
 
 namespace Log {
 
+namespace {
+
+/// Deferred records written by a single thread, read by the logging thread.
+struct DeferredRing {
+    Common::RingBuffer<Detail::DeferredRecord, 1024> records;
+    /// Set once the owning thread has exited and will not push any more records.
+    std::atomic_bool orphaned{false};
+};
+
+/// Thread-local owner of the calling thread's ring.
+struct ThreadRingHandle {
+    std::shared_ptr<DeferredRing> ring;
+
+    ~ThreadRingHandle() {
+        if (ring) {
+            ring->orphaned = true;
+        }
+    }
+};
+
+} // Anonymous namespace
+
 /**
  * Static state as a singleton.
  */
@@ -45,6 +74,25 @@ public:
             CreateEntry(log_class, log_level, filename, line_num, function, std::move(message)));
     }
 
+    bool PushDeferred(Detail::DeferredRecord& record) {
+        thread_local ThreadRingHandle handle;
+        if (!handle.ring) {
+            handle.ring = std::make_shared<DeferredRing>();
+            std::lock_guard lock{rings_mutex};
+            deferred_rings.push_back(handle.ring);
+        }
+        record.timestamp = GetTimestamp().count();
+        return handle.ring->records.Push(&record, 1) == 1;
+    }
+
+    bool IsDeferredFormattingEnabled() const {
+        return deferred_formatting.load(std::memory_order_relaxed);
+    }
+
+    void SetDeferredFormatting(bool enabled) {
+        deferred_formatting = enabled;
+    }
+
     void AddBackend(std::unique_ptr<Backend> backend) {
         std::lock_guard lock{writing_mutex};
         backends.push_back(std::move(backend));
@@ -78,28 +126,57 @@ public:
 private:
     Impl() {
         backend_thread = std::thread([&] {
-            Entry entry;
+            std::vector<Entry> batch;
             auto write_logs = [&](Entry& e) {
                 std::lock_guard lock{writing_mutex};
+                const bool needs_message = std::any_of(
+                    backends.begin(), backends.end(),
+                    [](const auto& backend) { return backend->NeedsFormattedMessage(); });
+                if (needs_message) {
+                    FormatDeferredEntry(e);
+                }
                 for (const auto& backend : backends) {
                     backend->Write(e);
                 }
             };
+            // Gathers pending entries from both the queue and the per-thread rings, and writes
+            // them in timestamp order. Returns false once the final entry has been seen.
+            auto write_batch = [&](std::size_t max_entries) {
+                bool running = true;
+                Entry entry;
+                while (batch.size() < max_entries && message_queue.Pop(entry)) {
+                    if (entry.final_entry) {
+                        running = false;
+                        break;
+                    }
+                    batch.push_back(std::move(entry));
+                }
+                DrainDeferredRecords(batch, max_entries);
+                std::stable_sort(batch.begin(), batch.end(), [](const Entry& a, const Entry& b) {
+                    return a.timestamp < b.timestamp;
+                });
+                for (auto& e : batch) {
+                    write_logs(e);
+                }
+                batch.clear();
+                return running;
+            };
+
+            constexpr std::size_t MAX_BATCH_SIZE = 4096;
             while (true) {
-                entry = message_queue.PopWait();
-                if (entry.final_entry) {
+                // Deferred records do not wake this thread up, so they are polled for.
+                const auto timeout = IsDeferredFormattingEnabled() ? std::chrono::milliseconds{5}
+                                                                   : std::chrono::milliseconds{100};
+                message_queue.WaitFor(timeout);
+                if (!write_batch(MAX_BATCH_SIZE)) {
                     break;
                 }
-                write_logs(entry);
             }
 
             // Drain the logging queue. Only writes out up to MAX_LOGS_TO_WRITE to prevent a case
             // where a system is repeatedly spamming logs even on close.
-            constexpr int MAX_LOGS_TO_WRITE = 100;
-            int logs_written = 0;
-            while (logs_written++ < MAX_LOGS_TO_WRITE && message_queue.Pop(entry)) {
-                write_logs(entry);
-            }
+            constexpr std::size_t MAX_LOGS_TO_WRITE = 100;
+            write_batch(MAX_LOGS_TO_WRITE);
         });
     }
 
@@ -110,14 +187,46 @@ private:
         backend_thread.join();
     }
 
-    Entry CreateEntry(Class log_class, Level log_level, const char* filename, unsigned int line_nr,
-                      const char* function, std::string message) const {
+    std::chrono::microseconds GetTimestamp() const {
         using std::chrono::duration_cast;
         using std::chrono::steady_clock;
+        return duration_cast<std::chrono::microseconds>(steady_clock::now() - time_origin);
+    }
+
+    void DrainDeferredRecords(std::vector<Entry>& out, std::size_t max_entries) {
+        std::lock_guard lock{rings_mutex};
+        Detail::DeferredRecord record;
+        for (const auto& ring : deferred_rings) {
+            while (out.size() < max_entries && ring->records.Pop(&record, 1) == 1) {
+                out.push_back(CreateDeferredEntry(record));
+            }
+        }
+
+        // Forget the rings of exited threads once they have been emptied.
+        const auto it = std::remove_if(deferred_rings.begin(), deferred_rings.end(),
+                                       [](const auto& ring) {
+                                           return ring->orphaned && ring->records.Size() == 0;
+                                       });
+        deferred_rings.erase(it, deferred_rings.end());
+    }
+
+    Entry CreateDeferredEntry(const Detail::DeferredRecord& record) const {
+        Entry entry;
+        entry.timestamp = std::chrono::microseconds{record.timestamp};
+        entry.log_class = record.log_class;
+        entry.log_level = record.log_level;
+        entry.filename = record.filename;
+        entry.line_num = record.line_num;
+        entry.function = record.function;
+        entry.format = record.format;
+        entry.args.assign(record.args.begin(), record.args.begin() + record.args_size);
+        return entry;
+    }
 
+    Entry CreateEntry(Class log_class, Level log_level, const char* filename, unsigned int line_nr,
+                      const char* function, std::string message) const {
         Entry entry;
-        entry.timestamp =
-            duration_cast<std::chrono::microseconds>(steady_clock::now() - time_origin);
+        entry.timestamp = GetTimestamp();
         entry.log_class = log_class;
         entry.log_level = log_level;
         entry.filename = filename;
@@ -132,6 +241,9 @@ private:
     std::thread backend_thread;
     std::vector<std::unique_ptr<Backend>> backends;
     Common::MPSCQueue<Log::Entry> message_queue;
+    std::mutex rings_mutex;
+    std::vector<std::shared_ptr<DeferredRing>> deferred_rings;
+    std::atomic_bool deferred_formatting{false};
     Filter filter;
     std::chrono::steady_clock::time_point time_origin{std::chrono::steady_clock::now()};
 };
@@ -170,6 +282,76 @@ void FileBackend::Write(const Entry& entry) {
     }
 }
 
+BinaryFileBackend::BinaryFileBackend(const std::string& filename) {
+    if (FileUtil::Exists(filename + ".old")) {
+        FileUtil::Delete(filename + ".old");
+    }
+    if (FileUtil::Exists(filename)) {
+        FileUtil::Rename(filename, filename + ".old");
+    }
+
+    file = FileUtil::IOFile(filename, "wb", _SH_DENYWR);
+    file.WriteArray(BinaryLog::Magic.data(), BinaryLog::Magic.size());
+    file.WriteObject(BinaryLog::Version);
+}
+
+template <typename T>
+static void AppendValue(std::vector<u8>& buffer, const T& value) {
+    const auto* bytes = reinterpret_cast<const u8*>(&value);
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+u32 BinaryFileBackend::GetStringId(std::string_view str) {
+    str = str.substr(0, std::numeric_limits<u16>::max());
+    const auto [it, inserted] =
+        string_ids.emplace(std::string(str), static_cast<u32>(string_ids.size()));
+    if (inserted) {
+        AppendValue(buffer, BinaryLog::RecordType::String);
+        AppendValue(buffer, it->second);
+        AppendValue(buffer, static_cast<u16>(str.size()));
+        buffer.insert(buffer.end(), str.begin(), str.end());
+    }
+    return it->second;
+}
+
+void BinaryFileBackend::Write(const Entry& entry) {
+    // Same limit as the text log, although the binary form fits a lot more entries in it.
+    constexpr std::size_t MAX_BYTES_WRITTEN = 50 * 1024L * 1024L;
+    if (!file.IsOpen() || bytes_written > MAX_BYTES_WRITTEN) {
+        return;
+    }
+
+    buffer.clear();
+    const u32 filename_id = GetStringId(entry.filename);
+    const u32 function_id = GetStringId(entry.function);
+    const u32 format_id = GetStringId(entry.format ? entry.format : "{}");
+
+    AppendValue(buffer, BinaryLog::RecordType::Entry);
+    AppendValue(buffer, static_cast<u64>(entry.timestamp.count()));
+    AppendValue(buffer, entry.log_class);
+    AppendValue(buffer, entry.log_level);
+    AppendValue(buffer, static_cast<u32>(entry.line_num));
+    AppendValue(buffer, filename_id);
+    AppendValue(buffer, function_id);
+    AppendValue(buffer, format_id);
+    if (entry.format) {
+        AppendValue(buffer, static_cast<u32>(entry.args.size()));
+        buffer.insert(buffer.end(), entry.args.begin(), entry.args.end());
+    } else {
+        const std::string_view message =
+            std::string_view(entry.message).substr(0, std::numeric_limits<u16>::max());
+        AppendValue(buffer, static_cast<u32>(1 + sizeof(u16) + message.size()));
+        AppendValue(buffer, Detail::ArgType::String);
+        AppendValue(buffer, static_cast<u16>(message.size()));
+        buffer.insert(buffer.end(), message.begin(), message.end());
+    }
+
+    bytes_written += file.WriteBytes(buffer.data(), buffer.size());
+    if (entry.log_level >= Level::Error) {
+        file.Flush();
+    }
+}
+
 void DebuggerBackend::Write(const Entry& entry) {
 #ifdef _WIN32
     ::OutputDebugStringW(Common::UTF8ToUTF16W(FormatLogMessage(entry).append(1, '\n')).c_str());
@@ -283,6 +465,99 @@ const char* GetLevelName(Level log_level) {
     return "Invalid";
 }
 
+std::string FormatDeferredMessage(std::string_view format, const u8* args, std::size_t args_size) {
+    fmt::dynamic_format_arg_store<fmt::format_context> store;
+    std::size_t offset = 0;
+    const auto read = [&](auto& value) {
+        if (offset + sizeof(value) > args_size) {
+            return false;
+        }
+        std::memcpy(&value, args + offset, sizeof(value));
+        offset += sizeof(value);
+        return true;
+    };
+
+    while (offset < args_size) {
+        const auto type = static_cast<Detail::ArgType>(args[offset++]);
+        bool ok = false;
+        switch (type) {
+        case Detail::ArgType::Bool: {
+            u8 value;
+            if ((ok = read(value))) {
+                store.push_back(value != 0);
+            }
+            break;
+        }
+        case Detail::ArgType::Char: {
+            char value;
+            if ((ok = read(value))) {
+                store.push_back(value);
+            }
+            break;
+        }
+        case Detail::ArgType::Signed: {
+            s64 value;
+            if ((ok = read(value))) {
+                store.push_back(value);
+            }
+            break;
+        }
+        case Detail::ArgType::Unsigned: {
+            u64 value;
+            if ((ok = read(value))) {
+                store.push_back(value);
+            }
+            break;
+        }
+        case Detail::ArgType::Float: {
+            float value;
+            if ((ok = read(value))) {
+                store.push_back(value);
+            }
+            break;
+        }
+        case Detail::ArgType::Double: {
+            double value;
+            if ((ok = read(value))) {
+                store.push_back(value);
+            }
+            break;
+        }
+        case Detail::ArgType::String: {
+            u16 length;
+            if ((ok = read(length) && offset + length <= args_size)) {
+                store.push_back(std::string(reinterpret_cast<const char*>(args + offset), length));
+                offset += length;
+            }
+            break;
+        }
+        case Detail::ArgType::Pointer: {
+            u64 value;
+            if ((ok = read(value))) {
+                store.push_back(reinterpret_cast<const void*>(static_cast<std::uintptr_t>(value)));
+            }
+            break;
+        }
+        }
+        if (!ok) {
+            return fmt::format("<malformed log arguments> {}", format);
+        }
+    }
+
+    try {
+        return fmt::vformat(format, store);
+    } catch (const fmt::format_error& e) {
+        return fmt::format("<format error: {}> {}", e.what(), format);
+    }
+}
+
+void FormatDeferredEntry(Entry& entry) {
+    if (entry.format == nullptr || !entry.message.empty()) {
+        return;
+    }
+    entry.message = FormatDeferredMessage(entry.format, entry.args.data(), entry.args.size());
+}
+
 void SetGlobalFilter(const Filter& filter) {
     Impl::Instance().SetGlobalFilter(filter);
 }
@@ -299,6 +574,31 @@ Backend* GetBackend(std::string_view backend_name) {
     return Impl::Instance().GetBackend(backend_name);
 }
 
+void SetDeferredFormatting(bool enabled) {
+    Impl::Instance().SetDeferredFormatting(enabled);
+}
+
+namespace Detail {
+
+bool ShouldDefer(Class log_class, Level log_level) {
+    auto& instance = Impl::Instance();
+    return instance.IsDeferredFormattingEnabled() &&
+           instance.GetGlobalFilter().CheckMessage(log_class, log_level);
+}
+
+bool PushDeferred(DeferredRecord& record, Class log_class, Level log_level, const char* filename,
+                  unsigned int line_num, const char* function, const char* format) {
+    record.log_class = log_class;
+    record.log_level = log_level;
+    record.filename = filename;
+    record.line_num = line_num;
+    record.function = function;
+    record.format = format;
+    return Impl::Instance().PushDeferred(record);
+}
+
+} // namespace Detail
+
 void FmtLogMessageImpl(Class log_class, Level log_level, const char* filename,
                        unsigned int line_num, const char* function, const char* format,
                        const fmt::format_args& args) {
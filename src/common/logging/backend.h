@@ -8,6 +8,8 @@
 #include <memory>
 #include <string>
 #include <string_view>
+#include <unordered_map>
+#include <vector>
 #include "common/file_util.h"
 #include "common/logging/filter.h"
 #include "common/logging/log.h"
@@ -28,6 +30,10 @@ struct Entry {
     unsigned int line_num;
     std::string function;
     std::string message;
+    /// Format string and encoded arguments of entries logged with deferred formatting. `message`
+    /// stays empty until FormatDeferredEntry is called on them.
+    const char* format = nullptr;
+    std::vector<u8> args;
     bool final_entry = false;
 
     Entry() = default;
@@ -49,6 +55,11 @@ public:
     }
     virtual const char* GetName() const = 0;
     virtual void Write(const Entry& entry) = 0;
+    /// Whether this backend reads Entry::message. If no backend does, deferred entries are never
+    /// formatted.
+    virtual bool NeedsFormattedMessage() const {
+        return true;
+    }
 
 private:
     Filter filter;
@@ -105,6 +116,38 @@ private:
     std::size_t bytes_written;
 };
 
+/**
+ * Backend that writes entries in a compact binary form, without formatting deferred entries. The
+ * resulting file can be turned back into text with BinaryLogReader (see binary_log.h).
+ */
+class BinaryFileBackend : public Backend {
+public:
+    explicit BinaryFileBackend(const std::string& filename);
+
+    static const char* Name() {
+        return "binary_file";
+    }
+
+    const char* GetName() const override {
+        return Name();
+    }
+
+    bool NeedsFormattedMessage() const override {
+        return false;
+    }
+
+    void Write(const Entry& entry) override;
+
+private:
+    /// Returns the id of `str` in the file's string table, emitting a definition if it is new.
+    u32 GetStringId(std::string_view str);
+
+    FileUtil::IOFile file;
+    std::size_t bytes_written = 0;
+    std::unordered_map<std::string, u32> string_ids;
+    std::vector<u8> buffer;
+};
+
 /**
  * Backend that writes to Visual Studio's output window
  */
@@ -136,6 +179,15 @@ const char* GetLogClassName(Class log_class);
  */
 const char* GetLevelName(Level log_level);
 
+/**
+ * Formats a message from its format string and arguments encoded as in Detail::DeferredRecord.
+ * Malformed argument data or format strings produce a placeholder message instead.
+ */
+std::string FormatDeferredMessage(std::string_view format, const u8* args, std::size_t args_size);
+
+/// Fills in the message of an entry logged with deferred formatting. No-op for other entries.
+void FormatDeferredEntry(Entry& entry);
+
 /**
  * The global filter will prevent any messages from even being processed if they are filtered. Each
  * backend can have a filter, but if the level is lower than the global filter, the backend will
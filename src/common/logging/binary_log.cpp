@@ -0,0 +1,75 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include "common/logging/binary_log.h"
+
+namespace Log::BinaryLog {
+
+Reader::Reader(const std::string& filename) : file(filename, "rb") {
+    std::array<char, 4> magic{};
+    u32 version = 0;
+    valid = file.IsOpen() && file.ReadArray(magic.data(), magic.size()) == magic.size() &&
+            magic == Magic && Read(version) && version == Version;
+}
+
+const char* Reader::GetString(u32 id) const {
+    const auto it = strings.find(id);
+    return it == strings.end() ? "" : it->second.c_str();
+}
+
+std::optional<Entry> Reader::ReadEntry() {
+    if (!valid) {
+        return std::nullopt;
+    }
+
+    RecordType type;
+    while (Read(type)) {
+        if (type == RecordType::String) {
+            u32 id;
+            u16 length;
+            if (!Read(id) || !Read(length)) {
+                return std::nullopt;
+            }
+            std::string str(length, '\0');
+            if (file.ReadBytes(str.data(), length) != length) {
+                return std::nullopt;
+            }
+            strings[id] = std::move(str);
+            continue;
+        }
+
+        if (type != RecordType::Entry) {
+            return std::nullopt;
+        }
+
+        u64 timestamp;
+        u32 line_num, filename_id, function_id, format_id, args_size;
+        Entry entry;
+        if (!Read(timestamp) || !Read(entry.log_class) || !Read(entry.log_level) ||
+            !Read(line_num) || !Read(filename_id) || !Read(function_id) || !Read(format_id) ||
+            !Read(args_size)) {
+            return std::nullopt;
+        }
+        if (entry.log_class >= Class::Count || entry.log_level >= Level::Count) {
+            return std::nullopt;
+        }
+
+        entry.args.resize(args_size);
+        if (file.ReadBytes(entry.args.data(), args_size) != args_size) {
+            return std::nullopt;
+        }
+
+        entry.timestamp = std::chrono::microseconds{timestamp};
+        entry.line_num = line_num;
+        entry.filename = GetString(filename_id);
+        entry.function = GetString(function_id);
+        entry.format = GetString(format_id);
+        FormatDeferredEntry(entry);
+        return entry;
+    }
+    return std::nullopt;
+}
+
+} // namespace Log::BinaryLog
@@ -0,0 +1,64 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include "common/common_types.h"
+#include "common/file_util.h"
+#include "common/logging/backend.h"
+
+/**
+ * Binary log file format written by BinaryFileBackend.
+ *
+ * The file starts with `Magic` followed by a u32 `Version`, then contains a sequence of records,
+ * each starting with a RecordType byte. All integers are little-endian.
+ *
+ *  - String: u32 id, u16 length, characters. Defines an entry of the string table.
+ *  - Entry:  u64 timestamp (us), u8 class, u8 level, u32 line, u32 filename id, u32 function id,
+ *            u32 format id, u32 args size, encoded arguments (see Log::Detail::ArgType).
+ *
+ * Entries that were formatted immediately are stored with the format "{}" and the message as
+ * their only argument.
+ */
+namespace Log::BinaryLog {
+
+constexpr std::array<char, 4> Magic{'C', 'L', 'O', 'G'};
+constexpr u32 Version = 1;
+
+enum class RecordType : u8 {
+    String = 0,
+    Entry = 1,
+};
+
+/// Reads back the entries of a file written by BinaryFileBackend, formatting their messages.
+class Reader {
+public:
+    explicit Reader(const std::string& filename);
+
+    /// Returns whether the file was opened and has a valid header.
+    bool IsValid() const {
+        return valid;
+    }
+
+    /// Reads the next entry. Returns std::nullopt at the end of the file or on corrupted data.
+    std::optional<Entry> ReadEntry();
+
+private:
+    template <typename T>
+    bool Read(T& value) {
+        return file.ReadBytes(&value, sizeof(T)) == sizeof(T);
+    }
+
+    const char* GetString(u32 id) const;
+
+    FileUtil::IOFile file;
+    bool valid = false;
+    std::unordered_map<u32, std::string> strings;
+};
+
+} // namespace Log::BinaryLog
@@ -4,6 +4,12 @@
 
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
 #include <fmt/format.h>
 #include "common/common_types.h"
 
@@ -125,33 +131,171 @@ void FmtLogMessage(Class log_class, Level log_level, const char* filename, unsig
                       fmt::make_format_args(args...));
 }
 
+/**
+ * Enables or disables deferred formatting. When enabled, messages logged through the LOG_* macros
+ * whose arguments are all plain values or strings are captured in binary form into a per-thread
+ * ring buffer, and only formatted on the logging thread.
+ */
+void SetDeferredFormatting(bool enabled);
+
+namespace Detail {
+
+/// Type tags of the arguments encoded in a DeferredRecord.
+enum class ArgType : u8 {
+    Bool,
+    Char,
+    Signed,   ///< Stored as s64
+    Unsigned, ///< Stored as u64
+    Float,
+    Double,
+    String,  ///< Stored as a u16 length followed by the characters
+    Pointer, ///< Stored as u64
+};
+
+/// A log message captured with its arguments, before formatting.
+struct DeferredRecord {
+    static constexpr std::size_t ArgBufferSize = 208;
+
+    u64 timestamp;
+    const char* filename;
+    const char* function;
+    const char* format;
+    u32 line_num;
+    Class log_class;
+    Level log_level;
+    u16 args_size;
+    std::array<u8, ArgBufferSize> args;
+};
+static_assert(std::is_trivial_v<DeferredRecord>);
+
+template <typename T>
+constexpr bool IsDeferrableArg =
+    (std::is_arithmetic_v<T> && !std::is_same_v<T, long double> &&
+     (!std::is_integral_v<T> || sizeof(T) <= sizeof(u64))) ||
+    std::is_same_v<T, const char*> || std::is_same_v<T, char*> ||
+    std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view> ||
+    std::is_same_v<T, const void*> || std::is_same_v<T, void*>;
+
+inline bool EncodeBytes(DeferredRecord& record, ArgType type, const void* data, std::size_t size) {
+    if (record.args_size + 1 + size > DeferredRecord::ArgBufferSize) {
+        return false;
+    }
+    record.args[record.args_size] = static_cast<u8>(type);
+    std::memcpy(&record.args[record.args_size + 1], data, size);
+    record.args_size += static_cast<u16>(1 + size);
+    return true;
+}
+
+inline bool EncodeString(DeferredRecord& record, std::string_view str) {
+    const std::size_t size = sizeof(u16) + str.size();
+    if (record.args_size + 1 + size > DeferredRecord::ArgBufferSize) {
+        return false;
+    }
+    const u16 length = static_cast<u16>(str.size());
+    u8* out = &record.args[record.args_size];
+    out[0] = static_cast<u8>(ArgType::String);
+    std::memcpy(out + 1, &length, sizeof(length));
+    std::memcpy(out + 1 + sizeof(length), str.data(), str.size());
+    record.args_size += static_cast<u16>(1 + size);
+    return true;
+}
+
+/// Appends `arg` to the record. Returns false if it does not fit.
+template <typename T>
+bool EncodeArg(DeferredRecord& record, const T& arg) {
+    using D = std::decay_t<T>;
+    if constexpr (std::is_same_v<D, bool>) {
+        return EncodeBytes(record, ArgType::Bool, &arg, sizeof(bool));
+    } else if constexpr (std::is_same_v<D, char>) {
+        return EncodeBytes(record, ArgType::Char, &arg, sizeof(char));
+    } else if constexpr (std::is_same_v<D, float>) {
+        return EncodeBytes(record, ArgType::Float, &arg, sizeof(float));
+    } else if constexpr (std::is_same_v<D, double>) {
+        return EncodeBytes(record, ArgType::Double, &arg, sizeof(double));
+    } else if constexpr (std::is_integral_v<D> && std::is_signed_v<D>) {
+        const s64 value = arg;
+        return EncodeBytes(record, ArgType::Signed, &value, sizeof(value));
+    } else if constexpr (std::is_integral_v<D>) {
+        const u64 value = arg;
+        return EncodeBytes(record, ArgType::Unsigned, &value, sizeof(value));
+    } else if constexpr (std::is_same_v<D, const char*> || std::is_same_v<D, char*>) {
+        const char* str = arg;
+        // Let fmt report null strings on the calling thread, as it would without deferral.
+        return str != nullptr && EncodeString(record, str);
+    } else if constexpr (std::is_same_v<D, std::string> || std::is_same_v<D, std::string_view>) {
+        return EncodeString(record, arg);
+    } else {
+        const u64 value = reinterpret_cast<std::uintptr_t>(arg);
+        return EncodeBytes(record, ArgType::Pointer, &value, sizeof(value));
+    }
+}
+
+/// Returns true if deferred formatting is enabled and the message passes the global filter.
+bool ShouldDefer(Class log_class, Level log_level);
+
+/// Timestamps the record and pushes it to the calling thread's ring. Returns false if it is full.
+bool PushDeferred(DeferredRecord& record, Class log_class, Level log_level, const char* filename,
+                  unsigned int line_num, const char* function, const char* format);
+
+} // namespace Detail
+
+/**
+ * Same as FmtLogMessage, but formatting may be deferred to the logging thread. `filename`,
+ * `function` and `format` must have static storage duration, as the string literals used by the
+ * LOG_* macros do. Arguments of other types fall back to immediate formatting.
+ */
+template <typename... Args>
+void FmtLogMessageDeferrable(Class log_class, Level log_level, const char* filename,
+                             unsigned int line_num, const char* function, const char* format,
+                             const Args&... args) {
+    if constexpr ((Detail::IsDeferrableArg<std::decay_t<Args>> && ...)) {
+        if (Detail::ShouldDefer(log_class, log_level)) {
+            Detail::DeferredRecord record;
+            record.args_size = 0;
+            if ((Detail::EncodeArg(record, args) && ...) &&
+                Detail::PushDeferred(record, log_class, log_level, filename, line_num, function,
+                                     format)) {
+                return;
+            }
+        }
+    }
+    FmtLogMessageImpl(log_class, log_level, filename, line_num, function, format,
+                      fmt::make_format_args(args...));
+}
+
 } // namespace Log
 
 // Define the fmt lib macros
 #define LOG_GENERIC(log_class, log_level, ...)                                                     \
-    ::Log::FmtLogMessage(log_class, log_level, ::Log::TrimSourcePath(__FILE__), __LINE__,          \
-                         __func__, __VA_ARGS__)
+    ::Log::FmtLogMessageDeferrable(log_class, log_level, ::Log::TrimSourcePath(__FILE__),          \
+                                   __LINE__, __func__, __VA_ARGS__)
 
 #ifdef _DEBUG
 #define LOG_TRACE(log_class, ...)                                                                  \
-    ::Log::FmtLogMessage(::Log::Class::log_class, ::Log::Level::Trace,                             \
-                         ::Log::TrimSourcePath(__FILE__), __LINE__, __func__, __VA_ARGS__)
+    ::Log::FmtLogMessageDeferrable(::Log::Class::log_class, ::Log::Level::Trace,                   \
+                                   ::Log::TrimSourcePath(__FILE__), __LINE__, __func__,            \
+                                   __VA_ARGS__)
 #else
 #define LOG_TRACE(log_class, fmt, ...) (void(0))
 #endif
 
 #define LOG_DEBUG(log_class, ...)                                                                  \
-    ::Log::FmtLogMessage(::Log::Class::log_class, ::Log::Level::Debug,                             \
-                         ::Log::TrimSourcePath(__FILE__), __LINE__, __func__, __VA_ARGS__)
+    ::Log::FmtLogMessageDeferrable(::Log::Class::log_class, ::Log::Level::Debug,                   \
+                                   ::Log::TrimSourcePath(__FILE__), __LINE__, __func__,            \
+                                   __VA_ARGS__)
 #define LOG_INFO(log_class, ...)                                                                   \
-    ::Log::FmtLogMessage(::Log::Class::log_class, ::Log::Level::Info,                              \
-                         ::Log::TrimSourcePath(__FILE__), __LINE__, __func__, __VA_ARGS__)
+    ::Log::FmtLogMessageDeferrable(::Log::Class::log_class, ::Log::Level::Info,                    \
+                                   ::Log::TrimSourcePath(__FILE__), __LINE__, __func__,            \
+                                   __VA_ARGS__)
 #define LOG_WARNING(log_class, ...)                                                                \
-    ::Log::FmtLogMessage(::Log::Class::log_class, ::Log::Level::Warning,                           \
-                         ::Log::TrimSourcePath(__FILE__), __LINE__, __func__, __VA_ARGS__)
+    ::Log::FmtLogMessageDeferrable(::Log::Class::log_class, ::Log::Level::Warning,                 \
+                                   ::Log::TrimSourcePath(__FILE__), __LINE__, __func__,            \
+                                   __VA_ARGS__)
 #define LOG_ERROR(log_class, ...)                                                                  \
-    ::Log::FmtLogMessage(::Log::Class::log_class, ::Log::Level::Error,                             \
-                         ::Log::TrimSourcePath(__FILE__), __LINE__, __func__, __VA_ARGS__)
+    ::Log::FmtLogMessageDeferrable(::Log::Class::log_class, ::Log::Level::Error,                   \
+                                   ::Log::TrimSourcePath(__FILE__), __LINE__, __func__,            \
+                                   __VA_ARGS__)
 #define LOG_CRITICAL(log_class, ...)                                                               \
-    ::Log::FmtLogMessage(::Log::Class::log_class, ::Log::Level::Critical,                          \
-                         ::Log::TrimSourcePath(__FILE__), __LINE__, __func__, __VA_ARGS__)
+    ::Log::FmtLogMessageDeferrable(::Log::Class::log_class, ::Log::Level::Critical,                \
+                                   ::Log::TrimSourcePath(__FILE__), __LINE__, __func__,            \
+                                   __VA_ARGS__)
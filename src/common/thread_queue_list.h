@@ -7,32 +7,33 @@
 #include <algorithm>
 #include <array>
 #include <deque>
+#include <vector>
 #include <boost/serialization/deque.hpp>
 #include <boost/serialization/split_member.hpp>
+#include "common/bit_set.h"
 #include "common/common_types.h"
 
 namespace Common {
 
+/**
+ * Ready queue of the kernel scheduler: one FIFO of threads per priority level, where lower levels
+ * are scheduled first.
+ *
+ * A bitmap of the non-empty levels makes finding the next thread a count-trailing-zeros per 64
+ * levels instead of a walk over the levels. Each level is a circular buffer, which only allocates
+ * when it grows past its largest size so far.
+ */
 template <class T, unsigned int N>
 struct ThreadQueueList {
-    // TODO(yuriks): If performance proves to be a problem, the std::deques can be replaced with
-    //               (dynamically resizable) circular buffers to remove their overhead when
-    //               inserting and popping.
-
     using Priority = unsigned int;
 
     // Number of priority levels. (Valid levels are [0..NUM_QUEUES).)
     static constexpr Priority NUM_QUEUES = N;
 
-    ThreadQueueList() {
-        first = nullptr;
-    }
-
     // Only for debugging, returns priority level.
     [[nodiscard]] Priority contains(const T& uid) const {
         for (Priority i = 0; i < NUM_QUEUES; ++i) {
-            const Queue& cur = queues[i];
-            if (std::find(cur.data.cbegin(), cur.data.cend(), uid) != cur.data.cend()) {
+            if (queues[i].Find(uid) != Queue::NotFound) {
                 return i;
             }
         }
@@ -41,54 +42,40 @@ struct ThreadQueueList {
     }
 
     [[nodiscard]] T get_first() const {
-        const Queue* cur = first;
-        while (cur != nullptr) {
-            if (!cur->data.empty()) {
-                return cur->data.front();
-            }
-            cur = cur->next_nonempty;
+        const Priority priority = FirstNonEmpty();
+        if (priority == NUM_QUEUES) {
+            return T();
         }
-
-        return T();
+        return queues[priority].Front();
     }
 
     T pop_first() {
-        Queue* cur = first;
-        while (cur != nullptr) {
-            if (!cur->data.empty()) {
-                auto tmp = std::move(cur->data.front());
-                cur->data.pop_front();
-                return tmp;
-            }
-            cur = cur->next_nonempty;
-        }
-
-        return T();
+        return pop_first_better(NUM_QUEUES);
     }
 
+    /// Pops the first thread of a level lower than the given one, if there is any
     T pop_first_better(Priority priority) {
-        Queue* cur = first;
-        Queue* stop = &queues[priority];
-        while (cur < stop) {
-            if (!cur->data.empty()) {
-                auto tmp = std::move(cur->data.front());
-                cur->data.pop_front();
-                return tmp;
-            }
-            cur = cur->next_nonempty;
+        const Priority first = FirstNonEmpty();
+        if (first >= priority) {
+            return T();
         }
 
-        return T();
+        Queue& cur = queues[first];
+        T tmp = cur.PopFront();
+        if (cur.Empty()) {
+            SetNonEmpty(first, false);
+        }
+        return tmp;
     }
 
     void push_front(Priority priority, const T& thread_id) {
-        Queue* cur = &queues[priority];
-        cur->data.push_front(thread_id);
+        queues[priority].PushFront(thread_id);
+        SetNonEmpty(priority, true);
     }
 
     void push_back(Priority priority, const T& thread_id) {
-        Queue* cur = &queues[priority];
-        cur->data.push_back(thread_id);
+        queues[priority].PushBack(thread_id);
+        SetNonEmpty(priority, true);
     }
 
     void move(const T& thread_id, Priority old_priority, Priority new_priority) {
@@ -98,110 +85,212 @@ struct ThreadQueueList {
     }
 
     void remove(Priority priority, const T& thread_id) {
-        Queue* const cur = &queues[priority];
-        const auto iter = std::remove(cur->data.begin(), cur->data.end(), thread_id);
-        cur->data.erase(iter, cur->data.end());
+        Queue& cur = queues[priority];
+        cur.Remove(thread_id);
+        if (cur.Empty()) {
+            SetNonEmpty(priority, false);
+        }
     }
 
     void rotate(Priority priority) {
-        Queue* cur = &queues[priority];
-
-        if (cur->data.size() > 1) {
-            cur->data.push_back(std::move(cur->data.front()));
-            cur->data.pop_front();
-        }
+        queues[priority].Rotate();
     }
 
     void clear() {
-        queues.fill(Queue());
-        first = nullptr;
+        for (Queue& queue : queues) {
+            queue.Clear();
+        }
+        non_empty.fill(0);
+        used.fill(0);
     }
 
     [[nodiscard]] bool empty(Priority priority) const {
-        const Queue* cur = &queues[priority];
-        return cur->data.empty();
+        return queues[priority].Empty();
     }
 
+    /// Marks a level as used. Only kept so that save states record the same levels as before.
     void prepare(Priority priority) {
-        Queue* cur = &queues[priority];
-        if (cur->next_nonempty == UnlinkedTag())
-            link(priority);
+        used[priority / 64] |= u64(1) << (priority % 64);
     }
 
 private:
-    struct Queue {
-        // Points to the next active priority, skipping over ones that have never been used.
-        Queue* next_nonempty = UnlinkedTag();
-        // Double-ended queue of threads in this priority level
-        std::deque<T> data;
-    };
+    /// Circular buffer of threads, with a power-of-two capacity
+    class Queue {
+    public:
+        static constexpr std::size_t NotFound = ~std::size_t(0);
 
-    /// Special tag used to mark priority levels that have never been used.
-    static Queue* UnlinkedTag() {
-        return reinterpret_cast<Queue*>(1);
-    }
+        [[nodiscard]] bool Empty() const {
+            return size == 0;
+        }
+
+        [[nodiscard]] std::size_t Size() const {
+            return size;
+        }
+
+        [[nodiscard]] const T& Front() const {
+            return data[head];
+        }
+
+        [[nodiscard]] const T& At(std::size_t i) const {
+            return data[(head + i) & Mask()];
+        }
+
+        [[nodiscard]] std::size_t Find(const T& value) const {
+            for (std::size_t i = 0; i < size; ++i) {
+                if (At(i) == value) {
+                    return i;
+                }
+            }
+            return NotFound;
+        }
+
+        void PushBack(const T& value) {
+            Reserve();
+            data[(head + size) & Mask()] = value;
+            ++size;
+        }
+
+        void PushFront(const T& value) {
+            Reserve();
+            head = (head - 1) & Mask();
+            data[head] = value;
+            ++size;
+        }
+
+        T PopFront() {
+            T value = std::move(data[head]);
+            head = (head + 1) & Mask();
+            --size;
+            return value;
+        }
+
+        /// Removes every occurrence of the value, keeping the others in order
+        void Remove(const T& value) {
+            std::size_t kept = 0;
+            for (std::size_t i = 0; i < size; ++i) {
+                const T& cur = At(i);
+                if (!(cur == value)) {
+                    data[(head + kept) & Mask()] = cur;
+                    ++kept;
+                }
+            }
+            size = kept;
+        }
+
+        void Rotate() {
+            if (size > 1) {
+                data[(head + size) & Mask()] = std::move(data[head]);
+                head = (head + 1) & Mask();
+            }
+        }
+
+        void Clear() {
+            head = 0;
+            size = 0;
+        }
 
-    void link(Priority priority) {
-        Queue* cur = &queues[priority];
+    private:
+        std::size_t Mask() const {
+            return data.size() - 1;
+        }
 
-        for (int i = priority - 1; i >= 0; --i) {
-            if (queues[i].next_nonempty != UnlinkedTag()) {
-                cur->next_nonempty = queues[i].next_nonempty;
-                queues[i].next_nonempty = cur;
+        /// Makes room for one more element, unwrapping the contents if the buffer grows
+        void Reserve() {
+            if (size < data.size()) {
                 return;
             }
+            std::vector<T> grown(std::max<std::size_t>(data.size() * 2, InitialCapacity));
+            for (std::size_t i = 0; i < size; ++i) {
+                grown[i] = std::move(data[(head + i) & Mask()]);
+            }
+            data = std::move(grown);
+            head = 0;
         }
 
-        cur->next_nonempty = first;
-        first = cur;
-    }
+        static constexpr std::size_t InitialCapacity = 8;
 
-    // The first queue that's ever been used.
-    Queue* first;
-    // The priority level queues of thread ids.
-    std::array<Queue, NUM_QUEUES> queues;
+        std::vector<T> data;
+        std::size_t head = 0;
+        std::size_t size = 0;
+    };
 
-    s64 ToIndex(const Queue* q) const {
-        if (q == nullptr) {
-            return -2;
-        } else if (q == UnlinkedTag()) {
-            return -1;
-        } else {
-            return q - queues.data();
+    static constexpr std::size_t NUM_WORDS = (NUM_QUEUES + 63) / 64;
+
+    /// Returns the lowest non-empty level, or NUM_QUEUES if all of them are empty
+    Priority FirstNonEmpty() const {
+        for (std::size_t word = 0; word < NUM_WORDS; ++word) {
+            if (non_empty[word] != 0) {
+                return static_cast<Priority>(word * 64 + LeastSignificantSetBit(non_empty[word]));
+            }
         }
+        return NUM_QUEUES;
     }
 
-    Queue* ToPointer(s64 idx) {
-        if (idx == -1) {
-            return UnlinkedTag();
-        } else if (idx < 0) {
-            return nullptr;
+    void SetNonEmpty(Priority priority, bool value) {
+        const u64 bit = u64(1) << (priority % 64);
+        if (value) {
+            non_empty[priority / 64] |= bit;
         } else {
-            return &queues[idx];
+            non_empty[priority / 64] &= ~bit;
         }
     }
 
+    bool IsUsed(Priority priority) const {
+        return (used[priority / 64] >> (priority % 64)) & 1;
+    }
+
+    /// Levels that have threads queued
+    std::array<u64, NUM_WORDS> non_empty{};
+    /// Levels that have been prepared
+    std::array<u64, NUM_WORDS> used{};
+    // The priority level queues of thread ids.
+    std::array<Queue, NUM_QUEUES> queues;
+
+    // Save states store the levels as a list of the used ones in priority order, with a deque of
+    // threads for each level. Links are stored as indices: -2 ends the list, -1 marks an unused
+    // level.
+
+    s64 NextUsedIndex(std::size_t priority) const {
+        for (std::size_t i = priority + 1; i < NUM_QUEUES; ++i) {
+            if (IsUsed(static_cast<Priority>(i))) {
+                return static_cast<s64>(i);
+            }
+        }
+        return -2;
+    }
+
     friend class boost::serialization::access;
     template <class Archive>
     void save(Archive& ar, const unsigned int file_version) const {
-        const s64 idx = ToIndex(first);
-        ar << idx;
+        const s64 first = IsUsed(0) ? 0 : NextUsedIndex(0);
+        ar << first;
         for (std::size_t i = 0; i < NUM_QUEUES; i++) {
-            const s64 idx1 = ToIndex(queues[i].next_nonempty);
-            ar << idx1;
-            ar << queues[i].data;
+            const s64 next = IsUsed(static_cast<Priority>(i)) ? NextUsedIndex(i) : -1;
+            ar << next;
+            std::deque<T> data;
+            for (std::size_t j = 0; j < queues[i].Size(); ++j) {
+                data.push_back(queues[i].At(j));
+            }
+            ar << data;
         }
     }
 
     template <class Archive>
     void load(Archive& ar, const unsigned int file_version) {
+        clear();
         s64 idx;
         ar >> idx;
-        first = ToPointer(idx);
         for (std::size_t i = 0; i < NUM_QUEUES; i++) {
+            const auto priority = static_cast<Priority>(i);
             ar >> idx;
-            queues[i].next_nonempty = ToPointer(idx);
-            ar >> queues[i].data;
+            if (idx != -1) {
+                prepare(priority);
+            }
+            std::deque<T> data;
+            ar >> data;
+            for (const T& thread_id : data) {
+                push_back(priority, thread_id);
+            }
         }
     }
 
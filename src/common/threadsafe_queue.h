@@ -8,6 +8,7 @@
 // single reader, single writer queue
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstddef>
 #include <mutex>
@@ -93,6 +94,15 @@ public:
         return t;
     }
 
+    /// Blocks until the queue is non-empty or the timeout expires.
+    template <typename Rep, typename Period>
+    void WaitFor(const std::chrono::duration<Rep, Period>& timeout) {
+        if (Empty()) {
+            std::unique_lock lock{cv_mutex};
+            cv.wait_for(lock, timeout, [this]() { return !Empty(); });
+        }
+    }
+
     // not thread-safe
     void Clear() {
         size.store(0);
@@ -145,7 +155,7 @@ public:
     template <typename Arg>
     void Push(Arg&& t) {
         std::lock_guard lock{write_lock};
-        spsc_queue.Push(t);
+        spsc_queue.Push(std::forward<Arg>(t));
     }
 
     void Pop() {
@@ -160,6 +170,11 @@ public:
         return spsc_queue.PopWait();
     }
 
+    template <typename Rep, typename Period>
+    void WaitFor(const std::chrono::duration<Rep, Period>& timeout) {
+        spsc_queue.WaitFor(timeout);
+    }
+
     // not thread-safe
     void Clear() {
         spsc_queue.Clear();
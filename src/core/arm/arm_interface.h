@@ -10,6 +10,7 @@
 #include <boost/serialization/split_member.hpp>
 #include <boost/serialization/version.hpp>
 #include "common/common_types.h"
+#include "core/arm/idle_loop_detector.h"
 #include "core/arm/skyeye_common/arm_regformat.h"
 #include "core/arm/skyeye_common/vfp/asm_vfp.h"
 #include "core/core_timing.h"
@@ -125,6 +126,10 @@ public:
     /// Notify CPU emulation that page tables have changed
     virtual void SetPageTable(const std::shared_ptr<Memory::PageTable>& page_table) = 0;
 
+    /// Returns the page table the core runs on. Returning nullptr is valid if page tables are not
+    /// used.
+    virtual std::shared_ptr<Memory::PageTable> GetPageTable() const = 0;
+
     /**
      * Set the Program Counter to an address
      * @param addr Address to set PC to
@@ -240,12 +245,20 @@ public:
         return id;
     }
 
-protected:
-    // This us used for serialization. Returning nullptr is valid if page tables are not used.
-    virtual std::shared_ptr<Memory::PageTable> GetPageTable() const = 0;
+    IdleLoopDetector& GetIdleLoopDetector() {
+        return idle_loop_detector;
+    }
 
+    const IdleLoopDetector& GetIdleLoopDetector() const {
+        return idle_loop_detector;
+    }
+
+protected:
     std::shared_ptr<Core::Timing::Timer> timer;
 
+    // Not serialized, it only caches the analysis of the guest code
+    IdleLoopDetector idle_loop_detector;
+
 private:
     u32 id;
 
@@ -3,17 +3,21 @@
 // Refer to the license.txt file included.
 
 #include <cstring>
+#include <type_traits>
 #include <dynarmic/A32/a32.h>
 #include <dynarmic/A32/context.h>
 #include "common/assert.h"
 #include "common/microprofile.h"
 #include "core/arm/dynarmic/arm_dynarmic.h"
 #include "core/arm/dynarmic/arm_dynarmic_cp15.h"
+#include "core/arm/exclusive_monitor.h"
 #include "core/core.h"
 #include "core/core_timing.h"
+#include "core/cpu_threads.h"
 #include "core/gdbstub/gdbstub.h"
 #include "core/hle/kernel/svc.h"
 #include "core/memory.h"
+#include "core/settings.h"
 
 class DynarmicThreadContext final : public ARM_Interface::ThreadContext {
 public:
@@ -68,6 +72,25 @@ private:
     u32 fpexc;
 };
 
+/**
+ * Number of the SVC that replaces the branch of idle loop candidates in the JIT's view of the
+ * code. Its condition is the branch's, so the loop still exits through the next instruction, while
+ * taking the branch leaves the JIT for DynarmicUserCallbacks::RunIdleLoopBranch.
+ */
+constexpr u32 IdleLoopSVC = 0xFF1D1E;
+
+/**
+ * Number of the SVC that replaces exclusive loads and stores while the cores can run in parallel,
+ * so that DynarmicUserCallbacks::RunExclusiveAccess does them through the global monitor. Its
+ * condition is the one of the replaced instruction.
+ */
+constexpr u32 ExclusiveAccessSVC = 0xFF1D1F;
+
+/// Returns whether an ARM instruction is one of LDREX, STREX and their B, H and D variants
+constexpr bool IsExclusiveAccess(u32 inst) {
+    return (inst >> 28) != 0xF && (inst & 0x0F800FF0) == 0x01800F90;
+}
+
 class DynarmicUserCallbacks final : public Dynarmic::A32::UserCallbacks {
 public:
     explicit DynarmicUserCallbacks(ARM_Dynarmic& parent)
@@ -75,29 +98,42 @@ public:
     ~DynarmicUserCallbacks() = default;
 
     std::uint8_t MemoryRead8(VAddr vaddr) override {
-        return memory.Read8(vaddr);
+        return OnEmulationThread([&] { return memory.Read8(vaddr); });
     }
     std::uint16_t MemoryRead16(VAddr vaddr) override {
-        return memory.Read16(vaddr);
+        return OnEmulationThread([&] { return memory.Read16(vaddr); });
     }
     std::uint32_t MemoryRead32(VAddr vaddr) override {
-        return memory.Read32(vaddr);
+        return OnEmulationThread([&] { return memory.Read32(vaddr); });
     }
     std::uint64_t MemoryRead64(VAddr vaddr) override {
-        return memory.Read64(vaddr);
+        return OnEmulationThread([&] { return memory.Read64(vaddr); });
     }
 
     void MemoryWrite8(VAddr vaddr, std::uint8_t value) override {
-        memory.Write8(vaddr, value);
+        OnEmulationThread([&] { memory.Write8(vaddr, value); });
     }
     void MemoryWrite16(VAddr vaddr, std::uint16_t value) override {
-        memory.Write16(vaddr, value);
+        OnEmulationThread([&] { memory.Write16(vaddr, value); });
     }
     void MemoryWrite32(VAddr vaddr, std::uint32_t value) override {
-        memory.Write32(vaddr, value);
+        OnEmulationThread([&] { memory.Write32(vaddr, value); });
     }
     void MemoryWrite64(VAddr vaddr, std::uint64_t value) override {
-        memory.Write64(vaddr, value);
+        OnEmulationThread([&] { memory.Write64(vaddr, value); });
+    }
+
+    std::uint32_t MemoryReadCode(VAddr vaddr) override {
+        const u32 inst = MemoryRead32(vaddr);
+        // ARMv6K has no exclusive accesses in Thumb state
+        if (parent.system.GetExclusiveMonitor() && (parent.jit->Cpsr() & (1 << 5)) == 0 &&
+            IsExclusiveAccess(inst)) {
+            return (inst & 0xF0000000) | 0x0F000000 | ExclusiveAccessSVC;
+        }
+        if (IsIdleLoopCandidate(vaddr, inst)) {
+            return (inst & 0xF0000000) | 0x0F000000 | IdleLoopSVC;
+        }
+        return inst;
     }
 
     void InterpreterFallback(VAddr pc, std::size_t num_instructions) override {
@@ -107,7 +143,17 @@ public:
     }
 
     void CallSVC(std::uint32_t swi) override {
-        svc_context.CallSVC(swi);
+        if (swi == IdleLoopSVC && RunIdleLoopBranch()) {
+            return;
+        }
+        if (swi == ExclusiveAccessSVC && RunExclusiveAccess()) {
+            return;
+        }
+        // The kernel returns from the SVC with an ERET, which clears the reservation
+        if (ExclusiveMonitor* monitor = parent.system.GetExclusiveMonitor()) {
+            monitor->Clear(parent.GetID());
+        }
+        OnEmulationThread([&] { svc_context.CallSVC(swi); });
     }
 
     void ExceptionRaised(VAddr pc, Dynarmic::A32::Exception exception) override {
@@ -144,6 +190,171 @@ public:
         return static_cast<u64>(ticks <= 0 ? 0 : ticks);
     }
 
+    bool IsIdleLoopCandidate(VAddr vaddr, u32 inst) {
+        // Blocks are only translated when the JIT is about to run them, so the current mode is
+        // the one of the code being read. Cores running in parallel do not skip, as the other
+        // cores keep running while the timer of this one jumps ahead.
+        if (!Settings::values.skip_idle_loops || parent.system.IsRunningCoresInParallel() ||
+            (parent.jit->Cpsr() & (1 << 5)) != 0 || !IdleLoopDetector::GetLoopStart(vaddr, inst)) {
+            return false;
+        }
+        return parent.GetIdleLoopDetector().IsCandidate(
+            vaddr, inst, [this](VAddr addr) { return MemoryRead32(addr); });
+    }
+
+    /**
+     * Takes the branch replaced by the idle loop SVC, and skips to the next event if the loop is
+     * idle. Returns false if the SVC was not put there by MemoryReadCode.
+     */
+    bool RunIdleLoopBranch() {
+        // The JIT has already moved the PC past the SVC
+        const VAddr address = parent.GetPC() - 4;
+        const u32 inst = MemoryRead32(address);
+        const auto loop_start = IdleLoopDetector::GetLoopStart(address, inst);
+        if (!loop_start) {
+            return false;
+        }
+        parent.SetPC(*loop_start);
+
+        if (!Settings::values.skip_idle_loops || parent.system.IsRunningCoresInParallel()) {
+            return true;
+        }
+        auto& detector = parent.GetIdleLoopDetector();
+        const auto read_code = [this](VAddr addr) { return MemoryRead32(addr); };
+        if (detector.IsCandidate(address, inst, read_code) &&
+            detector.OnBranchTaken(address, *loop_start, parent.jit->Regs(),
+                                   parent.jit->Cpsr() & 0xF0000000, parent.GetTimer().GetTicks())) {
+            // Nothing changes until the next event, so skip ahead to it
+            parent.GetTimer().Idle();
+        }
+        return true;
+    }
+
+    /**
+     * Runs the exclusive load or store replaced by the exclusive access SVC through the global
+     * monitor. Returns false if the SVC was not put there by MemoryReadCode.
+     */
+    bool RunExclusiveAccess() {
+        ExclusiveMonitor* monitor = parent.system.GetExclusiveMonitor();
+        // The JIT has already moved the PC past the SVC
+        const u32 inst = MemoryRead32(parent.GetPC() - 4);
+        if (!monitor || !IsExclusiveAccess(inst)) {
+            return false;
+        }
+
+        const u32 core_id = parent.GetID();
+        const VAddr address = parent.GetReg((inst >> 16) & 0xF);
+        const int rt = (inst >> 12) & 0xF;
+        // Bits 22 and 21 give the size: word, doubleword, byte or halfword
+        const u32 size = (inst >> 21) & 3;
+        if ((inst & (1 << 20)) != 0) {
+            monitor->Load(core_id, address, [&] {
+                switch (size) {
+                case 0:
+                    parent.SetReg(rt, ExclusiveRead<u32>(address));
+                    break;
+                case 1: {
+                    const u64 value = ExclusiveRead<u64>(address);
+                    parent.SetReg(rt, static_cast<u32>(value));
+                    parent.SetReg(rt + 1, static_cast<u32>(value >> 32));
+                    break;
+                }
+                case 2:
+                    parent.SetReg(rt, ExclusiveRead<u8>(address));
+                    break;
+                case 3:
+                    parent.SetReg(rt, ExclusiveRead<u16>(address));
+                    break;
+                }
+            });
+            return true;
+        }
+
+        const int source = inst & 0xF;
+        const bool stored = monitor->Store(core_id, address, [&] {
+            const u32 value = parent.GetReg(source);
+            switch (size) {
+            case 0:
+                ExclusiveWrite<u32>(address, value);
+                break;
+            case 1:
+                ExclusiveWrite<u64>(address, value | u64{parent.GetReg(source + 1)} << 32);
+                break;
+            case 2:
+                ExclusiveWrite<u8>(address, static_cast<u8>(value));
+                break;
+            case 3:
+                ExclusiveWrite<u16>(address, static_cast<u16>(value));
+                break;
+            }
+        });
+        parent.SetReg(rt, stored ? 0 : 1);
+        return true;
+    }
+
+    /// Returns the host memory of an address that the page table maps directly, or nullptr
+    u8* GetDirectPointer(VAddr vaddr) {
+        u8* page = parent.current_page_table->GetPointerArray()[vaddr >> Memory::PAGE_BITS];
+        return page ? page + (vaddr & Memory::PAGE_MASK) : nullptr;
+    }
+
+    /// Reads for an exclusive load, only leaving the core's thread if the page table misses
+    template <typename T>
+    T ExclusiveRead(VAddr vaddr) {
+        if (const u8* pointer = GetDirectPointer(vaddr)) {
+            T value;
+            std::memcpy(&value, pointer, sizeof(T));
+            return value;
+        }
+        if constexpr (sizeof(T) == 1) {
+            return MemoryRead8(vaddr);
+        } else if constexpr (sizeof(T) == 2) {
+            return MemoryRead16(vaddr);
+        } else if constexpr (sizeof(T) == 4) {
+            return MemoryRead32(vaddr);
+        } else {
+            return MemoryRead64(vaddr);
+        }
+    }
+
+    /// Writes for an exclusive store, only leaving the core's thread if the page table misses
+    template <typename T>
+    void ExclusiveWrite(VAddr vaddr, T value) {
+        if (u8* pointer = GetDirectPointer(vaddr)) {
+            std::memcpy(pointer, &value, sizeof(T));
+            return;
+        }
+        if constexpr (sizeof(T) == 1) {
+            MemoryWrite8(vaddr, value);
+        } else if constexpr (sizeof(T) == 2) {
+            MemoryWrite16(vaddr, value);
+        } else if constexpr (sizeof(T) == 4) {
+            MemoryWrite32(vaddr, value);
+        } else {
+            MemoryWrite64(vaddr, value);
+        }
+    }
+
+    /**
+     * Runs a callback which leaves the JIT. When the core runs on a thread of its own, this hands
+     * it to the emulation thread, which owns the kernel, the HLE services and the GPU context.
+     * Only accesses that miss the page table (MMIO and rasterizer cached memory) get here.
+     */
+    template <typename Func>
+    auto OnEmulationThread(Func&& func) -> decltype(func()) {
+        Core::CPUThreads* cpu_threads = Core::CPUThreads::GetCurrent();
+        if (!cpu_threads) {
+            return func();
+        }
+        if constexpr (std::is_void_v<decltype(func())>) {
+            cpu_threads->CallOnEmulationThread(parent, func);
+        } else {
+            decltype(func()) result{};
+            cpu_threads->CallOnEmulationThread(parent, [&] { result = func(); });
+            return result;
+        }
+    }
+
     ARM_Dynarmic& parent;
     Kernel::SVCContext svc_context;
     Memory::MemorySystem& memory;
@@ -163,6 +374,7 @@ MICROPROFILE_DEFINE(ARM_Jit, "ARM JIT", "ARM JIT", MP_RGB(255, 64, 64));
 void ARM_Dynarmic::Run() {
     ASSERT(memory.GetCurrentPageTable() == current_page_table);
     MICROPROFILE_SCOPE(ARM_Jit);
+    Core::PerfTimer perf_timer{Core::PerfCategory::Cpu};
 
     jit->Run();
 }
@@ -273,6 +485,11 @@ void ARM_Dynarmic::LoadContext(const std::unique_ptr<ThreadContext>& arg) {
 
     jit->LoadContext(ctx->ctx);
     fpexc = ctx->fpexc;
+
+    // The thread switched in doesn't hold the reservation of the previous one
+    if (ExclusiveMonitor* monitor = system.GetExclusiveMonitor()) {
+        monitor->Clear(GetID());
+    }
 }
 
 void ARM_Dynarmic::PrepareReschedule() {
@@ -285,10 +502,12 @@ void ARM_Dynarmic::ClearInstructionCache() {
     for (const auto& j : jits) {
         j.second->ClearCache();
     }
+    idle_loop_detector.Invalidate();
 }
 
 void ARM_Dynarmic::InvalidateCacheRange(u32 start_address, std::size_t length) {
     jit->InvalidateCacheRange(start_address, length);
+    idle_loop_detector.Invalidate();
 }
 
 std::shared_ptr<Memory::PageTable> ARM_Dynarmic::GetPageTable() const {
@@ -296,6 +515,13 @@ std::shared_ptr<Memory::PageTable> ARM_Dynarmic::GetPageTable() const {
 }
 
 void ARM_Dynarmic::SetPageTable(const std::shared_ptr<Memory::PageTable>& page_table) {
+    // The kernel binds the process of a core again whenever the emulation thread serves one of its
+    // calls, while its JIT is still inside the callback
+    if (jit && page_table == current_page_table) {
+        return;
+    }
+    // The analyzed loops belong to the code of the previous process
+    idle_loop_detector.Invalidate();
     current_page_table = page_table;
     Dynarmic::A32::Context ctx{};
     if (jit) {
@@ -53,10 +53,8 @@ public:
     void ClearInstructionCache() override;
     void InvalidateCacheRange(u32 start_address, std::size_t length) override;
     void SetPageTable(const std::shared_ptr<Memory::PageTable>& page_table) override;
-    void PurgeState() override;
-
-protected:
     std::shared_ptr<Memory::PageTable> GetPageTable() const override;
+    void PurgeState() override;
 
 private:
     void ServeBreak();
@@ -79,6 +79,7 @@ ARM_DynCom::~ARM_DynCom() {}
 
 void ARM_DynCom::Run() {
     DEBUG_ASSERT(system != nullptr);
+    Core::PerfTimer perf_timer{Core::PerfCategory::Cpu};
     ExecuteInstructions(std::max<s64>(timer->GetDowncount(), 0));
 }
 
@@ -89,6 +90,7 @@ void ARM_DynCom::Step() {
 void ARM_DynCom::ClearInstructionCache() {
     state->instruction_cache.clear();
     trans_cache_buf_top = 0;
+    idle_loop_detector.Invalidate();
 }
 
 void ARM_DynCom::InvalidateCacheRange(u32, std::size_t) {
@@ -23,6 +23,7 @@
 #include "core/gdbstub/gdbstub.h"
 #include "core/hle/kernel/svc.h"
 #include "core/memory.h"
+#include "core/settings.h"
 
 #define RM BITS(sht_oper, 0, 3)
 #define RS BITS(sht_oper, 8, 11)
@@ -837,6 +838,14 @@ static unsigned int InterpreterTranslateInstruction(const ARMul_State* cpu, cons
     }
     inst_base = arm_instruction_trans[idx](inst, idx);
 
+    if (!cpu->TFlag && cpu->system != nullptr && Settings::values.skip_idle_loops &&
+        IdleLoopDetector::GetLoopStart(phys_addr, inst)) {
+        auto& detector = cpu->system->GetRunningCore().GetIdleLoopDetector();
+        bbl_inst* const inst_cream = (bbl_inst*)inst_base->component;
+        inst_cream->idle_loop = detector.IsCandidate(
+            phys_addr, inst, [cpu](VAddr addr) { return cpu->memory.Read32(addr); });
+    }
+
     return inst_size;
 }
 
@@ -1766,6 +1775,21 @@ BBL_INST : {
         if (inst_cream->L) {
             LINK_RTN_ADDR;
         }
+        if (inst_cream->idle_loop && Settings::values.skip_idle_loops) {
+            ARM_Interface& core = cpu->system->GetRunningCore();
+            const u32 loop_start = cpu->Reg[15] + 8 + inst_cream->signed_immed_24;
+            const u32 nzcv = (cpu->NFlag << 31) | (cpu->ZFlag << 30) | (cpu->CFlag << 29) |
+                             (cpu->VFlag << 28);
+            if (core.GetIdleLoopDetector().OnBranchTaken(cpu->Reg[15], loop_start, cpu->Reg, nzcv,
+                                                         core.GetTimer().GetTicks() + num_instrs)) {
+                // Nothing changes until the next event, so skip ahead to it
+                SET_PC;
+                core.GetTimer().AddTicks(num_instrs);
+                num_instrs = 0;
+                core.GetTimer().Idle();
+                goto END;
+            }
+        }
         SET_PC;
         INC_PC(sizeof(bbl_inst));
         goto DISPATCH;
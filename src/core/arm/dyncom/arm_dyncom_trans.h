@@ -88,6 +88,8 @@ struct bbl_inst {
     int signed_immed_24;
     unsigned int next_addr;
     unsigned int jmp_addr;
+    // Whether the branch closes a candidate idle loop
+    unsigned int idle_loop;
 };
 
 struct bx_inst {
@@ -0,0 +1,13 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "core/arm/exclusive_monitor.h"
+
+ExclusiveMonitor::ExclusiveMonitor(std::size_t num_cores)
+    : reservations(num_cores, NoReservation) {}
+
+void ExclusiveMonitor::Clear(std::size_t core_id) {
+    std::lock_guard lock{mutex};
+    reservations[core_id] = NoReservation;
+}
@@ -0,0 +1,67 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+#include "common/common_types.h"
+
+/**
+ * Global exclusive monitor of the ARM11 cores. The JIT only tracks LDREX/STREX reservations per
+ * core, so while the cores can run in parallel, their exclusive accesses are done through this
+ * monitor instead. A successful exclusive store clears the reservations that the other cores hold
+ * on the same granule, so only one of them succeeds.
+ *
+ * Plain stores don't clear reservations, as the JIT writes them to memory directly.
+ */
+class ExclusiveMonitor {
+public:
+    explicit ExclusiveMonitor(std::size_t num_cores);
+
+    /**
+     * Reserves the granule of an address for a core and runs the load while holding the monitor,
+     * so that no exclusive store of another core happens in between.
+     */
+    template <typename Func>
+    void Load(std::size_t core_id, VAddr address, Func&& load) {
+        std::lock_guard lock{mutex};
+        reservations[core_id] = address & ReservationGranuleMask;
+        load();
+    }
+
+    /**
+     * Runs the store if the core still holds the reservation of the address, and clears the
+     * reservations of every core on its granule.
+     * @returns Whether the store ran.
+     */
+    template <typename Func>
+    bool Store(std::size_t core_id, VAddr address, Func&& store) {
+        std::lock_guard lock{mutex};
+        const VAddr granule = address & ReservationGranuleMask;
+        if (reservations[core_id] != granule) {
+            reservations[core_id] = NoReservation;
+            return false;
+        }
+        for (VAddr& reservation : reservations) {
+            if (reservation == granule) {
+                reservation = NoReservation;
+            }
+        }
+        store();
+        return true;
+    }
+
+    /// Clears the reservation of a core, like CLREX or an exception return
+    void Clear(std::size_t core_id);
+
+private:
+    static constexpr VAddr ReservationGranuleMask = 0xFFFFFFF8;
+    /// Never equal to a granule, as these have the low bits clear
+    static constexpr VAddr NoReservation = 0xFFFFFFFF;
+
+    std::mutex mutex;
+    std::vector<VAddr> reservations;
+};
@@ -0,0 +1,110 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "core/arm/idle_loop_detector.h"
+
+std::optional<VAddr> IdleLoopDetector::GetLoopStart(VAddr address, u32 inst) {
+    // B without link. Condition 0b1111 is BLX.
+    if ((inst & 0x0F000000) != 0x0A000000 || (inst >> 28) == 0xF) {
+        return std::nullopt;
+    }
+    const s32 offset = static_cast<s32>(inst << 8) >> 6;
+    const s32 max_offset = -8;
+    const s32 min_offset = max_offset - 4 * static_cast<s32>(MaxLoopLength - 1);
+    if (offset > max_offset || offset < min_offset) {
+        return std::nullopt;
+    }
+    return address + 8 + offset;
+}
+
+bool IdleLoopDetector::IsSideEffectFree(u32 inst) {
+    if ((inst >> 28) == 0xF) {
+        return false;
+    }
+    const u32 rd = (inst >> 12) & 0xF;
+    const u32 rn = (inst >> 16) & 0xF;
+    const bool load = (inst & (1 << 20)) != 0;
+
+    switch ((inst >> 25) & 0x7) {
+    case 0b000:
+        if ((inst & 0x90) == 0x90) {
+            if ((inst & 0x60) == 0) {
+                // MUL, MLA, UMULL and the like. SWP and LDREX/STREX have bit 24 set.
+                return (inst & 0x0F000000) == 0 && rd != 15 && rn != 15;
+            }
+            // LDRH, LDRSB and LDRSH. Without L these are STRH, LDRD and STRD.
+            return load && rd != 15;
+        }
+        [[fallthrough]];
+    case 0b001:
+        // TST, TEQ, CMP and CMN without S encode MRS, MSR, BX, the hints and other oddities
+        if ((inst & 0x01900000) == 0x01000000) {
+            // MOVW and MOVT
+            if ((inst & 0x0FB00000) == 0x03000000) {
+                return rd != 15;
+            }
+            // NOP, YIELD and WFE
+            return (inst & 0x0FFFFFF8) == 0x0320F000 && (inst & 0x7) <= 2;
+        }
+        return rd != 15;
+    case 0b010:
+        return load && rd != 15;
+    case 0b011:
+        // Bit 4 set is the media instructions
+        return (inst & 0x10) == 0 && load && rd != 15;
+    case 0b100:
+        // LDM without PC in the list nor user mode registers
+        return load && (inst & (1 << 15)) == 0 && (inst & (1 << 22)) == 0;
+    default:
+        return false;
+    }
+}
+
+bool IdleLoopDetector::IsCandidate(VAddr address, u32 inst, const CodeReader& read_code) {
+    const auto loop_start = GetLoopStart(address, inst);
+    if (!loop_start) {
+        return false;
+    }
+    const auto [it, inserted] = candidates.try_emplace(address, true);
+    if (inserted) {
+        for (VAddr pc = *loop_start; pc != address; pc += 4) {
+            if (!IsSideEffectFree(read_code(pc))) {
+                it->second = false;
+                break;
+            }
+        }
+    }
+    return it->second;
+}
+
+bool IdleLoopDetector::OnBranchTaken(VAddr address, VAddr loop_start,
+                                     const std::array<u32, 16>& regs, u32 nzcv, u64 ticks) {
+    // The body has no branch of its own, so if at most one iteration worth of ticks went by since
+    // the branch was last taken, the loop ran exactly once in between.
+    const u64 loop_length = (address - loop_start) / 4 + 1;
+    const bool idle = has_last_iteration && last_address == address && last_nzcv == nzcv &&
+                      ticks - last_ticks <= loop_length &&
+                      std::equal(last_regs.begin(), last_regs.end(), regs.begin());
+
+    has_last_iteration = true;
+    last_address = address;
+    std::copy_n(regs.begin(), last_regs.size(), last_regs.begin());
+    last_nzcv = nzcv;
+    last_ticks = ticks;
+
+    if (idle) {
+        hit_count.fetch_add(1, std::memory_order_relaxed);
+    }
+    return idle;
+}
+
+void IdleLoopDetector::Invalidate() {
+    candidates.clear();
+    has_last_iteration = false;
+}
+
+u64 IdleLoopDetector::GetHitCount() const {
+    return hit_count.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,67 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <optional>
+#include <unordered_map>
+#include "common/common_types.h"
+
+/**
+ * Finds guest loops that spin without side effects, such as polling a flag in shared memory, so
+ * that the CPU backends can skip to the next Core::Timing event instead of running them.
+ *
+ * A candidate is a short ARM-mode backward B whose loop body is straight-line code that only loads
+ * from memory or computes on registers. Once the branch is taken twice in a row with the same
+ * registers and flags, an iteration changes nothing, so the loop keeps spinning until an event
+ * changes the memory it reads.
+ */
+class IdleLoopDetector {
+public:
+    /// Maximum number of instructions of a loop, the branch included
+    static constexpr u32 MaxLoopLength = 8;
+
+    using CodeReader = std::function<u32(VAddr)>;
+
+    /// Returns the start of the loop if the ARM instruction at the address is a short backward B
+    static std::optional<VAddr> GetLoopStart(VAddr address, u32 inst);
+
+    /// Returns whether an ARM instruction can be part of the body of an idle loop
+    static bool IsSideEffectFree(u32 inst);
+
+    /**
+     * Returns whether the ARM instruction at the address closes a candidate loop. The body is read
+     * with read_code the first time, and the result is kept until Invalidate is called.
+     */
+    bool IsCandidate(VAddr address, u32 inst, const CodeReader& read_code);
+
+    /**
+     * Called when the branch of a candidate loop is taken, with the registers, the NZCV flags and
+     * the tick count of the core at that point. Returns true, and counts a hit, when the previous
+     * iteration left the registers and flags unchanged.
+     */
+    bool OnBranchTaken(VAddr address, VAddr loop_start, const std::array<u32, 16>& regs, u32 nzcv,
+                       u64 ticks);
+
+    /// Forgets the analyzed loops, for when code got modified or another process got mapped
+    void Invalidate();
+
+    /// Returns the number of times a loop was found to be idle
+    u64 GetHitCount() const;
+
+private:
+    /// Analysis results, by branch address
+    std::unordered_map<VAddr, bool> candidates;
+
+    bool has_last_iteration = false;
+    VAddr last_address = 0;
+    std::array<u32, 15> last_regs{};
+    u32 last_nzcv = 0;
+    u64 last_ticks = 0;
+
+    std::atomic<u64> hit_count{0};
+};
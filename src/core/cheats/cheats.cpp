@@ -8,6 +8,7 @@
 #include "common/file_util.h"
 #include "core/cheats/cheats.h"
 #include "core/cheats/gateway_cheat.h"
+#include "core/cheats/gateway_program.h"
 #include "core/core.h"
 #include "core/core_timing.h"
 #include "core/hle/kernel/process.h"
@@ -19,7 +20,8 @@ namespace Cheats {
 // we use the same value
 constexpr u64 run_interval_ticks = 50'000'000;
 
-CheatEngine::CheatEngine(Core::System& system_) : system(system_) {
+CheatEngine::CheatEngine(Core::System& system_)
+    : batched_program(std::make_unique<GatewayProgram>()), system(system_) {
     LoadCheatFile();
     Connect();
 }
@@ -105,13 +107,38 @@ void CheatEngine::LoadCheatFile() {
 void CheatEngine::RunCallback([[maybe_unused]] u64 userdata, s64 cycles_late) {
     {
         std::shared_lock<std::shared_mutex> lock(cheats_list_mutex);
-        for (auto& cheat : cheats_list) {
-            if (cheat->IsEnabled()) {
-                cheat->Execute(system);
-            }
+        UpdateBatch();
+        batched_program->Execute(system);
+        for (auto& cheat : unbatched_cheats) {
+            cheat->Execute(system);
         }
     }
     system.CoreTiming().ScheduleEvent(run_interval_ticks - cycles_late, event);
 }
 
+void CheatEngine::UpdateBatch() {
+    std::vector<std::shared_ptr<CheatBase>> enabled;
+    for (const auto& cheat : cheats_list) {
+        if (cheat->IsEnabled()) {
+            enabled.push_back(cheat);
+        }
+    }
+    // Holding on to the cheats keeps a replaced one from being mistaken for a new one at the same
+    // address
+    if (enabled == enabled_cheats) {
+        return;
+    }
+    enabled_cheats = std::move(enabled);
+
+    batched_program->Clear();
+    unbatched_cheats.clear();
+    for (const auto& cheat : enabled_cheats) {
+        if (const auto* gateway_cheat = dynamic_cast<const GatewayCheat*>(cheat.get())) {
+            batched_program->Append(gateway_cheat->GetProgram());
+        } else {
+            unbatched_cheats.push_back(cheat);
+        }
+    }
+}
+
 } // namespace Cheats
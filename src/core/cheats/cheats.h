@@ -21,6 +21,7 @@ struct EventType;
 namespace Cheats {
 
 class CheatBase;
+class GatewayProgram;
 
 class CheatEngine {
 public:
@@ -36,8 +37,16 @@ public:
 private:
     void LoadCheatFile();
     void RunCallback(u64 userdata, s64 cycles_late);
+    /// Rebuilds the batched program if the set of enabled cheats changed since the last run
+    void UpdateBatch();
     std::vector<std::shared_ptr<CheatBase>> cheats_list;
     mutable std::shared_mutex cheats_list_mutex;
+    /// Enabled cheats as of the last run. Only accessed from the emulation thread.
+    std::vector<std::shared_ptr<CheatBase>> enabled_cheats;
+    /// Programs of the enabled Gateway cheats, appended in list order
+    std::unique_ptr<GatewayProgram> batched_program;
+    /// Enabled cheats of other types, which run one by one
+    std::vector<std::shared_ptr<CheatBase>> unbatched_cheats;
     Core::TimingEventType* event;
     Core::System& system;
 };
@@ -6,9 +6,14 @@
 
 #include <atomic>
 #include <memory>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
 #include "core/cheats/cheat_base.h"
 
 namespace Cheats {
+class GatewayProgram;
+
 class GatewayCheat final : public CheatBase {
 public:
     enum class CheatType {
@@ -59,6 +64,9 @@ public:
 
     void Execute(Core::System& system) const override;
 
+    /// Returns the code compiled to be run by CheatEngine together with the other enabled cheats
+    const GatewayProgram& GetProgram() const;
+
     bool IsEnabled() const override;
     void SetEnabled(bool enabled) override;
 
@@ -82,5 +90,6 @@ private:
     const std::string name;
     std::vector<CheatLine> cheat_lines;
     const std::string comments;
+    std::unique_ptr<GatewayProgram> program;
 };
 } // namespace Cheats
@@ -0,0 +1,512 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include "common/logging/log.h"
+#include "core/cheats/gateway_program.h"
+#include "core/core.h"
+#include "core/hle/service/hid/hid.h"
+#include "core/memory.h"
+
+namespace Cheats {
+
+namespace {
+
+using CheatType = GatewayCheat::CheatType;
+using Opcode = GatewayProgram::Opcode;
+
+struct State {
+    u32 reg = 0;
+    u32 offset = 0;
+    u32 if_flag = 0;
+    u32 loop_count = 0;
+    std::size_t loop_back = 0;
+    bool loop_flag = false;
+};
+
+/// Returns the number of bytes an instruction accesses at its address
+u32 AccessSize(const GatewayProgram::Instruction& inst) {
+    switch (inst.opcode) {
+    case Opcode::Write32:
+    case Opcode::GreaterThan32:
+    case Opcode::LessThan32:
+    case Opcode::EqualTo32:
+    case Opcode::NotEqualTo32:
+    case Opcode::LoadOffset:
+    case Opcode::IncrementiveWrite32:
+    case Opcode::Load32:
+        return 4;
+    case Opcode::Write16:
+    case Opcode::GreaterThan16WithMask:
+    case Opcode::LessThan16WithMask:
+    case Opcode::EqualTo16WithMask:
+    case Opcode::NotEqualTo16WithMask:
+    case Opcode::IncrementiveWrite16:
+    case Opcode::Load16:
+        return 2;
+    case Opcode::Write8:
+    case Opcode::IncrementiveWrite8:
+    case Opcode::Load8:
+        return 1;
+    case Opcode::Patch:
+        return inst.value;
+    default:
+        return 0;
+    }
+}
+
+template <typename T>
+T Read(Memory::MemorySystem& memory, const u8* host_pointer, VAddr addr) {
+    if (host_pointer != nullptr) {
+        T value;
+        std::memcpy(&value, host_pointer, sizeof(T));
+        return value;
+    }
+    if constexpr (sizeof(T) == 1) {
+        return memory.Read8(addr);
+    } else if constexpr (sizeof(T) == 2) {
+        return memory.Read16(addr);
+    } else {
+        return memory.Read32(addr);
+    }
+}
+
+template <typename T>
+void WriteIfChanged(Core::System& system, u8* host_pointer, VAddr addr, T value) {
+    Memory::MemorySystem& memory = system.Memory();
+    if (Read<T>(memory, host_pointer, addr) == value) {
+        return;
+    }
+    if (host_pointer != nullptr) {
+        std::memcpy(host_pointer, &value, sizeof(T));
+    } else if constexpr (sizeof(T) == 1) {
+        memory.Write8(addr, value);
+    } else if constexpr (sizeof(T) == 2) {
+        memory.Write16(addr, value);
+    } else {
+        memory.Write32(addr, value);
+    }
+    system.InvalidateCacheRange(addr, sizeof(T));
+}
+
+bool Compare16WithMask(Opcode opcode, u32 operand, u16 val) {
+    const u16 reference = static_cast<u16>(operand);
+    const u16 masked = static_cast<u16>(~operand >> 16) & val;
+    switch (opcode) {
+    case Opcode::GreaterThan16WithMask:
+        return reference > masked;
+    case Opcode::LessThan16WithMask:
+        return reference < masked;
+    case Opcode::EqualTo16WithMask:
+        return reference == masked;
+    default:
+        return reference != masked;
+    }
+}
+
+void FullTerminate(State& state, std::size_t& pc) {
+    if (state.loop_flag) {
+        pc = state.loop_back - 1;
+    } else {
+        state.offset = 0;
+        state.reg = 0;
+        state.loop_count = 0;
+        state.if_flag = 0;
+        state.loop_flag = false;
+    }
+}
+
+} // Anonymous namespace
+
+GatewayProgram GatewayProgram::Compile(const std::vector<GatewayCheat::CheatLine>& cheat_lines) {
+    GatewayProgram program;
+    program.instructions.push_back({Opcode::Begin});
+
+    // Value of the offset register when reaching the current line, if it is the same on every path
+    std::optional<u32> offset = 0;
+    // Value of the offset register at the start of each open conditional block
+    std::vector<std::optional<u32>> blocks;
+
+    const auto emit = [&](Opcode opcode, u32 value) -> Instruction& {
+        Instruction& inst = program.instructions.emplace_back();
+        inst.opcode = opcode;
+        inst.value = value;
+        return inst;
+    };
+    const auto emit_memory = [&](Opcode opcode, u32 address, u32 value) -> Instruction& {
+        Instruction& inst = emit(opcode, value);
+        inst.static_address = offset.has_value();
+        inst.address = address + offset.value_or(0);
+        return inst;
+    };
+    const auto open_block = [&] { blocks.push_back(offset); };
+    const auto add_offset = [&](u32 value) {
+        if (offset) {
+            *offset += value;
+        }
+    };
+
+    for (std::size_t i = 0; i < cheat_lines.size(); ++i) {
+        const GatewayCheat::CheatLine& line = cheat_lines[i];
+        switch (line.type) {
+        case CheatType::Write32:
+            emit_memory(Opcode::Write32, line.address, line.value);
+            break;
+        case CheatType::Write16:
+            emit_memory(Opcode::Write16, line.address, line.value);
+            break;
+        case CheatType::Write8:
+            emit_memory(Opcode::Write8, line.address, line.value);
+            break;
+        case CheatType::GreaterThan32:
+            emit_memory(Opcode::GreaterThan32, line.address, line.value);
+            open_block();
+            break;
+        case CheatType::LessThan32:
+            emit_memory(Opcode::LessThan32, line.address, line.value);
+            open_block();
+            break;
+        case CheatType::EqualTo32:
+            emit_memory(Opcode::EqualTo32, line.address, line.value);
+            open_block();
+            break;
+        case CheatType::NotEqualTo32:
+            emit_memory(Opcode::NotEqualTo32, line.address, line.value);
+            open_block();
+            break;
+        case CheatType::GreaterThan16WithMask:
+            emit_memory(Opcode::GreaterThan16WithMask, line.address, line.value);
+            open_block();
+            break;
+        case CheatType::LessThan16WithMask:
+            emit_memory(Opcode::LessThan16WithMask, line.address, line.value);
+            open_block();
+            break;
+        case CheatType::EqualTo16WithMask:
+            emit_memory(Opcode::EqualTo16WithMask, line.address, line.value);
+            open_block();
+            break;
+        case CheatType::NotEqualTo16WithMask:
+            emit_memory(Opcode::NotEqualTo16WithMask, line.address, line.value);
+            open_block();
+            break;
+        case CheatType::Joker:
+            emit(Opcode::Joker, line.value);
+            open_block();
+            break;
+        case CheatType::LoadOffset:
+            emit_memory(Opcode::LoadOffset, line.address, line.value);
+            offset.reset();
+            break;
+        case CheatType::Loop:
+            // The loop body runs again with whatever offset the previous iteration left
+            emit(Opcode::Loop, line.value);
+            offset.reset();
+            break;
+        case CheatType::Terminator:
+            // After the block, the offset is either the one it started with, if it was skipped,
+            // or the one it ended with
+            emit(Opcode::Terminator, line.value);
+            if (!blocks.empty()) {
+                if (blocks.back() != offset) {
+                    offset.reset();
+                }
+                blocks.pop_back();
+            }
+            break;
+        case CheatType::LoopExecuteVariant:
+            emit(Opcode::LoopExecuteVariant, line.value);
+            break;
+        case CheatType::FullTerminator:
+            // Either jumps back to the loop or resets the state, even inside a skipped block
+            emit(Opcode::FullTerminator, line.value);
+            blocks.clear();
+            offset = 0;
+            break;
+        case CheatType::SetOffset:
+            emit(Opcode::SetOffset, line.value);
+            offset = line.value;
+            break;
+        case CheatType::AddValue:
+            emit(Opcode::AddValue, line.value);
+            break;
+        case CheatType::SetValue:
+            emit(Opcode::SetValue, line.value);
+            break;
+        case CheatType::IncrementiveWrite32:
+            emit_memory(Opcode::IncrementiveWrite32, line.value, 0);
+            add_offset(4);
+            break;
+        case CheatType::IncrementiveWrite16:
+            emit_memory(Opcode::IncrementiveWrite16, line.value, 0);
+            add_offset(2);
+            break;
+        case CheatType::IncrementiveWrite8:
+            emit_memory(Opcode::IncrementiveWrite8, line.value, 0);
+            add_offset(1);
+            break;
+        case CheatType::Load32:
+            emit_memory(Opcode::Load32, line.value, 0);
+            break;
+        case CheatType::Load16:
+            emit_memory(Opcode::Load16, line.value, 0);
+            break;
+        case CheatType::Load8:
+            emit_memory(Opcode::Load8, line.value, 0);
+            break;
+        case CheatType::AddOffset:
+            emit(Opcode::AddOffset, line.value);
+            add_offset(line.value);
+            break;
+        case CheatType::Patch: {
+            // The bytes to copy are the following lines, both words of each in order
+            const std::size_t num_lines = (static_cast<std::size_t>(line.value) + 7) / 8;
+            const std::size_t available = std::min(num_lines, cheat_lines.size() - i - 1);
+            u32 num_bytes = line.value;
+            if (available < num_lines) {
+                LOG_ERROR(Core_Cheats, "Patch of {} bytes is missing {} lines of data", num_bytes,
+                          num_lines - available);
+                num_bytes = static_cast<u32>(available * 8);
+            }
+
+            Instruction& inst = emit_memory(Opcode::Patch, line.address, num_bytes);
+            inst.data_offset = static_cast<u32>(program.patch_data.size());
+            for (std::size_t j = 1; j <= available; ++j) {
+                for (const u32 word : {cheat_lines[i + j].first, cheat_lines[i + j].value}) {
+                    for (u32 shift = 0; shift < 32; shift += 8) {
+                        program.patch_data.push_back(static_cast<u8>(word >> shift));
+                    }
+                }
+            }
+            program.patch_data.resize(inst.data_offset + num_bytes);
+            i += num_lines;
+            break;
+        }
+        default:
+            // Invalid lines do nothing
+            break;
+        }
+    }
+    return program;
+}
+
+void GatewayProgram::Append(const GatewayProgram& other) {
+    const auto data_base = static_cast<u32>(patch_data.size());
+    for (Instruction inst : other.instructions) {
+        if (inst.opcode == Opcode::Patch) {
+            inst.data_offset += data_base;
+        }
+        instructions.push_back(inst);
+    }
+    patch_data.insert(patch_data.end(), other.patch_data.begin(), other.patch_data.end());
+    linked = false;
+}
+
+void GatewayProgram::Clear() {
+    instructions.clear();
+    patch_data.clear();
+    host_pointers.clear();
+    linked = false;
+}
+
+const std::vector<GatewayProgram::Instruction>& GatewayProgram::GetInstructions() const {
+    return instructions;
+}
+
+const std::vector<u8>& GatewayProgram::GetPatchData() const {
+    return patch_data;
+}
+
+void GatewayProgram::Link(Memory::MemorySystem& memory) {
+    host_pointers.assign(instructions.size(), nullptr);
+    linked = true;
+    linked_generation = memory.GetPageTableGeneration();
+
+    const auto page_table = memory.GetCurrentPageTable();
+    if (!page_table) {
+        return;
+    }
+    // Only pages of regular memory have a pointer, the others need the checks of MemorySystem
+    const auto& pointers = page_table->GetPointerArray();
+    for (std::size_t i = 0; i < instructions.size(); ++i) {
+        const Instruction& inst = instructions[i];
+        const u32 size = AccessSize(inst);
+        if (!inst.static_address || size == 0 ||
+            (inst.address & Memory::PAGE_MASK) + std::size_t{size} > Memory::PAGE_SIZE) {
+            continue;
+        }
+        u8* page_pointer = pointers[inst.address >> Memory::PAGE_BITS];
+        if (page_pointer != nullptr) {
+            host_pointers[i] = page_pointer + (inst.address & Memory::PAGE_MASK);
+        }
+    }
+}
+
+void GatewayProgram::Execute(Core::System& system) {
+    Memory::MemorySystem& memory = system.Memory();
+    if (!linked || linked_generation != memory.GetPageTableGeneration()) {
+        Link(memory);
+    }
+
+    State state;
+    std::optional<u32> pad_state;
+    for (std::size_t pc = 0; pc < instructions.size(); ++pc) {
+        const Instruction& inst = instructions[pc];
+        if (inst.opcode == Opcode::Begin) {
+            state = {};
+            continue;
+        }
+        if (state.if_flag > 0) {
+            switch (inst.opcode) {
+            case Opcode::GreaterThan32:
+            case Opcode::LessThan32:
+            case Opcode::EqualTo32:
+            case Opcode::NotEqualTo32:
+            case Opcode::GreaterThan16WithMask:
+            case Opcode::LessThan16WithMask:
+            case Opcode::EqualTo16WithMask:
+            case Opcode::NotEqualTo16WithMask:
+            case Opcode::Joker:
+                // Increment the if_flag to handle the end if correctly
+                state.if_flag++;
+                break;
+            case Opcode::Terminator:
+                state.if_flag--;
+                break;
+            case Opcode::FullTerminator:
+                FullTerminate(state, pc);
+                break;
+            default:
+                break;
+            }
+            // Do not execute any other op code
+            continue;
+        }
+
+        const VAddr addr = inst.static_address ? inst.address : inst.address + state.offset;
+        u8* const host_pointer = host_pointers[pc];
+        switch (inst.opcode) {
+        case Opcode::Write32:
+            WriteIfChanged<u32>(system, host_pointer, addr, inst.value);
+            break;
+        case Opcode::Write16:
+            WriteIfChanged<u16>(system, host_pointer, addr, static_cast<u16>(inst.value));
+            break;
+        case Opcode::Write8:
+            WriteIfChanged<u8>(system, host_pointer, addr, static_cast<u8>(inst.value));
+            break;
+        case Opcode::GreaterThan32:
+            state.if_flag += inst.value > Read<u32>(memory, host_pointer, addr) ? 0 : 1;
+            break;
+        case Opcode::LessThan32:
+            state.if_flag += inst.value < Read<u32>(memory, host_pointer, addr) ? 0 : 1;
+            break;
+        case Opcode::EqualTo32:
+            state.if_flag += inst.value == Read<u32>(memory, host_pointer, addr) ? 0 : 1;
+            break;
+        case Opcode::NotEqualTo32:
+            state.if_flag += inst.value != Read<u32>(memory, host_pointer, addr) ? 0 : 1;
+            break;
+        case Opcode::GreaterThan16WithMask:
+        case Opcode::LessThan16WithMask:
+        case Opcode::EqualTo16WithMask:
+        case Opcode::NotEqualTo16WithMask: {
+            const u16 val = Read<u16>(memory, host_pointer, addr);
+            state.if_flag += Compare16WithMask(inst.opcode, inst.value, val) ? 0 : 1;
+            break;
+        }
+        case Opcode::LoadOffset:
+            state.offset = Read<u32>(memory, host_pointer, addr);
+            break;
+        case Opcode::Loop:
+            state.loop_flag = state.loop_count < inst.value;
+            state.loop_count++;
+            state.loop_back = pc;
+            break;
+        case Opcode::Terminator:
+            break;
+        case Opcode::LoopExecuteVariant:
+            if (state.loop_flag) {
+                pc = state.loop_back - 1;
+            } else {
+                state.loop_count = 0;
+            }
+            break;
+        case Opcode::FullTerminator:
+            FullTerminate(state, pc);
+            break;
+        case Opcode::SetOffset:
+            state.offset = inst.value;
+            break;
+        case Opcode::AddValue:
+            state.reg += inst.value;
+            break;
+        case Opcode::SetValue:
+            state.reg = inst.value;
+            break;
+        case Opcode::IncrementiveWrite32:
+            WriteIfChanged<u32>(system, host_pointer, addr, state.reg);
+            state.offset += 4;
+            break;
+        case Opcode::IncrementiveWrite16:
+            WriteIfChanged<u16>(system, host_pointer, addr, static_cast<u16>(state.reg));
+            state.offset += 2;
+            break;
+        case Opcode::IncrementiveWrite8:
+            WriteIfChanged<u8>(system, host_pointer, addr, static_cast<u8>(state.reg));
+            state.offset += 1;
+            break;
+        case Opcode::Load32:
+            state.reg = Read<u32>(memory, host_pointer, addr);
+            break;
+        case Opcode::Load16:
+            state.reg = Read<u16>(memory, host_pointer, addr);
+            break;
+        case Opcode::Load8:
+            state.reg = Read<u8>(memory, host_pointer, addr);
+            break;
+        case Opcode::AddOffset:
+            state.offset += inst.value;
+            break;
+        case Opcode::Joker: {
+            // The pad state is looked up once per run, as cheats all run at the same instant
+            if (!pad_state) {
+                pad_state = system.ServiceManager()
+                                .GetService<Service::HID::Module::Interface>("hid:USER")
+                                ->GetModule()
+                                ->GetState()
+                                .hex;
+            }
+            const bool pressed = (*pad_state & inst.value) == inst.value;
+            state.if_flag += pressed ? 0 : 1;
+            break;
+        }
+        case Opcode::Patch: {
+            const u32 num_bytes = inst.value;
+            const u8* data = patch_data.data() + inst.data_offset;
+            system.InvalidateCacheRange(addr, num_bytes);
+            if (host_pointer != nullptr) {
+                std::memcpy(host_pointer, data, num_bytes);
+                break;
+            }
+            u32 i = 0;
+            for (; i + 4 <= num_bytes; i += 4) {
+                u32 word;
+                std::memcpy(&word, data + i, sizeof(word));
+                memory.Write32(addr + i, word);
+            }
+            for (; i < num_bytes; ++i) {
+                memory.Write8(addr + i, data[i]);
+            }
+            break;
+        }
+        case Opcode::Begin:
+            break;
+        }
+    }
+}
+
+} // namespace Cheats
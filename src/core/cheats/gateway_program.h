@@ -0,0 +1,106 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <vector>
+#include "common/common_types.h"
+#include "core/cheats/gateway_cheat.h"
+
+namespace Core {
+class System;
+}
+
+namespace Memory {
+class MemorySystem;
+}
+
+namespace Cheats {
+
+/**
+ * Gateway cheat code compiled to a flat list of instructions, with the patch data pulled out of
+ * the code and invalid lines dropped.
+ *
+ * Where the offset register is known at compile time, it is folded into the address of the
+ * instruction, and the host pointer backing that address is resolved once. The pointers are
+ * resolved again whenever the page table generation of the memory system changes.
+ *
+ * Programs of several cheats can be appended to one another and run in a single pass, each cheat
+ * starting with a fresh state.
+ */
+class GatewayProgram {
+public:
+    enum class Opcode : u8 {
+        /// Resets the state, at the start of each cheat
+        Begin,
+        Write32,
+        Write16,
+        Write8,
+        GreaterThan32,
+        LessThan32,
+        EqualTo32,
+        NotEqualTo32,
+        GreaterThan16WithMask,
+        LessThan16WithMask,
+        EqualTo16WithMask,
+        NotEqualTo16WithMask,
+        LoadOffset,
+        Loop,
+        Terminator,
+        LoopExecuteVariant,
+        FullTerminator,
+        SetOffset,
+        AddValue,
+        SetValue,
+        IncrementiveWrite32,
+        IncrementiveWrite16,
+        IncrementiveWrite8,
+        Load32,
+        Load16,
+        Load8,
+        AddOffset,
+        Joker,
+        Patch,
+    };
+
+    struct Instruction {
+        Opcode opcode;
+        /// Whether the offset register is already added to `address`
+        bool static_address = false;
+        /// Memory operand, before adding the offset register unless static_address is set
+        u32 address = 0;
+        /// Immediate operand. For Patch, the number of bytes to copy.
+        u32 value = 0;
+        /// For Patch, the position of the bytes to copy in the patch data
+        u32 data_offset = 0;
+    };
+
+    /// Compiles the code of one cheat
+    static GatewayProgram Compile(const std::vector<GatewayCheat::CheatLine>& cheat_lines);
+
+    /// Appends the instructions of another program, which will run after the ones of this one
+    void Append(const GatewayProgram& other);
+
+    void Clear();
+
+    const std::vector<Instruction>& GetInstructions() const;
+    const std::vector<u8>& GetPatchData() const;
+
+    /// Runs the program against the current process
+    void Execute(Core::System& system);
+
+private:
+    /// Resolves the host pointers of the static addresses against the current page table
+    void Link(Memory::MemorySystem& memory);
+
+    std::vector<Instruction> instructions;
+    std::vector<u8> patch_data;
+
+    /// Host pointer backing the address of each instruction, or null if it must go through memory
+    std::vector<u8*> host_pointers;
+    bool linked = false;
+    u64 linked_generation = 0;
+};
+
+} // namespace Cheats
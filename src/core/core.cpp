@@ -4,12 +4,14 @@
 
 #include <fstream>
 #include <memory>
+#include <optional>
 #include <stdexcept>
 #include <utility>
 #include <boost/serialization/array.hpp>
 #include "audio_core/dsp_interface.h"
 #include "audio_core/hle/hle.h"
 #include "audio_core/lle/lle.h"
+#include "common/assert.h"
 #include "common/logging/log.h"
 #include "common/texture.h"
 #include "core/arm/arm_interface.h"
@@ -17,6 +19,8 @@
 #include "core/arm/dynarmic/arm_dynarmic.h"
 #endif
 #include "core/arm/dyncom/arm_dyncom.h"
+#include "core/arm/exclusive_monitor.h"
+#include "core/cpu_threads.h"
 #include "core/cheats/cheats.h"
 #include "core/core.h"
 #include "core/core_timing.h"
@@ -25,6 +29,7 @@
 #include "core/dumping/ffmpeg_backend.h"
 #endif
 #include "core/custom_tex_cache.h"
+#include "core/dumping/image_dumper.h"
 #include "core/gdbstub/gdbstub.h"
 #include "core/global.h"
 #include "core/hle/kernel/client_port.h"
@@ -34,7 +39,6 @@
 #include "core/hle/service/apt/applet_manager.h"
 #include "core/hle/service/apt/apt.h"
 #include "core/hle/service/fs/archive.h"
-#include "core/hle/service/gsp/gsp.h"
 #include "core/hle/service/pm/pm_app.h"
 #include "core/hle/service/service.h"
 #include "core/hle/service/sm/sm.h"
@@ -46,6 +50,8 @@
 #include "core/rpc/rpc_server.h"
 #include "core/settings.h"
 #include "network/network.h"
+#include "video_core/gpu_thread.h"
+#include "video_core/pica_state.h"
 #include "video_core/renderer_base.h"
 #include "video_core/video_core.h"
 
@@ -53,6 +59,29 @@ namespace Core {
 
 /*static*/ System System::s_instance;
 
+namespace {
+/// Instance bound to the calling thread. Threads that never bind one use System::s_instance.
+thread_local System* current_instance = nullptr;
+/// Core bound to the calling thread by the parallel CPU mode
+thread_local ARM_Interface* bound_core = nullptr;
+} // Anonymous namespace
+
+System& System::GetInstance() {
+    return current_instance ? *current_instance : s_instance;
+}
+
+void System::SetCurrentInstance(System* instance) {
+    current_instance = instance;
+}
+
+ARM_Interface& System::GetRunningCore() {
+    return bound_core ? *bound_core : *running_core;
+}
+
+void System::BindRunningCore(ARM_Interface* core) {
+    bound_core = core;
+}
+
 template <>
 Core::System& Global() {
     return System::GetInstance();
@@ -68,6 +97,10 @@ Core::Timing& Global() {
     return System::GetInstance().CoreTiming();
 }
 
+System::System()
+    : pica_state(std::make_unique<Pica::State>()), gpu_state(std::make_unique<GPU::State>()),
+      lcd_regs(std::make_unique<LCD::Regs>()) {}
+
 System::~System() = default;
 
 System::ResultStatus System::RunLoop(bool tight_loop) {
@@ -96,7 +129,7 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
     }
 
     Signal signal{Signal::None};
-    u32 param{};
+    u64 param{};
     {
         std::lock_guard lock{signal_mutex};
         if (current_signal != Signal::None) {
@@ -114,7 +147,7 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
     case Signal::Load: {
         LOG_INFO(Core, "Begin load");
         try {
-            System::LoadState(param);
+            System::LoadState(static_cast<u32>(param));
             LOG_INFO(Core, "Load completed");
         } catch (const std::exception& e) {
             LOG_ERROR(Core, "Error loading: {}", e.what());
@@ -127,7 +160,7 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
     case Signal::Save: {
         LOG_INFO(Core, "Begin save");
         try {
-            System::SaveState(param);
+            System::SaveState(static_cast<u32>(param));
             LOG_INFO(Core, "Save completed");
         } catch (const std::exception& e) {
             LOG_ERROR(Core, "Error saving: {}", e.what());
@@ -137,10 +170,29 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
         frame_limiter.WaitOnce();
         return ResultStatus::Success;
     }
+    case Signal::MovieSeek: {
+        LOG_INFO(Core, "Begin movie seek to frame {}", param);
+        try {
+            Movie::GetInstance().SeekToFrame(*this, param);
+        } catch (const std::exception& e) {
+            LOG_ERROR(Core, "Error loading movie keyframe: {}", e.what());
+            status_details = e.what();
+            return ResultStatus::ErrorSavestate;
+        }
+        return ResultStatus::Success;
+    }
     default:
         break;
     }
 
+    // Movies take their keyframes between two slices, like save states
+    if (Movie::GetInstance().IsKeyframeDue()) {
+        Movie::GetInstance().RecordKeyframe(*this);
+    }
+
+    // Counts the rest of the loop as idle time when no guest code runs in this slice
+    std::optional<PerfTimer> idle_timer;
+
     // All cores should have executed the same amount of ticks. If this is not the case an event was
     // scheduled with a cycles_into_future smaller then the current downcount.
     // So we have to get those cores to the same global time first
@@ -175,6 +227,7 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
             kernel->SetRunningCPU(running_core);
         }
         if (kernel->GetCurrentThreadManager().GetCurrentThread() == nullptr) {
+            idle_timer.emplace(PerfCategory::Idle);
             LOG_TRACE(Core_ARM11, "Core {} idling", current_core_to_execute->GetID());
             current_core_to_execute->GetTimer().Idle();
             PrepareReschedule();
@@ -197,27 +250,55 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
             kernel->GetThreadManager(cpu_core->GetID()).Reschedule();
             max_slice = std::min(max_slice, cpu_core->GetTimer().GetMaxSliceLength());
         }
-        for (auto& cpu_core : cpu_cores) {
-            cpu_core->GetTimer().SetNextSlice(max_slice);
-            auto start_ticks = cpu_core->GetTimer().GetTicks();
-            LOG_TRACE(Core_ARM11, "Core {} running for {} ticks", cpu_core->GetID(),
-                      cpu_core->GetTimer().GetDowncount());
-            running_core = cpu_core.get();
+        if (std::all_of(cpu_cores.begin(), cpu_cores.end(), [this](const auto& cpu_core) {
+                return kernel->GetThreadManager(cpu_core->GetID()).GetCurrentThread() == nullptr;
+            })) {
+            idle_timer.emplace(PerfCategory::Idle);
+        }
+        if (cpu_threads && tight_loop && !GDBStub::IsServerEnabled()) {
+            // Every core gets the same slice and runs it on its own host thread. Cross-core
+            // effects, like waking a thread of another core, are picked up at the next slice.
+            std::vector<ARM_Interface*> active_cores;
+            for (auto& cpu_core : cpu_cores) {
+                cpu_core->GetTimer().SetNextSlice(max_slice);
+                kernel->SetRunningCPU(cpu_core.get());
+                if (kernel->GetCurrentThreadManager().GetCurrentThread() == nullptr) {
+                    LOG_TRACE(Core_ARM11, "Core {} idling", cpu_core->GetID());
+                    cpu_core->GetTimer().Idle();
+                    cpu_core->PrepareReschedule();
+                    reschedule_pending = true;
+                } else {
+                    active_cores.push_back(cpu_core.get());
+                }
+            }
+            running_cores_in_parallel = true;
+            cpu_threads->RunSlice(active_cores);
+            running_cores_in_parallel = false;
+            running_core = cpu_cores.back().get();
             kernel->SetRunningCPU(running_core);
-            // If we don't have a currently active thread then don't execute instructions,
-            // instead advance to the next event and try to yield to the next thread
-            if (kernel->GetCurrentThreadManager().GetCurrentThread() == nullptr) {
-                LOG_TRACE(Core_ARM11, "Core {} idling", cpu_core->GetID());
-                cpu_core->GetTimer().Idle();
-                PrepareReschedule();
-            } else {
-                if (tight_loop) {
-                    cpu_core->Run();
+        } else {
+            for (auto& cpu_core : cpu_cores) {
+                cpu_core->GetTimer().SetNextSlice(max_slice);
+                auto start_ticks = cpu_core->GetTimer().GetTicks();
+                LOG_TRACE(Core_ARM11, "Core {} running for {} ticks", cpu_core->GetID(),
+                          cpu_core->GetTimer().GetDowncount());
+                running_core = cpu_core.get();
+                kernel->SetRunningCPU(running_core);
+                // If we don't have a currently active thread then don't execute instructions,
+                // instead advance to the next event and try to yield to the next thread
+                if (kernel->GetCurrentThreadManager().GetCurrentThread() == nullptr) {
+                    LOG_TRACE(Core_ARM11, "Core {} idling", cpu_core->GetID());
+                    cpu_core->GetTimer().Idle();
+                    PrepareReschedule();
                 } else {
-                    cpu_core->Step();
+                    if (tight_loop) {
+                        cpu_core->Run();
+                    } else {
+                        cpu_core->Step();
+                    }
                 }
+                max_slice = cpu_core->GetTimer().GetTicks() - start_ticks;
             }
-            max_slice = cpu_core->GetTimer().GetTicks() - start_ticks;
         }
     }
 
@@ -231,7 +312,7 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
     return status;
 }
 
-bool System::SendSignal(System::Signal signal, u32 param) {
+bool System::SendSignal(System::Signal signal, u64 param) {
     std::lock_guard lock{signal_mutex};
     if (current_signal != signal && current_signal != Signal::None) {
         LOG_ERROR(Core, "Unable to {} as {} is ongoing", signal, current_signal);
@@ -247,6 +328,9 @@ System::ResultStatus System::SingleStep() {
 }
 
 System::ResultStatus System::Load(Frontend::EmuWindow& emu_window, const std::string& filepath) {
+    // Services, the video core and the MMIO handlers find their instance through GetInstance
+    ASSERT_MSG(&GetInstance() == this, "System must be bound to the loading thread");
+
     FileUtil::SetCurrentRomPath(filepath);
     app_loader = Loader::GetLoader(filepath);
     if (!app_loader) {
@@ -309,6 +393,9 @@ System::ResultStatus System::Load(Frontend::EmuWindow& emu_window, const std::st
                   static_cast<u32>(load_result));
     }
     perf_stats = std::make_unique<PerfStats>(title_id);
+    if (!Settings::values.perf_breakdown_file.empty()) {
+        perf_stats->StartFrameBreakdown(Settings::values.perf_breakdown_file);
+    }
     custom_tex_cache = std::make_unique<Core::CustomTexCache>();
 
     if (Settings::values.custom_textures) {
@@ -319,6 +406,9 @@ System::ResultStatus System::Load(Frontend::EmuWindow& emu_window, const std::st
     }
     if (Settings::values.preload_textures) {
         custom_tex_cache->PreloadTextures(*GetImageInterface());
+    } else {
+        custom_tex_cache->SetMemoryBudget(
+            std::size_t{Settings::values.custom_textures_memory_budget} * 1024 * 1024);
     }
 
     status = ResultStatus::Success;
@@ -332,10 +422,27 @@ System::ResultStatus System::Load(Frontend::EmuWindow& emu_window, const std::st
 }
 
 void System::PrepareReschedule() {
-    running_core->PrepareReschedule();
+    ARM_Interface& core = GetRunningCore();
+    if (cpu_threads) {
+        cpu_threads->CallOnStoppedCore(core, [&core] { core.PrepareReschedule(); });
+    } else {
+        core.PrepareReschedule();
+    }
     reschedule_pending = true;
 }
 
+void System::InvalidateCacheRange(u32 start_address, std::size_t length) {
+    for (const auto& cpu : cpu_cores) {
+        if (cpu_threads) {
+            cpu_threads->CallOnStoppedCore(*cpu, [cpu, start_address, length] {
+                cpu->InvalidateCacheRange(start_address, length);
+            });
+        } else {
+            cpu->InvalidateCacheRange(start_address, length);
+        }
+    }
+}
+
 PerfStats::Results System::GetAndResetPerfStats() {
     return (perf_stats && timing) ? perf_stats->GetAndResetStats(timing->GetGlobalTimeUs())
                                   : PerfStats::Results{};
@@ -370,6 +477,10 @@ System::ResultStatus System::Init(Frontend::EmuWindow& emu_window, u32 system_mo
             cpu_cores.push_back(
                 std::make_shared<ARM_Dynarmic>(this, *memory, i, timing->GetTimer(i)));
         }
+        if (Settings::values.enable_cpu_multithread && num_cores > 1) {
+            cpu_threads = std::make_unique<CPUThreads>(*this, num_cores);
+            exclusive_monitor = std::make_unique<ExclusiveMonitor>(num_cores);
+        }
 #else
         for (u32 i = 0; i < num_cores; ++i) {
             cpu_cores.push_back(
@@ -382,6 +493,13 @@ System::ResultStatus System::Init(Frontend::EmuWindow& emu_window, u32 system_mo
             cpu_cores.push_back(
                 std::make_shared<ARM_DynCom>(this, *memory, USER32MODE, i, timing->GetTimer(i)));
         }
+        if (this != &s_instance) {
+            LOG_WARNING(Core, "The interpreter's translation cache is shared by all instances");
+        }
+    }
+    if (Settings::values.enable_cpu_multithread && !cpu_threads) {
+        LOG_WARNING(Core, "Multithreaded CPU emulation requires the CPU JIT and more than one "
+                          "core, running the cores on the emulation thread");
     }
     running_core = cpu_cores[0].get();
 
@@ -397,12 +515,13 @@ System::ResultStatus System::Init(Frontend::EmuWindow& emu_window, u32 system_mo
 
     memory->SetDSP(*dsp_core);
 
-    dsp_core->SetSink(Settings::values.sink_id, Settings::values.audio_device_id);
-    dsp_core->EnableStretching(Settings::values.enable_audio_stretching);
+    dsp_core->SetSink(Settings::GetAudioSinkID(), Settings::values.audio_device_id);
+    dsp_core->EnableStretching(Settings::values.enable_audio_stretching &&
+                               !Settings::values.max_throughput);
 
     telemetry_session = std::make_unique<Core::TelemetrySession>();
 
-    rpc_server = std::make_unique<RPC::RPCServer>();
+    rpc_server = std::make_unique<RPC::RPCServer>(*this);
 
     service_manager = std::make_unique<Service::SM::ServiceManager>(*this);
     archive_manager = std::make_unique<Service::FS::ArchiveManager>(*this);
@@ -417,7 +536,11 @@ System::ResultStatus System::Init(Frontend::EmuWindow& emu_window, u32 system_mo
     video_dumper = std::make_unique<VideoDumper::NullBackend>();
 #endif
 
-    VideoCore::ResultStatus result = VideoCore::Init(emu_window, *memory);
+    // Created here rather than in Load, as loading a save state shuts the system down and only
+    // calls Init to bring it back
+    image_dumper = std::make_unique<Core::ImageDumper>(GetImageInterface());
+
+    VideoCore::ResultStatus result = VideoCore::Init(emu_window, renderer, gpu_thread);
     if (result != VideoCore::ResultStatus::Success) {
         switch (result) {
         case VideoCore::ResultStatus::ErrorGenericDrivers:
@@ -437,7 +560,19 @@ System::ResultStatus System::Init(Frontend::EmuWindow& emu_window, u32 system_mo
 }
 
 RendererBase& System::Renderer() {
-    return *VideoCore::g_renderer;
+    return *renderer;
+}
+
+Pica::State& System::PicaState() {
+    return *pica_state;
+}
+
+GPU::State& System::GPUState() {
+    return *gpu_state;
+}
+
+LCD::Regs& System::LCDRegs() {
+    return *lcd_regs;
 }
 
 Service::SM::ServiceManager& System::ServiceManager() {
@@ -496,6 +631,14 @@ const VideoDumper::Backend& System::VideoDumper() const {
     return *video_dumper;
 }
 
+RPC::RPCServer& System::RPCServer() {
+    return *rpc_server;
+}
+
+const RPC::RPCServer& System::RPCServer() const {
+    return *rpc_server;
+}
+
 Core::CustomTexCache& System::CustomTexCache() {
     return *custom_tex_cache;
 }
@@ -504,6 +647,10 @@ const Core::CustomTexCache& System::CustomTexCache() const {
     return *custom_tex_cache;
 }
 
+Core::ImageDumper& System::ImageDumper() {
+    return *image_dumper;
+}
+
 void System::RegisterMiiSelector(std::shared_ptr<Frontend::MiiSelector> mii_selector) {
     registered_mii_selector = std::move(mii_selector);
 }
@@ -526,9 +673,17 @@ void System::Shutdown(bool is_deserializing) {
     telemetry_session->AddField(performance, "Shutdown_Framerate", perf_results.game_fps);
     telemetry_session->AddField(performance, "Shutdown_Frametime", perf_results.frametime * 1000.0);
     telemetry_session->AddField(performance, "Mean_Frametime_MS", perf_stats->GetMeanFrametime());
+    u64 idle_loop_hits = 0;
+    for (const auto& cpu_core : cpu_cores) {
+        idle_loop_hits += cpu_core->GetIdleLoopDetector().GetHitCount();
+    }
+    telemetry_session->AddField(performance, "Shutdown_IdleLoopHits", idle_loop_hits);
+    LOG_INFO(Core, "Idle loops were skipped {} times", idle_loop_hits);
 
     // Shutdown emulation session
-    VideoCore::Shutdown();
+    VideoCore::Shutdown(renderer, gpu_thread);
+    // Writes the images that are still queued
+    image_dumper.reset();
     HW::Shutdown();
     if (!is_deserializing) {
         GDBStub::Shutdown();
@@ -541,6 +696,8 @@ void System::Shutdown(bool is_deserializing) {
     archive_manager.reset();
     service_manager.reset();
     dsp_core.reset();
+    cpu_threads.reset();
+    exclusive_monitor.reset();
     cpu_cores.clear();
     kernel.reset();
     timing.reset();
@@ -598,6 +755,12 @@ void System::serialize(Archive& ar, const unsigned int file_version) {
         Init(*m_emu_window, *system_mode.first, *n3ds_mode.first, num_cores);
     }
 
+    // Let the GPU thread finish, so that the video state below is complete
+    if (gpu_thread) {
+        gpu_thread->WaitIdle();
+        gpu_thread->RunCallbacks();
+    }
+
     // flush on save, don't flush on load
     bool should_flush = !Archive::is_loading::value;
     Memory::RasterizerClearAll(should_flush);
@@ -607,8 +770,8 @@ void System::serialize(Archive& ar, const unsigned int file_version) {
     }
     ar&* service_manager.get();
     ar&* archive_manager.get();
-    ar& GPU::g_regs;
-    ar& LCD::g_regs;
+    ar& gpu_state->regs;
+    ar&* lcd_regs;
 
     // NOTE: DSP doesn't like being destroyed and recreated. So instead we do an inline
     // serialization; this means that the DSP Settings need to match for loading to work.
@@ -628,10 +791,9 @@ void System::serialize(Archive& ar, const unsigned int file_version) {
 
     // This needs to be set from somewhere - might as well be here!
     if (Archive::is_loading::value) {
-        Service::GSP::SetGlobalModule(*this);
         memory->SetDSP(*dsp_core);
         cheat_engine->Connect();
-        VideoCore::g_renderer->Sync();
+        VideoCore::RunOnGPUThread([this] { renderer->Sync(); });
     }
 }
 
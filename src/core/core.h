@@ -7,6 +7,7 @@
 #include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 #include <boost/serialization/version.hpp>
 #include "common/common_types.h"
 #include "core/custom_tex_cache.h"
@@ -19,6 +20,7 @@
 #include "core/telemetry_session.h"
 
 class ARM_Interface;
+class ExclusiveMonitor;
 
 namespace Frontend {
 class EmuWindow;
@@ -53,25 +55,51 @@ namespace Cheats {
 class CheatEngine;
 }
 
+namespace Core {
+class ImageDumper;
+}
+
 namespace VideoDumper {
 class Backend;
 }
 
+namespace Pica {
+struct State;
+}
+
+namespace GPU {
+struct State;
+}
+
+namespace LCD {
+struct Regs;
+}
+
 class RendererBase;
 
+namespace VideoCore {
+class GPUThread;
+}
+
 namespace Core {
 
+class CPUThreads;
 class Timing;
 
 class System {
 public:
     /**
-     * Gets the instance of the System singleton class.
-     * @returns Reference to the instance of the System singleton class.
+     * Gets the System instance bound to the calling thread, or the default instance if none was
+     * bound with SetCurrentInstance.
+     * @returns Reference to the current System instance.
      */
-    [[nodiscard]] static System& GetInstance() {
-        return s_instance;
-    }
+    [[nodiscard]] static System& GetInstance();
+
+    /**
+     * Binds a System instance to the calling thread, so that the code emulating that instance on
+     * this thread finds its own state. Passing nullptr restores the default instance.
+     */
+    static void SetCurrentInstance(System* instance);
 
     /// Enumeration representing the return values of the System Initialize and Load process.
     enum class ResultStatus : u32 {
@@ -94,6 +122,7 @@ public:
         ErrorUnknown                        ///< Any other error
     };
 
+    System();
     ~System();
 
     /**
@@ -120,9 +149,9 @@ public:
     /// Shutdown and then load again
     void Reset();
 
-    enum class Signal : u32 { None, Shutdown, Reset, Save, Load };
+    enum class Signal : u32 { None, Shutdown, Reset, Save, Load, MovieSeek };
 
-    [[nodiscard]] bool SendSignal(Signal signal, u32 param = 0);
+    [[nodiscard]] bool SendSignal(Signal signal, u64 param = 0);
 
     /// Request reset of the system
     void RequestReset() {
@@ -173,9 +202,14 @@ public:
      * @returns A reference to the emulated CPU.
      */
 
-    [[nodiscard]] ARM_Interface& GetRunningCore() {
-        return *running_core;
-    };
+    [[nodiscard]] ARM_Interface& GetRunningCore();
+
+    /**
+     * Binds the core that is running on the calling thread, which GetRunningCore then returns
+     * instead of the core picked by RunLoop. Used by the host threads of the parallel CPU mode.
+     * @param core The core to bind, or nullptr to unbind.
+     */
+    static void BindRunningCore(ARM_Interface* core);
 
     /**
      * Gets a reference to the emulated CPU.
@@ -191,10 +225,16 @@ public:
         return static_cast<u32>(cpu_cores.size());
     }
 
-    void InvalidateCacheRange(u32 start_address, std::size_t length) {
-        for (const auto& cpu : cpu_cores) {
-            cpu->InvalidateCacheRange(start_address, length);
-        }
+    void InvalidateCacheRange(u32 start_address, std::size_t length);
+
+    /// Returns whether the cores are running a slice in parallel, on host threads of their own
+    [[nodiscard]] bool IsRunningCoresInParallel() const {
+        return running_cores_in_parallel;
+    }
+
+    /// Returns the monitor of the exclusive accesses, or nullptr if the cores never run in parallel
+    [[nodiscard]] ExclusiveMonitor* GetExclusiveMonitor() {
+        return exclusive_monitor.get();
     }
 
     /**
@@ -207,6 +247,35 @@ public:
 
     [[nodiscard]] RendererBase& Renderer();
 
+    /// Returns whether a renderer has been created for this instance
+    [[nodiscard]] bool HasRenderer() const {
+        return renderer != nullptr;
+    }
+
+    /// Returns the GPU thread, or nullptr if the GPU is emulated synchronously
+    [[nodiscard]] VideoCore::GPUThread* GetGPUThread() const {
+        return gpu_thread.get();
+    }
+
+    /// Gets a reference to the PICA200 register and shader state
+    [[nodiscard]] Pica::State& PicaState();
+
+    /// Gets a reference to the GPU MMIO state
+    [[nodiscard]] GPU::State& GPUState();
+
+    /// Gets a reference to the LCD registers
+    [[nodiscard]] LCD::Regs& LCDRegs();
+
+    /**
+     * Gets the lock which synchronizes access to the HLE kernel structures of this instance. It is
+     * acquired when a guest application thread performs a syscall, and should be acquired by any
+     * host thread that reads or modifies the HLE kernel state. Note: Any operation that directly
+     * or indirectly reads from or writes to the emulated memory is not protected by this mutex.
+     */
+    [[nodiscard]] std::recursive_mutex& HLELock() {
+        return hle_lock;
+    }
+
     /**
      * Gets a reference to the service manager.
      * @returns A reference to the service manager.
@@ -261,6 +330,15 @@ public:
     /// Gets a const reference to the video dumper backend
     [[nodiscard]] const VideoDumper::Backend& VideoDumper() const;
 
+    /// Gets a reference to the image dumper, which writes texture dumps and screenshots
+    [[nodiscard]] Core::ImageDumper& ImageDumper();
+
+    /// Gets a reference to the RPC server
+    [[nodiscard]] RPC::RPCServer& RPCServer();
+
+    /// Gets a const reference to the RPC server
+    [[nodiscard]] const RPC::RPCServer& RPCServer() const;
+
     std::unique_ptr<PerfStats> perf_stats;
     FrameLimiter frame_limiter;
 
@@ -305,6 +383,12 @@ public:
 
     void LoadState(u32 slot);
 
+    /// Serializes the system into a compressed save state, without the header of save state files
+    [[nodiscard]] std::vector<u8> SaveStateBuffer() const;
+
+    /// Restores the system from a compressed save state made by SaveStateBuffer
+    void LoadStateBuffer(const std::vector<u8>& buffer);
+
 private:
     /**
      * Initialize the emulated system.
@@ -326,6 +410,13 @@ private:
     std::vector<std::shared_ptr<ARM_Interface>> cpu_cores;
     ARM_Interface* running_core = nullptr;
 
+    /// Host threads for the cores, when they run in parallel
+    std::unique_ptr<CPUThreads> cpu_threads;
+    /// Set while cpu_threads runs a slice
+    bool running_cores_in_parallel = false;
+    /// Exclusive accesses of the cores, shared as they may run in parallel
+    std::unique_ptr<ExclusiveMonitor> exclusive_monitor;
+
     /// DSP core
     std::unique_ptr<AudioCore::DspInterface> dsp_core;
 
@@ -351,6 +442,9 @@ private:
     /// Custom texture cache system
     std::unique_ptr<Core::CustomTexCache> custom_tex_cache;
 
+    /// Background writer of texture dumps and screenshots
+    std::unique_ptr<Core::ImageDumper> image_dumper;
+
     /// Image interface
     std::shared_ptr<Frontend::ImageInterface> registered_image_interface;
 
@@ -363,6 +457,15 @@ private:
     std::unique_ptr<Kernel::KernelSystem> kernel;
     std::unique_ptr<Timing> timing;
 
+    /// Video and MMIO state, owned here so that each instance renders independently
+    std::unique_ptr<Pica::State> pica_state;
+    std::unique_ptr<GPU::State> gpu_state;
+    std::unique_ptr<LCD::Regs> lcd_regs;
+    std::unique_ptr<RendererBase> renderer;
+    std::unique_ptr<VideoCore::GPUThread> gpu_thread;
+
+    std::recursive_mutex hle_lock;
+
 private:
     static System s_instance;
 
@@ -377,7 +480,7 @@ private:
 
     std::mutex signal_mutex;
     Signal current_signal;
-    u32 signal_param;
+    u64 signal_param;
 
     friend class boost::serialization::access;
     template <typename Archive>
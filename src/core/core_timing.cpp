@@ -58,8 +58,8 @@ void Timing::ScheduleEvent(s64 cycles_into_future, const TimingEventType* event_
         timer = timers.at(core_id).get();
     }
 
-    s64 timeout = timer->GetTicks() + cycles_into_future;
     if (current_timer == timer) {
+        const s64 timeout = timer->GetTicks() + cycles_into_future;
         // If this event needs to be scheduled before the next advance(), force one early
         if (!timer->is_timer_sane)
             timer->ForceExceptionCheck(cycles_into_future);
@@ -68,8 +68,10 @@ void Timing::ScheduleEvent(s64 cycles_into_future, const TimingEventType* event_
             Event{timeout, timer->event_fifo_id++, userdata, event_type});
         std::push_heap(timer->event_queue.begin(), timer->event_queue.end(), std::greater<>());
     } else {
-        timer->ts_queue.Push(Event{static_cast<s64>(timer->GetTicks() + cycles_into_future), 0,
-                                   userdata, event_type});
+        // The other core may be running on a host thread of its own, so its ticks can't be read.
+        // The cores are in sync at slice boundaries, so the calling core's ticks are used instead.
+        const s64 timeout = static_cast<s64>(current_timer->GetTicks()) + cycles_into_future;
+        timer->ts_queue.Push(Event{timeout, 0, userdata, event_type});
     }
 }
 
@@ -0,0 +1,163 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <string>
+#include "common/assert.h"
+#include "common/microprofile.h"
+#include "core/arm/arm_interface.h"
+#include "core/core.h"
+#include "core/cpu_threads.h"
+#include "core/hle/kernel/kernel.h"
+
+namespace Core {
+
+namespace {
+/// Set on the threads which run cores for a CPUThreads instance
+thread_local CPUThreads* current_cpu_threads = nullptr;
+} // Anonymous namespace
+
+CPUThreads::CPUThreads(System& system, std::size_t num_cores) : system(system) {
+    // Every core runs on a thread of its own, which leaves the emulation thread free to serve them
+    workers.resize(num_cores);
+    for (auto& slot : workers) {
+        slot = std::make_unique<Worker>();
+        Worker& worker = *slot;
+        worker.thread = std::thread([this, &worker] { WorkerLoop(worker); });
+    }
+}
+
+CPUThreads::~CPUThreads() {
+    {
+        std::lock_guard lock{mutex};
+        stop = true;
+    }
+    for (auto& worker : workers) {
+        worker->start.Set();
+        worker->thread.join();
+    }
+}
+
+CPUThreads* CPUThreads::GetCurrent() {
+    return current_cpu_threads;
+}
+
+void CPUThreads::RunSlice(const std::vector<ARM_Interface*>& cores) {
+    // Cores that share the page table of the first remaining one run together
+    std::vector<ARM_Interface*> remaining = cores;
+    while (!remaining.empty()) {
+        const auto page_table = remaining.front()->GetPageTable();
+        const auto group_end =
+            std::stable_partition(remaining.begin(), remaining.end(), [&](ARM_Interface* core) {
+                return core->GetPageTable() == page_table;
+            });
+        RunGroup({remaining.begin(), group_end});
+        remaining.erase(remaining.begin(), group_end);
+    }
+    System::BindRunningCore(nullptr);
+
+    std::vector<std::function<void()>> calls;
+    {
+        std::lock_guard lock{mutex};
+        calls.swap(deferred_calls);
+    }
+    for (const auto& call : calls) {
+        call();
+    }
+}
+
+void CPUThreads::RunGroup(const std::vector<ARM_Interface*>& group) {
+    // Maps the process of the group for the HLE code serving its calls
+    BindCore(*group.front());
+
+    {
+        std::lock_guard lock{mutex};
+        pending_workers = group.size();
+        for (ARM_Interface* core : group) {
+            Worker& worker = *workers[core->GetID()];
+            worker.core = core;
+            worker.running = true;
+        }
+    }
+    for (ARM_Interface* core : group) {
+        workers[core->GetID()]->start.Set();
+    }
+
+    // Serve the calls of the cores until they have all reached the end of the slice
+    std::unique_lock lock{mutex};
+    while (true) {
+        emulation_thread_cv.wait(lock,
+                                 [this] { return pending_workers == 0 || !requests.empty(); });
+        if (requests.empty()) {
+            break;
+        }
+
+        Request* request = requests.front();
+        requests.pop_front();
+        serving_core = request->core;
+        lock.unlock();
+        BindCore(*request->core);
+        (*request->call)();
+        lock.lock();
+        serving_core = nullptr;
+        request->done = true;
+        worker_cv.notify_all();
+    }
+}
+
+void CPUThreads::CallOnEmulationThread(ARM_Interface& core, const std::function<void()>& call) {
+    Request request{&core, &call};
+    std::unique_lock lock{mutex};
+    requests.push_back(&request);
+    emulation_thread_cv.notify_one();
+    worker_cv.wait(lock, [&request] { return request.done; });
+}
+
+void CPUThreads::CallOnStoppedCore(ARM_Interface& core, std::function<void()> call) {
+    std::unique_lock lock{mutex};
+    const Worker& worker = *workers[core.GetID()];
+    // A core waiting for the emulation thread stays in its callback until the call returns
+    if (worker.running && &core != serving_core &&
+        worker.thread.get_id() != std::this_thread::get_id()) {
+        deferred_calls.push_back(std::move(call));
+        return;
+    }
+    lock.unlock();
+    call();
+}
+
+void CPUThreads::WorkerLoop(Worker& worker) {
+    Common::SetCurrentThreadName("CPU Core");
+    System::SetCurrentInstance(&system);
+    current_cpu_threads = this;
+
+    while (true) {
+        worker.start.Wait();
+        {
+            std::lock_guard lock{mutex};
+            if (stop) {
+                break;
+            }
+        }
+
+        System::BindRunningCore(worker.core);
+        worker.core->Run();
+        System::BindRunningCore(nullptr);
+
+        std::lock_guard lock{mutex};
+        worker.running = false;
+        if (--pending_workers == 0) {
+            emulation_thread_cv.notify_one();
+        }
+    }
+
+    MicroProfileOnThreadExit();
+}
+
+void CPUThreads::BindCore(ARM_Interface& core) {
+    System::BindRunningCore(&core);
+    system.Kernel().SetRunningCPU(&core);
+}
+
+} // namespace Core
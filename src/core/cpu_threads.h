@@ -0,0 +1,114 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "common/common_types.h"
+#include "common/thread.h"
+
+class ARM_Interface;
+
+namespace Core {
+
+class System;
+
+/**
+ * Runs the emulated ARM11 cores on host threads of their own. This is the opt-in alternative to
+ * running every core round-robin on the emulation thread.
+ *
+ * Synchronization rules:
+ * - Cores only run in parallel within a Core::Timing slice. Timing events, thread scheduling and
+ *   HW updates happen on the emulation thread between slices, while no core is running.
+ * - Everything a core does outside of its own JIT code (SVCs and accesses to MMIO or to memory
+ *   cached by the rasterizer) is handed to the emulation thread and runs there, one call at a
+ *   time, with the kernel bound to the calling core. HLE code therefore never runs concurrently
+ *   and always has the emulation thread's GPU context.
+ * - Memory::MemorySystem maps one process for HLE access at a time, so only cores running the
+ *   same process run in parallel. Cores of other processes run after them, within the same slice.
+ * - Calls that change the JIT state of a core, like reschedule requests and code invalidations,
+ *   run right away if the core is stopped or waiting for the emulation thread. If it is running on
+ *   its own thread, they are queued and take effect at the next slice boundary.
+ * - Plain guest memory accesses from different cores are not ordered within a slice. Exclusive
+ *   accesses (LDREX/STREX) go through the instance's ExclusiveMonitor, so they stay exclusive
+ *   across cores. The end of a slice orders all accesses made during it before everything that
+ *   follows.
+ */
+class CPUThreads {
+public:
+    CPUThreads(System& system, std::size_t num_cores);
+    ~CPUThreads();
+
+    CPUThreads(const CPUThreads&) = delete;
+    CPUThreads& operator=(const CPUThreads&) = delete;
+
+    /**
+     * Runs the given cores on their own threads until the end of their current slice, serving
+     * their calls into the emulation thread meanwhile. Returns once every core has finished and
+     * all calls queued for them have run.
+     * Must be called from the emulation thread.
+     */
+    void RunSlice(const std::vector<ARM_Interface*>& cores);
+
+    /**
+     * Runs a call made by a core on the emulation thread and blocks until it has finished.
+     * Must be called from a core thread, during RunSlice.
+     */
+    void CallOnEmulationThread(ARM_Interface& core, const std::function<void()>& call);
+
+    /**
+     * Runs a call which changes the JIT state of a core. If the core is running on another thread,
+     * the call is queued and runs once the slice has ended.
+     */
+    void CallOnStoppedCore(ARM_Interface& core, std::function<void()> call);
+
+    /// Returns the instance whose core thread is the calling thread, or nullptr
+    static CPUThreads* GetCurrent();
+
+private:
+    struct Request {
+        ARM_Interface* core;
+        const std::function<void()>* call;
+        bool done = false;
+    };
+
+    struct Worker {
+        std::thread thread;
+        Common::Event start;
+        ARM_Interface* core = nullptr;
+        /// Whether the core is inside its slice, guarded by mutex
+        bool running = false;
+    };
+
+    void WorkerLoop(Worker& worker);
+    /// Runs cores that share a page table in parallel and serves their calls
+    void RunGroup(const std::vector<ARM_Interface*>& group);
+    /// Binds the kernel and the calling thread to a core before running it or one of its calls
+    void BindCore(ARM_Interface& core);
+
+    System& system;
+    std::vector<std::unique_ptr<Worker>> workers;
+    bool stop = false;
+
+    std::mutex mutex;
+    /// Signalled when a worker finishes or posts a request
+    std::condition_variable emulation_thread_cv;
+    /// Signalled when a request has been served
+    std::condition_variable worker_cv;
+    std::size_t pending_workers = 0;
+    std::deque<Request*> requests;
+    /// Core whose request the emulation thread is serving
+    ARM_Interface* serving_core = nullptr;
+    /// Calls for cores that were running when they were made
+    std::vector<std::function<void()>> deferred_calls;
+};
+
+} // namespace Core
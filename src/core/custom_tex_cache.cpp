@@ -2,11 +2,16 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <thread>
 #include <fmt/format.h>
 #include "common/file_util.h"
 #include "common/texture.h"
 #include "core.h"
 #include "core/custom_tex_cache.h"
+#include "core/custom_tex_pack.h"
 
 namespace Core {
 CustomTexCache::CustomTexCache() = default;
@@ -22,15 +27,74 @@ void CustomTexCache::SetTextureDumped(const u64 hash) {
 }
 
 bool CustomTexCache::IsTextureCached(u64 hash) const {
+    std::lock_guard lock{cache_mutex};
     return custom_textures.count(hash);
 }
 
-const CustomTexInfo& CustomTexCache::LookupTexture(u64 hash) const {
-    return custom_textures.at(hash);
+const CustomTexInfo& CustomTexCache::LookupTexture(u64 hash) {
+    std::lock_guard lock{cache_mutex};
+    auto& cached = custom_textures.at(hash);
+    lru_list.splice(lru_list.begin(), lru_list, cached.lru_entry);
+    return cached.info;
 }
 
-void CustomTexCache::CacheTexture(u64 hash, const std::vector<u8>& tex, u32 width, u32 height) {
-    custom_textures[hash] = {width, height, tex};
+void CustomTexCache::CacheTexture(u64 hash, CustomTexInfo tex_info) {
+    std::lock_guard lock{cache_mutex};
+    const auto [it, inserted] = custom_textures.try_emplace(hash);
+    auto& cached = it->second;
+    if (!inserted) {
+        cached_size -= cached.info.tex.size();
+        lru_list.erase(cached.lru_entry);
+    }
+    cached_size += tex_info.tex.size();
+    cached.info = std::move(tex_info);
+    cached.lru_entry = lru_list.insert(lru_list.begin(), hash);
+    EvictTextures();
+}
+
+void CustomTexCache::SetMemoryBudget(std::size_t budget) {
+    std::lock_guard lock{cache_mutex};
+    memory_budget = budget;
+    EvictTextures();
+}
+
+void CustomTexCache::EvictTextures() {
+    // The most recently used texture is kept even if it does not fit on its own
+    while (memory_budget != 0 && cached_size > memory_budget && lru_list.size() > 1) {
+        const auto cached = custom_textures.find(lru_list.back());
+        cached_size -= cached->second.info.tex.size();
+        custom_textures.erase(cached);
+        lru_list.pop_back();
+    }
+}
+
+bool CustomTexCache::DecodeTexture(u64 hash, Frontend::ImageInterface& image_interface,
+                                   CustomTexInfo& tex_info) const {
+    // PNG files take precedence over the texture pack, so that textures can be edited without
+    // compiling the pack again
+    const auto path = custom_texture_paths.find(hash);
+    if (path == custom_texture_paths.end()) {
+        return texture_pack && texture_pack->ReadTexture(hash, tex_info);
+    }
+
+    const auto& path_info = path->second;
+    if (!image_interface.DecodePNG(tex_info.tex, tex_info.width, tex_info.height,
+                                   path_info.path)) {
+        LOG_ERROR(Render_OpenGL, "Failed to load custom texture {}", path_info.path);
+        return false;
+    }
+
+    // Make sure the texture size is a power of 2
+    const std::bitset<32> width_bits(tex_info.width);
+    const std::bitset<32> height_bits(tex_info.height);
+    if (width_bits.count() != 1 || height_bits.count() != 1) {
+        LOG_ERROR(Render_OpenGL, "Texture {} size is not a power of 2", path_info.path);
+        return false;
+    }
+
+    LOG_DEBUG(Render_OpenGL, "Loaded custom texture from {}", path_info.path);
+    Common::FlipRGBA8Texture(tex_info.tex, tex_info.width, tex_info.height);
+    return true;
 }
 
 void CustomTexCache::AddTexturePath(u64 hash, const std::string& path) {
@@ -47,6 +111,16 @@ void CustomTexCache::FindCustomTextures(u64 program_id) {
     const std::string load_path = fmt::format(
         "{}textures/{:016X}/", FileUtil::GetUserPath(FileUtil::UserPath::LoadDir), program_id);
 
+    const std::string pack_path = load_path + CustomTexPack::FileName;
+    if (FileUtil::Exists(pack_path)) {
+        auto pack = std::make_unique<CustomTexPack>();
+        if (pack->Open(pack_path)) {
+            LOG_INFO(Render_OpenGL, "Loaded custom texture pack {} with {} textures", pack_path,
+                     pack->GetHashes().size());
+            texture_pack = std::move(pack);
+        }
+    }
+
     if (FileUtil::Exists(load_path)) {
         FileUtil::FSTEntry texture_dir;
         std::vector<FileUtil::FSTEntry> textures;
@@ -74,29 +148,44 @@ void CustomTexCache::FindCustomTextures(u64 program_id) {
 }
 
 void CustomTexCache::PreloadTextures(Frontend::ImageInterface& image_interface) {
+    std::vector<u64> hashes;
+    if (texture_pack) {
+        hashes = texture_pack->GetHashes();
+    }
     for (const auto& path : custom_texture_paths) {
-        const auto& path_info = path.second;
-        Core::CustomTexInfo tex_info;
-        if (image_interface.DecodePNG(tex_info.tex, tex_info.width, tex_info.height,
-                                      path_info.path)) {
-            // Make sure the texture size is a power of 2
-            std::bitset<32> width_bits(tex_info.width);
-            std::bitset<32> height_bits(tex_info.height);
-            if (width_bits.count() == 1 && height_bits.count() == 1) {
-                LOG_DEBUG(Render_OpenGL, "Loaded custom texture from {}", path_info.path);
-                Common::FlipRGBA8Texture(tex_info.tex, tex_info.width, tex_info.height);
-                CacheTexture(path_info.hash, tex_info.tex, tex_info.width, tex_info.height);
-            } else {
-                LOG_ERROR(Render_OpenGL, "Texture {} size is not a power of 2", path_info.path);
+        if (!texture_pack || !texture_pack->Contains(path.first)) {
+            hashes.push_back(path.first);
+        }
+    }
+
+    std::atomic<std::size_t> next_texture{0};
+    const auto worker = [&] {
+        std::size_t i;
+        while ((i = next_texture++) < hashes.size()) {
+            CustomTexInfo tex_info;
+            if (DecodeTexture(hashes[i], image_interface, tex_info)) {
+                CacheTexture(hashes[i], std::move(tex_info));
             }
-        } else {
-            LOG_ERROR(Render_OpenGL, "Failed to load custom texture {}", path_info.path);
         }
+    };
+
+    std::vector<std::thread> threads;
+    const std::size_t thread_count =
+        std::min<std::size_t>(std::max(1U, std::thread::hardware_concurrency()), hashes.size());
+    for (std::size_t i = 1; i < thread_count; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
     }
+
+    LOG_INFO(Render_OpenGL, "Preloaded {} of {} custom textures", custom_textures.size(),
+             hashes.size());
 }
 
 bool CustomTexCache::CustomTextureExists(u64 hash) const {
-    return custom_texture_paths.count(hash);
+    return custom_texture_paths.count(hash) || (texture_pack && texture_pack->Contains(hash));
 }
 
 const CustomTexPathInfo& CustomTexCache::LookupTexturePathInfo(u64 hash) const {
@@ -104,6 +193,6 @@ const CustomTexPathInfo& CustomTexCache::LookupTexturePathInfo(u64 hash) const {
 }
 
 bool CustomTexCache::IsTexturePathMapEmpty() const {
-    return custom_texture_paths.size() == 0;
+    return custom_texture_paths.size() == 0 && !texture_pack;
 }
 } // namespace Core
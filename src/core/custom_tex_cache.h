@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include <list>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -15,6 +18,8 @@ class ImageInterface;
 } // namespace Frontend
 
 namespace Core {
+class CustomTexPack;
+
 struct CustomTexInfo {
     u32 width;
     u32 height;
@@ -37,19 +42,52 @@ public:
     void SetTextureDumped(u64 hash);
 
     bool IsTextureCached(u64 hash) const;
-    const CustomTexInfo& LookupTexture(u64 hash) const;
-    void CacheTexture(u64 hash, const std::vector<u8>& tex, u32 width, u32 height);
+    /// Returns a cached texture and marks it as recently used. The reference is only valid until
+    /// the next texture is cached, as that may evict this one.
+    const CustomTexInfo& LookupTexture(u64 hash);
+    void CacheTexture(u64 hash, CustomTexInfo tex_info);
+
+    /**
+     * Decodes a custom texture, from its PNG file or from the texture pack. Can be called from
+     * several threads at once.
+     * @returns false if the texture could not be decoded
+     */
+    bool DecodeTexture(u64 hash, Frontend::ImageInterface& image_interface,
+                       CustomTexInfo& tex_info) const;
 
     void AddTexturePath(u64 hash, const std::string& path);
     void FindCustomTextures(u64 program_id);
+    /// Decodes all the custom textures on a pool of threads and caches them
     void PreloadTextures(Frontend::ImageInterface& image_interface);
     bool CustomTextureExists(u64 hash) const;
     const CustomTexPathInfo& LookupTexturePathInfo(u64 hash) const;
     bool IsTexturePathMapEmpty() const;
 
+    /**
+     * Sets how many bytes the cached textures may use. Beyond it, the least recently used
+     * textures are evicted, and decoded again when needed. 0 disables the limit.
+     */
+    void SetMemoryBudget(std::size_t budget);
+
 private:
+    struct CachedTexture {
+        CustomTexInfo info;
+        std::list<u64>::iterator lru_entry;
+    };
+
+    /// Evicts the least recently used textures until the cache fits in the memory budget
+    void EvictTextures();
+
     std::unordered_set<u64> dumped_textures;
-    std::unordered_map<u64, CustomTexInfo> custom_textures;
+    std::unordered_map<u64, CachedTexture> custom_textures;
+    /// Hashes of the cached textures, from the most to the least recently used
+    std::list<u64> lru_list;
+    std::size_t cached_size = 0;
+    std::size_t memory_budget = 0;
+    /// Guards the cached textures, which are filled from several threads when preloading
+    mutable std::mutex cache_mutex;
+
     std::unordered_map<u64, CustomTexPathInfo> custom_texture_paths;
+    std::unique_ptr<CustomTexPack> texture_pack;
 };
 } // namespace Core
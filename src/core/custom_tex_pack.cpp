@@ -0,0 +1,163 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include "common/logging/log.h"
+#include "common/zstd_compression.h"
+#include "core/custom_tex_cache.h"
+#include "core/custom_tex_pack.h"
+
+namespace Core {
+
+namespace {
+
+constexpr std::array<char, 4> PackMagic{'C', 'T', 'E', 'X'};
+constexpr u32 PackVersion = 1;
+
+struct PackHeader {
+    std::array<char, 4> magic;
+    u32_le version;
+    u32_le num_textures;
+    u32_le reserved;
+};
+static_assert(sizeof(PackHeader) == 16, "PackHeader has incorrect size");
+
+} // Anonymous namespace
+
+CustomTexPack::CustomTexPack() = default;
+
+CustomTexPack::~CustomTexPack() = default;
+
+bool CustomTexPack::Open(const std::string& path_) {
+    path = path_;
+    file = FileUtil::IOFile(path, "rb");
+    if (!file.IsOpen()) {
+        return false;
+    }
+    file_size = file.GetSize();
+
+    PackHeader header;
+    if (file.ReadBytes(&header, sizeof(header)) != sizeof(header) || header.magic != PackMagic ||
+        header.version != PackVersion ||
+        sizeof(header) + u64{header.num_textures} * sizeof(IndexEntry) > file_size) {
+        LOG_ERROR(Core, "Invalid custom texture pack {}", path);
+        file.Close();
+        return false;
+    }
+
+    index.resize(header.num_textures);
+    if (file.ReadArray(index.data(), index.size()) != index.size()) {
+        LOG_ERROR(Core, "Failed to read the index of custom texture pack {}", path);
+        index.clear();
+        file.Close();
+        return false;
+    }
+
+    // Drop the entries pointing outside of the file, in case it was truncated
+    index.erase(std::remove_if(index.begin(), index.end(),
+                               [this](const IndexEntry& entry) {
+                                   return entry.offset > file_size ||
+                                          entry.size > file_size - entry.offset;
+                               }),
+                index.end());
+    if (index.size() != header.num_textures) {
+        LOG_ERROR(Core, "Custom texture pack {} is truncated, {} of {} textures are missing", path,
+                  header.num_textures - index.size(), header.num_textures);
+    }
+
+    std::sort(index.begin(), index.end(),
+              [](const IndexEntry& a, const IndexEntry& b) { return a.hash < b.hash; });
+    return true;
+}
+
+std::vector<u64> CustomTexPack::GetHashes() const {
+    std::vector<u64> hashes;
+    hashes.reserve(index.size());
+    for (const auto& entry : index) {
+        hashes.push_back(entry.hash);
+    }
+    return hashes;
+}
+
+bool CustomTexPack::Contains(u64 hash) const {
+    return FindEntry(hash) != nullptr;
+}
+
+bool CustomTexPack::ReadTexture(u64 hash, CustomTexInfo& tex_info) {
+    const IndexEntry* entry = FindEntry(hash);
+    if (!entry) {
+        return false;
+    }
+
+    // Only the read is serialized, textures are decompressed in parallel
+    std::vector<u8> compressed(entry->size);
+    {
+        std::lock_guard lock{file_mutex};
+        if (!file.Seek(static_cast<s64>(entry->offset), SEEK_SET) ||
+            file.ReadBytes(compressed.data(), compressed.size()) != compressed.size()) {
+            LOG_ERROR(Core, "Failed to read custom texture {:016X} from {}", hash, path);
+            return false;
+        }
+    }
+
+    tex_info.width = entry->width;
+    tex_info.height = entry->height;
+    tex_info.tex = Common::Compression::DecompressDataZSTD(compressed);
+    if (tex_info.tex.size() != std::size_t{tex_info.width} * tex_info.height * 4) {
+        LOG_ERROR(Core, "Custom texture {:016X} in {} is corrupted", hash, path);
+        return false;
+    }
+    return true;
+}
+
+CustomTexPack::CompressedTexture CustomTexPack::CompressTexture(u64 hash,
+                                                               const CustomTexInfo& tex_info,
+                                                               s32 compression_level) {
+    return {hash, tex_info.width, tex_info.height,
+            Common::Compression::CompressDataZSTD(tex_info.tex.data(), tex_info.tex.size(),
+                                                  compression_level)};
+}
+
+bool CustomTexPack::Write(const std::string& path, std::vector<CompressedTexture> textures) {
+    std::sort(textures.begin(), textures.end(),
+              [](const CompressedTexture& a, const CompressedTexture& b) {
+                  return a.hash < b.hash;
+              });
+
+    FileUtil::IOFile file(path, "wb");
+    if (!file.IsOpen()) {
+        return false;
+    }
+
+    const PackHeader header{PackMagic, PackVersion, static_cast<u32>(textures.size()), 0};
+    std::vector<IndexEntry> entries;
+    entries.reserve(textures.size());
+    u64 offset = sizeof(header) + textures.size() * sizeof(IndexEntry);
+    for (const auto& texture : textures) {
+        entries.push_back({texture.hash, texture.width, texture.height, offset,
+                           static_cast<u32>(texture.data.size()), 0});
+        offset += texture.data.size();
+    }
+
+    file.WriteObject(header);
+    file.WriteArray(entries.data(), entries.size());
+    for (const auto& texture : textures) {
+        file.WriteBytes(texture.data.data(), texture.data.size());
+    }
+    return file.IsGood();
+}
+
+const CustomTexPack::IndexEntry* CustomTexPack::FindEntry(u64 hash) const {
+    const auto it = std::lower_bound(
+        index.begin(), index.end(), hash,
+        [](const IndexEntry& entry, u64 value) { return entry.hash < value; });
+    if (it == index.end() || it->hash != hash) {
+        return nullptr;
+    }
+    return &*it;
+}
+
+} // namespace Core
@@ -0,0 +1,83 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+#include "common/file_util.h"
+#include "common/swap.h"
+
+namespace Core {
+
+struct CustomTexInfo;
+
+/**
+ * A pack of custom textures for one title, decoded ahead of time so that they can be loaded
+ * without PNG decoding.
+ *
+ * The file starts with a header and an index of fixed size entries sorted by texture hash,
+ * followed by the texture data. Each texture is stored as flipped RGBA8, compressed with zstd, at
+ * an absolute offset in the file, so a texture can be read without reading the ones before it.
+ */
+class CustomTexPack {
+public:
+    /// A texture compressed for writing to a pack
+    struct CompressedTexture {
+        u64 hash;
+        u32 width;
+        u32 height;
+        std::vector<u8> data;
+    };
+
+    /// Name of the texture pack in the custom texture directory of a title
+    static constexpr char FileName[] = "textures.pack";
+
+    CustomTexPack();
+    ~CustomTexPack();
+
+    /// Opens a pack and reads its index. Returns false if the file is not a valid pack.
+    bool Open(const std::string& path);
+
+    /// Returns the hashes of all the textures in the pack
+    std::vector<u64> GetHashes() const;
+
+    bool Contains(u64 hash) const;
+
+    /**
+     * Reads and decompresses a texture. Can be called from several threads at once.
+     * @returns false if the texture is not in the pack or its data is corrupted
+     */
+    bool ReadTexture(u64 hash, CustomTexInfo& tex_info);
+
+    /// Compresses a flipped RGBA8 texture for writing to a pack, with a zstd level from 1 to 22
+    static CompressedTexture CompressTexture(u64 hash, const CustomTexInfo& tex_info,
+                                             s32 compression_level);
+
+    /// Writes the given textures to a new pack. Returns false if the file could not be written.
+    static bool Write(const std::string& path, std::vector<CompressedTexture> textures);
+
+private:
+    struct IndexEntry {
+        u64_le hash;
+        u32_le width;
+        u32_le height;
+        u64_le offset; ///< Offset of the compressed data from the start of the file
+        u32_le size;   ///< Size of the compressed data
+        u32_le reserved;
+    };
+    static_assert(sizeof(IndexEntry) == 32, "IndexEntry has incorrect size");
+
+    const IndexEntry* FindEntry(u64 hash) const;
+
+    std::string path;
+    FileUtil::IOFile file;
+    std::mutex file_mutex;
+    u64 file_size = 0;
+    std::vector<IndexEntry> index;
+};
+
+} // namespace Core
@@ -2,15 +2,56 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
-#include <cstring>
+#include <algorithm>
+#include <utility>
 #include "core/dumping/backend.h"
 
 namespace VideoDumper {
 
-VideoFrame::VideoFrame(std::size_t width_, std::size_t height_, u8* data_)
-    : width(width_), height(height_), stride(width * 4), data(data_, data_ + width * height * 4) {}
+FramePool::FramePool(std::size_t max_buffers) : state(std::make_shared<State>()) {
+    state->max_buffers = std::max<std::size_t>(max_buffers, 1);
+}
+
+FramePool::~FramePool() = default;
+
+FrameBuffer FramePool::Acquire(std::size_t size) {
+    std::unique_ptr<std::vector<u8>> buffer;
+    {
+        std::unique_lock lock{state->mutex};
+        state->buffer_released.wait(
+            lock, [this] { return state->buffers_in_use < state->max_buffers; });
+        ++state->buffers_in_use;
+        if (!state->free_buffers.empty()) {
+            buffer = std::move(state->free_buffers.back());
+            state->free_buffers.pop_back();
+        }
+    }
+    if (!buffer) {
+        buffer = std::make_unique<std::vector<u8>>();
+    }
+    buffer->resize(size);
+
+    // The deleter keeps the state alive, in case the buffer outlives the pool
+    return FrameBuffer(buffer.release(), [state = state](std::vector<u8>* released) {
+        {
+            std::lock_guard lock{state->mutex};
+            --state->buffers_in_use;
+            state->free_buffers.emplace_back(released);
+        }
+        state->buffer_released.notify_one();
+    });
+}
+
+VideoFrame::VideoFrame(std::size_t width_, std::size_t height_, FrameBuffer data_)
+    : width(width_), height(height_), stride(static_cast<u32>(width * 4)),
+      data(std::move(data_)) {}
 
 Backend::~Backend() = default;
+
+VideoFrame Backend::AcquireVideoFrame(std::size_t width, std::size_t height) {
+    return VideoFrame(width, height, std::make_shared<std::vector<u8>>(width * height * 4));
+}
+
 NullBackend::~NullBackend() = default;
 
 } // namespace VideoDumper
\ No newline at end of file
@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include "audio_core/audio_types.h"
@@ -11,30 +14,75 @@
 #include "core/frontend/framebuffer_layout.h"
 
 namespace VideoDumper {
+
+using FrameBuffer = std::shared_ptr<std::vector<u8>>;
+
+/**
+ * Pool of reusable frame buffers, so that dumping does not allocate a buffer for every frame.
+ * A buffer goes back to the pool when its last reference is dropped, which can happen after the
+ * pool is destroyed.
+ */
+class FramePool {
+public:
+    /// @param max_buffers Number of buffers that can be in use at the same time
+    explicit FramePool(std::size_t max_buffers);
+    ~FramePool();
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    /// Returns a buffer of the given size, waiting while all the buffers of the pool are in use
+    FrameBuffer Acquire(std::size_t size);
+
+private:
+    struct State {
+        std::mutex mutex;
+        std::condition_variable buffer_released;
+        std::vector<std::unique_ptr<std::vector<u8>>> free_buffers;
+        std::size_t buffers_in_use = 0;
+        std::size_t max_buffers;
+    };
+
+    std::shared_ptr<State> state;
+};
+
 /**
  * Frame dump data for a single screen
- * data is in RGB888 format, left to right then top to bottom
+ * data is in BGRA8888 format, left to right then top to bottom. It is shared so that frames are
+ * handed between the dumping threads without being copied.
  */
 class VideoFrame {
 public:
     std::size_t width;
     std::size_t height;
     u32 stride;
-    std::vector<u8> data;
+    FrameBuffer data;
 
-    VideoFrame(std::size_t width_ = 0, std::size_t height_ = 0, u8* data_ = nullptr);
+    VideoFrame(std::size_t width_ = 0, std::size_t height_ = 0, FrameBuffer data_ = nullptr);
+};
+
+/// Counts of the video frames given to a backend since dumping last started
+struct VideoDumpingStats {
+    u64 queued_frames = 0;  ///< Frames waiting to be converted or encoded
+    u64 dropped_frames = 0; ///< Frames that could not be converted or encoded
+    u64 encoded_frames = 0; ///< Frames sent to the video encoder
 };
 
 class Backend {
 public:
     virtual ~Backend();
     virtual bool StartDumping(const std::string& path, const Layout::FramebufferLayout& layout) = 0;
+    /// Returns an empty frame of the given size to be filled and passed to AddVideoFrame
+    virtual VideoFrame AcquireVideoFrame(std::size_t width, std::size_t height);
     virtual void AddVideoFrame(VideoFrame frame) = 0;
     virtual void AddAudioFrame(AudioCore::StereoFrame16 frame) = 0;
     virtual void AddAudioSample(const std::array<s16, 2>& sample) = 0;
     virtual void StopDumping() = 0;
     virtual bool IsDumping() const = 0;
     virtual Layout::FramebufferLayout GetLayout() const = 0;
+    virtual VideoDumpingStats GetStats() const {
+        return {};
+    }
 };
 
 class NullBackend : public Backend {
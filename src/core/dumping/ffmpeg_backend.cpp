@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <unordered_set>
 #include "common/assert.h"
 #include "common/file_util.h"
@@ -71,7 +72,7 @@ void FFmpegStream::WritePacket(AVPacket& packet) {
     }
 }
 
-void FFmpegStream::SendFrame(AVFrame* frame) {
+bool FFmpegStream::SendFrame(AVFrame* frame) {
     // Initialize packet
     AVPacket packet;
     av_init_packet(&packet);
@@ -81,28 +82,30 @@ void FFmpegStream::SendFrame(AVFrame* frame) {
     // Encode frame
     if (avcodec_send_frame(codec_context.get(), frame) < 0) {
         LOG_ERROR(Render, "Frame dropped: could not send frame");
-        return;
+        return false;
     }
     int error = 1;
     while (error >= 0) {
         error = avcodec_receive_packet(codec_context.get(), &packet);
         if (error == AVERROR(EAGAIN) || error == AVERROR_EOF)
-            return;
+            return true;
         if (error < 0) {
             LOG_ERROR(Render, "Frame dropped: could not encode audio");
-            return;
+            return false;
         } else {
             // Write frame to video file
             WritePacket(packet);
         }
     }
+    return true;
 }
 
 FFmpegVideoStream::~FFmpegVideoStream() {
     Free();
 }
 
-bool FFmpegVideoStream::Init(FFmpegMuxer& muxer, const Layout::FramebufferLayout& layout_) {
+bool FFmpegVideoStream::Init(FFmpegMuxer& muxer, const Layout::FramebufferLayout& layout_,
+                             std::size_t num_scaled_frames) {
 
     InitializeFFmpegLibraries();
 
@@ -158,13 +161,16 @@ bool FFmpegVideoStream::Init(FFmpegMuxer& muxer, const Layout::FramebufferLayout
 
     // Allocate frames
     current_frame.reset(av_frame_alloc());
-    scaled_frame.reset(av_frame_alloc());
-    scaled_frame->format = codec_context->pix_fmt;
-    scaled_frame->width = layout.width;
-    scaled_frame->height = layout.height;
-    if (av_frame_get_buffer(scaled_frame.get(), 0) < 0) {
-        LOG_ERROR(Render, "Could not allocate frame buffer");
-        return false;
+    for (std::size_t i = 0; i < std::max<std::size_t>(num_scaled_frames, 1); ++i) {
+        auto& scaled_frame = scaled_frames.emplace_back(av_frame_alloc());
+        scaled_frame->format = codec_context->pix_fmt;
+        scaled_frame->width = layout.width;
+        scaled_frame->height = layout.height;
+        if (av_frame_get_buffer(scaled_frame.get(), 0) < 0) {
+            LOG_ERROR(Render, "Could not allocate frame buffer");
+            return false;
+        }
+        free_scaled_frames.Push(scaled_frame.get());
     }
 
     // Create SWS Context
@@ -181,35 +187,42 @@ void FFmpegVideoStream::Free() {
     FFmpegStream::Free();
 
     current_frame.reset();
-    scaled_frame.reset();
+    free_scaled_frames.Clear();
+    scaled_frames.clear();
     sws_context.reset();
 }
 
-void FFmpegVideoStream::ProcessFrame(VideoFrame& frame) {
+AVFrame* FFmpegVideoStream::ConvertFrame(const VideoFrame& frame) {
     if (frame.width != layout.width || frame.height != layout.height) {
         LOG_ERROR(Render, "Frame dropped: resolution does not match");
-        return;
+        return nullptr;
     }
     // Prepare frame
-    current_frame->data[0] = frame.data.data();
+    current_frame->data[0] = frame.data->data();
     current_frame->linesize[0] = frame.stride;
     current_frame->format = pixel_format;
     current_frame->width = layout.width;
     current_frame->height = layout.height;
 
-    // Scale the frame
-    if (av_frame_make_writable(scaled_frame.get()) < 0) {
+    // Scale the frame, into a frame that the encoder is done with
+    AVFrame* scaled_frame = free_scaled_frames.PopWait();
+    if (av_frame_make_writable(scaled_frame) < 0) {
         LOG_ERROR(Render, "Video frame dropped: Could not prepare frame");
-        return;
+        free_scaled_frames.Push(scaled_frame);
+        return nullptr;
     }
     if (sws_context) {
         sws_scale(sws_context.get(), current_frame->data, current_frame->linesize, 0, layout.height,
                   scaled_frame->data, scaled_frame->linesize);
     }
     scaled_frame->pts = frame_count++;
+    return scaled_frame;
+}
 
-    // Encode frame
-    SendFrame(scaled_frame.get());
+bool FFmpegVideoStream::EncodeFrame(AVFrame* frame) {
+    const bool encoded = SendFrame(frame);
+    free_scaled_frames.Push(frame);
+    return encoded;
 }
 
 FFmpegAudioStream::~FFmpegAudioStream() {
@@ -406,7 +419,8 @@ FFmpegMuxer::~FFmpegMuxer() {
     Free();
 }
 
-bool FFmpegMuxer::Init(const std::string& path, const Layout::FramebufferLayout& layout) {
+bool FFmpegMuxer::Init(const std::string& path, const Layout::FramebufferLayout& layout,
+                       std::size_t num_queued_frames) {
 
     InitializeFFmpegLibraries();
 
@@ -432,7 +446,7 @@ bool FFmpegMuxer::Init(const std::string& path, const Layout::FramebufferLayout&
     }
     format_context.reset(format_context_raw);
 
-    if (!video_stream.Init(*this, layout))
+    if (!video_stream.Init(*this, layout, num_queued_frames))
         return false;
     if (!audio_stream.Init(*this))
         return false;
@@ -461,8 +475,12 @@ void FFmpegMuxer::Free() {
     format_context.reset();
 }
 
-void FFmpegMuxer::ProcessVideoFrame(VideoFrame& frame) {
-    video_stream.ProcessFrame(frame);
+AVFrame* FFmpegMuxer::ConvertVideoFrame(const VideoFrame& frame) {
+    return video_stream.ConvertFrame(frame);
+}
+
+bool FFmpegMuxer::EncodeVideoFrame(AVFrame* frame) {
+    return video_stream.EncodeFrame(frame);
 }
 
 void FFmpegMuxer::ProcessAudioFrame(const VariableAudioFrame& channel0,
@@ -489,8 +507,10 @@ FFmpegBackend::FFmpegBackend() = default;
 FFmpegBackend::~FFmpegBackend() {
     ASSERT_MSG(!IsDumping(), "Dumping must be stopped first");
 
-    if (video_processing_thread.joinable())
-        video_processing_thread.join();
+    if (video_conversion_thread.joinable())
+        video_conversion_thread.join();
+    if (video_encoding_thread.joinable())
+        video_encoding_thread.join();
     if (audio_processing_thread.joinable())
         audio_processing_thread.join();
     ffmpeg.Free();
@@ -500,63 +520,49 @@ bool FFmpegBackend::StartDumping(const std::string& path, const Layout::Framebuf
 
     InitializeFFmpegLibraries();
 
-    if (!ffmpeg.Init(path, layout)) {
+    const std::size_t queue_depth = std::max<u32>(Settings::values.video_frame_queue_depth, 1);
+    if (!ffmpeg.Init(path, layout, queue_depth)) {
         ffmpeg.Free();
         return false;
     }
 
     video_layout = layout;
 
-    if (video_processing_thread.joinable())
-        video_processing_thread.join();
-    video_processing_thread = std::thread([&] {
-        event1.Set();
-        while (true) {
-            event2.Wait();
-            current_buffer = (current_buffer + 1) % 2;
-            next_buffer = (current_buffer + 1) % 2;
-            event1.Set();
-            // Process this frame
-            auto& frame = video_frame_buffers[current_buffer];
-            if (frame.width == 0 && frame.height == 0) {
-                // An empty frame marks the end of frame data
-                ffmpeg.FlushVideo();
-                break;
-            }
-            ffmpeg.ProcessVideoFrame(frame);
-        }
-        // Finish audio execution first if not done yet
-        if (audio_processing_thread.joinable())
-            audio_processing_thread.join();
-        EndDumping();
-    });
-
+    if (video_conversion_thread.joinable())
+        video_conversion_thread.join();
+    if (video_encoding_thread.joinable())
+        video_encoding_thread.join();
     if (audio_processing_thread.joinable())
         audio_processing_thread.join();
-    audio_processing_thread = std::thread([&] {
-        VariableAudioFrame channel0, channel1;
-        while (true) {
-            channel0 = audio_frame_queues[0].PopWait();
-            channel1 = audio_frame_queues[1].PopWait();
-            if (channel0.empty()) {
-                // An empty frame marks the end of frame data
-                ffmpeg.FlushAudio();
-                break;
-            }
-            ffmpeg.ProcessAudioFrame(channel0, channel1);
-        }
-    });
 
-    VideoCore::g_renderer->PrepareVideoDumping();
+    // Drop what was queued after the end of the previous dump
+    video_frame_queue.Clear();
+    scaled_frame_queue.Clear();
+    for (auto& queue : audio_frame_queues) {
+        queue.Clear();
+    }
+    added_frames = 0;
+    dropped_frames = 0;
+    encoded_frames = 0;
+
+    frame_pool = std::make_unique<FramePool>(queue_depth);
+    video_conversion_thread = std::thread(&FFmpegBackend::ConvertVideoFrames, this);
+    video_encoding_thread = std::thread(&FFmpegBackend::EncodeVideoFrames, this);
+    audio_processing_thread = std::thread(&FFmpegBackend::EncodeAudioFrames, this);
+
+    VideoCore::GetRenderer()->PrepareVideoDumping();
     is_dumping = true;
 
     return true;
 }
 
+VideoFrame FFmpegBackend::AcquireVideoFrame(std::size_t width, std::size_t height) {
+    return VideoFrame(width, height, frame_pool->Acquire(width * height * 4));
+}
+
 void FFmpegBackend::AddVideoFrame(VideoFrame frame) {
-    event1.Wait();
-    video_frame_buffers[next_buffer] = std::move(frame);
-    event2.Set();
+    ++added_frames;
+    video_frame_queue.Push(std::move(frame));
 }
 
 void FFmpegBackend::AddAudioFrame(AudioCore::StereoFrame16 frame) {
@@ -580,10 +586,10 @@ void FFmpegBackend::AddAudioSample(const std::array<s16, 2>& sample) {
 
 void FFmpegBackend::StopDumping() {
     is_dumping = false;
-    VideoCore::g_renderer->CleanupVideoDumping();
+    VideoCore::GetRenderer()->CleanupVideoDumping();
 
     // Flush the video processing queue
-    AddVideoFrame(VideoFrame());
+    video_frame_queue.Push(VideoFrame());
     for (auto i : {0, 1}) {
         // Flush the audio processing queue
         audio_frame_queues[i].Push(VariableAudioFrame());
@@ -600,8 +606,70 @@ Layout::FramebufferLayout FFmpegBackend::GetLayout() const {
     return video_layout;
 }
 
+VideoDumpingStats FFmpegBackend::GetStats() const {
+    VideoDumpingStats stats;
+    stats.dropped_frames = dropped_frames.load(std::memory_order_relaxed);
+    stats.encoded_frames = encoded_frames.load(std::memory_order_relaxed);
+    stats.queued_frames = added_frames.load(std::memory_order_relaxed) - stats.dropped_frames -
+                          stats.encoded_frames;
+    return stats;
+}
+
+void FFmpegBackend::ConvertVideoFrames() {
+    while (true) {
+        // The frame is moved out of the queue so that its buffer returns to the pool right after
+        // it is rescaled
+        const VideoFrame frame = video_frame_queue.PopWait();
+        if (!frame.data) {
+            // An empty frame marks the end of frame data
+            scaled_frame_queue.Push(nullptr);
+            break;
+        }
+        if (AVFrame* scaled_frame = ffmpeg.ConvertVideoFrame(frame)) {
+            scaled_frame_queue.Push(scaled_frame);
+        } else {
+            ++dropped_frames;
+        }
+    }
+}
+
+void FFmpegBackend::EncodeVideoFrames() {
+    while (true) {
+        AVFrame* frame = scaled_frame_queue.PopWait();
+        if (!frame) {
+            ffmpeg.FlushVideo();
+            break;
+        }
+        if (ffmpeg.EncodeVideoFrame(frame)) {
+            ++encoded_frames;
+        } else {
+            ++dropped_frames;
+        }
+    }
+    // Finish audio execution first if not done yet
+    if (audio_processing_thread.joinable())
+        audio_processing_thread.join();
+    EndDumping();
+}
+
+void FFmpegBackend::EncodeAudioFrames() {
+    VariableAudioFrame channel0, channel1;
+    while (true) {
+        channel0 = audio_frame_queues[0].PopWait();
+        channel1 = audio_frame_queues[1].PopWait();
+        if (channel0.empty()) {
+            // An empty frame marks the end of frame data
+            ffmpeg.FlushAudio();
+            break;
+        }
+        ffmpeg.ProcessAudioFrame(channel0, channel1);
+    }
+}
+
 void FFmpegBackend::EndDumping() {
-    LOG_INFO(Render, "Ending frame dumping");
+    const auto stats = GetStats();
+    LOG_INFO(Render, "Ending frame dumping, {} frames encoded, {} dropped", stats.encoded_frames,
+             stats.dropped_frames);
 
     ffmpeg.WriteTrailer();
     ffmpeg.Free();
@@ -47,7 +47,8 @@ protected:
     ~FFmpegStream();
 
     void WritePacket(AVPacket& packet);
-    void SendFrame(AVFrame* frame);
+    /// Encodes a frame and writes the resulting packets, returns whether the frame was encoded
+    bool SendFrame(AVFrame* frame);
 
     struct AVCodecContextDeleter {
         void operator()(AVCodecContext* codec_context) const {
@@ -69,15 +70,26 @@ protected:
 
 /**
  * A FFmpegStream used for video data.
- * Rescales, encodes and writes a frame.
+ * Rescales, encodes and writes a frame. Rescaling and encoding can run on two different threads,
+ * with the rescaled frames taken from a fixed set of frames reused once they are encoded.
  */
 class FFmpegVideoStream : public FFmpegStream {
 public:
     ~FFmpegVideoStream();
 
-    bool Init(FFmpegMuxer& muxer, const Layout::FramebufferLayout& layout);
+    /// @param num_scaled_frames Number of rescaled frames that can wait to be encoded
+    bool Init(FFmpegMuxer& muxer, const Layout::FramebufferLayout& layout,
+              std::size_t num_scaled_frames);
     void Free();
-    void ProcessFrame(VideoFrame& frame);
+
+    /**
+     * Rescales a frame to the pixel format of the encoder, waiting for a free rescaled frame.
+     * @returns The rescaled frame to pass to EncodeFrame, or nullptr if the frame is dropped
+     */
+    AVFrame* ConvertFrame(const VideoFrame& frame);
+
+    /// Encodes a frame returned by ConvertFrame, then makes it free to be reused
+    bool EncodeFrame(AVFrame* frame);
 
 private:
     struct SwsContextDeleter {
@@ -89,7 +101,9 @@ private:
     u64 frame_count{};
 
     std::unique_ptr<AVFrame, AVFrameDeleter> current_frame{};
-    std::unique_ptr<AVFrame, AVFrameDeleter> scaled_frame{};
+    std::vector<std::unique_ptr<AVFrame, AVFrameDeleter>> scaled_frames{};
+    /// Rescaled frames that are not waiting to be encoded
+    Common::MPSCQueue<AVFrame*> free_scaled_frames;
     std::unique_ptr<SwsContext, SwsContextDeleter> sws_context{};
     Layout::FramebufferLayout layout;
 
@@ -136,9 +150,11 @@ class FFmpegMuxer {
 public:
     ~FFmpegMuxer();
 
-    bool Init(const std::string& path, const Layout::FramebufferLayout& layout);
+    bool Init(const std::string& path, const Layout::FramebufferLayout& layout,
+              std::size_t num_queued_frames);
     void Free();
-    void ProcessVideoFrame(VideoFrame& frame);
+    AVFrame* ConvertVideoFrame(const VideoFrame& frame);
+    bool EncodeVideoFrame(AVFrame* frame);
     void ProcessAudioFrame(const VariableAudioFrame& channel0, const VariableAudioFrame& channel1);
     void FlushVideo();
     void FlushAudio();
@@ -162,21 +178,28 @@ private:
 
 /**
  * FFmpeg video dumping backend.
- * This class implements a double buffer.
+ * Video frames are rescaled and encoded on two threads, and audio is encoded on a third one. The
+ * frames are read into buffers from a pool, whose size is the configured queue depth, so that
+ * the frame dumper only waits once that many frames are waiting to be encoded.
  */
 class FFmpegBackend : public Backend {
 public:
     FFmpegBackend();
     ~FFmpegBackend() override;
     bool StartDumping(const std::string& path, const Layout::FramebufferLayout& layout) override;
+    VideoFrame AcquireVideoFrame(std::size_t width, std::size_t height) override;
     void AddVideoFrame(VideoFrame frame) override;
     void AddAudioFrame(AudioCore::StereoFrame16 frame) override;
     void AddAudioSample(const std::array<s16, 2>& sample) override;
     void StopDumping() override;
     bool IsDumping() const override;
     Layout::FramebufferLayout GetLayout() const override;
+    VideoDumpingStats GetStats() const override;
 
 private:
+    void ConvertVideoFrames();
+    void EncodeVideoFrames();
+    void EncodeAudioFrames();
     void EndDumping();
 
     std::atomic_bool is_dumping = false; ///< Whether the backend is currently dumping
@@ -184,10 +207,17 @@ private:
     FFmpegMuxer ffmpeg{};
 
     Layout::FramebufferLayout video_layout;
-    std::array<VideoFrame, 2> video_frame_buffers;
-    u32 current_buffer = 0, next_buffer = 1;
-    Common::Event event1, event2;
-    std::thread video_processing_thread;
+    std::unique_ptr<FramePool> frame_pool;
+    /// Frames read back from the renderer. An empty frame marks the end of the video.
+    Common::MPSCQueue<VideoFrame> video_frame_queue;
+    /// Rescaled frames waiting to be encoded. nullptr marks the end of the video.
+    Common::SPSCQueue<AVFrame*> scaled_frame_queue;
+    std::thread video_conversion_thread;
+    std::thread video_encoding_thread;
+
+    std::atomic<u64> added_frames{};
+    std::atomic<u64> dropped_frames{};
+    std::atomic<u64> encoded_frames{};
 
     std::array<Common::SPSCQueue<VariableAudioFrame>, 2> audio_frame_queues;
     std::thread audio_processing_thread;
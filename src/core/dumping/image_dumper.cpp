@@ -0,0 +1,100 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <utility>
+#include "common/logging/log.h"
+#include "common/texture.h"
+#include "core/dumping/image_dumper.h"
+#include "core/frontend/image_interface.h"
+
+namespace Core {
+
+ImageDumper::ImageDumper(std::shared_ptr<Frontend::ImageInterface> image_interface_,
+                         std::size_t num_threads, std::size_t max_queued_size_)
+    : image_interface(std::move(image_interface_)), max_queued_size(max_queued_size_) {
+    if (num_threads == 0) {
+        num_threads = std::max(1U, std::thread::hardware_concurrency() / 2);
+    }
+    for (std::size_t i = 0; i < num_threads; ++i) {
+        threads.emplace_back(&ImageDumper::WorkerLoop, this);
+    }
+}
+
+ImageDumper::~ImageDumper() {
+    {
+        std::lock_guard lock{queue_mutex};
+        stop = true;
+    }
+    queue_not_empty.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void ImageDumper::Queue(Image image) {
+    const std::size_t size = image.pixels.size();
+    {
+        std::unique_lock lock{queue_mutex};
+        // An image larger than the limit is let through when the queue is empty
+        queue_changed.wait(lock, [this, size] {
+            return queue.empty() || queued_size + size <= max_queued_size;
+        });
+        queued_size += size;
+        queue.push_back(std::move(image));
+    }
+    queue_not_empty.notify_one();
+}
+
+void ImageDumper::Flush() {
+    std::unique_lock lock{queue_mutex};
+    queue_changed.wait(lock, [this] { return queue.empty() && in_flight == 0; });
+}
+
+void ImageDumper::WorkerLoop() {
+    std::unique_lock lock{queue_mutex};
+    while (true) {
+        // The queue is drained before stopping, so that no dump is lost on shutdown
+        queue_not_empty.wait(lock, [this] { return stop || !queue.empty(); });
+        if (queue.empty()) {
+            return;
+        }
+        Image image = std::move(queue.front());
+        queue.pop_front();
+        queued_size -= image.pixels.size();
+        ++in_flight;
+        lock.unlock();
+        queue_changed.notify_all();
+
+        Write(image);
+
+        lock.lock();
+        --in_flight;
+        queue_changed.notify_all();
+    }
+}
+
+void ImageDumper::Write(Image& image) {
+    if (image.format == PixelFormat::BGRX8) {
+        for (std::size_t i = 0; i + 3 < image.pixels.size(); i += 4) {
+            std::swap(image.pixels[i], image.pixels[i + 2]);
+            image.pixels[i + 3] = 0xFF;
+        }
+    }
+    if (image.flip) {
+        Common::FlipRGBA8Texture(image.pixels, image.width, image.height);
+    }
+
+    const bool success =
+        image_interface &&
+        image_interface->EncodePNG(image.path, image.pixels, image.width, image.height);
+    if (!success) {
+        LOG_ERROR(Core, "Failed to write image {}", image.path);
+    }
+    if (image.callback) {
+        image.callback(success);
+    }
+}
+
+} // namespace Core
@@ -0,0 +1,94 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Frontend {
+class ImageInterface;
+}
+
+namespace Core {
+
+/**
+ * Encodes images to PNG and writes them on a pool of threads, so that texture dumps and
+ * screenshots do not stall the thread that produced them.
+ *
+ * The queue is bounded by the size of the images waiting in it. Queueing an image while it is full
+ * blocks until the writers catch up, so a burst of dumps cannot use unbounded memory.
+ */
+class ImageDumper {
+public:
+    enum class PixelFormat {
+        RGBA8,
+        /// As read by glReadPixels with GL_BGRA. The alpha channel is ignored.
+        BGRX8,
+    };
+
+    struct Image {
+        std::string path;
+        std::vector<u8> pixels;
+        u32 width = 0;
+        u32 height = 0;
+        PixelFormat format = PixelFormat::RGBA8;
+        /// Whether the rows are stored bottom to top, as OpenGL reads them back
+        bool flip = false;
+        /// Called from a writer thread once the image is written, with whether it succeeded
+        std::function<void(bool)> callback;
+    };
+
+    /// The default limit of the size of the images waiting to be written
+    static constexpr std::size_t DefaultMaxQueuedSize = 256 * 1024 * 1024;
+
+    /**
+     * @param image_interface Interface used to encode the images
+     * @param num_threads Number of writer threads. 0 uses half of the host's hardware concurrency.
+     * @param max_queued_size Size in bytes of the images that can wait in the queue
+     */
+    explicit ImageDumper(std::shared_ptr<Frontend::ImageInterface> image_interface,
+                         std::size_t num_threads = 0,
+                         std::size_t max_queued_size = DefaultMaxQueuedSize);
+
+    /// Writes the images still in the queue before returning
+    ~ImageDumper();
+
+    ImageDumper(const ImageDumper&) = delete;
+    ImageDumper& operator=(const ImageDumper&) = delete;
+
+    /// Queues an image to be written, blocking while the queue is full
+    void Queue(Image image);
+
+    /// Blocks until all the queued images have been written
+    void Flush();
+
+private:
+    void WorkerLoop();
+    void Write(Image& image);
+
+    std::shared_ptr<Frontend::ImageInterface> image_interface;
+    std::size_t max_queued_size;
+
+    std::mutex queue_mutex;
+    std::condition_variable queue_not_empty;
+    /// Signaled when an image leaves the queue, and when one is written
+    std::condition_variable queue_changed;
+    std::deque<Image> queue;
+    std::size_t queued_size = 0;
+    /// Images taken from the queue that are still being written
+    std::size_t in_flight = 0;
+    bool stop = false;
+
+    std::vector<std::thread> threads;
+};
+
+} // namespace Core
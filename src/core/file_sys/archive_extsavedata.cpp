@@ -31,8 +31,9 @@ namespace FileSys {
 class FixSizeDiskFile : public DiskFile {
 public:
     FixSizeDiskFile(FileUtil::IOFile&& file, const Mode& mode,
-                    std::unique_ptr<DelayGenerator> delay_generator_)
-        : DiskFile(std::move(file), mode, std::move(delay_generator_)) {
+                    std::unique_ptr<DelayGenerator> delay_generator_,
+                    std::shared_ptr<CachedFile> cache_)
+        : DiskFile(std::move(file), mode, std::move(delay_generator_), std::move(cache_)) {
         size = GetSize();
     }
 
@@ -149,14 +150,15 @@ public:
             LOG_CRITICAL(Service_FS, "(unreachable) Unknown error opening {}", full_path);
             return ERROR_FILE_NOT_FOUND;
         }
+        auto cache = disk_cache->Open(full_path, file.GetSize());
 
         Mode rwmode;
         rwmode.write_flag.Assign(1);
         rwmode.read_flag.Assign(1);
         std::unique_ptr<DelayGenerator> delay_generator =
             std::make_unique<ExtSaveDataDelayGenerator>();
-        auto disk_file =
-            std::make_unique<FixSizeDiskFile>(std::move(file), rwmode, std::move(delay_generator));
+        auto disk_file = std::make_unique<FixSizeDiskFile>(
+            std::move(file), rwmode, std::move(delay_generator), std::move(cache));
         return MakeResult<std::unique_ptr<FileBackend>>(std::move(disk_file));
     }
 
@@ -10,6 +10,7 @@
 #include <boost/serialization/export.hpp>
 #include <boost/serialization/string.hpp>
 #include "core/file_sys/archive_backend.h"
+#include "core/file_sys/disk_cache.h"
 #include "core/hle/result.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -22,7 +23,7 @@ class SDMCArchive : public ArchiveBackend {
 public:
     explicit SDMCArchive(const std::string& mount_point_,
                          std::unique_ptr<DelayGenerator> delay_generator_)
-        : mount_point(mount_point_) {
+        : mount_point(mount_point_), disk_cache(std::make_shared<DiskCache>(mount_point_)) {
         delay_generator = std::move(delay_generator_);
     }
 
@@ -45,12 +46,16 @@ public:
 protected:
     ResultVal<std::unique_ptr<FileBackend>> OpenFileBase(const Path& path, const Mode& mode) const;
     std::string mount_point;
+    std::shared_ptr<DiskCache> disk_cache;
 
     SDMCArchive() = default;
     template <class Archive>
     void serialize(Archive& ar, const unsigned int) {
         ar& boost::serialization::base_object<ArchiveBackend>(*this);
         ar& mount_point;
+        if (Archive::is_loading::value) {
+            disk_cache = std::make_shared<DiskCache>(mount_point);
+        }
     }
     friend class boost::serialization::access;
 };
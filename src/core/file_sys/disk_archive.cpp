@@ -20,13 +20,17 @@ SERIALIZE_EXPORT_IMPL(FileSys::DiskDirectory)
 
 namespace FileSys {
 
+DiskFile::~DiskFile() {
+    if (file)
+        Close();
+}
+
 ResultVal<std::size_t> DiskFile::Read(const u64 offset, const std::size_t length,
                                       u8* buffer) const {
     if (!mode.read_flag)
         return ERROR_INVALID_OPEN_FLAGS;
 
-    file->Seek(offset, SEEK_SET);
-    return MakeResult<std::size_t>(file->ReadBytes(buffer, length));
+    return MakeResult<std::size_t>(cache->Read(*file, offset, length, buffer));
 }
 
 ResultVal<std::size_t> DiskFile::Write(const u64 offset, const std::size_t length, const bool flush,
@@ -34,27 +38,41 @@ ResultVal<std::size_t> DiskFile::Write(const u64 offset, const std::size_t lengt
     if (!mode.write_flag)
         return ERROR_INVALID_OPEN_FLAGS;
 
-    file->Seek(offset, SEEK_SET);
-    std::size_t written = file->WriteBytes(buffer, length);
+    std::size_t written = cache->Write(*file, offset, length, buffer);
     if (flush)
-        file->Flush();
+        Flush();
     return MakeResult<std::size_t>(written);
 }
 
 u64 DiskFile::GetSize() const {
-    return file->GetSize();
+    return cache->GetSize();
 }
 
 bool DiskFile::SetSize(const u64 size) const {
-    file->Resize(size);
+    // Resizing writes back the dirty pages of every handle, which needs a writable file
+    if (!mode.write_flag)
+        return false;
+
+    cache->SetSize(*file, size);
     file->Flush();
     return true;
 }
 
 bool DiskFile::Close() const {
+    if (!file->IsOpen())
+        return false;
+
+    if (mode.write_flag)
+        cache->Flush(*file);
     return file->Close();
 }
 
+void DiskFile::Flush() const {
+    if (mode.write_flag)
+        cache->Flush(*file);
+    file->Flush();
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 DiskDirectory::DiskDirectory(const std::string& path) {
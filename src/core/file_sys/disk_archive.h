@@ -9,12 +9,15 @@
 #include <string>
 #include <vector>
 #include <boost/serialization/base_object.hpp>
+#include <boost/serialization/string.hpp>
 #include <boost/serialization/unique_ptr.hpp>
 #include <boost/serialization/vector.hpp>
+#include <boost/serialization/version.hpp>
 #include "common/common_types.h"
 #include "common/file_util.h"
 #include "core/file_sys/archive_backend.h"
 #include "core/file_sys/directory_backend.h"
+#include "core/file_sys/disk_cache.h"
 #include "core/file_sys/file_backend.h"
 #include "core/hle/result.h"
 
@@ -23,38 +26,58 @@
 
 namespace FileSys {
 
+/**
+ * File of a disk archive. Reads and writes go through the page cache of the file, which is shared
+ * with the other handles open on the host file, and writes reach the host file when the file is
+ * flushed, resized or closed.
+ */
 class DiskFile : public FileBackend {
 public:
     DiskFile(FileUtil::IOFile&& file_, const Mode& mode_,
-             std::unique_ptr<DelayGenerator> delay_generator_)
-        : file(new FileUtil::IOFile(std::move(file_))) {
+             std::unique_ptr<DelayGenerator> delay_generator_, std::shared_ptr<CachedFile> cache_)
+        : file(new FileUtil::IOFile(std::move(file_))), cache(std::move(cache_)) {
         delay_generator = std::move(delay_generator_);
         mode.hex = mode_.hex;
     }
 
+    ~DiskFile() override;
+
     ResultVal<std::size_t> Read(u64 offset, std::size_t length, u8* buffer) const override;
     ResultVal<std::size_t> Write(u64 offset, std::size_t length, bool flush,
                                  const u8* buffer) override;
     u64 GetSize() const override;
     bool SetSize(u64 size) const override;
     bool Close() const override;
-
-    void Flush() const override {
-        file->Flush();
-    }
+    void Flush() const override;
 
 protected:
     Mode mode;
     std::unique_ptr<FileUtil::IOFile> file;
+    std::shared_ptr<CachedFile> cache;
 
 private:
     DiskFile() = default;
 
     template <class Archive>
-    void serialize(Archive& ar, const unsigned int) {
+    void serialize(Archive& ar, const unsigned int file_version) {
+        std::string path;
+        if (Archive::is_saving::value) {
+            if (mode.write_flag) {
+                cache->Flush(*file);
+            }
+            path = cache->GetPath();
+        }
         ar& boost::serialization::base_object<FileBackend>(*this);
         ar& mode.hex;
         ar& file;
+        if (file_version > 0) {
+            ar& path;
+        }
+        if (Archive::is_loading::value) {
+            // Restored handles share the cache of their host path again. Older save states have
+            // no path, so their files get a cache of their own.
+            cache = std::make_shared<DiskCache>("Restored file")->Open(path, file->GetSize());
+        }
     }
     friend class boost::serialization::access;
 };
@@ -103,3 +126,4 @@ private:
 
 BOOST_CLASS_EXPORT_KEY(FileSys::DiskFile)
 BOOST_CLASS_EXPORT_KEY(FileSys::DiskDirectory)
+BOOST_CLASS_VERSION(FileSys::DiskFile, 1)
@@ -0,0 +1,380 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "core/file_sys/disk_cache.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// FileSys namespace
+
+namespace FileSys {
+
+namespace {
+
+/// Caches of the host files that have a handle open, shared by every archive and instance
+std::mutex open_files_mutex;
+std::unordered_map<std::string, std::weak_ptr<CachedFile>> open_files;
+
+} // Anonymous namespace
+
+DiskCache::DiskCache(std::string name) : name(std::move(name)) {}
+
+DiskCache::~DiskCache() {
+    if (stats.read_requests == 0 && stats.write_requests == 0) {
+        return;
+    }
+    LOG_DEBUG(Service_FS,
+              "{}: {} reads ({} cached), {} writes, {} host reads ({} bytes), {} host writes ({} "
+              "bytes), {} pages prefetched, {} pages evicted",
+              name, stats.read_requests.load(), stats.read_hits.load(),
+              stats.write_requests.load(), stats.host_reads.load(), stats.host_read_bytes.load(),
+              stats.host_writes.load(), stats.host_write_bytes.load(),
+              stats.prefetched_pages.load(), stats.evicted_pages.load());
+}
+
+std::shared_ptr<CachedFile> DiskCache::Open(const std::string& path, u64 size) {
+    if (path.empty()) {
+        return std::make_shared<CachedFile>(shared_from_this(), path, size);
+    }
+
+    std::lock_guard lock{open_files_mutex};
+    for (auto it = open_files.begin(); it != open_files.end();) {
+        if (it->second.expired()) {
+            it = open_files.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    std::weak_ptr<CachedFile>& entry = open_files[path];
+    if (auto file = entry.lock()) {
+        return file;
+    }
+    auto file = std::make_shared<CachedFile>(shared_from_this(), path, size);
+    entry = file;
+    return file;
+}
+
+void DiskCache::Detach(const std::string& path) {
+    const std::string directory = path + '/';
+    std::lock_guard lock{open_files_mutex};
+    for (auto it = open_files.begin(); it != open_files.end();) {
+        if (it->first == path || it->first.compare(0, directory.size(), directory) == 0) {
+            it = open_files.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+CachedFile::CachedFile(std::shared_ptr<DiskCache> owner, std::string path, u64 size)
+    : owner(std::move(owner)), path(std::move(path)), size(size) {}
+
+std::size_t CachedFile::Read(FileUtil::IOFile& file, u64 offset, std::size_t length, u8* buffer) {
+    std::lock_guard lock{mutex};
+    DiskCacheStats& stats = owner->GetStats();
+    ++stats.read_requests;
+
+    if (offset >= size || length == 0) {
+        return 0;
+    }
+    length = static_cast<std::size_t>(std::min<u64>(length, size - offset));
+    const u64 end = offset + length;
+
+    if (length >= DirectTransferSize) {
+        // The host file doesn't have the dirty pages yet, and ends before them if they extend it
+        const std::size_t read = ReadHost(file, offset, length, buffer);
+        std::fill(buffer + read, buffer + length, 0);
+        for (auto it = pages.lower_bound(offset / PageSize);
+             it != pages.end() && it->first * PageSize < end; ++it) {
+            if (!it->second.dirty) {
+                continue;
+            }
+            const u64 page_offset = it->first * PageSize;
+            const u64 copy_begin = std::max(page_offset, offset);
+            const u64 copy_end = std::min(page_offset + PageSize, end);
+            std::memcpy(buffer + (copy_begin - offset),
+                        it->second.data.data() + (copy_begin - page_offset),
+                        static_cast<std::size_t>(copy_end - copy_begin));
+        }
+        next_sequential_offset = end;
+        return length;
+    }
+
+    const u64 first = offset / PageSize;
+    const u64 last = (end - 1) / PageSize;
+
+    // Grow the read ahead window while the guest keeps reading where it left off
+    if (offset == next_sequential_offset) {
+        read_ahead_pages = std::clamp(read_ahead_pages * 2, MinReadAheadPages, MaxReadAheadPages);
+    } else {
+        read_ahead_pages = 0;
+    }
+    next_sequential_offset = end;
+
+    bool hit = true;
+    for (u64 index = first; index <= last; ++index) {
+        const auto it = pages.find(index);
+        if (it == pages.end()) {
+            hit = false;
+        } else {
+            Touch(it->second);
+        }
+    }
+
+    if (hit) {
+        ++stats.read_hits;
+    } else {
+        const u64 prefetch_last = std::min(last + read_ahead_pages, (size - 1) / PageSize);
+        LoadPages(file, first, last, prefetch_last);
+    }
+
+    for (u64 index = first; index <= last; ++index) {
+        const Page& page = pages.at(index);
+        const u64 page_offset = index * PageSize;
+        const u64 copy_begin = std::max(page_offset, offset);
+        const u64 copy_end = std::min(page_offset + PageSize, end);
+        std::memcpy(buffer + (copy_begin - offset), page.data.data() + (copy_begin - page_offset),
+                    static_cast<std::size_t>(copy_end - copy_begin));
+    }
+    return length;
+}
+
+std::size_t CachedFile::Write(FileUtil::IOFile& file, u64 offset, std::size_t length,
+                              const u8* buffer) {
+    std::lock_guard lock{mutex};
+    ++owner->GetStats().write_requests;
+
+    if (length == 0) {
+        return 0;
+    }
+    const u64 end = offset + length;
+
+    if (length >= DirectTransferSize) {
+        const std::size_t written = WriteHost(file, offset, length, buffer);
+        for (auto it = pages.lower_bound(offset / PageSize);
+             it != pages.end() && it->first * PageSize < end; ++it) {
+            const u64 page_offset = it->first * PageSize;
+            const u64 copy_begin = std::max(page_offset, offset);
+            const u64 copy_end = std::min(page_offset + PageSize, end);
+            std::memcpy(it->second.data.data() + (copy_begin - page_offset),
+                        buffer + (copy_begin - offset),
+                        static_cast<std::size_t>(copy_end - copy_begin));
+        }
+        size = std::max(size, offset + written);
+        return written;
+    }
+
+    const u64 first = offset / PageSize;
+    const u64 last = (end - 1) / PageSize;
+
+    // Pages that are only partially overwritten need their current contents first. Past the end of
+    // the file they are all zeroes.
+    for (const u64 index : {first, last}) {
+        const u64 page_offset = index * PageSize;
+        const bool partial = offset > page_offset || end < page_offset + PageSize;
+        if (partial && page_offset < size && pages.count(index) == 0) {
+            LoadPages(file, index, index, index);
+        }
+    }
+
+    std::size_t missing = 0;
+    for (u64 index = first; index <= last; ++index) {
+        missing += pages.count(index) == 0;
+    }
+    if (pages.size() + missing > MaxPages) {
+        EvictPages(pages.size() + missing - MaxPages, first, last);
+    }
+
+    for (u64 index = first; index <= last; ++index) {
+        Page& page = GetPage(index);
+        Touch(page);
+        const u64 page_offset = index * PageSize;
+        const u64 copy_begin = std::max(page_offset, offset);
+        const u64 copy_end = std::min(page_offset + PageSize, end);
+        std::memcpy(page.data.data() + (copy_begin - page_offset), buffer + (copy_begin - offset),
+                    static_cast<std::size_t>(copy_end - copy_begin));
+        if (!page.dirty) {
+            page.dirty = true;
+            ++dirty_pages;
+        }
+    }
+    size = std::max(size, end);
+
+    if (dirty_pages > MaxDirtyPages) {
+        FlushPages(file);
+    }
+    return length;
+}
+
+u64 CachedFile::GetSize() const {
+    std::lock_guard lock{mutex};
+    return size;
+}
+
+bool CachedFile::SetSize(FileUtil::IOFile& file, u64 new_size) {
+    std::lock_guard lock{mutex};
+    const bool flushed = FlushPages(file);
+    const bool resized = file.Resize(new_size);
+
+    // Clear what is past the new end, so that growing the file again reads zeroes
+    pages.erase(pages.lower_bound((new_size + PageSize - 1) / PageSize), pages.end());
+    const auto last = pages.find(new_size / PageSize);
+    if (last != pages.end()) {
+        std::fill(last->second.data.begin() + new_size % PageSize, last->second.data.end(), 0);
+    }
+    size = new_size;
+    return flushed && resized;
+}
+
+bool CachedFile::Flush(FileUtil::IOFile& file) {
+    std::lock_guard lock{mutex};
+    return FlushPages(file);
+}
+
+bool CachedFile::HasDirtyPages() const {
+    std::lock_guard lock{mutex};
+    return dirty_pages != 0;
+}
+
+bool CachedFile::FlushPages(FileUtil::IOFile& file) {
+    if (dirty_pages == 0) {
+        return true;
+    }
+
+    // Write back each run of consecutive dirty pages at once
+    bool success = true;
+    std::vector<u8> run;
+    for (auto it = pages.begin(); it != pages.end();) {
+        if (!it->second.dirty) {
+            ++it;
+            continue;
+        }
+        const u64 run_offset = it->first * PageSize;
+        run.clear();
+        for (u64 index = it->first; it != pages.end() && it->first == index && it->second.dirty;
+             ++it, ++index) {
+            run.insert(run.end(), it->second.data.begin(), it->second.data.end());
+            it->second.dirty = false;
+        }
+        if (run_offset >= size) {
+            continue;
+        }
+        const auto run_length =
+            static_cast<std::size_t>(std::min<u64>(run.size(), size - run_offset));
+        success &= WriteHost(file, run_offset, run_length, run.data()) == run_length;
+    }
+    dirty_pages = 0;
+
+    if (!success) {
+        LOG_ERROR(Service_FS, "Failed to write back cached pages");
+    }
+    return success;
+}
+
+CachedFile::Page& CachedFile::GetPage(u64 index) {
+    auto [it, inserted] = pages.try_emplace(index);
+    if (inserted) {
+        it->second.data.resize(PageSize);
+    }
+    return it->second;
+}
+
+void CachedFile::Touch(Page& page) {
+    page.last_use = ++use_counter;
+}
+
+void CachedFile::EvictPages(std::size_t count, u64 first, u64 last) {
+    if (count == 0) {
+        return;
+    }
+
+    std::vector<std::pair<u64, u64>> candidates; // last use, index
+    for (const auto& [index, page] : pages) {
+        if (!page.dirty && (index < first || index > last)) {
+            candidates.emplace_back(page.last_use, index);
+        }
+    }
+    count = std::min(count, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end());
+    for (std::size_t i = 0; i < count; ++i) {
+        pages.erase(candidates[i].second);
+    }
+    owner->GetStats().evicted_pages += count;
+}
+
+void CachedFile::LoadPages(FileUtil::IOFile& file, u64 first, u64 last, u64 prefetch_last) {
+    std::size_t missing = 0;
+    for (u64 index = first; index <= prefetch_last; ++index) {
+        missing += pages.count(index) == 0;
+    }
+    if (pages.size() + missing > MaxPages) {
+        EvictPages(pages.size() + missing - MaxPages, first, prefetch_last);
+    }
+
+    std::vector<u8> run;
+    for (u64 index = first; index <= prefetch_last;) {
+        if (pages.count(index) != 0) {
+            ++index;
+            continue;
+        }
+        u64 run_last = index;
+        while (run_last < prefetch_last && pages.count(run_last + 1) == 0) {
+            ++run_last;
+        }
+
+        run.resize(static_cast<std::size_t>(run_last - index + 1) * PageSize);
+        const std::size_t read = ReadHost(file, index * PageSize, run.size(), run.data());
+        std::fill(run.begin() + read, run.end(), 0);
+
+        for (u64 page_index = index; page_index <= run_last; ++page_index) {
+            Page& page = GetPage(page_index);
+            Touch(page);
+            const auto run_offset = static_cast<std::size_t>(page_index - index) * PageSize;
+            std::copy_n(run.begin() + run_offset, PageSize, page.data.begin());
+        }
+        if (run_last > last) {
+            owner->GetStats().prefetched_pages += run_last - std::max(index, last + 1) + 1;
+        }
+        index = run_last + 1;
+    }
+}
+
+std::size_t CachedFile::ReadHost(FileUtil::IOFile& file, u64 offset, std::size_t length,
+                                 u8* buffer) {
+    DiskCacheStats& stats = owner->GetStats();
+    ++stats.host_reads;
+
+    file.Seek(offset, SEEK_SET);
+    const std::size_t read = file.ReadBytes(buffer, length);
+    // A file that isn't open reports more bytes than requested
+    if (read > length) {
+        return 0;
+    }
+    stats.host_read_bytes += read;
+    return read;
+}
+
+std::size_t CachedFile::WriteHost(FileUtil::IOFile& file, u64 offset, std::size_t length,
+                                  const u8* buffer) {
+    DiskCacheStats& stats = owner->GetStats();
+    ++stats.host_writes;
+
+    file.Seek(offset, SEEK_SET);
+    const std::size_t written = file.WriteBytes(buffer, length);
+    if (written > length) {
+        return 0;
+    }
+    stats.host_write_bytes += written;
+    return written;
+}
+
+} // namespace FileSys
@@ -0,0 +1,155 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+
+namespace FileUtil {
+class IOFile;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// FileSys namespace
+
+namespace FileSys {
+
+class CachedFile;
+
+/// Host I/O counters of the files opened through a DiskCache. These are atomic, as a file cache
+/// can be shared with an instance running on another thread.
+struct DiskCacheStats {
+    std::atomic<u64> read_requests = 0;
+    /// Reads that were served without touching the host file
+    std::atomic<u64> read_hits = 0;
+    std::atomic<u64> write_requests = 0;
+    std::atomic<u64> host_reads = 0;
+    std::atomic<u64> host_read_bytes = 0;
+    std::atomic<u64> host_writes = 0;
+    std::atomic<u64> host_write_bytes = 0;
+    /// Pages loaded ahead of a sequential read
+    std::atomic<u64> prefetched_pages = 0;
+    std::atomic<u64> evicted_pages = 0;
+};
+
+/**
+ * Page cache of the files opened from a disk archive. Every handle opened on the same host path
+ * shares one CachedFile, so that they see each other's writes before these reach the host. The
+ * caches are shared across archives and instances, as archives with overlapping mount points can
+ * open the same host file.
+ */
+class DiskCache : public std::enable_shared_from_this<DiskCache> {
+public:
+    explicit DiskCache(std::string name);
+    ~DiskCache();
+
+    /**
+     * Gets the cache of a host file, creating it if no handle has the file open. A cache
+     * created through another DiskCache keeps counting into the stats of that one.
+     * @param path Host path of the file, an empty path gets a cache that isn't shared
+     * @param size Size of the host file, used when creating the cache
+     */
+    std::shared_ptr<CachedFile> Open(const std::string& path, u64 size);
+
+    /**
+     * Stops sharing the caches of a path, and of everything under it if it is a directory. Must be
+     * called before the path is deleted or renamed, handles that are still open keep their cache.
+     */
+    void Detach(const std::string& path);
+
+    DiskCacheStats& GetStats() {
+        return stats;
+    }
+
+    const DiskCacheStats& GetStats() const {
+        return stats;
+    }
+
+private:
+    std::string name;
+    DiskCacheStats stats;
+};
+
+/**
+ * Write-back page cache of a host file. Sequential reads prefetch the following pages, and dirty
+ * pages are written back in contiguous runs when flushed. The host file is passed to each call, as
+ * the cache is shared by every handle open on the file, which may be used from several threads.
+ */
+class CachedFile {
+public:
+    static constexpr std::size_t PageSize = 0x1000;
+    /// Pages kept per file, the least recently used clean page is evicted past this
+    static constexpr std::size_t MaxPages = 256;
+    /// Dirty pages are written back once there are more than this
+    static constexpr std::size_t MaxDirtyPages = 64;
+    static constexpr std::size_t MinReadAheadPages = 4;
+    static constexpr std::size_t MaxReadAheadPages = 32;
+    /// Transfers of at least this many bytes go straight to the host file
+    static constexpr std::size_t DirectTransferSize = 64 * PageSize;
+
+    CachedFile(std::shared_ptr<DiskCache> owner, std::string path, u64 size);
+
+    std::size_t Read(FileUtil::IOFile& file, u64 offset, std::size_t length, u8* buffer);
+    std::size_t Write(FileUtil::IOFile& file, u64 offset, std::size_t length, const u8* buffer);
+
+    /// Host path of the file, empty if the cache isn't shared
+    const std::string& GetPath() const {
+        return path;
+    }
+
+    u64 GetSize() const;
+
+    /// Writes back the dirty pages and resizes the host file
+    bool SetSize(FileUtil::IOFile& file, u64 new_size);
+
+    /// Writes back the dirty pages to the host file
+    bool Flush(FileUtil::IOFile& file);
+
+    bool HasDirtyPages() const;
+
+private:
+    struct Page {
+        std::vector<u8> data;
+        u64 last_use = 0;
+        bool dirty = false;
+    };
+
+    bool FlushPages(FileUtil::IOFile& file);
+
+    Page& GetPage(u64 index);
+    void Touch(Page& page);
+
+    /// Evicts up to `count` of the least recently used clean pages outside of [first, last]
+    void EvictPages(std::size_t count, u64 first, u64 last);
+
+    /**
+     * Loads the pages in [first, prefetch_last] that aren't cached, reading each missing run with
+     * a single host read. The pages after `last` are counted as prefetched.
+     */
+    void LoadPages(FileUtil::IOFile& file, u64 first, u64 last, u64 prefetch_last);
+
+    std::size_t ReadHost(FileUtil::IOFile& file, u64 offset, std::size_t length, u8* buffer);
+    std::size_t WriteHost(FileUtil::IOFile& file, u64 offset, std::size_t length,
+                          const u8* buffer);
+
+    std::shared_ptr<DiskCache> owner;
+    std::string path;
+    mutable std::mutex mutex;
+    std::map<u64, Page> pages;
+    std::size_t dirty_pages = 0;
+    u64 size;
+    u64 use_counter = 0;
+
+    u64 next_sequential_offset = 0;
+    std::size_t read_ahead_pages = 0;
+};
+
+} // namespace FileSys
@@ -91,9 +91,11 @@ ResultVal<std::unique_ptr<FileBackend>> SaveDataArchive::OpenFile(const Path& pa
         LOG_CRITICAL(Service_FS, "(unreachable) Unknown error opening {}", full_path);
         return ERROR_FILE_NOT_FOUND;
     }
+    auto cache = disk_cache->Open(full_path, file.GetSize());
 
     std::unique_ptr<DelayGenerator> delay_generator = std::make_unique<SaveDataDelayGenerator>();
-    auto disk_file = std::make_unique<DiskFile>(std::move(file), mode, std::move(delay_generator));
+    auto disk_file = std::make_unique<DiskFile>(std::move(file), mode, std::move(delay_generator),
+                                                std::move(cache));
     return MakeResult<std::unique_ptr<FileBackend>>(std::move(disk_file));
 }
 
@@ -123,6 +125,7 @@ ResultCode SaveDataArchive::DeleteFile(const Path& path) const {
         break; // Expected 'success' case
     }
 
+    disk_cache->Detach(full_path);
     if (FileUtil::Delete(full_path)) {
         return RESULT_SUCCESS;
     }
@@ -150,6 +153,8 @@ ResultCode SaveDataArchive::RenameFile(const Path& src_path, const Path& dest_pa
     const auto src_path_full = path_parser_src.BuildHostPath(mount_point);
     const auto dest_path_full = path_parser_dest.BuildHostPath(mount_point);
 
+    disk_cache->Detach(src_path_full);
+    disk_cache->Detach(dest_path_full);
     if (FileUtil::Rename(src_path_full, dest_path_full)) {
         return RESULT_SUCCESS;
     }
@@ -200,12 +205,17 @@ static ResultCode DeleteDirectoryHelper(const Path& path, const std::string& mou
 }
 
 ResultCode SaveDataArchive::DeleteDirectory(const Path& path) const {
-    return DeleteDirectoryHelper(path, mount_point, FileUtil::DeleteDir);
+    return DeleteDirectoryHelper(path, mount_point, [this](const std::string& p) {
+        disk_cache->Detach(p);
+        return FileUtil::DeleteDir(p);
+    });
 }
 
 ResultCode SaveDataArchive::DeleteDirectoryRecursively(const Path& path) const {
-    return DeleteDirectoryHelper(
-        path, mount_point, [](const std::string& p) { return FileUtil::DeleteDirRecursively(p); });
+    return DeleteDirectoryHelper(path, mount_point, [this](const std::string& p) {
+        disk_cache->Detach(p);
+        return FileUtil::DeleteDirRecursively(p);
+    });
 }
 
 ResultCode SaveDataArchive::CreateFile(const FileSys::Path& path, u64 size) const {
@@ -309,6 +319,8 @@ ResultCode SaveDataArchive::RenameDirectory(const Path& src_path, const Path& de
     const auto src_path_full = path_parser_src.BuildHostPath(mount_point);
     const auto dest_path_full = path_parser_dest.BuildHostPath(mount_point);
 
+    disk_cache->Detach(src_path_full);
+    disk_cache->Detach(dest_path_full);
     if (FileUtil::Rename(src_path_full, dest_path_full)) {
         return RESULT_SUCCESS;
     }
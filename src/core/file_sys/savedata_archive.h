@@ -4,9 +4,11 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include "core/file_sys/archive_backend.h"
 #include "core/file_sys/directory_backend.h"
+#include "core/file_sys/disk_cache.h"
 #include "core/file_sys/file_backend.h"
 #include "core/hle/result.h"
 
@@ -18,7 +20,8 @@ namespace FileSys {
 /// Archive backend for general save data archive type (SaveData and SystemSaveData)
 class SaveDataArchive : public ArchiveBackend {
 public:
-    explicit SaveDataArchive(const std::string& mount_point_) : mount_point(mount_point_) {}
+    explicit SaveDataArchive(const std::string& mount_point_)
+        : mount_point(mount_point_), disk_cache(std::make_shared<DiskCache>(mount_point_)) {}
 
     std::string GetName() const override {
         return "SaveDataArchive: " + mount_point;
@@ -38,6 +41,7 @@ public:
 
 protected:
     std::string mount_point;
+    std::shared_ptr<DiskCache> disk_cache;
     SaveDataArchive() = default;
 
 private:
@@ -45,6 +49,9 @@ private:
     void serialize(Archive& ar, const unsigned int) {
         ar& boost::serialization::base_object<ArchiveBackend>(*this);
         ar& mount_point;
+        if (Archive::is_loading::value) {
+            disk_cache = std::make_shared<DiskCache>(mount_point);
+        }
     }
     friend class boost::serialization::access;
 };
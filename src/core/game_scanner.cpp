@@ -0,0 +1,310 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <thread>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "common/string_util.h"
+#include "core/game_scanner.h"
+#include "core/hle/service/am/am.h"
+#include "core/hle/service/fs/archive.h"
+#include "core/hw/aes/key.h"
+#include "core/loader/loader.h"
+#include "core/loader/smdh.h"
+
+namespace Core {
+
+namespace {
+
+constexpr std::array<char, 4> IndexMagic{'C', 'G', 'L', 'I'};
+constexpr u32 IndexVersion = 1;
+
+template <typename T>
+bool ReadValue(FileUtil::IOFile& file, T& value) {
+    return file.ReadBytes(&value, sizeof(T)) == sizeof(T);
+}
+
+template <typename T>
+void WriteValue(FileUtil::IOFile& file, const T& value) {
+    file.WriteBytes(&value, sizeof(T));
+}
+
+/// Returns the directory a file is in, as used to key scanned_directories.
+std::string GetParentDirectory(const std::string& path) {
+    return path.substr(0, path.find_last_of(DIR_SEP_CHR));
+}
+
+} // Anonymous namespace
+
+GameScanner::GameScanner(std::string index_path_, std::size_t num_threads_)
+    : index_path(std::move(index_path_)), num_threads(num_threads_) {
+    if (num_threads == 0) {
+        num_threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+}
+
+GameScanner::~GameScanner() {
+    SaveIndex();
+}
+
+bool GameScanner::HasSupportedFileExtension(const std::string& file_name) {
+    const std::size_t dot = file_name.find_last_of('.');
+    if (dot == std::string::npos) {
+        return false;
+    }
+    const std::string extension = Common::ToLower(file_name.substr(dot + 1));
+    const auto& extensions = Loader::SupportedFileExtensions;
+    return std::find(extensions.begin(), extensions.end(), extension) != extensions.end();
+}
+
+std::string GameScanner::GetDefaultIndexPath() {
+    return FileUtil::GetUserPath(FileUtil::UserPath::CacheDir) + "game_list_index.bin";
+}
+
+void GameScanner::Cancel() {
+    stop_processing = true;
+}
+
+std::vector<GameEntry> GameScanner::ScanDirectory(const std::string& directory,
+                                                  unsigned int recursion,
+                                                  std::vector<std::string>* watch_list) {
+    stop_processing = false;
+    LoadIndex();
+
+    // Walk the directory tree first. This is cheap compared to identifying the files.
+    std::vector<std::string> files;
+    std::vector<std::string> directories;
+    std::function<void(const std::string&, unsigned int)> walk;
+    walk = [&](const std::string& dir_path, unsigned int depth) {
+        directories.push_back(dir_path);
+        const auto callback = [&](u64*, const std::string& dir, const std::string& name) -> bool {
+            if (stop_processing) {
+                // Breaks the callback loop.
+                return false;
+            }
+            const std::string physical_name = dir + DIR_SEP + name;
+            const bool is_dir = FileUtil::IsDirectory(physical_name);
+            if (!is_dir && HasSupportedFileExtension(physical_name)) {
+                files.push_back(physical_name);
+            } else if (is_dir && depth > 0) {
+                if (watch_list) {
+                    watch_list->push_back(physical_name);
+                }
+                walk(physical_name, depth - 1);
+            }
+            return true;
+        };
+        FileUtil::ForeachDirectoryEntry(nullptr, dir_path, callback);
+    };
+    walk(directory, recursion);
+
+    // Encrypted NCCH loading initializes the AES keys lazily, which is not thread-safe.
+    HW::AES::InitKeys();
+
+    std::vector<std::optional<GameEntry>> results(files.size());
+    std::atomic<std::size_t> next_file{0};
+    const auto worker = [&] {
+        std::size_t i;
+        while (!stop_processing && (i = next_file++) < files.size()) {
+            results[i] = ScanFile(files[i]);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    const std::size_t thread_count = std::min(num_threads, files.size());
+    for (std::size_t i = 1; i < thread_count; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    if (!stop_processing) {
+        std::lock_guard lock{index_mutex};
+        scanned_directories.insert(directories.begin(), directories.end());
+    }
+
+    std::vector<GameEntry> games;
+    for (auto& result : results) {
+        if (result) {
+            games.push_back(std::move(*result));
+        }
+    }
+    return games;
+}
+
+GameScanner::FileInfo GameScanner::GetFileInfo(const std::string& path) {
+    const u64 size = FileUtil::GetSize(path);
+    const s64 modification_time = FileUtil::GetModificationTime(path);
+
+    {
+        std::lock_guard lock{index_mutex};
+        used_paths.insert(path);
+        const auto it = index.find(path);
+        if (it != index.end() && it->second.size == size &&
+            it->second.modification_time == modification_time) {
+            return it->second;
+        }
+    }
+
+    FileInfo info;
+    info.size = size;
+    info.modification_time = modification_time;
+
+    std::unique_ptr<Loader::AppLoader> loader = Loader::GetLoader(path);
+    if (loader) {
+        bool executable = false;
+        const auto res = loader->IsExecutable(executable);
+        info.is_game = executable || res == Loader::ResultStatus::ErrorEncrypted;
+        loader->ReadProgramId(info.program_id);
+        loader->ReadExtdataId(info.extdata_id);
+        loader->ReadIcon(info.smdh);
+        info.file_type = static_cast<u32>(loader->GetFileType());
+    }
+
+    std::lock_guard lock{index_mutex};
+    index[path] = info;
+    index_dirty = true;
+    return info;
+}
+
+std::optional<GameEntry> GameScanner::ScanFile(const std::string& path) {
+    FileInfo info = GetFileInfo(path);
+    if (!info.is_game) {
+        return std::nullopt;
+    }
+
+    GameEntry entry;
+    entry.path = path;
+    entry.program_id = info.program_id;
+    entry.extdata_id = info.extdata_id;
+    entry.file_type = static_cast<Loader::FileType>(info.file_type);
+    entry.size = info.size;
+
+    // Look for an update icon if available
+    if (!(info.program_id & ~0x00040000FFFFFFFF)) {
+        const std::string update_path = Service::AM::GetTitleContentPath(
+            Service::FS::MediaType::SDMC, info.program_id | 0x0000000E00000000);
+        {
+            // The update of this title was looked up, so other files of its content directory
+            // that are still indexed belong to removed or replaced updates.
+            std::lock_guard lock{index_mutex};
+            scanned_directories.insert(GetParentDirectory(update_path));
+        }
+        if (FileUtil::Exists(update_path)) {
+            FileInfo update_info = GetFileInfo(update_path);
+            if (Loader::IsValidSMDH(update_info.smdh)) {
+                entry.smdh = std::move(update_info.smdh);
+            }
+        }
+    }
+
+    if (!Loader::IsValidSMDH(entry.smdh)) {
+        // Use the original smdh if there is no valid update smdh
+        entry.smdh = std::move(info.smdh);
+    }
+    return entry;
+}
+
+void GameScanner::LoadIndex() {
+    std::lock_guard lock{index_mutex};
+    if (index_loaded || index_path.empty()) {
+        return;
+    }
+    index_loaded = true;
+
+    FileUtil::IOFile file(index_path, "rb");
+    if (!file.IsOpen()) {
+        return;
+    }
+
+    std::array<char, 4> magic{};
+    u32 version = 0;
+    u32 count = 0;
+    if (file.ReadArray(magic.data(), magic.size()) != magic.size() || magic != IndexMagic ||
+        !ReadValue(file, version) || version != IndexVersion || !ReadValue(file, count)) {
+        LOG_WARNING(Frontend, "Ignoring invalid game list index {}", index_path);
+        return;
+    }
+
+    for (u32 i = 0; i < count; ++i) {
+        u16 path_length;
+        u32 smdh_size;
+        u8 is_game;
+        FileInfo info;
+        if (!ReadValue(file, path_length)) {
+            break;
+        }
+        std::string path(path_length, '\0');
+        if (file.ReadBytes(path.data(), path_length) != path_length ||
+            !ReadValue(file, info.size) || !ReadValue(file, info.modification_time) ||
+            !ReadValue(file, is_game) || !ReadValue(file, info.program_id) ||
+            !ReadValue(file, info.extdata_id) || !ReadValue(file, info.file_type) ||
+            !ReadValue(file, smdh_size)) {
+            break;
+        }
+        info.is_game = is_game != 0;
+        info.smdh.resize(smdh_size);
+        if (file.ReadBytes(info.smdh.data(), smdh_size) != smdh_size) {
+            break;
+        }
+        index.emplace(std::move(path), std::move(info));
+    }
+    LOG_DEBUG(Frontend, "Loaded {} entries from the game list index", index.size());
+}
+
+void GameScanner::SaveIndex() {
+    std::lock_guard lock{index_mutex};
+    if (index_path.empty()) {
+        return;
+    }
+
+    // Drop files that a completed scan of their directory did not find, because they were deleted.
+    // Files of other directories are kept, as they may belong to another game directory.
+    for (auto it = index.begin(); it != index.end();) {
+        const std::string& path = it->first;
+        const bool deleted =
+            scanned_directories.count(GetParentDirectory(path)) && !used_paths.count(path);
+        if (deleted) {
+            it = index.erase(it);
+            index_dirty = true;
+        } else {
+            ++it;
+        }
+    }
+    if (!index_dirty) {
+        return;
+    }
+
+    FileUtil::CreateFullPath(index_path);
+    FileUtil::IOFile file(index_path, "wb");
+    if (!file.IsOpen()) {
+        LOG_ERROR(Frontend, "Could not write game list index {}", index_path);
+        return;
+    }
+
+    file.WriteArray(IndexMagic.data(), IndexMagic.size());
+    WriteValue(file, IndexVersion);
+    WriteValue(file, static_cast<u32>(index.size()));
+    for (const auto& [path, info] : index) {
+        WriteValue(file, static_cast<u16>(path.size()));
+        file.WriteBytes(path.data(), path.size());
+        WriteValue(file, info.size);
+        WriteValue(file, info.modification_time);
+        WriteValue(file, static_cast<u8>(info.is_game));
+        WriteValue(file, info.program_id);
+        WriteValue(file, info.extdata_id);
+        WriteValue(file, info.file_type);
+        WriteValue(file, static_cast<u32>(info.smdh.size()));
+        file.WriteBytes(info.smdh.data(), info.smdh.size());
+    }
+    index_dirty = false;
+}
+
+} // namespace Core
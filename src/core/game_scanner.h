@@ -0,0 +1,111 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Loader {
+enum class FileType;
+}
+
+namespace Core {
+
+/// A game found by GameScanner.
+struct GameEntry {
+    std::string path;
+    u64 program_id = 0;
+    u64 extdata_id = 0;
+    Loader::FileType file_type;
+    u64 size = 0;
+    /// SMDH of the installed update if it has a valid one, otherwise the game's own SMDH.
+    std::vector<u8> smdh;
+};
+
+/**
+ * Scans directories for games. Files are identified and their metadata read on a pool of threads.
+ * The results are kept in an on-disk index keyed by path, size and modification time, so later
+ * scans only need to stat unchanged files. This is shared by the Qt game list and the command line
+ * frontend's game listing.
+ */
+class GameScanner {
+public:
+    /**
+     * @param index_path Path of the persistent index. An empty path disables the index.
+     * @param num_threads Number of worker threads. 0 uses the host's hardware concurrency.
+     */
+    explicit GameScanner(std::string index_path = GetDefaultIndexPath(),
+                         std::size_t num_threads = 0);
+    ~GameScanner();
+
+    GameScanner(const GameScanner&) = delete;
+    GameScanner& operator=(const GameScanner&) = delete;
+
+    /**
+     * Scans a directory for games.
+     * @param directory Directory to scan
+     * @param recursion Maximum depth of subdirectories to visit
+     * @param watch_list If not null, the visited subdirectories are appended to it
+     * @returns The games found, in directory traversal order
+     */
+    std::vector<GameEntry> ScanDirectory(const std::string& directory, unsigned int recursion,
+                                         std::vector<std::string>* watch_list = nullptr);
+
+    /// Makes the ongoing scan return early. Thread-safe.
+    void Cancel();
+
+    /// Drops deleted files from the index and writes it to disk if it has changed. Also done on
+    /// destruction.
+    void SaveIndex();
+
+    /// Returns whether the file name has an extension of a file type that can hold a game.
+    static bool HasSupportedFileExtension(const std::string& file_name);
+
+    /// Returns the default location of the index, in the cache directory.
+    static std::string GetDefaultIndexPath();
+
+private:
+    /// Cached metadata of a single file.
+    struct FileInfo {
+        u64 size = 0;
+        s64 modification_time = 0;
+        bool is_game = false;
+        u64 program_id = 0;
+        u64 extdata_id = 0;
+        u32 file_type = 0;
+        std::vector<u8> smdh;
+    };
+
+    /// Returns the metadata of a file, from the index if it is still up to date.
+    FileInfo GetFileInfo(const std::string& path);
+    /// Builds a GameEntry for the file if it is a game.
+    std::optional<GameEntry> ScanFile(const std::string& path);
+
+    /// Loads the index on first use, so that constructing a scanner is cheap.
+    void LoadIndex();
+
+    std::string index_path;
+    std::size_t num_threads;
+    std::atomic_bool stop_processing{false};
+
+    std::mutex index_mutex;
+    bool index_loaded = false;
+    std::unordered_map<std::string, FileInfo> index;
+    /// Paths looked up during this scanner's lifetime.
+    std::unordered_set<std::string> used_paths;
+    /// Directories whose files were all looked up by a scan that was not cancelled, and the
+    /// content directories of looked up updates. Entries of files in these directories that were
+    /// not looked up no longer exist and are dropped.
+    std::unordered_set<std::string> scanned_directories;
+    bool index_dirty = false;
+};
+
+} // namespace Core
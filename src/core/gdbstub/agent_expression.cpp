@@ -0,0 +1,330 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <utility>
+#include "core/gdbstub/agent_expression.h"
+
+namespace GDBStub {
+
+namespace {
+
+/// Opcodes of the agent expressions, as listed in GDB's agentexpr.def
+enum class Op : u8 {
+    Add = 0x02,
+    Sub = 0x03,
+    Mul = 0x04,
+    DivSigned = 0x05,
+    DivUnsigned = 0x06,
+    RemSigned = 0x07,
+    RemUnsigned = 0x08,
+    Lsh = 0x09,
+    RshSigned = 0x0a,
+    RshUnsigned = 0x0b,
+    Trace = 0x0c,
+    TraceQuick = 0x0d,
+    LogNot = 0x0e,
+    BitAnd = 0x0f,
+    BitOr = 0x10,
+    BitXor = 0x11,
+    BitNot = 0x12,
+    Equal = 0x13,
+    LessSigned = 0x14,
+    LessUnsigned = 0x15,
+    Ext = 0x16,
+    Ref8 = 0x17,
+    Ref16 = 0x18,
+    Ref32 = 0x19,
+    Ref64 = 0x1a,
+    IfGoto = 0x20,
+    Goto = 0x21,
+    Const8 = 0x22,
+    Const16 = 0x23,
+    Const32 = 0x24,
+    Const64 = 0x25,
+    Reg = 0x26,
+    End = 0x27,
+    Dup = 0x28,
+    Pop = 0x29,
+    ZeroExt = 0x2a,
+    Swap = 0x2b,
+    TraceNz = 0x2f,
+    Trace16 = 0x30,
+    Pick = 0x32,
+    Rot = 0x33,
+};
+
+/// Limits that keep a malformed or looping expression from stalling the emulation
+constexpr std::size_t MaxStackSize = 256;
+constexpr std::size_t MaxExecutedOps = 100000;
+
+u64 SignExtend(u64 value, u32 bits) {
+    if (bits == 0 || bits >= 64) {
+        return value;
+    }
+    const u64 sign = u64{1} << (bits - 1);
+    value &= (sign << 1) - 1;
+    return (value ^ sign) - sign;
+}
+
+u64 ZeroExtend(u64 value, u32 bits) {
+    if (bits >= 64) {
+        return value;
+    }
+    return value & ((u64{1} << bits) - 1);
+}
+
+} // Anonymous namespace
+
+AgentExpression::AgentExpression(std::vector<u8> bytecode_) : bytecode(std::move(bytecode_)) {}
+
+std::optional<u64> AgentExpression::Evaluate(const RegisterReader& read_register,
+                                             const MemoryReader& read_memory) const {
+    std::vector<u64> stack;
+    std::size_t pc = 0;
+
+    // Immediates are stored big endian
+    const auto read_immediate = [this, &pc](std::size_t size) -> std::optional<u64> {
+        if (pc + size > bytecode.size()) {
+            return std::nullopt;
+        }
+        u64 value = 0;
+        for (std::size_t i = 0; i < size; ++i) {
+            value = (value << 8) | bytecode[pc++];
+        }
+        return value;
+    };
+    const auto pop = [&stack]() -> std::optional<u64> {
+        if (stack.empty()) {
+            return std::nullopt;
+        }
+        const u64 value = stack.back();
+        stack.pop_back();
+        return value;
+    };
+
+    for (std::size_t executed = 0; executed < MaxExecutedOps; ++executed) {
+        if (pc >= bytecode.size() || stack.size() > MaxStackSize) {
+            return std::nullopt;
+        }
+        const Op op = static_cast<Op>(bytecode[pc++]);
+
+        switch (op) {
+        case Op::Add:
+        case Op::Sub:
+        case Op::Mul:
+        case Op::DivSigned:
+        case Op::DivUnsigned:
+        case Op::RemSigned:
+        case Op::RemUnsigned:
+        case Op::Lsh:
+        case Op::RshSigned:
+        case Op::RshUnsigned:
+        case Op::BitAnd:
+        case Op::BitOr:
+        case Op::BitXor:
+        case Op::Equal:
+        case Op::LessSigned:
+        case Op::LessUnsigned: {
+            const auto b = pop();
+            const auto a = pop();
+            if (!a || !b) {
+                return std::nullopt;
+            }
+            const bool divides = op == Op::DivSigned || op == Op::DivUnsigned ||
+                                 op == Op::RemSigned || op == Op::RemUnsigned;
+            if (divides && *b == 0) {
+                return std::nullopt;
+            }
+            const s64 sa = static_cast<s64>(*a);
+            const s64 sb = static_cast<s64>(*b);
+            u64 result = 0;
+            switch (op) {
+            case Op::Add:
+                result = *a + *b;
+                break;
+            case Op::Sub:
+                result = *a - *b;
+                break;
+            case Op::Mul:
+                result = *a * *b;
+                break;
+            case Op::DivSigned:
+                result = sb == -1 ? 0 - *a : static_cast<u64>(sa / sb);
+                break;
+            case Op::DivUnsigned:
+                result = *a / *b;
+                break;
+            case Op::RemSigned:
+                result = sb == -1 ? 0 : static_cast<u64>(sa % sb);
+                break;
+            case Op::RemUnsigned:
+                result = *a % *b;
+                break;
+            case Op::Lsh:
+                result = *b >= 64 ? 0 : *a << *b;
+                break;
+            case Op::RshSigned:
+                result = static_cast<u64>(sa >> std::min<u64>(*b, 63));
+                break;
+            case Op::RshUnsigned:
+                result = *b >= 64 ? 0 : *a >> *b;
+                break;
+            case Op::BitAnd:
+                result = *a & *b;
+                break;
+            case Op::BitOr:
+                result = *a | *b;
+                break;
+            case Op::BitXor:
+                result = *a ^ *b;
+                break;
+            case Op::Equal:
+                result = *a == *b;
+                break;
+            case Op::LessSigned:
+                result = sa < sb;
+                break;
+            default:
+                result = *a < *b;
+                break;
+            }
+            stack.push_back(result);
+            break;
+        }
+        case Op::LogNot:
+        case Op::BitNot: {
+            const auto value = pop();
+            if (!value) {
+                return std::nullopt;
+            }
+            stack.push_back(op == Op::LogNot ? *value == 0 : ~*value);
+            break;
+        }
+        case Op::Ext:
+        case Op::ZeroExt: {
+            const auto bits = read_immediate(1);
+            const auto value = pop();
+            if (!bits || !value) {
+                return std::nullopt;
+            }
+            const u32 num_bits = static_cast<u32>(*bits);
+            stack.push_back(op == Op::Ext ? SignExtend(*value, num_bits)
+                                          : ZeroExtend(*value, num_bits));
+            break;
+        }
+        case Op::Ref8:
+        case Op::Ref16:
+        case Op::Ref32:
+        case Op::Ref64: {
+            const u32 size = 1U << (static_cast<u32>(op) - static_cast<u32>(Op::Ref8));
+            const auto addr = pop();
+            if (!addr) {
+                return std::nullopt;
+            }
+            const auto value = read_memory(static_cast<VAddr>(*addr), size);
+            if (!value) {
+                return std::nullopt;
+            }
+            stack.push_back(*value);
+            break;
+        }
+        case Op::IfGoto:
+        case Op::Goto: {
+            const auto target = read_immediate(2);
+            if (!target) {
+                return std::nullopt;
+            }
+            if (op == Op::IfGoto) {
+                const auto condition = pop();
+                if (!condition) {
+                    return std::nullopt;
+                }
+                if (*condition == 0) {
+                    break;
+                }
+            }
+            pc = static_cast<std::size_t>(*target);
+            break;
+        }
+        case Op::Const8:
+        case Op::Const16:
+        case Op::Const32:
+        case Op::Const64: {
+            const std::size_t size = std::size_t{1}
+                                     << (static_cast<u32>(op) - static_cast<u32>(Op::Const8));
+            const auto value = read_immediate(size);
+            if (!value) {
+                return std::nullopt;
+            }
+            stack.push_back(*value);
+            break;
+        }
+        case Op::Reg: {
+            const auto id = read_immediate(2);
+            if (!id) {
+                return std::nullopt;
+            }
+            stack.push_back(read_register(static_cast<u32>(*id)));
+            break;
+        }
+        case Op::End:
+            return pop();
+        case Op::Dup:
+            if (stack.empty()) {
+                return std::nullopt;
+            }
+            stack.push_back(stack.back());
+            break;
+        case Op::Pop:
+            if (!pop()) {
+                return std::nullopt;
+            }
+            break;
+        case Op::Swap:
+            if (stack.size() < 2) {
+                return std::nullopt;
+            }
+            std::swap(stack[stack.size() - 1], stack[stack.size() - 2]);
+            break;
+        case Op::Pick: {
+            const auto depth = read_immediate(1);
+            if (!depth || *depth >= stack.size()) {
+                return std::nullopt;
+            }
+            stack.push_back(stack[stack.size() - 1 - *depth]);
+            break;
+        }
+        case Op::Rot:
+            // a b c -> c a b, with c on top
+            if (stack.size() < 3) {
+                return std::nullopt;
+            }
+            std::rotate(stack.end() - 3, stack.end() - 1, stack.end());
+            break;
+        // Nothing is collected when evaluating a condition, these only consume their operands
+        case Op::Trace:
+        case Op::TraceNz:
+            if (!pop() || !pop()) {
+                return std::nullopt;
+            }
+            break;
+        case Op::TraceQuick:
+            if (!read_immediate(1) || stack.empty()) {
+                return std::nullopt;
+            }
+            break;
+        case Op::Trace16:
+            if (!read_immediate(2) || stack.empty()) {
+                return std::nullopt;
+            }
+            break;
+        default:
+            return std::nullopt;
+        }
+    }
+    return std::nullopt;
+}
+
+} // namespace GDBStub
@@ -0,0 +1,42 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <functional>
+#include <optional>
+#include <vector>
+#include "common/common_types.h"
+
+namespace GDBStub {
+
+/**
+ * Evaluator for GDB agent expressions, the stack machine bytecode in which GDB sends breakpoint
+ * conditions to the stub, so that they can be checked without a round trip to the client.
+ *
+ * Only the integer subset is supported. Floating point and trace state variable opcodes make the
+ * evaluation fail, and the trace opcodes only consume their operands.
+ */
+class AgentExpression {
+public:
+    /// Returns the value of a register, using the register numbers of the GDB target description
+    using RegisterReader = std::function<u64(u32 id)>;
+    /// Returns the value of `size` bytes of memory at an address, or nullopt if it can't be read
+    using MemoryReader = std::function<std::optional<u64>(VAddr addr, u32 size)>;
+
+    explicit AgentExpression(std::vector<u8> bytecode);
+
+    /**
+     * Runs the expression.
+     * @returns The value on top of the stack when the expression ends, or nullopt if the
+     *          expression is invalid, unsupported or faults
+     */
+    std::optional<u64> Evaluate(const RegisterReader& read_register,
+                                const MemoryReader& read_memory) const;
+
+private:
+    std::vector<u8> bytecode;
+};
+
+} // namespace GDBStub
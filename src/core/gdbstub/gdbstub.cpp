@@ -13,6 +13,9 @@
 #include <cstring>
 #include <map>
 #include <numeric>
+#include <optional>
+#include <string>
+#include <vector>
 #include <fcntl.h>
 #include <fmt/format.h>
 
@@ -34,6 +37,7 @@
 #include "common/logging/log.h"
 #include "core/arm/arm_interface.h"
 #include "core/core.h"
+#include "core/gdbstub/agent_expression.h"
 #include "core/gdbstub/gdbstub.h"
 #include "core/hle/kernel/process.h"
 #include "core/loader/loader.h"
@@ -41,12 +45,17 @@
 
 namespace GDBStub {
 namespace {
-constexpr int GDB_BUFFER_SIZE = 10000;
+constexpr int GDB_BUFFER_SIZE = 0x10000;
+// Largest packet data that fits in command_buffer along with the $ and #xx framing. Advertised to
+// the client as the packet size, large enough for bulk memory transfers.
+constexpr int GDB_MAX_PACKET_SIZE = GDB_BUFFER_SIZE - 4;
+constexpr int GDB_RECEIVE_BUFFER_SIZE = 0x1000;
 
 constexpr char GDB_STUB_START = '$';
 constexpr char GDB_STUB_END = '#';
 constexpr char GDB_STUB_ACK = '+';
 constexpr char GDB_STUB_NACK = '-';
+constexpr char GDB_STUB_ESCAPE = '}';
 
 #ifndef SIGTRAP
 constexpr u32 SIGTRAP = 5;
@@ -126,6 +135,15 @@ bool defer_start = false;
 u8 command_buffer[GDB_BUFFER_SIZE];
 u32 command_length;
 
+// Bytes received from the client but not processed yet, so that packets are not read one recv
+// call per byte
+u8 receive_buffer[GDB_RECEIVE_BUFFER_SIZE];
+u32 receive_offset = 0;
+u32 receive_size = 0;
+
+// Set once the client asked to stop acknowledging packets with QStartNoAckMode
+bool no_ack_mode = false;
+
 u32 latest_signal = 0;
 bool memory_break = false;
 
@@ -152,12 +170,17 @@ struct Breakpoint {
     VAddr addr;
     u32 len;
     std::array<u8, 4> inst;
+    /// Conditions evaluated by the stub, the breakpoint is hit when any of them holds
+    std::vector<AgentExpression> conditions;
 };
 
 using BreakpointMap = std::map<VAddr, Breakpoint>;
 BreakpointMap breakpoints_execute;
 BreakpointMap breakpoints_read;
 BreakpointMap breakpoints_write;
+
+// Execute breakpoint whose conditions were false, removed while the CPU steps over it
+std::optional<Breakpoint> skipped_breakpoint;
 } // Anonymous namespace
 
 static Kernel::Thread* FindThreadById(int id) {
@@ -365,14 +388,19 @@ static u64 GdbHexToLong(const u8* src) {
 
 /// Read a byte from the gdb client.
 static u8 ReadByte() {
-    u8 c;
-    std::size_t received_size = recv(gdbserver_socket, reinterpret_cast<char*>(&c), 1, MSG_WAITALL);
-    if (received_size != 1) {
-        LOG_ERROR(Debug_GDBStub, "recv failed : {}", received_size);
-        Shutdown();
+    if (receive_offset == receive_size) {
+        const int received_size = static_cast<int>(recv(
+            gdbserver_socket, reinterpret_cast<char*>(receive_buffer), sizeof(receive_buffer), 0));
+        if (received_size <= 0) {
+            LOG_ERROR(Debug_GDBStub, "recv failed : {}", received_size);
+            Shutdown();
+            return 0;
+        }
+        receive_offset = 0;
+        receive_size = static_cast<u32>(received_size);
     }
 
-    return c;
+    return receive_buffer[receive_offset++];
 }
 
 /// Calculate the checksum of the current command buffer.
@@ -427,6 +455,53 @@ static void RemoveBreakpoint(BreakpointType type, VAddr addr) {
     p.erase(addr);
 }
 
+/**
+ * Check whether a breakpoint should stop the CPU, evaluating its conditions in the emulator.
+ *
+ * @param breakpoint Breakpoint that was reached.
+ * @param thread Thread whose saved context holds the registers, or nullptr to read them from the
+ *               running core.
+ */
+static bool IsConditionMet(const Breakpoint& breakpoint, Kernel::Thread* thread) {
+    if (breakpoint.conditions.empty()) {
+        return true;
+    }
+
+    const auto read_register = [thread](u32 id) -> u64 {
+        if (thread) {
+            return id >= D0_REGISTER ? FpuRead(id, thread) : RegRead(id, thread);
+        }
+        const auto& core = Core::GetRunningCore();
+        if (id <= PC_REGISTER) {
+            return core.GetReg(static_cast<int>(id));
+        } else if (id == CPSR_REGISTER) {
+            return core.GetCPSR();
+        } else if (id >= D0_REGISTER && id < FPSCR_REGISTER) {
+            const int index = static_cast<int>(2 * (id - D0_REGISTER));
+            return core.GetVFPReg(index) | static_cast<u64>(core.GetVFPReg(index + 1)) << 32;
+        } else if (id == FPSCR_REGISTER) {
+            return core.GetVFPSystemReg(VFP_FPSCR);
+        }
+        return 0;
+    };
+    const auto read_memory = [](VAddr addr, u32 size) -> std::optional<u64> {
+        auto& process = *Core::System::GetInstance().Kernel().GetCurrentProcess();
+        if (!Memory::IsValidVirtualAddress(process, addr) ||
+            !Memory::IsValidVirtualAddress(process, addr + size - 1)) {
+            return std::nullopt;
+        }
+        u64 value = 0;
+        Core::System::GetInstance().Memory().ReadBlock(process, addr, &value, size);
+        return value;
+    };
+
+    // A condition that can't be evaluated stops the CPU, so that the error is not hidden
+    return std::any_of(breakpoint.conditions.begin(), breakpoint.conditions.end(),
+                       [&](const AgentExpression& condition) {
+                           return condition.Evaluate(read_register, read_memory).value_or(1) != 0;
+                       });
+}
+
 BreakpointAddress GetNextBreakpointFromAddress(VAddr addr, BreakpointType type) {
     const BreakpointMap& p = GetBreakpointMap(type);
     const auto next_breakpoint = p.lower_bound(addr);
@@ -469,7 +544,8 @@ bool CheckBreakpoint(VAddr addr, BreakpointType type) {
         len = 1;
     }
 
-    if (bp->second.active && (addr >= bp->second.addr && addr < bp->second.addr + len)) {
+    if (bp->second.active && (addr >= bp->second.addr && addr < bp->second.addr + len) &&
+        IsConditionMet(bp->second, nullptr)) {
         LOG_DEBUG(Debug_GDBStub,
                   "Found breakpoint type {} @ {:08x}, range: {:08x}"
                   " - {:08x} ({:x} bytes)",
@@ -532,6 +608,65 @@ static void SendReply(const char* reply) {
     }
 }
 
+/**
+ * Send the part of an object requested by a qXfer read to gdb client.
+ *
+ * @param object Object being read.
+ * @param args Offset and length requested, in the "offset,length" format of the request.
+ */
+static void SendXferReply(const std::string& object, const char* args) {
+    const char* length_pos = strchr(args, ',');
+    if (!length_pos) {
+        return SendReply("E01");
+    }
+    const u8* args_ptr = reinterpret_cast<const u8*>(args);
+    const u32 offset = HexToInt(args_ptr, static_cast<std::size_t>(length_pos - args));
+    const u32 length = HexToInt(args_ptr + (length_pos - args) + 1, strlen(length_pos + 1));
+
+    // The reply is prefixed with 'm' when there is more to read, and 'l' for the last part
+    const std::size_t max_length = std::min<std::size_t>(length, GDB_MAX_PACKET_SIZE - 1);
+    if (offset >= object.size()) {
+        return SendReply("l");
+    }
+    const std::string part = object.substr(offset, max_length);
+    const char prefix = offset + part.size() < object.size() ? 'm' : 'l';
+    SendReply((prefix + part).c_str());
+}
+
+/// Build the memory map of the current process, with the mapped regions of its address space.
+static std::string BuildMemoryMap() {
+    std::string map = R"(<?xml version="1.0"?>)"
+                      R"(<!DOCTYPE memory-map PUBLIC "+//IDN gnu.org//DTD GDB Memory Map V1.0//EN")"
+                      R"( "http://sourceware.org/gdb/gdb-memory-map.dtd">)"
+                      "<memory-map>";
+    const auto process = Core::System::GetInstance().Kernel().GetCurrentProcess();
+    if (!process) {
+        return map + "</memory-map>";
+    }
+
+    // Adjacent mapped areas are reported as a single region
+    VAddr region_start = 0;
+    VAddr region_end = 0;
+    const auto add_region = [&map, &region_start, &region_end] {
+        if (region_end != region_start) {
+            map += fmt::format(R"(<memory type="ram" start="0x{:08x}" length="0x{:x}"/>)",
+                               region_start, region_end - region_start);
+        }
+    };
+    for (const auto& [base, vma] : process->vm_manager.vma_map) {
+        if (vma.type == Kernel::VMAType::Free) {
+            continue;
+        }
+        if (base != region_end) {
+            add_region();
+            region_start = base;
+        }
+        region_end = base + vma.size;
+    }
+    add_region();
+    return map + "</memory-map>";
+}
+
 /// Handle query command from gdb client.
 static void HandleQuery() {
     LOG_DEBUG(Debug_GDBStub, "gdb: query '{}'\n", command_buffer + 1);
@@ -542,10 +677,15 @@ static void HandleQuery() {
         SendReply("T0");
     } else if (strncmp(query, "Supported", strlen("Supported")) == 0) {
         // PacketSize needs to be large enough for target xml
-        SendReply("PacketSize=2000;qXfer:features:read+;qXfer:threads:read+");
+        SendReply(fmt::format("PacketSize={:x};qXfer:features:read+;qXfer:threads:read+;"
+                              "qXfer:memory-map:read+;QStartNoAckMode+;ConditionalBreakpoints+",
+                              GDB_MAX_PACKET_SIZE)
+                      .c_str());
     } else if (strncmp(query, "Xfer:features:read:target.xml:",
                        strlen("Xfer:features:read:target.xml:")) == 0) {
         SendReply(target_xml);
+    } else if (strncmp(query, "Xfer:memory-map:read::", strlen("Xfer:memory-map:read::")) == 0) {
+        SendXferReply(BuildMemoryMap(), query + strlen("Xfer:memory-map:read::"));
     } else if (strncmp(query, "fThreadInfo", strlen("fThreadInfo")) == 0) {
         std::string val = "m";
         u32 num_cores = Core::GetNumCores();
@@ -668,6 +808,10 @@ static void ReadCommand() {
     }
 
     while ((c = ReadByte()) != GDB_STUB_END) {
+        if (!IsConnected()) {
+            command_length = 0;
+            return;
+        }
         if (command_length >= sizeof(command_buffer)) {
             LOG_ERROR(Debug_GDBStub, "gdb: command_buffer overflow\n");
             SendPacket(GDB_STUB_NACK);
@@ -689,11 +833,15 @@ static void ReadCommand() {
 
         command_length = 0;
 
-        SendPacket(GDB_STUB_NACK);
+        if (!no_ack_mode) {
+            SendPacket(GDB_STUB_NACK);
+        }
         return;
     }
 
-    SendPacket(GDB_STUB_ACK);
+    if (!no_ack_mode) {
+        SendPacket(GDB_STUB_ACK);
+    }
 }
 
 /// Check if there is data to be read from the gdb client.
@@ -702,6 +850,10 @@ static bool IsDataAvailable() {
         return false;
     }
 
+    if (receive_offset != receive_size) {
+        return true;
+    }
+
     fd_set fd_socket;
 
     FD_ZERO(&fd_socket);
@@ -833,7 +985,7 @@ static void WriteRegisters() {
 
 /// Read location in memory specified by gdb client.
 static void ReadMemory() {
-    static u8 reply[GDB_BUFFER_SIZE - 4];
+    static u8 reply[GDB_MAX_PACKET_SIZE + 1];
 
     auto start_offset = command_buffer + 1;
     auto addr_pos = std::find(start_offset, command_buffer + command_length, ',');
@@ -845,8 +997,8 @@ static void ReadMemory() {
 
     LOG_DEBUG(Debug_GDBStub, "gdb: addr: {:08x} len: {:08x}\n", addr, len);
 
-    if (len * 2 > sizeof(reply)) {
-        SendReply("E01");
+    if (len > GDB_MAX_PACKET_SIZE / 2) {
+        return SendReply("E01");
     }
 
     if (!Memory::IsValidVirtualAddress(*Core::System::GetInstance().Kernel().GetCurrentProcess(),
@@ -887,22 +1039,67 @@ static void WriteMemory() {
     SendReply("OK");
 }
 
+/// Modify location in memory with binary data received from the gdb client.
+static void WriteMemoryBinary() {
+    auto start_offset = command_buffer + 1;
+    auto addr_pos = std::find(start_offset, command_buffer + command_length, ',');
+    VAddr addr = HexToInt(start_offset, static_cast<u32>(addr_pos - start_offset));
+
+    start_offset = addr_pos + 1;
+    auto len_pos = std::find(start_offset, command_buffer + command_length, ':');
+    u32 len = HexToInt(start_offset, static_cast<u32>(len_pos - start_offset));
+
+    // A zero length write is used by the client to probe for X packet support
+    if (len == 0) {
+        return SendReply("OK");
+    }
+
+    auto& process = *Core::System::GetInstance().Kernel().GetCurrentProcess();
+    if (!Memory::IsValidVirtualAddress(process, addr) ||
+        !Memory::IsValidVirtualAddress(process, addr + len - 1)) {
+        return SendReply("E00");
+    }
+
+    // '#', '$', '}' and '*' are sent as the escape character followed by the byte xor 0x20
+    std::vector<u8> data;
+    data.reserve(len);
+    for (const u8* ptr = len_pos + 1; ptr < command_buffer + command_length; ++ptr) {
+        if (*ptr == GDB_STUB_ESCAPE && ptr + 1 < command_buffer + command_length) {
+            data.push_back(*++ptr ^ 0x20);
+        } else {
+            data.push_back(*ptr);
+        }
+    }
+    if (data.size() != len) {
+        return SendReply("E01");
+    }
+
+    Core::System::GetInstance().Memory().WriteBlock(process, addr, data.data(), len);
+    Core::GetRunningCore().ClearInstructionCache();
+    SendReply("OK");
+}
+
 void Break(bool is_memory_break) {
     send_trap = true;
 
     memory_break = is_memory_break;
 }
 
+/// Tell the CPU that it should execute a single instruction, then report back.
+static void StartStep() {
+    step_loop = true;
+    halt_loop = true;
+    send_trap = true;
+    Core::GetRunningCore().ClearInstructionCache();
+}
+
 /// Tell the CPU that it should perform a single step.
 static void Step() {
     if (command_length > 1) {
         RegWrite(PC_REGISTER, GdbHexToInt(command_buffer + 1), current_thread);
         Core::GetRunningCore().LoadContext(current_thread->context);
     }
-    step_loop = true;
-    halt_loop = true;
-    send_trap = true;
-    Core::GetRunningCore().ClearInstructionCache();
+    StartStep();
 }
 
 bool IsMemoryBreak() {
@@ -921,20 +1118,91 @@ static void Continue() {
     Core::GetRunningCore().ClearInstructionCache();
 }
 
+/**
+ * Handle vCont command from gdb client.
+ *
+ * The stub runs in all-stop mode, since all the emulated threads stop with the CPU, so the whole
+ * CPU steps or continues according to the action that applies to the current thread.
+ */
+static bool HandleVCont() {
+    const char* command = reinterpret_cast<const char*>(command_buffer);
+    if (strcmp(command, "vCont?") == 0) {
+        SendReply("vCont;c;C;s;S");
+        return false;
+    }
+
+    // Actions are ";action[:thread]", the first one matching the thread applies
+    std::optional<char> action;
+    const u8* const end = command_buffer + command_length;
+    for (const u8* ptr = command_buffer + strlen("vCont"); ptr < end && *ptr == ';';) {
+        const u8* const action_end = std::find(ptr + 1, end, ';');
+        const u8* const thread_pos = std::find(ptr + 1, action_end, ':');
+        const char type = static_cast<char>(ptr[1]);
+        bool applies = thread_pos == action_end;
+        if (!applies && current_thread) {
+            const auto thread_id = static_cast<int>(
+                HexToInt(thread_pos + 1, static_cast<std::size_t>(action_end - thread_pos - 1)));
+            applies = thread_pos[1] == '-' ||
+                      static_cast<u32>(thread_id) == current_thread->GetThreadId();
+        }
+        if (applies || !action) {
+            action = type;
+            if (applies) {
+                break;
+            }
+        }
+        ptr = action_end;
+    }
+
+    if (!action) {
+        SendReply("E01");
+        return false;
+    }
+    if (*action == 's' || *action == 'S') {
+        StartStep();
+    } else {
+        Continue();
+    }
+    return true;
+}
+
+/// Handle general set command from gdb client.
+static void HandleGeneralSet() {
+    const char* command = reinterpret_cast<const char*>(command_buffer + 1);
+    if (strcmp(command, "StartNoAckMode") == 0) {
+        // This reply is still acknowledged by the client
+        SendReply("OK");
+        no_ack_mode = true;
+    } else {
+        SendReply("");
+    }
+}
+
 /**
  * Commit breakpoint to list of breakpoints.
  *
  * @param type Type of breakpoint.
  * @param addr Address of breakpoint.
  * @param len Length of breakpoint.
+ * @param conditions Conditions of the breakpoint, replacing those of an existing one.
  */
-static bool CommitBreakpoint(BreakpointType type, VAddr addr, u32 len) {
+static bool CommitBreakpoint(BreakpointType type, VAddr addr, u32 len,
+                             std::vector<AgentExpression> conditions = {}) {
     BreakpointMap& p = GetBreakpointMap(type);
 
+    // The client sends the breakpoint again when its conditions change
+    const auto existing = p.find(addr);
+    if (existing != p.end()) {
+        existing->second.len = len;
+        existing->second.conditions = std::move(conditions);
+        return true;
+    }
+
     Breakpoint breakpoint;
     breakpoint.active = true;
     breakpoint.addr = addr;
     breakpoint.len = len;
+    breakpoint.conditions = std::move(conditions);
     Core::System::GetInstance().Memory().ReadBlock(
         *Core::System::GetInstance().Kernel().GetCurrentProcess(), addr, breakpoint.inst.data(),
         breakpoint.inst.size());
@@ -982,21 +1250,36 @@ static void AddBreakpoint() {
     VAddr addr = HexToInt(start_offset, static_cast<u32>(addr_pos - start_offset));
 
     start_offset = addr_pos + 1;
-    u32 len =
-        HexToInt(start_offset, static_cast<u32>((command_buffer + command_length) - start_offset));
+    u8* const end = command_buffer + command_length;
+    auto len_end = std::find(start_offset, end, ';');
+    u32 len = HexToInt(start_offset, static_cast<u32>(len_end - start_offset));
+
+    // Conditions follow as ";X<length>,<bytecode>", possibly followed by ";cmds:..."
+    std::vector<AgentExpression> conditions;
+    for (auto ptr = len_end; ptr + 1 < end && ptr[1] == 'X';) {
+        const auto bytecode_pos = std::find(ptr + 2, end, ',');
+        const u32 bytecode_len = HexToInt(ptr + 2, static_cast<u32>(bytecode_pos - ptr - 2));
+        if (bytecode_pos == end || bytecode_pos + 1 + bytecode_len * 2 > end) {
+            return SendReply("E01");
+        }
+        std::vector<u8> bytecode(bytecode_len);
+        GdbHexToMem(bytecode.data(), bytecode_pos + 1, bytecode_len);
+        conditions.emplace_back(std::move(bytecode));
+        ptr = bytecode_pos + 1 + bytecode_len * 2;
+    }
 
     if (type == BreakpointType::Access) {
         // Access is made up of Read and Write types, so add both breakpoints
         type = BreakpointType::Read;
 
-        if (!CommitBreakpoint(type, addr, len)) {
+        if (!CommitBreakpoint(type, addr, len, conditions)) {
             return SendReply("E02");
         }
 
         type = BreakpointType::Write;
     }
 
-    if (!CommitBreakpoint(type, addr, len)) {
+    if (!CommitBreakpoint(type, addr, len, std::move(conditions))) {
         return SendReply("E02");
     }
 
@@ -1093,6 +1376,22 @@ void HandlePacket() {
     case 'M':
         WriteMemory();
         break;
+    case 'X':
+        WriteMemoryBinary();
+        break;
+    case 'Q':
+        HandleGeneralSet();
+        break;
+    case 'v':
+        if (strncmp(reinterpret_cast<const char*>(command_buffer), "vCont",
+                    strlen("vCont")) == 0) {
+            if (HandleVCont()) {
+                return;
+            }
+        } else {
+            SendReply("");
+        }
+        break;
     case 's':
         Step();
         return;
@@ -1157,6 +1456,11 @@ static void Init(u16 port) {
     breakpoints_execute.clear();
     breakpoints_read.clear();
     breakpoints_write.clear();
+    skipped_breakpoint.reset();
+
+    receive_offset = 0;
+    receive_size = 0;
+    no_ack_mode = false;
 
     // Start gdb server
     LOG_INFO(Debug_GDBStub, "Starting GDB server on port {}...", port);
@@ -1264,6 +1568,32 @@ void SendTrap(Kernel::Thread* thread, int trap) {
         return;
     }
 
+    if (skipped_breakpoint) {
+        // The CPU stepped over a breakpoint whose conditions were false, so put it back. Unless
+        // the client interrupted the step, execution resumes without telling the client.
+        const Breakpoint breakpoint = std::move(*skipped_breakpoint);
+        skipped_breakpoint.reset();
+        CommitBreakpoint(BreakpointType::Execute, breakpoint.addr, breakpoint.len,
+                         breakpoint.conditions);
+        if (step_loop) {
+            halt_loop = false;
+            step_loop = false;
+            send_trap = false;
+            return;
+        }
+    } else if (!step_loop && !memory_break) {
+        const auto bp = breakpoints_execute.find(RegRead(PC_REGISTER, thread));
+        if (bp != breakpoints_execute.end() && !IsConditionMet(bp->second, thread)) {
+            // Step over the original instruction, like the client does when it continues
+            skipped_breakpoint = bp->second;
+            RemoveBreakpoint(BreakpointType::Execute, bp->first);
+            halt_loop = true;
+            step_loop = true;
+            send_trap = false;
+            return;
+        }
+    }
+
     current_thread = thread;
     SendSignal(thread, trap);
 
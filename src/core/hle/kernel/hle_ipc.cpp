@@ -7,9 +7,11 @@
 #include "common/assert.h"
 #include "common/common_types.h"
 #include "core/core.h"
+#include "core/core_timing.h"
 #include "core/hle/kernel/event.h"
 #include "core/hle/kernel/handle_table.h"
 #include "core/hle/kernel/hle_ipc.h"
+#include "core/hle/kernel/ipc_debugger/profiler.h"
 #include "core/hle/kernel/ipc_debugger/recorder.h"
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/process.h"
@@ -25,6 +27,12 @@ public:
     void WakeUp(ThreadWakeupReason reason, std::shared_ptr<Thread> thread,
                 std::shared_ptr<WaitObject> object) {
         ASSERT(thread->status == ThreadStatus::WaitHleEvent);
+        if (context->command_stats) {
+            const s64 slept_ticks =
+                context->kernel.timing.GetGlobalTicks() - context->sleep_start_ticks;
+            context->command_stats->sleep.Record(
+                std::chrono::microseconds(cyclesToUs(std::max<s64>(slept_ticks, 0))));
+        }
         if (callback) {
             callback->WakeUp(thread, *context, reason);
         }
@@ -39,7 +47,10 @@ public:
         Memory::MemorySystem& memory = context->kernel.memory;
         memory.ReadBlock(*process, thread->GetCommandBufferAddress(), cmd_buff.data(),
                          cmd_buff.size() * sizeof(u32));
+        const auto translation_start = std::chrono::steady_clock::now();
         context->WriteToOutgoingCommandBuffer(cmd_buff.data(), *process);
+        context->AddTranslationTime(std::chrono::steady_clock::now() - translation_start);
+        context->FinishTranslation();
         // Copy the translated command buffer back into the thread's command buffer area.
         memory.WriteBlock(*process, thread->GetCommandBufferAddress(), cmd_buff.data(),
                           cmd_buff.size() * sizeof(u32));
@@ -81,6 +92,7 @@ std::shared_ptr<Event> HLERequestContext::SleepClientThread(
     std::shared_ptr<WakeupCallback> callback) {
     // Put the client thread to sleep until the wait event is signaled or the timeout expires.
     thread->wakeup_callback = std::make_shared<ThreadCallback>(shared_from_this(), callback);
+    sleep_start_ticks = kernel.timing.GetGlobalTicks();
 
     auto event = kernel.CreateEvent(Kernel::ResetType::OneShot, "HLE Pause Event: " + reason);
     thread->status = ThreadStatus::WaitHleEvent;
@@ -294,6 +306,20 @@ void HLERequestContext::ReportUnimplemented() const {
     }
 }
 
+void HLERequestContext::SetCommandStats(IPCDebugger::CommandStats* stats) {
+    command_stats = stats;
+}
+
+void HLERequestContext::AddTranslationTime(std::chrono::nanoseconds time) {
+    translation_time += time;
+}
+
+void HLERequestContext::FinishTranslation() {
+    if (command_stats) {
+        command_stats->translate.Record(translation_time);
+    }
+}
+
 MappedBuffer::MappedBuffer() : memory(&Core::Global<Core::System>().Memory()) {}
 
 MappedBuffer::MappedBuffer(Memory::MemorySystem& memory, std::shared_ptr<Process> process,
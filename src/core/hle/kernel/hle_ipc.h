@@ -26,6 +26,10 @@ namespace Service {
 class ServiceFrameworkBase;
 }
 
+namespace IPCDebugger {
+struct CommandStats;
+}
+
 namespace Memory {
 class MemorySystem;
 }
@@ -288,6 +292,18 @@ public:
     /// Reports an unimplemented function.
     void ReportUnimplemented() const;
 
+    /**
+     * Sets the profiling counters of the command being handled. The translation time and the time
+     * the client thread sleeps are then accounted to them as well.
+     */
+    void SetCommandStats(IPCDebugger::CommandStats* stats);
+
+    /// Adds host time spent translating the request or the reply of this context.
+    void AddTranslationTime(std::chrono::nanoseconds time);
+
+    /// Accounts the translation time to the profiled command, once the reply has been written.
+    void FinishTranslation();
+
     class ThreadCallback;
     friend class ThreadCallback;
 
@@ -302,6 +318,10 @@ private:
     std::array<std::vector<u8>, IPC::MAX_STATIC_BUFFERS> static_buffers;
     // The mapped buffers will be created when the IPC request is translated
     boost::container::small_vector<MappedBuffer, 8> request_mapped_buffers;
+    // Profiling of the command, which is not kept in save states
+    IPCDebugger::CommandStats* command_stats = nullptr;
+    std::chrono::nanoseconds translation_time{};
+    s64 sleep_start_ticks = 0;
 
     HLERequestContext();
     template <class Archive>
@@ -0,0 +1,177 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <fmt/format.h>
+#include "core/hle/kernel/ipc_debugger/profiler.h"
+
+namespace IPCDebugger {
+
+namespace {
+
+std::size_t BucketOf(u64 ns) {
+    std::size_t bucket = 0;
+    while (ns >>= 1) {
+        ++bucket;
+    }
+    return std::min(bucket, LatencyHistogram::NumBuckets - 1);
+}
+
+std::string EscapeJson(const std::string& str) {
+    std::string escaped;
+    escaped.reserve(str.size());
+    for (const char c : str) {
+        if (c == '"' || c == '\\') {
+            escaped.push_back('\\');
+            escaped.push_back(c);
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            escaped += fmt::format("\\u{:04x}", static_cast<int>(c));
+        } else {
+            escaped.push_back(c);
+        }
+    }
+    return escaped;
+}
+
+void FormatHistogram(fmt::memory_buffer& buf, const char* name,
+                     const LatencyHistogram& histogram) {
+    const u64 count = histogram.Count();
+    const u64 total_ns = histogram.TotalNs();
+    fmt::format_to(buf,
+                   "\"{}\":{{\"count\":{},\"total_ns\":{},\"mean_ns\":{},\"max_ns\":{},"
+                   "\"p50_ns\":{},\"p99_ns\":{},\"buckets\":[",
+                   name, count, total_ns, count == 0 ? 0 : total_ns / count, histogram.MaxNs(),
+                   histogram.PercentileNs(0.5), histogram.PercentileNs(0.99));
+    // Trailing empty buckets are left out
+    std::size_t used = LatencyHistogram::NumBuckets;
+    while (used > 0 && histogram.BucketCount(used - 1) == 0) {
+        --used;
+    }
+    for (std::size_t i = 0; i < used; ++i) {
+        fmt::format_to(buf, "{}{}", i == 0 ? "" : ",", histogram.BucketCount(i));
+    }
+    fmt::format_to(buf, "]}}");
+}
+
+} // Anonymous namespace
+
+void LatencyHistogram::Record(std::chrono::nanoseconds time) {
+    const u64 ns = static_cast<u64>(std::max<std::chrono::nanoseconds::rep>(time.count(), 0));
+    buckets[BucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    total_ns.fetch_add(ns, std::memory_order_relaxed);
+    if (ns > max_ns.load(std::memory_order_relaxed)) {
+        max_ns.store(ns, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::Reset() {
+    for (auto& bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count.store(0, std::memory_order_relaxed);
+    total_ns.store(0, std::memory_order_relaxed);
+    max_ns.store(0, std::memory_order_relaxed);
+}
+
+u64 LatencyHistogram::Count() const {
+    return count.load(std::memory_order_relaxed);
+}
+
+u64 LatencyHistogram::TotalNs() const {
+    return total_ns.load(std::memory_order_relaxed);
+}
+
+u64 LatencyHistogram::MaxNs() const {
+    return max_ns.load(std::memory_order_relaxed);
+}
+
+u64 LatencyHistogram::BucketCount(std::size_t bucket) const {
+    return buckets[bucket].load(std::memory_order_relaxed);
+}
+
+u64 LatencyHistogram::PercentileNs(double fraction) const {
+    const u64 total = Count();
+    if (total == 0) {
+        return 0;
+    }
+    const auto target = std::max<u64>(static_cast<u64>(fraction * total), 1);
+    u64 seen = 0;
+    for (std::size_t i = 0; i < NumBuckets; ++i) {
+        seen += BucketCount(i);
+        if (seen >= target && i + 1 < NumBuckets) {
+            return std::min(u64(1) << (i + 1), MaxNs());
+        }
+    }
+    // The last bucket is open-ended
+    return MaxNs();
+}
+
+Profiler::Profiler() = default;
+Profiler::~Profiler() = default;
+
+CommandStats& Profiler::GetCommandStats(const std::string& service_name, u32 header,
+                                        const std::string& function_name) {
+    std::lock_guard lock(mutex);
+    auto& stats = commands[{service_name, header}];
+    if (!stats) {
+        stats = std::make_unique<CommandStats>();
+        stats->service_name = service_name;
+        stats->function_name = function_name;
+        stats->header = header;
+
+        // All commands of a service share one timer, as MicroProfile only has room for a few
+        // hundred of them
+        auto other = std::find_if(commands.begin(), commands.end(), [&](const auto& entry) {
+            return entry.first.first == service_name && entry.second != stats;
+        });
+        if (other != commands.end()) {
+            stats->microprofile_token = other->second->microprofile_token;
+        } else {
+#if MICROPROFILE_ENABLED
+            stats->microprofile_token = MicroProfileGetToken(
+                "HLE IPC", service_name.c_str(), MP_RGB(70, 160, 200), MicroProfileTokenTypeCpu);
+#endif
+        }
+    }
+    return *stats;
+}
+
+void Profiler::Reset() {
+    std::lock_guard lock(mutex);
+    for (auto& [key, stats] : commands) {
+        stats->translate.Reset();
+        stats->handler.Reset();
+        stats->sleep.Reset();
+    }
+}
+
+std::string Profiler::DumpJson() const {
+    std::lock_guard lock(mutex);
+    fmt::memory_buffer buf;
+    fmt::format_to(buf, "{{\"services\":[");
+    const std::string* current_service = nullptr;
+    for (const auto& [key, stats] : commands) {
+        if (current_service == nullptr || *current_service != stats->service_name) {
+            fmt::format_to(buf, "{}{{\"name\":\"{}\",\"commands\":[",
+                           current_service == nullptr ? "" : "]},",
+                           EscapeJson(stats->service_name));
+            current_service = &stats->service_name;
+        } else {
+            buf.push_back(',');
+        }
+        fmt::format_to(buf, "{{\"header\":\"{:#010x}\",\"name\":\"{}\",\"calls\":{},",
+                       stats->header, EscapeJson(stats->function_name), stats->handler.Count());
+        FormatHistogram(buf, "translate", stats->translate);
+        buf.push_back(',');
+        FormatHistogram(buf, "handler", stats->handler);
+        buf.push_back(',');
+        FormatHistogram(buf, "sleep", stats->sleep);
+        buf.push_back('}');
+    }
+    fmt::format_to(buf, "{}]}}", current_service == nullptr ? "" : "]}");
+    return fmt::to_string(buf);
+}
+
+} // namespace IPCDebugger
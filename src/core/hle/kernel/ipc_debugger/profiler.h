@@ -0,0 +1,93 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include "common/common_types.h"
+#include "common/microprofile.h"
+
+namespace IPCDebugger {
+
+/**
+ * Latency histogram with power-of-two buckets: bucket i counts the samples in [2^i, 2^(i+1)) ns,
+ * and the last bucket also counts everything longer.
+ * Samples are only recorded by the emulation thread, but may be read from any thread.
+ */
+class LatencyHistogram {
+public:
+    static constexpr std::size_t NumBuckets = 32;
+
+    void Record(std::chrono::nanoseconds time);
+    void Reset();
+
+    u64 Count() const;
+    u64 TotalNs() const;
+    u64 MaxNs() const;
+    u64 BucketCount(std::size_t bucket) const;
+
+    /// Returns the upper bound of the bucket holding the given fraction (0 to 1) of the samples
+    u64 PercentileNs(double fraction) const;
+
+private:
+    std::array<std::atomic<u64>, NumBuckets> buckets{};
+    std::atomic<u64> count{0};
+    std::atomic<u64> total_ns{0};
+    std::atomic<u64> max_ns{0};
+};
+
+/**
+ * Counters of one command of an HLE service.
+ */
+struct CommandStats {
+    std::string service_name;
+    std::string function_name;
+    u32 header = 0;
+
+    /// Host time spent translating the request and reply command buffers
+    LatencyHistogram translate;
+    /// Host time spent in the service handler. Its count is the number of calls.
+    LatencyHistogram handler;
+    /// Emulated time the client thread was put to sleep by the handler
+    LatencyHistogram sleep;
+
+    /// MicroProfile timer of the service, in the "HLE IPC" group
+    MicroProfileToken microprofile_token{};
+};
+
+/**
+ * Always-on profiler of the IPC commands handled by HLE services, keyed by service name and
+ * command header.
+ */
+class Profiler {
+public:
+    Profiler();
+    ~Profiler();
+
+    /**
+     * Returns the counters of a command, creating them on first use. The reference stays valid
+     * for the lifetime of the profiler, so callers are expected to cache it.
+     */
+    CommandStats& GetCommandStats(const std::string& service_name, u32 header,
+                                  const std::string& function_name);
+
+    /// Clears the counters of all commands
+    void Reset();
+
+    /// Returns the counters of all commands as a JSON document, grouped by service
+    std::string DumpJson() const;
+
+private:
+    mutable std::mutex mutex;
+    std::map<std::pair<std::string, u32>, std::unique_ptr<CommandStats>> commands;
+};
+
+} // namespace IPCDebugger
@@ -33,8 +33,9 @@ class Timing;
 }
 
 namespace IPCDebugger {
+class Profiler;
 class Recorder;
-}
+} // namespace IPCDebugger
 
 namespace Kernel {
 
@@ -237,6 +238,9 @@ public:
     IPCDebugger::Recorder& GetIPCRecorder();
     const IPCDebugger::Recorder& GetIPCRecorder() const;
 
+    IPCDebugger::Profiler& GetIPCProfiler();
+    const IPCDebugger::Profiler& GetIPCProfiler() const;
+
     std::shared_ptr<MemoryRegionInfo> GetMemoryRegion(MemoryRegion region);
 
     void HandleSpecialMapping(VMManager& address_space, const AddressMapping& mapping);
@@ -296,6 +300,7 @@ private:
     std::shared_ptr<SharedPage::Handler> shared_page_handler;
 
     std::unique_ptr<IPCDebugger::Recorder> ipc_recorder;
+    std::unique_ptr<IPCDebugger::Profiler> ipc_profiler;
 
     u32 next_thread_id;
 
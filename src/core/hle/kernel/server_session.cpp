@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <chrono>
 #include <tuple>
 #include <boost/serialization/shared_ptr.hpp>
 #include <boost/serialization/string.hpp>
@@ -92,7 +93,9 @@ ResultCode ServerSession::HandleSyncRequest(std::shared_ptr<Thread> thread) {
 
         auto context =
             std::make_shared<Kernel::HLERequestContext>(kernel, SharedFrom(this), thread);
+        const auto translation_start = std::chrono::steady_clock::now();
         context->PopulateFromIncomingCommandBuffer(cmd_buf.data(), current_process);
+        context->AddTranslationTime(std::chrono::steady_clock::now() - translation_start);
 
         hle_handler->HandleSyncRequest(*context);
 
@@ -102,7 +105,10 @@ ResultCode ServerSession::HandleSyncRequest(std::shared_ptr<Thread> thread) {
         // put the thread to sleep then the writing of the command buffer will be deferred to the
         // wakeup callback.
         if (thread->status == Kernel::ThreadStatus::Running) {
+            const auto reply_start = std::chrono::steady_clock::now();
             context->WriteToOutgoingCommandBuffer(cmd_buf.data(), *current_process);
+            context->AddTranslationTime(std::chrono::steady_clock::now() - reply_start);
+            context->FinishTranslation();
             kernel.memory.WriteBlock(*current_process, thread->GetCommandBufferAddress(),
                                      cmd_buf.data(), cmd_buf.size() * sizeof(u32));
         }
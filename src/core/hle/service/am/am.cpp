@@ -270,6 +270,43 @@ ResultVal<std::size_t> CIAFile::Write(u64 offset, std::size_t length, bool flush
     return MakeResult<std::size_t>(length);
 }
 
+bool CIAFile::InstallContentsFromFile(FileUtil::IOFile& file,
+                                      const std::function<ProgressCallback>& progress_callback,
+                                      InstallStatistics* statistics) {
+    if (install_state != CIAInstallState::TMDLoaded)
+        return false;
+
+    const FileSys::TitleMetadata& tmd = container.GetTitleMetadata();
+    const auto title_key = container.GetTicket().GetTitleKey();
+
+    std::vector<CIAInstallPipeline::Content> contents(tmd.GetContentCount());
+    for (std::size_t i = 0; i < contents.size(); i++) {
+        auto& content = contents[i];
+        content.offset = container.GetContentOffset(i);
+        content.size = container.GetContentSize(i);
+        content.output_path = GetTitleContentPath(media_type, tmd.GetTitleID(), i, is_update);
+        if ((tmd.GetContentTypeByIndex(i) & FileSys::TMDContentTypeFlag::Encrypted) != 0) {
+            if (!title_key)
+                return false;
+            content.key = *title_key;
+            content.iv = tmd.GetContentCTRByIndex(i);
+        }
+        content.hash = tmd.GetContentHashByIndex(i);
+    }
+
+    CIAInstallPipeline pipeline(std::move(contents));
+    const auto status = pipeline.Run(file, progress_callback);
+    if (statistics)
+        *statistics = pipeline.GetStatistics();
+    if (status != CIAInstallPipeline::Status::Success)
+        return false;
+
+    for (std::size_t i = 0; i < content_written.size(); i++)
+        content_written[i] = container.GetContentSize(i);
+    written = file.GetSize();
+    return true;
+}
+
 u64 CIAFile::GetSize() const {
     return written;
 }
@@ -329,7 +366,8 @@ bool CIAFile::Close() const {
 void CIAFile::Flush() const {}
 
 InstallStatus InstallCIA(const std::string& path,
-                         std::function<ProgressCallback>&& update_callback) {
+                         std::function<ProgressCallback>&& update_callback,
+                         InstallStatistics* statistics) {
     LOG_INFO(Service_AM, "Installing {}...", path);
 
     if (!FileUtil::Exists(path)) {
@@ -357,22 +395,33 @@ InstallStatus InstallCIA(const std::string& path,
         if (!file.IsOpen())
             return InstallStatus::ErrorFailedToOpenFile;
 
-        std::array<u8, 0x10000> buffer;
-        std::size_t total_bytes_read = 0;
-        while (total_bytes_read != file.GetSize()) {
-            std::size_t bytes_read = file.ReadBytes(buffer.data(), buffer.size());
-            auto result = installFile.Write(static_cast<u64>(total_bytes_read), bytes_read, true,
-                                            static_cast<u8*>(buffer.data()));
+        // Everything before the content data is small, feed it through Write so that the ticket
+        // and TMD get parsed and the TMD is saved
+        std::vector<u8> buffer(container.GetContentOffset());
+        if (file.ReadBytes(buffer.data(), buffer.size()) != buffer.size())
+            return InstallStatus::ErrorInvalid;
+        auto result = installFile.Write(0, buffer.size(), true, buffer.data());
+        if (result.Failed()) {
+            LOG_ERROR(Service_AM, "CIA file installation aborted with error code {:08x}",
+                      result.Code().raw);
+            return InstallStatus::ErrorAborted;
+        }
 
+        // The content data is then streamed by the install pipeline
+        const std::size_t header_size = buffer.size();
+        const std::size_t file_size = file.GetSize();
+        const auto content_progress = [&](std::size_t content_written, std::size_t) {
             if (update_callback)
-                update_callback(total_bytes_read, file.GetSize());
-            if (result.Failed()) {
-                LOG_ERROR(Service_AM, "CIA file installation aborted with error code {:08x}",
-                          result.Code().raw);
-                return InstallStatus::ErrorAborted;
-            }
-            total_bytes_read += bytes_read;
+                update_callback(header_size + content_written, file_size);
+        };
+        if (!installFile.InstallContentsFromFile(file, content_progress, statistics)) {
+            LOG_ERROR(Service_AM, "CIA file installation aborted");
+            // The contents are incomplete, so this removes the partial contents and the TMD
+            installFile.Close();
+            return InstallStatus::ErrorAborted;
         }
+        if (update_callback)
+            update_callback(file_size, file_size);
         installFile.Close();
 
         LOG_INFO(Service_AM, "Installed {} successfully.", path);
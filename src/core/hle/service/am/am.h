@@ -19,6 +19,7 @@
 #include "core/global.h"
 #include "core/hle/kernel/mutex.h"
 #include "core/hle/result.h"
+#include "core/hle/service/am/cia_install_pipeline.h"
 #include "core/hle/service/service.h"
 
 namespace Core {
@@ -78,6 +79,19 @@ public:
     ResultVal<std::size_t> WriteContentData(u64 offset, std::size_t length, const u8* buffer);
     ResultVal<std::size_t> Write(u64 offset, std::size_t length, bool flush,
                                  const u8* buffer) override;
+
+    /**
+     * Installs all content data straight from a CIA file with a CIAInstallPipeline, instead of
+     * going through Write. The header, ticket and TMD must already have been written.
+     * @param file CIA file to read the content data from
+     * @param progress_callback If set, called with content bytes written and total content size
+     * @param statistics If not null, receives the timings of the install
+     * @returns bool whether all contents were installed
+     */
+    bool InstallContentsFromFile(FileUtil::IOFile& file,
+                                 const std::function<ProgressCallback>& progress_callback,
+                                 InstallStatistics* statistics = nullptr);
+
     u64 GetSize() const override;
     bool SetSize(u64 size) const override;
     bool Close() const override;
@@ -105,10 +119,12 @@ private:
  * Installs a CIA file from a specified file path.
  * @param path file path of the CIA file to install
  * @param update_callback callback function called during filesystem write
+ * @param statistics If not null, receives the timings of the content install
  * @returns bool whether the install was successful
  */
 InstallStatus InstallCIA(const std::string& path,
-                         std::function<ProgressCallback>&& update_callback = nullptr);
+                         std::function<ProgressCallback>&& update_callback = nullptr,
+                         InstallStatistics* statistics = nullptr);
 
 /**
  * Get the mediatype for an installed title
@@ -0,0 +1,249 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <cryptopp/aes.h>
+#include <cryptopp/modes.h>
+#include <cryptopp/sha.h>
+#include "common/alignment.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "core/hle/service/am/cia_install_pipeline.h"
+
+namespace Service::AM {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/// How often Run reports progress while the stages are working
+constexpr std::chrono::milliseconds ProgressInterval{100};
+
+double SecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+} // Anonymous namespace
+
+CIAInstallPipeline::CIAInstallPipeline(std::vector<Content> contents_)
+    : contents(std::move(contents_)) {
+    for (const auto& content : contents) {
+        total_size += content.size;
+    }
+    storage.resize(NumBlocks * BlockSize + BlockAlignment);
+}
+
+CIAInstallPipeline::~CIAInstallPipeline() = default;
+
+CIAInstallPipeline::Status CIAInstallPipeline::Run(
+    FileUtil::IOFile& file,
+    const std::function<void(std::size_t, std::size_t)>& progress_callback) {
+    status = Status::Success;
+    bytes_written = 0;
+    finished = false;
+    statistics = {};
+
+    free_blocks.Clear();
+    read_blocks.Clear();
+    decrypted_blocks.Clear();
+    verified_blocks.Clear();
+
+    u8* const base = reinterpret_cast<u8*>(
+        Common::AlignUp(reinterpret_cast<std::uintptr_t>(storage.data()), BlockAlignment));
+    for (std::size_t i = 0; i < NumBlocks; ++i) {
+        Block block;
+        block.data = base + i * BlockSize;
+        free_blocks.Push(block);
+    }
+
+    const auto start = Clock::now();
+
+    std::thread reader([this, &file] { ReadStage(file); });
+    std::thread decrypter([this] { DecryptStage(); });
+    std::thread verifier([this] { VerifyStage(); });
+    std::thread writer([this] { WriteStage(); });
+
+    bool done = false;
+    while (!done) {
+        {
+            std::unique_lock lock{finished_mutex};
+            done = finished_cv.wait_for(lock, ProgressInterval, [this] { return finished; });
+        }
+        if (progress_callback) {
+            progress_callback(static_cast<std::size_t>(bytes_written.load()),
+                              static_cast<std::size_t>(total_size));
+        }
+    }
+
+    reader.join();
+    decrypter.join();
+    verifier.join();
+    writer.join();
+
+    statistics.content_bytes = bytes_written;
+    statistics.elapsed_seconds = SecondsSince(start);
+
+    const auto& stage_busy = statistics.stage_busy_seconds;
+    LOG_INFO(Service_AM,
+             "Installed {} content bytes in {:.2f}s ({:.1f} MiB/s). Busy time: read {:.2f}s, "
+             "decrypt {:.2f}s, verify {:.2f}s, write {:.2f}s",
+             statistics.content_bytes, statistics.elapsed_seconds,
+             statistics.GetThroughput() / (1024 * 1024), stage_busy[InstallStatistics::Read],
+             stage_busy[InstallStatistics::Decrypt], stage_busy[InstallStatistics::Verify],
+             stage_busy[InstallStatistics::Write]);
+
+    return status;
+}
+
+void CIAInstallPipeline::ReadStage(FileUtil::IOFile& file) {
+    double& busy = statistics.stage_busy_seconds[InstallStatistics::Read];
+
+    for (std::size_t i = 0; i < contents.size() && !Failed(); ++i) {
+        const Content& content = contents[i];
+        if (!file.Seek(static_cast<s64>(content.offset), SEEK_SET)) {
+            Fail(Status::ReadError);
+            break;
+        }
+
+        // Empty contents still send a single block, so that the output file gets created
+        u64 remaining = content.size;
+        do {
+            Block block = free_blocks.PopWait();
+            if (Failed()) {
+                break;
+            }
+
+            const auto block_start = Clock::now();
+            const std::size_t length =
+                static_cast<std::size_t>(std::min<u64>(remaining, BlockSize));
+            if (file.ReadBytes(block.data, length) != length) {
+                LOG_ERROR(Service_AM, "Failed to read content {} from CIA", i);
+                Fail(Status::ReadError);
+                break;
+            }
+            busy += SecondsSince(block_start);
+
+            remaining -= length;
+            block.size = length;
+            block.content = i;
+            block.last = remaining == 0;
+            read_blocks.Push(block);
+        } while (remaining > 0);
+    }
+
+    read_blocks.Push(Block{});
+}
+
+void CIAInstallPipeline::DecryptStage() {
+    double& busy = statistics.stage_busy_seconds[InstallStatistics::Decrypt];
+
+    CryptoPP::CBC_Mode<CryptoPP::AES>::Decryption decryption;
+    std::size_t current_content = Block::EndOfStream;
+
+    while (true) {
+        Block block = read_blocks.PopWait();
+        if (block.content == Block::EndOfStream) {
+            decrypted_blocks.Push(block);
+            break;
+        }
+
+        const Content& content = contents[block.content];
+        if (content.key && !Failed()) {
+            const auto block_start = Clock::now();
+            if (block.content != current_content) {
+                decryption.SetKeyWithIV(content.key->data(), content.key->size(),
+                                        content.iv.data());
+                current_content = block.content;
+            }
+            decryption.ProcessData(block.data, block.data, block.size);
+            busy += SecondsSince(block_start);
+        }
+        decrypted_blocks.Push(block);
+    }
+}
+
+void CIAInstallPipeline::VerifyStage() {
+    double& busy = statistics.stage_busy_seconds[InstallStatistics::Verify];
+
+    CryptoPP::SHA256 sha;
+    while (true) {
+        Block block = decrypted_blocks.PopWait();
+        if (block.content == Block::EndOfStream) {
+            verified_blocks.Push(block);
+            break;
+        }
+
+        if (!Failed()) {
+            const auto block_start = Clock::now();
+            sha.Update(block.data, block.size);
+            if (block.last) {
+                // Final also resets the hash for the next content
+                std::array<u8, CryptoPP::SHA256::DIGESTSIZE> digest;
+                sha.Final(digest.data());
+                // Installs never enforced the TMD hashes, so a mismatch is only reported
+                if (digest != contents[block.content].hash) {
+                    LOG_WARNING(Service_AM, "Content {} does not match the hash in the TMD",
+                                block.content);
+                }
+            }
+            busy += SecondsSince(block_start);
+        }
+        verified_blocks.Push(block);
+    }
+}
+
+void CIAInstallPipeline::WriteStage() {
+    double& busy = statistics.stage_busy_seconds[InstallStatistics::Write];
+
+    FileUtil::IOFile output;
+    std::size_t current_content = Block::EndOfStream;
+
+    while (true) {
+        Block block = verified_blocks.PopWait();
+        if (block.content == Block::EndOfStream) {
+            break;
+        }
+
+        if (!Failed()) {
+            const auto block_start = Clock::now();
+            if (block.content != current_content) {
+                output = FileUtil::IOFile(contents[block.content].output_path, "wb");
+                current_content = block.content;
+                if (!output.IsOpen()) {
+                    LOG_ERROR(Service_AM, "Failed to open {} for writing",
+                              contents[block.content].output_path);
+                    Fail(Status::WriteError);
+                }
+            }
+            if (output.IsOpen() && output.WriteBytes(block.data, block.size) != block.size) {
+                LOG_ERROR(Service_AM, "Failed to write content {}", block.content);
+                Fail(Status::WriteError);
+            }
+            if (block.last) {
+                output.Close();
+            }
+            busy += SecondsSince(block_start);
+            bytes_written += block.size;
+        }
+
+        // Hand the buffer back to the reader even after a failure, so it never waits forever
+        free_blocks.Push(block);
+    }
+
+    {
+        std::scoped_lock lock{finished_mutex};
+        finished = true;
+    }
+    finished_cv.notify_one();
+}
+
+void CIAInstallPipeline::Fail(Status error) {
+    Status expected = Status::Success;
+    status.compare_exchange_strong(expected, error);
+}
+
+} // namespace Service::AM
@@ -0,0 +1,142 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+#include "common/threadsafe_queue.h"
+
+namespace FileUtil {
+class IOFile;
+}
+
+namespace Service::AM {
+
+/// Timings of a CIA install, for throughput reporting.
+struct InstallStatistics {
+    enum Stage : std::size_t { Read, Decrypt, Verify, Write, NumStages };
+
+    /// Number of content bytes read from the CIA and written to the install location
+    u64 content_bytes = 0;
+    /// Wall-clock time spent streaming the content data
+    double elapsed_seconds = 0.0;
+    /// Time each stage spent working rather than waiting on its neighbours
+    std::array<double, NumStages> stage_busy_seconds{};
+
+    /// @returns Average content throughput in bytes per second
+    double GetThroughput() const {
+        return elapsed_seconds > 0.0 ? content_bytes / elapsed_seconds : 0.0;
+    }
+};
+
+/**
+ * Streams the content section of a CIA to its install location. File reading, AES-CBC decryption,
+ * SHA-256 verification against the TMD and writing each run on their own thread. Contents that
+ * don't match the TMD are still installed, with a warning. The stages are
+ * connected by queues of large aligned blocks, so disk I/O overlaps with the crypto work and the
+ * amount of memory in flight is bounded.
+ */
+class CIAInstallPipeline {
+public:
+    /// A single content to install.
+    struct Content {
+        /// Offset of the content data within the CIA file
+        u64 offset = 0;
+        u64 size = 0;
+        std::string output_path;
+        /// Title key to decrypt with, if the content is encrypted
+        std::optional<std::array<u8, 16>> key;
+        std::array<u8, 16> iv{};
+        /// Expected SHA-256 of the decrypted content, from the TMD
+        std::array<u8, 0x20> hash{};
+    };
+
+    enum class Status {
+        Success,
+        ReadError,
+        WriteError,
+    };
+
+    /// Size of a single block in flight. A multiple of the AES block size.
+    static constexpr std::size_t BlockSize = 2 * 1024 * 1024;
+    /// Alignment of the block buffers.
+    static constexpr std::size_t BlockAlignment = 4096;
+    /// Number of blocks shared between the stages.
+    static constexpr std::size_t NumBlocks = 8;
+
+    explicit CIAInstallPipeline(std::vector<Content> contents);
+    ~CIAInstallPipeline();
+
+    CIAInstallPipeline(const CIAInstallPipeline&) = delete;
+    CIAInstallPipeline& operator=(const CIAInstallPipeline&) = delete;
+
+    /**
+     * Installs all contents. Blocks until every stage has finished. Progress is reported from the
+     * calling thread.
+     * @param file CIA file to read the content data from
+     * @param progress_callback If set, periodically called with the content bytes written so far
+     *                          and the total content size
+     * @returns Success, or the first error encountered by any stage
+     */
+    Status Run(FileUtil::IOFile& file,
+               const std::function<void(std::size_t, std::size_t)>& progress_callback = nullptr);
+
+    /// @returns Timings of the last Run
+    const InstallStatistics& GetStatistics() const {
+        return statistics;
+    }
+
+private:
+    struct Block {
+        /// Sentinel content index which tells a stage that no more blocks will follow
+        static constexpr std::size_t EndOfStream = ~std::size_t{0};
+
+        u8* data = nullptr;
+        std::size_t size = 0;
+        std::size_t content = EndOfStream;
+        /// Whether this is the last block of its content
+        bool last = false;
+    };
+
+    void ReadStage(FileUtil::IOFile& file);
+    void DecryptStage();
+    void VerifyStage();
+    void WriteStage();
+
+    /// Records the first error. Later stages keep draining blocks but stop processing them.
+    void Fail(Status error);
+    bool Failed() const {
+        return status.load(std::memory_order_relaxed) != Status::Success;
+    }
+
+    std::vector<Content> contents;
+    u64 total_size = 0;
+
+    std::vector<u8> storage;
+
+    Common::SPSCQueue<Block> free_blocks;
+    Common::SPSCQueue<Block> read_blocks;
+    Common::SPSCQueue<Block> decrypted_blocks;
+    Common::SPSCQueue<Block> verified_blocks;
+
+    std::atomic<Status> status{Status::Success};
+    std::atomic<u64> bytes_written{0};
+
+    std::mutex finished_mutex;
+    std::condition_variable finished_cv;
+    bool finished = false;
+
+    InstallStatistics statistics;
+};
+
+} // namespace Service::AM
@@ -7,13 +7,22 @@
 #include "core/hle/kernel/event.h"
 #include "core/hle/kernel/shared_memory.h"
 #include "core/hle/service/gsp/gsp.h"
+#include "core/hle/service/sm/sm.h"
+#include "video_core/gpu_thread.h"
+#include "video_core/video_core.h"
 
 namespace Service::GSP {
 
-static std::weak_ptr<GSP_GPU> gsp_gpu;
-
 void SignalInterrupt(InterruptId interrupt_id) {
-    auto gpu = gsp_gpu.lock();
+    // Interrupts raised by the GPU thread are delivered by the emulation thread, which owns the
+    // kernel
+    auto* gpu_thread = VideoCore::GetGPUThread();
+    if (gpu_thread && gpu_thread->IsGPUThread()) {
+        gpu_thread->PostCallback([interrupt_id] { SignalInterrupt(interrupt_id); });
+        return;
+    }
+
+    auto gpu = Core::System::GetInstance().ServiceManager().GetService<GSP_GPU>("gsp::Gpu");
     ASSERT(gpu != nullptr);
     return gpu->SignalInterrupt(interrupt_id);
 }
@@ -22,13 +31,8 @@ void InstallInterfaces(Core::System& system) {
     auto& service_manager = system.ServiceManager();
     auto gpu = std::make_shared<GSP_GPU>(system);
     gpu->InstallAsService(service_manager);
-    gsp_gpu = gpu;
 
     std::make_shared<GSP_LCD>()->InstallAsService(service_manager);
 }
 
-void SetGlobalModule(Core::System& system) {
-    gsp_gpu = system.ServiceManager().GetService<GSP_GPU>("gsp::Gpu");
-}
-
 } // namespace Service::GSP
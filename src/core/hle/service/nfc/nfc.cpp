@@ -6,7 +6,6 @@
 #include "core/core.h"
 #include "core/hle/ipc_helpers.h"
 #include "core/hle/kernel/event.h"
-#include "core/hle/lock.h"
 #include "core/hle/service/nfc/nfc.h"
 #include "core/hle/service/nfc/nfc_m.h"
 #include "core/hle/service/nfc/nfc_u.h"
@@ -319,14 +318,14 @@ std::shared_ptr<Module> Module::Interface::GetModule() const {
 }
 
 void Module::Interface::LoadAmiibo(const AmiiboData& amiibo_data) {
-    std::lock_guard lock(HLE::g_hle_lock);
+    std::lock_guard lock(nfc->system.HLELock());
     nfc->amiibo_data = amiibo_data;
     nfc->amiibo_in_range = true;
     nfc->SyncTagState();
 }
 
 void Module::Interface::RemoveAmiibo() {
-    std::lock_guard lock(HLE::g_hle_lock);
+    std::lock_guard lock(nfc->system.HLELock());
     nfc->amiibo_in_range = false;
     nfc->SyncTagState();
 }
@@ -353,7 +352,7 @@ Module::Interface::Interface(std::shared_ptr<Module> nfc, const char* name, u32
 
 Module::Interface::~Interface() = default;
 
-Module::Module(Core::System& system) {
+Module::Module(Core::System& system) : system(system) {
     tag_in_range_event =
         system.Kernel().CreateEvent(Kernel::ResetType::OneShot, "NFC::tag_in_range_event");
     tag_out_of_range_event =
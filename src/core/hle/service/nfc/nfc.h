@@ -242,6 +242,8 @@ private:
     // Sync nfc_tag_state with amiibo_in_range and signal events on state change.
     void SyncTagState();
 
+    Core::System& system;
+
     std::shared_ptr<Kernel::Event> tag_in_range_event;
     std::shared_ptr<Kernel::Event> tag_out_of_range_event;
     TagState nfc_tag_state = TagState::NotInitialized;
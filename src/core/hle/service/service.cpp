@@ -3,13 +3,16 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <chrono>
 #include <fmt/format.h>
 #include "common/assert.h"
 #include "common/logging/log.h"
+#include "common/microprofile.h"
 #include "core/core.h"
 #include "core/hle/ipc.h"
 #include "core/hle/kernel/client_port.h"
 #include "core/hle/kernel/handle_table.h"
+#include "core/hle/kernel/ipc_debugger/profiler.h"
 #include "core/hle/kernel/process.h"
 #include "core/hle/kernel/server_port.h"
 #include "core/hle/kernel/server_session.h"
@@ -175,9 +178,20 @@ void ServiceFrameworkBase::HandleSyncRequest(Kernel::HLERequestContext& context)
         return ReportUnimplementedFunction(context.CommandBuffer(), info);
     }
 
+    IPCDebugger::CommandStats*& stats = itr->second.stats;
+    if (stats == nullptr) {
+        stats = &Core::System::GetInstance().Kernel().GetIPCProfiler().GetCommandStats(
+            service_name, header_code, info->name);
+    }
+    context.SetCommandStats(stats);
+
     LOG_TRACE(Service, "{}",
               MakeFunctionString(info->name, GetServiceName(), context.CommandBuffer()));
+    MICROPROFILE_SCOPE_TOKEN(stats->microprofile_token);
+    Core::PerfTimer perf_timer{Core::PerfCategory::HleServices};
+    const auto handler_start = std::chrono::steady_clock::now();
     handler_invoker(this, info->handler_callback, context);
+    stats->handler.Record(std::chrono::steady_clock::now() - handler_start);
 }
 
 std::string ServiceFrameworkBase::GetFunctionName(u32 header) const {
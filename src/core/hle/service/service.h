@@ -83,6 +83,8 @@ private:
         u32 expected_header;
         HandlerFnP<ServiceFrameworkBase> handler_callback;
         const char* name;
+        /// Profiling counters of the command, looked up on its first call
+        IPCDebugger::CommandStats* stats = nullptr;
     };
 
     using InvokerFn = void(ServiceFrameworkBase* object, HandlerFnP<ServiceFrameworkBase> member,
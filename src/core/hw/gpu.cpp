@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <cstring>
+#include <functional>
 #include <numeric>
 #include <type_traits>
 #include "common/alignment.h"
@@ -16,10 +17,14 @@
 #include "core/hle/service/gsp/gsp.h"
 #include "core/hw/gpu.h"
 #include "core/hw/hw.h"
+#include "core/hw/lcd.h"
 #include "core/memory.h"
+#include "core/movie.h"
+#include "core/rpc/rpc_server.h"
 #include "core/tracer/recorder.h"
 #include "video_core/command_processor.h"
 #include "video_core/debug_utils/debug_utils.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/rasterizer_interface.h"
 #include "video_core/renderer_base.h"
 #include "video_core/utils.h"
@@ -27,11 +32,9 @@
 
 namespace GPU {
 
-Regs g_regs;
-Memory::MemorySystem* g_memory;
-
-/// Event id for CoreTiming
-static Core::TimingEventType* vblank_event;
+State& GetState() {
+    return Core::System::GetInstance().GPUState();
+}
 
 template <typename T>
 inline void Read(T& var, const u32 raw_addr) {
@@ -44,7 +47,7 @@ inline void Read(T& var, const u32 raw_addr) {
         return;
     }
 
-    var = g_regs[addr / 4];
+    var = GetState().regs[addr / 4];
 }
 
 static Common::Vec4<u8> DecodePixel(Regs::PixelFormat input_format, const u8* src_pixel) {
@@ -74,16 +77,17 @@ MICROPROFILE_DEFINE(GPU_DisplayTransfer, "GPU", "DisplayTransfer", MP_RGB(100, 1
 MICROPROFILE_DEFINE(GPU_CmdlistProcessing, "GPU", "Cmdlist Processing", MP_RGB(100, 255, 100));
 
 static void MemoryFill(const Regs::MemoryFillConfig& config) {
+    Memory::MemorySystem& memory = *GetState().memory;
     const PAddr start_addr = config.GetStartAddress();
     const PAddr end_addr = config.GetEndAddress();
 
     // TODO: do hwtest with these cases
-    if (!g_memory->IsValidPhysicalAddress(start_addr)) {
+    if (!memory.IsValidPhysicalAddress(start_addr)) {
         LOG_CRITICAL(HW_GPU, "invalid start address {:#010X}", start_addr);
         return;
     }
 
-    if (!g_memory->IsValidPhysicalAddress(end_addr)) {
+    if (!memory.IsValidPhysicalAddress(end_addr)) {
         LOG_CRITICAL(HW_GPU, "invalid end address {:#010X}", end_addr);
         return;
     }
@@ -94,10 +98,10 @@ static void MemoryFill(const Regs::MemoryFillConfig& config) {
         return;
     }
 
-    u8* start = g_memory->GetPhysicalPointer(start_addr);
-    u8* end = g_memory->GetPhysicalPointer(end_addr);
+    u8* start = memory.GetPhysicalPointer(start_addr);
+    u8* end = memory.GetPhysicalPointer(end_addr);
 
-    if (VideoCore::g_renderer->Rasterizer()->AccelerateFill(config))
+    if (VideoCore::GetRenderer()->Rasterizer()->AccelerateFill(config))
         return;
 
     Memory::RasterizerInvalidateRegion(config.GetStartAddress(),
@@ -127,16 +131,17 @@ static void MemoryFill(const Regs::MemoryFillConfig& config) {
 }
 
 static void DisplayTransfer(const Regs::DisplayTransferConfig& config) {
+    Memory::MemorySystem& memory = *GetState().memory;
     const PAddr src_addr = config.GetPhysicalInputAddress();
     const PAddr dst_addr = config.GetPhysicalOutputAddress();
 
     // TODO: do hwtest with these cases
-    if (!g_memory->IsValidPhysicalAddress(src_addr)) {
+    if (!memory.IsValidPhysicalAddress(src_addr)) {
         LOG_CRITICAL(HW_GPU, "invalid input address {:#010X}", src_addr);
         return;
     }
 
-    if (!g_memory->IsValidPhysicalAddress(dst_addr)) {
+    if (!memory.IsValidPhysicalAddress(dst_addr)) {
         LOG_CRITICAL(HW_GPU, "invalid output address {:#010X}", dst_addr);
         return;
     }
@@ -161,11 +166,11 @@ static void DisplayTransfer(const Regs::DisplayTransferConfig& config) {
         return;
     }
 
-    if (VideoCore::g_renderer->Rasterizer()->AccelerateDisplayTransfer(config))
+    if (VideoCore::GetRenderer()->Rasterizer()->AccelerateDisplayTransfer(config))
         return;
 
-    u8* src_pointer = g_memory->GetPhysicalPointer(src_addr);
-    u8* dst_pointer = g_memory->GetPhysicalPointer(dst_addr);
+    u8* src_pointer = memory.GetPhysicalPointer(src_addr);
+    u8* dst_pointer = memory.GetPhysicalPointer(dst_addr);
 
     if (config.scaling > config.ScaleXY) {
         LOG_CRITICAL(HW_GPU, "Unimplemented display transfer scaling mode {}",
@@ -303,25 +308,26 @@ static void DisplayTransfer(const Regs::DisplayTransferConfig& config) {
 }
 
 static void TextureCopy(const Regs::DisplayTransferConfig& config) {
+    Memory::MemorySystem& memory = *GetState().memory;
     const PAddr src_addr = config.GetPhysicalInputAddress();
     const PAddr dst_addr = config.GetPhysicalOutputAddress();
 
     // TODO: do hwtest with invalid addresses
-    if (!g_memory->IsValidPhysicalAddress(src_addr)) {
+    if (!memory.IsValidPhysicalAddress(src_addr)) {
         LOG_CRITICAL(HW_GPU, "invalid input address {:#010X}", src_addr);
         return;
     }
 
-    if (!g_memory->IsValidPhysicalAddress(dst_addr)) {
+    if (!memory.IsValidPhysicalAddress(dst_addr)) {
         LOG_CRITICAL(HW_GPU, "invalid output address {:#010X}", dst_addr);
         return;
     }
 
-    if (VideoCore::g_renderer->Rasterizer()->AccelerateTextureCopy(config))
+    if (VideoCore::GetRenderer()->Rasterizer()->AccelerateTextureCopy(config))
         return;
 
-    u8* src_pointer = g_memory->GetPhysicalPointer(src_addr);
-    u8* dst_pointer = g_memory->GetPhysicalPointer(dst_addr);
+    u8* src_pointer = memory.GetPhysicalPointer(src_addr);
+    u8* dst_pointer = memory.GetPhysicalPointer(dst_addr);
 
     u32 remaining_size = Common::AlignDown(config.texture_copy.size, 16);
 
@@ -384,6 +390,32 @@ static void TextureCopy(const Regs::DisplayTransferConfig& config) {
     }
 }
 
+/**
+ * Runs a GPU operation, then its completion, which updates the registers and signals interrupts.
+ * With asynchronous GPU emulation the operation runs on the GPU thread, and the completion runs on
+ * the emulation thread once the operation has finished.
+ */
+static void RunOperation(std::function<void()> operation, std::function<void()> completion) {
+    VideoCore::GPUThread* gpu_thread = VideoCore::GetGPUThread();
+    if (!gpu_thread) {
+        {
+            Core::PerfTimer perf_timer{Core::PerfCategory::GpuCommands};
+            operation();
+        }
+        completion();
+        return;
+    }
+
+    gpu_thread->Submit([gpu_thread, operation = std::move(operation),
+                        completion = std::move(completion)] {
+        {
+            Core::PerfTimer perf_timer{Core::PerfCategory::GpuCommands};
+            operation();
+        }
+        gpu_thread->PostCallback(completion);
+    });
+}
+
 template <typename T>
 inline void Write(u32 addr, const T data) {
     addr -= HW::VADDR_GPU;
@@ -395,7 +427,8 @@ inline void Write(u32 addr, const T data) {
         return;
     }
 
-    g_regs[index] = static_cast<u32>(data);
+    Regs& regs = GetState().regs;
+    regs[index] = static_cast<u32>(data);
 
     switch (index) {
 
@@ -403,76 +436,88 @@ inline void Write(u32 addr, const T data) {
     case GPU_REG_INDEX(memory_fill_config[0].trigger):
     case GPU_REG_INDEX(memory_fill_config[1].trigger): {
         const bool is_second_filler = (index != GPU_REG_INDEX(memory_fill_config[0].trigger));
-        auto& config = g_regs.memory_fill_config[is_second_filler];
+        const auto config = regs.memory_fill_config[is_second_filler];
 
         if (config.trigger) {
-            MemoryFill(config);
-            LOG_TRACE(HW_GPU, "MemoryFill from {:#010X} to {:#010X}", config.GetStartAddress(),
-                      config.GetEndAddress());
-
-            // It seems that it won't signal interrupt if "address_start" is zero.
-            // TODO: hwtest this
-            if (config.GetStartAddress() != 0) {
-                if (!is_second_filler) {
-                    Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC0);
-                } else {
-                    Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC1);
+            const auto fill = [config] {
+                MemoryFill(config);
+                LOG_TRACE(HW_GPU, "MemoryFill from {:#010X} to {:#010X}",
+                          config.GetStartAddress(), config.GetEndAddress());
+            };
+            const auto finish = [config, is_second_filler] {
+                // It seems that it won't signal interrupt if "address_start" is zero.
+                // TODO: hwtest this
+                if (config.GetStartAddress() != 0) {
+                    if (!is_second_filler) {
+                        Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC0);
+                    } else {
+                        Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC1);
+                    }
                 }
-            }
 
-            // Reset "trigger" flag and set the "finish" flag
-            // NOTE: This was confirmed to happen on hardware even if "address_start" is zero.
-            config.trigger.Assign(0);
-            config.finished.Assign(1);
+                // Reset "trigger" flag and set the "finish" flag
+                // NOTE: This was confirmed to happen on hardware even if "address_start" is zero.
+                auto& fill_config = GetState().regs.memory_fill_config[is_second_filler];
+                fill_config.trigger.Assign(0);
+                fill_config.finished.Assign(1);
+            };
+            RunOperation(fill, finish);
         }
         break;
     }
 
     case GPU_REG_INDEX(display_transfer_config.trigger): {
-        MICROPROFILE_SCOPE(GPU_DisplayTransfer);
-
-        const auto& config = g_regs.display_transfer_config;
+        const auto config = regs.display_transfer_config;
         if (config.trigger & 1) {
 
             if (Pica::g_debug_context)
                 Pica::g_debug_context->OnEvent(Pica::DebugContext::Event::IncomingDisplayTransfer,
                                                nullptr);
 
-            if (config.is_texture_copy) {
-                TextureCopy(config);
-                LOG_TRACE(HW_GPU,
-                          "TextureCopy: {:#X} bytes from {:#010X}({}+{})-> "
-                          "{:#010X}({}+{}), flags {:#010X}",
-                          config.texture_copy.size, config.GetPhysicalInputAddress(),
-                          config.texture_copy.input_width * 16, config.texture_copy.input_gap * 16,
-                          config.GetPhysicalOutputAddress(), config.texture_copy.output_width * 16,
-                          config.texture_copy.output_gap * 16, config.flags);
-            } else {
-                DisplayTransfer(config);
-                LOG_TRACE(HW_GPU,
-                          "DisplayTransfer: {:#010X}({}x{})-> "
-                          "{:#010X}({}x{}), dst format {:x}, flags {:#010X}",
-                          config.GetPhysicalInputAddress(), config.input_width.Value(),
-                          config.input_height.Value(), config.GetPhysicalOutputAddress(),
-                          config.output_width.Value(), config.output_height.Value(),
-                          static_cast<u32>(config.output_format.Value()), config.flags);
-            }
-
-            g_regs.display_transfer_config.trigger = 0;
-            Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PPF);
+            const auto transfer = [config] {
+                MICROPROFILE_SCOPE(GPU_DisplayTransfer);
+
+                if (config.is_texture_copy) {
+                    TextureCopy(config);
+                    LOG_TRACE(HW_GPU,
+                              "TextureCopy: {:#X} bytes from {:#010X}({}+{})-> "
+                              "{:#010X}({}+{}), flags {:#010X}",
+                              config.texture_copy.size, config.GetPhysicalInputAddress(),
+                              config.texture_copy.input_width * 16,
+                              config.texture_copy.input_gap * 16, config.GetPhysicalOutputAddress(),
+                              config.texture_copy.output_width * 16,
+                              config.texture_copy.output_gap * 16, config.flags);
+                } else {
+                    DisplayTransfer(config);
+                    LOG_TRACE(HW_GPU,
+                              "DisplayTransfer: {:#010X}({}x{})-> "
+                              "{:#010X}({}x{}), dst format {:x}, flags {:#010X}",
+                              config.GetPhysicalInputAddress(), config.input_width.Value(),
+                              config.input_height.Value(), config.GetPhysicalOutputAddress(),
+                              config.output_width.Value(), config.output_height.Value(),
+                              static_cast<u32>(config.output_format.Value()), config.flags);
+                }
+            };
+            const auto finish = [] {
+                GetState().regs.display_transfer_config.trigger = 0;
+                Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PPF);
+            };
+            RunOperation(transfer, finish);
         }
         break;
     }
 
     // Seems like writing to this register triggers processing
     case GPU_REG_INDEX(command_processor_config.trigger): {
-        const auto& config = g_regs.command_processor_config;
+        const auto& config = regs.command_processor_config;
         if (config.trigger & 1) {
-            MICROPROFILE_SCOPE(GPU_CmdlistProcessing);
-
-            Pica::CommandProcessor::ProcessCommandList(config.GetPhysicalAddress(), config.size);
+            const auto process = [address = config.GetPhysicalAddress(), size = config.size] {
+                MICROPROFILE_SCOPE(GPU_CmdlistProcessing);
 
-            g_regs.command_processor_config.trigger = 0;
+                Pica::CommandProcessor::ProcessCommandList(address, size);
+            };
+            const auto finish = [] { GetState().regs.command_processor_config.trigger = 0; };
+            RunOperation(process, finish);
         }
         break;
     }
@@ -504,7 +549,21 @@ template void Write<u8>(u32 addr, const u8 data);
 
 /// Update hardware
 static void VBlankCallback(u64 userdata, s64 cycles_late) {
-    VideoCore::g_renderer->SwapBuffers();
+    // The registers keep changing while the GPU thread presents the frame, so it gets a copy
+    RendererBase::FrameConfig config;
+    const Regs& regs = GetState().regs;
+    config.framebuffers = {regs.framebuffer_config[0], regs.framebuffer_config[1]};
+    config.color_fills = {LCD::GetRegs().color_fill_top, LCD::GetRegs().color_fill_bottom};
+
+    if (VideoCore::GPUThread* gpu_thread = VideoCore::GetGPUThread()) {
+        // Keep at most one frame in flight, so that the CPU does not run ahead of the display
+        State& state = GetState();
+        gpu_thread->WaitForFence(state.frame_fence);
+        state.frame_fence =
+            gpu_thread->Submit([config] { VideoCore::GetRenderer()->SwapBuffers(config); });
+    } else {
+        VideoCore::GetRenderer()->SwapBuffers(config);
+    }
 
     // Signal to GSP that GPU interrupt has occurred
     // TODO(yuriks): hwtest to determine if PDC0 is for the Top screen and PDC1 for the Sub
@@ -514,17 +573,29 @@ static void VBlankCallback(u64 userdata, s64 cycles_late) {
     Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PDC0);
     Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PDC1);
 
+    Core::Movie::GetInstance().HandleFrame();
+    Core::System::GetInstance().RPCServer().HandleFrame();
+
     // Reschedule recurrent event
-    Core::System::GetInstance().CoreTiming().ScheduleEvent(frame_ticks - cycles_late, vblank_event);
+    Core::System::GetInstance().CoreTiming().ScheduleEvent(frame_ticks - cycles_late,
+                                                           GetState().vblank_event);
+}
+
+void Update() {
+    if (VideoCore::GPUThread* gpu_thread = VideoCore::GetGPUThread()) {
+        gpu_thread->RunCallbacks();
+    }
 }
 
 /// Initialize hardware
 void Init(Memory::MemorySystem& memory) {
-    g_memory = &memory;
-    memset(&g_regs, 0, sizeof(g_regs));
+    State& state = GetState();
+    state.memory = &memory;
+    state.frame_fence = 0;
+    memset(&state.regs, 0, sizeof(state.regs));
 
-    auto& framebuffer_top = g_regs.framebuffer_config[0];
-    auto& framebuffer_sub = g_regs.framebuffer_config[1];
+    auto& framebuffer_top = state.regs.framebuffer_config[0];
+    auto& framebuffer_sub = state.regs.framebuffer_config[1];
 
     // Setup default framebuffer addresses (located in VRAM)
     // .. or at least these are the ones used by system applets.
@@ -550,8 +621,8 @@ void Init(Memory::MemorySystem& memory) {
     framebuffer_sub.active_fb = 0;
 
     Core::Timing& timing = Core::System::GetInstance().CoreTiming();
-    vblank_event = timing.RegisterEvent("GPU::VBlankCallback", VBlankCallback);
-    timing.ScheduleEvent(frame_ticks, vblank_event);
+    state.vblank_event = timing.RegisterEvent("GPU::VBlankCallback", VBlankCallback);
+    timing.ScheduleEvent(frame_ticks, state.vblank_event);
 
     LOG_DEBUG(HW_GPU, "initialized OK");
 }
@@ -312,7 +312,18 @@ ASSERT_REG_POSITION(command_processor_config, 0x00638);
 // anyway.
 static_assert(sizeof(Regs) == 0x1000 * sizeof(u32), "Invalid total size of register set");
 
-extern Regs g_regs;
+/// GPU state of a single emulator instance.
+struct State {
+    Regs regs{};
+    Memory::MemorySystem* memory = nullptr;
+    /// Event id for CoreTiming
+    Core::TimingEventType* vblank_event = nullptr;
+    /// Fence of the last frame submitted to the GPU thread
+    u64 frame_fence = 0;
+};
+
+/// Returns the GPU state of the emulator instance bound to the calling thread
+State& GetState();
 
 template <typename T>
 void Read(T& var, const u32 addr);
@@ -320,6 +331,9 @@ void Read(T& var, const u32 addr);
 template <typename T>
 void Write(u32 addr, const T data);
 
+/// Runs the completions of work that finished on the GPU thread
+void Update();
+
 /// Initialize hardware
 void Init(Memory::MemorySystem& memory);
 
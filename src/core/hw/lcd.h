@@ -80,7 +80,8 @@ ASSERT_REG_POSITION(backlight_bottom, 0x290);
 #undef ASSERT_REG_POSITION
 #endif // !defined(_MSC_VER)
 
-extern Regs g_regs;
+/// Returns the LCD registers of the emulator instance bound to the calling thread
+Regs& GetRegs();
 
 template <typename T>
 void Read(T& var, const u32 addr);
@@ -5,9 +5,11 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 #include "common/common_types.h"
@@ -36,6 +38,10 @@ enum class FileType {
     THREEDSX, // 3DSX
 };
 
+/// Extensions, in lowercase and without the dot, of the bootable files listed by the frontends
+constexpr std::array<std::string_view, 7> SupportedFileExtensions{"3ds", "3dsx", "elf", "axf",
+                                                                  "cci", "cxi",  "app"};
+
 /**
  * Identifies the type of a bootable file based on the magic value in its header.
  * @param file open file
@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <array>
+#include <atomic>
 #include <cstring>
 #include <boost/serialization/array.hpp>
 #include <boost/serialization/binary_object.hpp>
@@ -10,6 +11,7 @@
 #include "common/archives.h"
 #include "common/assert.h"
 #include "common/common_types.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "common/swap.h"
 #include "core/arm/arm_interface.h"
@@ -17,9 +19,9 @@
 #include "core/global.h"
 #include "core/hle/kernel/memory.h"
 #include "core/hle/kernel/process.h"
-#include "core/hle/lock.h"
 #include "core/memory.h"
 #include "core/settings.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/renderer_base.h"
 #include "video_core/video_core.h"
 
@@ -89,6 +91,7 @@ public:
 
     std::shared_ptr<PageTable> current_page_table = nullptr;
     RasterizerCacheMarker cache_marker;
+    std::atomic<u64> page_table_generation{0};
     std::vector<std::shared_ptr<PageTable>> page_table_list;
 
     AudioCore::DspInterface* dsp = nullptr;
@@ -206,18 +209,28 @@ MemorySystem::~MemorySystem() = default;
 template <class Archive>
 void MemorySystem::serialize(Archive& ar, const unsigned int file_version) {
     ar&* impl.get();
+    impl->page_table_generation++;
 }
 
 SERIALIZE_IMPL(MemorySystem)
 
 void MemorySystem::SetCurrentPageTable(std::shared_ptr<PageTable> page_table) {
+    // The kernel rebinds the same process whenever it switches between cores
+    if (impl->current_page_table == page_table) {
+        return;
+    }
     impl->current_page_table = page_table;
+    impl->page_table_generation++;
 }
 
 std::shared_ptr<PageTable> MemorySystem::GetCurrentPageTable() const {
     return impl->current_page_table;
 }
 
+u64 MemorySystem::GetPageTableGeneration() const {
+    return impl->page_table_generation.load(std::memory_order_relaxed);
+}
+
 void MemorySystem::MapPages(PageTable& page_table, u32 base, u32 size, MemoryRef memory,
                             PageType type) {
     LOG_DEBUG(HW_Memory, "Mapping {} onto {:08X}-{:08X}", (void*)memory.GetPtr(), base * PAGE_SIZE,
@@ -243,6 +256,9 @@ void MemorySystem::MapPages(PageTable& page_table, u32 base, u32 size, MemoryRef
         if (memory != nullptr && memory.GetSize() > PAGE_SIZE)
             memory += PAGE_SIZE;
     }
+
+    // Only once the entries have changed, so that nobody links against the old ones anew
+    impl->page_table_generation++;
 }
 
 void MemorySystem::MapMemoryRegion(PageTable& page_table, VAddr base, u32 size, MemoryRef target) {
@@ -524,11 +540,53 @@ static std::vector<VAddr> PhysicalToVirtualAddressForRasterizer(PAddr addr) {
     return {};
 }
 
+/// Hashes each page touching a rasterizer region, pages outside of VRAM and FCRAM hash to zero
+static std::vector<u64> HashRasterizerPages(const MemorySystem& memory, PAddr start, u32 size) {
+    const u32 num_pages = ((start + size - 1) >> PAGE_BITS) - (start >> PAGE_BITS) + 1;
+    std::vector<u64> hashes(num_pages);
+    PAddr paddr = start & ~PAGE_MASK;
+    for (u32 i = 0; i < num_pages; ++i, paddr += PAGE_SIZE) {
+        const bool in_vram = paddr >= VRAM_PADDR && paddr < VRAM_PADDR_END;
+        const bool in_fcram = paddr >= FCRAM_PADDR && paddr < FCRAM_N3DS_PADDR_END;
+        if (in_vram || in_fcram) {
+            hashes[i] = Common::ComputeHash64(memory.GetPhysicalPointer(paddr), PAGE_SIZE);
+        }
+    }
+    return hashes;
+}
+
 void MemorySystem::RasterizerMarkRegionCached(PAddr start, u32 size, bool cached) {
     if (start == 0) {
         return;
     }
 
+    // The JIT and the emulation thread read the page tables without locking, so only the
+    // emulation thread may change them. Until it does, CPU writes to the pages bypass the
+    // rasterizer, so the pages are hashed now and the ones that changed in the meantime are
+    // invalidated once they are marked.
+    VideoCore::GPUThread* gpu_thread = VideoCore::GetGPUThread();
+    if (gpu_thread && gpu_thread->IsGPUThread()) {
+        if (!cached) {
+            // Uncached pages still go through the rasterizer until the callback runs
+            gpu_thread->PostCallback(
+                [this, start, size] { RasterizerMarkRegionCached(start, size, false); });
+            return;
+        }
+        gpu_thread->PostCallback([this, start, size,
+                                  hashes = HashRasterizerPages(*this, start, size)] {
+            RasterizerMarkRegionCached(start, size, true);
+            const std::vector<u64> current = HashRasterizerPages(*this, start, size);
+            const PAddr first_page = start & ~PAGE_MASK;
+            for (std::size_t i = 0; i < hashes.size(); ++i) {
+                if (current[i] != hashes[i]) {
+                    RasterizerInvalidateRegion(first_page + static_cast<u32>(i) * PAGE_SIZE,
+                                               PAGE_SIZE);
+                }
+            }
+        });
+        return;
+    }
+
     u32 num_pages = ((start + size - 1) >> PAGE_BITS) - (start >> PAGE_BITS) + 1;
     PAddr paddr = start;
 
@@ -572,48 +630,56 @@ void MemorySystem::RasterizerMarkRegionCached(PAddr start, u32 size, bool cached
             }
         }
     }
+
+    impl->page_table_generation++;
 }
 
 void RasterizerFlushRegion(PAddr start, u32 size) {
-    if (VideoCore::g_renderer == nullptr) {
+    auto* renderer = VideoCore::GetRenderer();
+    if (renderer == nullptr) {
         return;
     }
 
-    VideoCore::g_renderer->Rasterizer()->FlushRegion(start, size);
+    VideoCore::RunOnGPUThread([&] { renderer->Rasterizer()->FlushRegion(start, size); });
 }
 
 void RasterizerInvalidateRegion(PAddr start, u32 size) {
-    if (VideoCore::g_renderer == nullptr) {
+    auto* renderer = VideoCore::GetRenderer();
+    if (renderer == nullptr) {
         return;
     }
 
-    VideoCore::g_renderer->Rasterizer()->InvalidateRegion(start, size);
+    VideoCore::RunOnGPUThread([&] { renderer->Rasterizer()->InvalidateRegion(start, size); });
 }
 
 void RasterizerFlushAndInvalidateRegion(PAddr start, u32 size) {
     // Since pages are unmapped on shutdown after video core is shutdown, the renderer may be
     // null here
-    if (VideoCore::g_renderer == nullptr) {
+    auto* renderer = VideoCore::GetRenderer();
+    if (renderer == nullptr) {
         return;
     }
 
-    VideoCore::g_renderer->Rasterizer()->FlushAndInvalidateRegion(start, size);
+    VideoCore::RunOnGPUThread(
+        [&] { renderer->Rasterizer()->FlushAndInvalidateRegion(start, size); });
 }
 
 void RasterizerClearAll(bool flush) {
     // Since pages are unmapped on shutdown after video core is shutdown, the renderer may be
     // null here
-    if (VideoCore::g_renderer == nullptr) {
+    auto* renderer = VideoCore::GetRenderer();
+    if (renderer == nullptr) {
         return;
     }
 
-    VideoCore::g_renderer->Rasterizer()->ClearAll(flush);
+    VideoCore::RunOnGPUThread([&] { renderer->Rasterizer()->ClearAll(flush); });
 }
 
 void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode) {
     // Since pages are unmapped on shutdown after video core is shutdown, the renderer may be
     // null here
-    if (VideoCore::g_renderer == nullptr) {
+    auto* renderer = VideoCore::GetRenderer();
+    if (renderer == nullptr) {
         return;
     }
 
@@ -630,7 +696,7 @@ void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode) {
         PAddr physical_start = paddr_region_start + (overlap_start - region_start);
         u32 overlap_size = overlap_end - overlap_start;
 
-        auto* rasterizer = VideoCore::g_renderer->Rasterizer();
+        auto* rasterizer = renderer->Rasterizer();
         switch (mode) {
         case FlushMode::Flush:
             rasterizer->FlushRegion(physical_start, overlap_size);
@@ -644,9 +710,11 @@ void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode) {
         }
     };
 
-    CheckRegion(LINEAR_HEAP_VADDR, LINEAR_HEAP_VADDR_END, FCRAM_PADDR);
-    CheckRegion(NEW_LINEAR_HEAP_VADDR, NEW_LINEAR_HEAP_VADDR_END, FCRAM_PADDR);
-    CheckRegion(VRAM_VADDR, VRAM_VADDR_END, VRAM_PADDR);
+    VideoCore::RunOnGPUThread([&] {
+        CheckRegion(LINEAR_HEAP_VADDR, LINEAR_HEAP_VADDR_END, FCRAM_PADDR);
+        CheckRegion(NEW_LINEAR_HEAP_VADDR, NEW_LINEAR_HEAP_VADDR_END, FCRAM_PADDR);
+        CheckRegion(VRAM_VADDR, VRAM_VADDR_END, VRAM_PADDR);
+    });
 }
 
 u8 MemorySystem::Read8(const VAddr addr) {
@@ -251,6 +251,10 @@ enum : VAddr {
     NEW_LINEAR_HEAP_VADDR_END = NEW_LINEAR_HEAP_VADDR + NEW_LINEAR_HEAP_SIZE,
 };
 
+// With asynchronous GPU emulation, the Rasterizer* functions below run on the GPU thread and only
+// return once it has processed all work submitted before them. This makes them the fences between
+// CPU accesses to memory and the results of GPU work.
+
 /**
  * Flushes any externally cached rasterizer resources touching the given region.
  */
@@ -317,6 +321,13 @@ public:
     void SetCurrentPageTable(std::shared_ptr<PageTable> page_table);
     std::shared_ptr<PageTable> GetCurrentPageTable() const;
 
+    /**
+     * Returns a counter that changes whenever the current page table is switched, or an entry of
+     * any page table is remapped or switched to or from rasterizer-cached. Host pointers taken
+     * from the page table stay valid as long as this value does not change.
+     */
+    u64 GetPageTableGeneration() const;
+
     u8 Read8(VAddr addr);
     u16 Read16(VAddr addr);
     u32 Read32(VAddr addr);
@@ -366,6 +377,9 @@ public:
 
     /**
      * Mark each page touching the region as cached.
+     * When called from the GPU thread, the pages change once the emulation thread runs the GPU
+     * callbacks, between two CPU slices. Newly cached pages that the CPU wrote in the meantime are
+     * invalidated then.
      */
     void RasterizerMarkRegionCached(PAddr start, u32 size, bool cached);
 
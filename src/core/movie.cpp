@@ -2,7 +2,9 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cstring>
+#include <stdexcept>
 #include <string>
 #include <vector>
 #include <boost/optional.hpp>
@@ -12,9 +14,11 @@
 #include "common/file_util.h"
 #include "common/logging/log.h"
 #include "common/scm_rev.h"
+#include "common/scope_exit.h"
 #include "common/string_util.h"
 #include "common/swap.h"
 #include "common/timer.h"
+#include "common/zstd_compression.h"
 #include "core/core.h"
 #include "core/hle/service/hid/hid.h"
 #include "core/hle/service/ir/extra_hid.h"
@@ -110,19 +114,42 @@ static_assert(sizeof(ControllerState) == 7, "ControllerState should be 7 bytes")
 #pragma pack(pop)
 
 constexpr std::array<u8, 4> header_magic_bytes{{'C', 'T', 'M', 0x1B}};
+/// Movies made of compressed chunks, each starting with a keyframe
+constexpr std::array<u8, 4> seekable_header_magic_bytes{{'C', 'T', 'S', 0x1B}};
 
 #pragma pack(push, 1)
 struct CTMHeader {
-    std::array<u8, 4> filetype;  /// Unique Identifier to check the file type (always "CTM"0x1B)
+    std::array<u8, 4> filetype;  /// Unique Identifier to check the file type ("CTM"/"CTS"0x1B)
     u64_le program_id;           /// ID of the ROM being executed. Also called title_id
     std::array<u8, 20> revision; /// Git hash of the revision this movie was created with
     u64_le clock_init_time;      /// The init time of the system clock
 
-    std::array<u8, 216> reserved; /// Make heading 256 bytes so it has consistent size
+    // Seekable movies only
+    u64_le index_offset; /// Offset of the chunk index, at the end of the file
+    u32_le num_chunks;   /// Number of entries in the chunk index
+    u64_le num_frames;   /// Length of the movie in frames
+
+    std::array<u8, 196> reserved; /// Make heading 256 bytes so it has consistent size
 };
 static_assert(sizeof(CTMHeader) == 256, "CTMHeader should be 256 bytes");
+
+/// Entry of the chunk index of seekable movies
+struct CTMChunk {
+    u64_le frame;              /// Frame at which the chunk starts
+    u64_le input_offset;       /// Offset of the chunk in the uncompressed input
+    u64_le input_file_offset;  /// Location of the zstd-compressed input in the file
+    u32_le input_size;         /// Uncompressed size of the input
+    u32_le input_file_size;    /// Compressed size of the input
+    u64_le state_file_offset;  /// Location of the keyframe save state in the file
+    u64_le state_file_size;    /// Size of the keyframe save state, 0 if there is none
+};
+static_assert(sizeof(CTMChunk) == 48, "CTMChunk should be 48 bytes");
 #pragma pack(pop)
 
+static bool IsMovieHeader(const CTMHeader& header) {
+    return header.filetype == header_magic_bytes || header.filetype == seekable_header_magic_bytes;
+}
+
 bool Movie::IsPlayingInput() const {
     return play_mode == PlayMode::Playing;
 }
@@ -133,6 +160,7 @@ bool Movie::IsRecordingInput() const {
 void Movie::CheckInputEnd() {
     if (current_byte + sizeof(ControllerState) > recorded_input.size()) {
         LOG_INFO(Movie, "Playback finished");
+        FinishSeek();
         play_mode = PlayMode::None;
         init_time = 0;
         playback_completion_callback();
@@ -359,14 +387,14 @@ u64 Movie::GetOverrideInitTime() const {
 }
 
 Movie::ValidationResult Movie::ValidateHeader(const CTMHeader& header, u64 program_id) const {
-    if (header_magic_bytes != header.filetype) {
+    if (!IsMovieHeader(header)) {
         LOG_ERROR(Movie, "Playback file does not have valid header");
         return ValidationResult::Invalid;
     }
 
     std::string revision = fmt::format("{:02x}", fmt::join(header.revision, ""));
 
-    if (!program_id)
+    if (!program_id && Core::System::GetInstance().IsPoweredOn())
         Core::System::GetInstance().GetAppLoader().ReadProgramId(program_id);
     if (program_id != header.program_id) {
         LOG_WARNING(Movie, "This movie was recorded using a ROM with a different program id");
@@ -392,24 +420,115 @@ void Movie::SaveMovie() {
     }
 
     CTMHeader header = {};
-    header.filetype = header_magic_bytes;
+    header.filetype = seekable_header_magic_bytes;
     header.clock_init_time = init_time;
+    header.num_frames = current_frame;
 
-    Core::System::GetInstance().GetAppLoader().ReadProgramId(header.program_id);
+    if (Core::System::GetInstance().IsPoweredOn()) {
+        Core::System::GetInstance().GetAppLoader().ReadProgramId(header.program_id);
+    }
 
     std::string rev_bytes;
     CryptoPP::StringSource(Common::g_scm_rev, true,
                            new CryptoPP::HexDecoder(new CryptoPP::StringSink(rev_bytes)));
     std::memcpy(header.revision.data(), rev_bytes.data(), sizeof(CTMHeader::revision));
 
+    // The header is written again once the index is known
+    save_record.WriteBytes(&header, sizeof(CTMHeader));
+
+    // Every keyframe starts a chunk. Input recorded before the first keyframe gets a chunk without
+    // one.
+    std::vector<CTMChunk> chunks;
+    if (keyframes.empty() || keyframes.front().input_offset != 0) {
+        chunks.push_back(CTMChunk{});
+    }
+    const std::size_t first_keyframe_chunk = chunks.size();
+    for (const Keyframe& keyframe : keyframes) {
+        CTMChunk chunk{};
+        chunk.frame = keyframe.frame;
+        chunk.input_offset = keyframe.input_offset;
+        chunks.push_back(chunk);
+    }
+
+    FileUtil::IOFile states(keyframe_file, "rb");
+    std::vector<u8> state;
+    for (std::size_t i = 0; i < chunks.size(); ++i) {
+        CTMChunk& chunk = chunks[i];
+        const std::size_t input_begin = chunk.input_offset;
+        const std::size_t input_end =
+            i + 1 < chunks.size() ? chunks[i + 1].input_offset : recorded_input.size();
+        const auto input = Common::Compression::CompressDataZSTDDefault(
+            recorded_input.data() + input_begin, input_end - input_begin);
+        chunk.input_size = static_cast<u32>(input_end - input_begin);
+        chunk.input_file_offset = save_record.Tell();
+        chunk.input_file_size = static_cast<u32>(input.size());
+        save_record.WriteBytes(input.data(), input.size());
+
+        if (i >= first_keyframe_chunk) {
+            // Keyframes that can't be read back leave their chunk without a save state
+            const Keyframe& keyframe = keyframes[i - first_keyframe_chunk];
+            state.resize(keyframe.state_size);
+            if (!states.Seek(keyframe.state_offset, SEEK_SET) ||
+                states.ReadBytes(state.data(), state.size()) != state.size()) {
+                LOG_ERROR(Movie, "Unable to read keyframe at frame {}", keyframe.frame);
+                continue;
+            }
+            chunk.state_file_offset = save_record.Tell();
+            chunk.state_file_size = state.size();
+            save_record.WriteBytes(state.data(), state.size());
+        }
+    }
+    states.Close();
+    FileUtil::Delete(keyframe_file);
+
+    header.index_offset = save_record.Tell();
+    header.num_chunks = static_cast<u32>(chunks.size());
+    save_record.WriteArray(chunks.data(), chunks.size());
+    save_record.Seek(0, SEEK_SET);
     save_record.WriteBytes(&header, sizeof(CTMHeader));
-    save_record.WriteBytes(recorded_input.data(), recorded_input.size());
 
     if (!save_record.IsGood()) {
         LOG_ERROR(Movie, "Error saving movie");
     }
 }
 
+bool Movie::LoadSeekableMovie(FileUtil::IOFile& file, const CTMHeader& header) {
+    std::vector<CTMChunk> chunks(header.num_chunks);
+    if (!file.Seek(header.index_offset, SEEK_SET) ||
+        file.ReadArray(chunks.data(), chunks.size()) != chunks.size()) {
+        return false;
+    }
+
+    recorded_input.clear();
+    keyframes.clear();
+    for (const CTMChunk& chunk : chunks) {
+        if (chunk.input_offset != recorded_input.size()) {
+            return false;
+        }
+        std::vector<u8> compressed(chunk.input_file_size);
+        if (!file.Seek(chunk.input_file_offset, SEEK_SET) ||
+            file.ReadBytes(compressed.data(), compressed.size()) != compressed.size()) {
+            return false;
+        }
+        const auto input = Common::Compression::DecompressDataZSTD(compressed);
+        if (input.size() != chunk.input_size) {
+            return false;
+        }
+        recorded_input.insert(recorded_input.end(), input.begin(), input.end());
+
+        // Save states are only read when seeking
+        if (chunk.state_file_size != 0) {
+            Keyframe keyframe;
+            keyframe.frame = chunk.frame;
+            keyframe.input_offset = chunk.input_offset;
+            keyframe.state_offset = chunk.state_file_offset;
+            keyframe.state_size = chunk.state_file_size;
+            keyframes.push_back(std::move(keyframe));
+        }
+    }
+    return true;
+}
+
 void Movie::StartPlayback(const std::string& movie_file,
                           std::function<void()> completion_callback) {
     LOG_INFO(Movie, "Loading Movie for playback");
@@ -420,10 +539,20 @@ void Movie::StartPlayback(const std::string& movie_file,
         CTMHeader header;
         save_record.ReadArray(&header, 1);
         if (ValidateHeader(header) != ValidationResult::Invalid) {
+            if (header.filetype == seekable_header_magic_bytes) {
+                if (!LoadSeekableMovie(save_record, header)) {
+                    LOG_ERROR(Movie, "Failed to playback movie: '{}' is corrupted", movie_file);
+                    return;
+                }
+            } else {
+                keyframes.clear();
+                recorded_input.resize(size - sizeof(CTMHeader));
+                save_record.ReadArray(recorded_input.data(), recorded_input.size());
+            }
             play_mode = PlayMode::Playing;
-            recorded_input.resize(size - sizeof(CTMHeader));
-            save_record.ReadArray(recorded_input.data(), recorded_input.size());
+            play_movie_file = movie_file;
             current_byte = 0;
+            current_frame = 0;
             playback_completion_callback = completion_callback;
         }
     } else {
@@ -435,6 +564,11 @@ void Movie::StartRecording(const std::string& movie_file) {
     LOG_INFO(Movie, "Enabling Movie recording");
     play_mode = PlayMode::Recording;
     record_movie_file = movie_file;
+    current_frame = 0;
+    keyframes.clear();
+    keyframes_enabled = true;
+    keyframe_file = movie_file + ".keyframes";
+    FileUtil::Delete(keyframe_file);
 }
 
 static boost::optional<CTMHeader> ReadHeader(const std::string& movie_file) {
@@ -448,7 +582,7 @@ static boost::optional<CTMHeader> ReadHeader(const std::string& movie_file) {
     CTMHeader header;
     save_record.ReadArray(&header, 1);
 
-    if (header_magic_bytes != header.filetype) {
+    if (!IsMovieHeader(header)) {
         return boost::none;
     }
 
@@ -491,13 +625,144 @@ void Movie::Shutdown() {
         SaveMovie();
     }
 
+    FinishSeek();
     play_mode = PlayMode::None;
     recorded_input.resize(0);
     record_movie_file.clear();
+    play_movie_file.clear();
     current_byte = 0;
+    current_frame = 0;
+    keyframes.clear();
+    keyframe_file.clear();
+    keyframes_enabled = true;
     init_time = 0;
 }
 
+void Movie::HandleFrame() {
+    if (play_mode == PlayMode::None) {
+        return;
+    }
+    ++current_frame;
+    if (seek_target_frame && current_frame >= *seek_target_frame) {
+        FinishSeek();
+    }
+}
+
+u64 Movie::GetCurrentFrame() const {
+    return current_frame;
+}
+
+bool Movie::IsKeyframeDue() const {
+    return IsRecordingInput() && keyframes_enabled &&
+           (keyframes.empty() || current_frame >= keyframes.back().frame + KeyframeInterval);
+}
+
+void Movie::RecordKeyframe(System& system) {
+    RecordKeyframe([&system] { return system.SaveStateBuffer(); });
+}
+
+void Movie::RecordKeyframe(const StateSaver& save_state) {
+    std::vector<u8> state;
+    try {
+        serializing_keyframe = true;
+        SCOPE_EXIT({ serializing_keyframe = false; });
+        state = save_state();
+    } catch (const std::exception& e) {
+        LOG_ERROR(Movie, "Unable to record keyframes, the movie will not be seekable: {}",
+                  e.what());
+        keyframes_enabled = false;
+        return;
+    }
+
+    // Save states are several megabytes, so they wait on disk until the movie is saved
+    FileUtil::IOFile file(keyframe_file, "ab");
+    Keyframe keyframe;
+    keyframe.frame = current_frame;
+    keyframe.input_offset = current_byte;
+    keyframe.state_offset = file.GetSize();
+    keyframe.state_size = state.size();
+    if (file.WriteBytes(state.data(), state.size()) != state.size()) {
+        LOG_ERROR(Movie, "Unable to write keyframe to '{}', the movie will not be seekable",
+                  keyframe_file);
+        keyframes_enabled = false;
+        return;
+    }
+    LOG_DEBUG(Movie, "Recorded keyframe at frame {} ({} bytes)", keyframe.frame, state.size());
+    keyframes.push_back(keyframe);
+}
+
+void Movie::DiscardKeyframesAfter(std::size_t input_offset) {
+    if (!IsRecordingInput()) {
+        return;
+    }
+    keyframes.erase(std::remove_if(keyframes.begin(), keyframes.end(),
+                                   [input_offset](const Keyframe& keyframe) {
+                                       return keyframe.input_offset > input_offset;
+                                   }),
+                    keyframes.end());
+
+    // Reclaim the save states of the discarded keyframes
+    const u64 size =
+        keyframes.empty() ? 0 : keyframes.back().state_offset + keyframes.back().state_size;
+    FileUtil::IOFile file(keyframe_file, "r+b");
+    file.Resize(size);
+}
+
+void Movie::SeekToFrame(System& system, u64 frame) {
+    SeekToFrame(frame, [&system](const std::vector<u8>& state) { system.LoadStateBuffer(state); });
+}
+
+void Movie::SeekToFrame(u64 frame, const StateLoader& load_state) {
+    if (!IsPlayingInput()) {
+        LOG_ERROR(Movie, "Unable to seek as no movie is being played back");
+        return;
+    }
+
+    // The last keyframe at or before the frame
+    auto keyframe = std::upper_bound(
+        keyframes.begin(), keyframes.end(), frame,
+        [](u64 value, const Keyframe& keyframe) { return value < keyframe.frame; });
+    const bool has_keyframe = keyframe != keyframes.begin();
+    if (has_keyframe) {
+        --keyframe;
+    }
+
+    // Playback simply continues if it is already between that keyframe and the frame
+    if (current_frame > frame || (has_keyframe && current_frame < keyframe->frame)) {
+        if (!has_keyframe) {
+            LOG_ERROR(Movie, "Unable to seek to frame {}, as the movie has no keyframe before it",
+                      frame);
+            return;
+        }
+
+        std::vector<u8> state(keyframe->state_size);
+        FileUtil::IOFile file(play_movie_file, "rb");
+        if (!file.Seek(keyframe->state_offset, SEEK_SET) ||
+            file.ReadBytes(state.data(), state.size()) != state.size()) {
+            throw std::runtime_error("Could not read keyframe from " + play_movie_file);
+        }
+
+        serializing_keyframe = true;
+        SCOPE_EXIT({ serializing_keyframe = false; });
+        load_state(state);
+        LOG_INFO(Movie, "Loaded keyframe at frame {}", current_frame);
+    }
+
+    if (current_frame < frame) {
+        seek_target_frame = frame;
+        Core::System::GetInstance().frame_limiter.SetFastForwarding(true);
+    }
+}
+
+void Movie::FinishSeek() {
+    if (!seek_target_frame) {
+        return;
+    }
+    LOG_INFO(Movie, "Seek finished at frame {}", current_frame);
+    seek_target_frame.reset();
+    Core::System::GetInstance().frame_limiter.SetFastForwarding(false);
+}
+
 template <typename... Targs>
 void Movie::Handle(Targs&... Fargs) {
     if (IsPlayingInput()) {
@@ -5,9 +5,17 @@
 #pragma once
 
 #include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+#include <boost/serialization/version.hpp>
 #include <boost/serialization/vector.hpp>
 #include "common/common_types.h"
 
+namespace FileUtil {
+class IOFile;
+}
+
 namespace Service {
 namespace HID {
 struct AccelerometerDataEntry;
@@ -22,6 +30,7 @@ union PadState;
 } // namespace Service
 
 namespace Core {
+class System;
 struct CTMHeader;
 struct ControllerState;
 enum class PlayMode;
@@ -99,9 +108,60 @@ public:
     bool IsPlayingInput() const;
     bool IsRecordingInput() const;
 
+    /// Counts an emulated frame (VBlank) of the movie being recorded or played back
+    void HandleFrame();
+
+    /// Returns the number of frames since the start of the movie
+    u64 GetCurrentFrame() const;
+
+    /// Returns whether the movie being recorded needs a new keyframe
+    bool IsKeyframeDue() const;
+
+    /// Makes a compressed save state, which includes the movie
+    using StateSaver = std::function<std::vector<u8>()>;
+    /// Loads a compressed save state made by a StateSaver
+    using StateLoader = std::function<void(const std::vector<u8>&)>;
+
+    /**
+     * Embeds a save state of the system as a keyframe into the movie being recorded.
+     * Must be called at a point where save states can be made.
+     */
+    void RecordKeyframe(System& system);
+
+    /// Embeds the save state made by `save_state` as a keyframe into the movie being recorded
+    void RecordKeyframe(const StateSaver& save_state);
+
+    /**
+     * Seeks the movie being played back to the given frame, by loading the last keyframe before it
+     * and then fast-forwarding. Must be called at a point where save states can be loaded, which
+     * is done by sending System::Signal::MovieSeek.
+     * Throws if loading the keyframe failed.
+     */
+    void SeekToFrame(System& system, u64 frame);
+
+    /// Seeks the movie being played back to the given frame, loading keyframes with `load_state`
+    void SeekToFrame(u64 frame, const StateLoader& load_state);
+
+    /// Number of frames between two keyframes of recorded movies, about a minute
+    static constexpr u64 KeyframeInterval = 3600;
+
 private:
     static Movie s_instance;
 
+    /// Save state embedded into a movie, from which playback can resume
+    struct Keyframe {
+        u64 frame = 0;
+        u64 input_offset = 0;
+        /// Location of the compressed save state, in the keyframe file while recording and in the
+        /// movie file while playing back
+        u64 state_offset = 0;
+        u64 state_size = 0;
+    };
+
+    bool LoadSeekableMovie(FileUtil::IOFile& file, const CTMHeader& header);
+    void DiscardKeyframesAfter(std::size_t input_offset);
+    void FinishSeek();
+
     void CheckInputEnd();
 
     template <typename... Targs>
@@ -134,15 +194,36 @@ private:
     std::function<void()> playback_completion_callback;
     std::size_t current_byte = 0;
 
+    u64 current_frame = 0;
+    std::string play_movie_file;
+    std::vector<Keyframe> keyframes;
+    /// Where the save states of the keyframes are kept until the recorded movie is saved
+    std::string keyframe_file;
+    bool keyframes_enabled = true;
+    /// Set while a keyframe is saved or loaded, which leaves out the input of the movie
+    bool serializing_keyframe = false;
+    std::optional<u64> seek_target_frame;
+
     template <class Archive>
-    void serialize(Archive& ar, const unsigned int) {
+    void serialize(Archive& ar, const unsigned int file_version) {
         // Only serialize what's needed to make savestates useful for TAS:
         u64 _current_byte = static_cast<u64>(current_byte);
         ar& _current_byte;
         current_byte = static_cast<std::size_t>(_current_byte);
-        ar& recorded_input;
+        if (!serializing_keyframe) {
+            ar& recorded_input;
+        }
         ar& init_time;
+        if (file_version >= 1) {
+            ar& current_frame;
+        }
+        if (Archive::is_loading::value && !serializing_keyframe) {
+            // Keyframes past the loaded state are about to be recorded over
+            DiscardKeyframesAfter(current_byte);
+        }
     }
     friend class boost::serialization::access;
 };
-} // namespace Core
\ No newline at end of file
+} // namespace Core
+
+BOOST_CLASS_VERSION(Core::Movie, 1)
\ No newline at end of file
@@ -11,6 +11,8 @@
 #include <fmt/chrono.h>
 #include <fmt/format.h>
 #include "common/file_util.h"
+#include "common/logging/log.h"
+#include "core/core.h"
 #include "core/hw/gpu.h"
 #include "core/perf_stats.h"
 #include "core/settings.h"
@@ -26,6 +28,66 @@ constexpr std::size_t IgnoreFrames = 5;
 
 namespace Core {
 
+namespace {
+
+constexpr std::size_t NumPerfCategories = static_cast<std::size_t>(PerfCategory::NumCategories);
+
+/// Keys of the categories in the frame breakdown file
+constexpr std::array<const char*, NumPerfCategories> PerfCategoryKeys{
+    "cpu_us",   "hle_us",     "gpu_us",  "rasterizer_us",
+    "audio_us", "present_us", "idle_us", "limiter_us",
+};
+
+constexpr std::size_t NumPerfCounters = static_cast<std::size_t>(PerfCounter::NumCounters);
+
+/// Keys of the counters in the frame breakdown file
+constexpr std::array<const char*, NumPerfCounters> PerfCounterKeys{
+    "pica_draws",
+    "host_draws",
+};
+
+thread_local PerfTimer* current_perf_timer = nullptr;
+
+/// Returns the stats of the instance bound to the calling thread, if they write a breakdown
+PerfStats* GetBreakdownStats() {
+    PerfStats* stats = System::GetInstance().perf_stats.get();
+    return stats && stats->IsBreakdownEnabled() ? stats : nullptr;
+}
+
+u64 ToMicroseconds(std::chrono::nanoseconds time) {
+    return static_cast<u64>(std::max<s64>(duration_cast<microseconds>(time).count(), 0));
+}
+
+} // Anonymous namespace
+
+void AddPerfCounter(PerfCounter counter, u64 value) {
+    if (PerfStats* stats = GetBreakdownStats()) {
+        stats->AddCounter(counter, value);
+    }
+}
+
+PerfTimer::PerfTimer(PerfCategory category) : category(category), stats(GetBreakdownStats()) {
+    if (!stats) {
+        return;
+    }
+    parent = current_perf_timer;
+    current_perf_timer = this;
+    start = Clock::now();
+}
+
+PerfTimer::~PerfTimer() {
+    if (!stats) {
+        return;
+    }
+    const auto elapsed = Clock::now() - start;
+    stats->AddCategoryTime(category,
+                           std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed - nested));
+    if (parent) {
+        parent->nested += elapsed;
+    }
+    current_perf_timer = parent;
+}
+
 PerfStats::PerfStats(u64 title_id) : title_id(title_id) {}
 
 PerfStats::~PerfStats() {
@@ -49,6 +111,9 @@ void PerfStats::BeginSystemFrame() {
     std::lock_guard lock{object_mutex};
 
     frame_begin = Clock::now();
+    if (breakdown_frame_ended) {
+        WriteFrameBreakdown(frame_begin);
+    }
 }
 
 void PerfStats::EndSystemFrame() {
@@ -62,6 +127,9 @@ void PerfStats::EndSystemFrame() {
     }
     accumulated_frametime += frame_time;
     system_frames += 1;
+    total_system_frames += 1;
+    last_frame_time = frame_time;
+    breakdown_frame_ended = breakdown_file.IsOpen();
 
     previous_frame_length = frame_end - previous_frame_end;
     previous_frame_end = frame_end;
@@ -118,6 +186,77 @@ double PerfStats::GetLastFrameTimeScale() const {
     return duration_cast<DoubleSecs>(previous_frame_length).count() / FRAME_LENGTH;
 }
 
+void PerfStats::StartFrameBreakdown(const std::string& path, u64 max_file_size) {
+    std::lock_guard lock{object_mutex};
+
+    breakdown_path = path;
+    breakdown_max_file_size = max_file_size;
+    breakdown_file = FileUtil::IOFile(path, "w");
+    if (!breakdown_file.IsOpen()) {
+        LOG_ERROR(Core, "Could not open the frame breakdown file {}", path);
+        return;
+    }
+    for (auto& time : category_time_ns) {
+        time = 0;
+    }
+    for (auto& value : counter_values) {
+        value = 0;
+    }
+    last_breakdown_point = Clock::now();
+    breakdown_enabled = true;
+    LOG_INFO(Core, "Writing the frame breakdown to {}", path);
+}
+
+void PerfStats::WriteFrameBreakdown(Clock::time_point now) {
+    breakdown_frame_ended = false;
+    fmt::memory_buffer line;
+    fmt::format_to(line, "frame={} interval_us={} frametime_us={}", breakdown_frames++,
+                   ToMicroseconds(now - last_breakdown_point), ToMicroseconds(last_frame_time));
+    for (std::size_t i = 0; i < NumPerfCategories; ++i) {
+        const u64 time_ns = category_time_ns[i].exchange(0, std::memory_order_relaxed);
+        fmt::format_to(line, " {}={}", PerfCategoryKeys[i], time_ns / 1000);
+    }
+    for (std::size_t i = 0; i < NumPerfCounters; ++i) {
+        const u64 value = counter_values[i].exchange(0, std::memory_order_relaxed);
+        fmt::format_to(line, " {}={}", PerfCounterKeys[i], value);
+    }
+    line.push_back('\n');
+    last_breakdown_point = now;
+
+    breakdown_file.WriteBytes(line.data(), line.size());
+    if (breakdown_file.Tell() < breakdown_max_file_size) {
+        return;
+    }
+    // Keep the previous file around, so that the latest frames are always available
+    breakdown_file.Close();
+    const std::string rolled_path = breakdown_path + ".1";
+    FileUtil::Delete(rolled_path);
+    FileUtil::Rename(breakdown_path, rolled_path);
+    breakdown_file = FileUtil::IOFile(breakdown_path, "w");
+}
+
+void PerfStats::AddCategoryTime(PerfCategory category, std::chrono::nanoseconds time) {
+    category_time_ns[static_cast<std::size_t>(category)].fetch_add(
+        static_cast<u64>(std::max<s64>(time.count(), 0)), std::memory_order_relaxed);
+}
+
+void PerfStats::AddCounter(PerfCounter counter, u64 value) {
+    counter_values[static_cast<std::size_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+}
+
+u64 PerfStats::GetTotalSystemFrames() const {
+    std::lock_guard lock{object_mutex};
+
+    return total_system_frames;
+}
+
+double PerfStats::GetOverallSystemFps() const {
+    std::lock_guard lock{object_mutex};
+
+    const auto interval = duration_cast<DoubleSecs>(Clock::now() - creation_point).count();
+    return interval > 0 ? static_cast<double>(total_system_frames) / interval : 0.0;
+}
+
 void FrameLimiter::WaitOnce() {
     if (frame_advancing_enabled) {
         // Frame advancing is enabled: wait on event instead of doing framelimiting
@@ -127,6 +266,7 @@ void FrameLimiter::WaitOnce() {
 }
 
 void FrameLimiter::DoFrameLimiting(microseconds current_system_time_us) {
+    PerfTimer perf_timer{PerfCategory::FrameLimiter};
     if (frame_advancing_enabled) {
         // Frame advancing is enabled: wait on event instead of doing framelimiting
         frame_advance_event.Wait();
@@ -134,6 +274,10 @@ void FrameLimiter::DoFrameLimiting(microseconds current_system_time_us) {
         return;
     }
 
+    if (fast_forwarding || Settings::values.max_throughput) {
+        return;
+    }
+
     auto now = Clock::now();
     double sleep_scale = Settings::values.frame_limit / 100.0;
 
@@ -177,6 +321,10 @@ void FrameLimiter::SetFrameAdvancing(bool value) {
     }
 }
 
+void FrameLimiter::SetFastForwarding(bool value) {
+    fast_forwarding = value;
+}
+
 void FrameLimiter::AdvanceFrame() {
     frame_advance_event.Set();
 }
@@ -9,11 +9,63 @@
 #include <chrono>
 #include <cstddef>
 #include <mutex>
+#include <string>
 #include "common/common_types.h"
+#include "common/file_util.h"
 #include "common/thread.h"
 
 namespace Core {
 
+/// Subsystems whose host time is broken down per system frame
+enum class PerfCategory : std::size_t {
+    Cpu,          ///< Guest code on the CPU cores, minus the HLE services it calls
+    HleServices,  ///< HLE service request handlers
+    GpuCommands,  ///< PICA command lists, memory fills and display transfers
+    Rasterizer,   ///< Draw calls
+    Audio,        ///< DSP emulation
+    Present,      ///< Drawing frames for the window and the video dumper
+    Idle,         ///< Emulation loop slices in which no guest code runs
+    FrameLimiter, ///< Waiting for the frame limiter
+    NumCategories,
+};
+
+/// Events counted per system frame in the frame breakdown
+enum class PerfCounter : std::size_t {
+    PicaDraws, ///< Draws submitted by the PICA command lists
+    HostDraws, ///< Batches drawn by the hardware renderer, after merging consecutive PICA draws
+    NumCounters,
+};
+
+class PerfStats;
+
+/**
+ * Adds to a counter of the frame breakdown, while the PerfStats of the instance bound to the
+ * calling thread writes one
+ */
+void AddPerfCounter(PerfCounter counter, u64 value = 1);
+
+/**
+ * Adds the host time until it goes out of scope to a category of the frame breakdown, while the
+ * PerfStats of the instance bound to the calling thread writes one. A timer nested in another one
+ * on the same thread takes its time out of the outer one, so that each category only counts its
+ * own work.
+ */
+class PerfTimer : NonCopyable {
+public:
+    explicit PerfTimer(PerfCategory category);
+    ~PerfTimer();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    PerfCategory category;
+    /// Stats to add the time to, or nullptr when no breakdown is written
+    PerfStats* stats;
+    PerfTimer* parent = nullptr;
+    Clock::time_point start;
+    Clock::duration nested = Clock::duration::zero();
+};
+
 /**
  * Class to manage and query performance/timing statistics. All public functions of this class are
  * thread-safe unless stated otherwise.
@@ -53,6 +105,36 @@ public:
      */
     double GetLastFrameTimeScale() const;
 
+    /// Default size past which the frame breakdown file is rolled over
+    static constexpr u64 MaxBreakdownFileSize = 64 * 1024 * 1024;
+
+    /**
+     * Starts writing the host time of each system frame, broken down by PerfCategory, and the
+     * PerfCounter values to a text file. Each frame is one line of space-separated key=value
+     * pairs. The file is moved to "<path>.1" once it grows past max_file_size.
+     */
+    void StartFrameBreakdown(const std::string& path, u64 max_file_size = MaxBreakdownFileSize);
+
+    /// Returns whether the frame breakdown is being written
+    bool IsBreakdownEnabled() const {
+        return breakdown_enabled.load(std::memory_order_relaxed);
+    }
+
+    /// Adds host time to a category of the frame breakdown
+    void AddCategoryTime(PerfCategory category, std::chrono::nanoseconds time);
+
+    /// Adds to a counter of the frame breakdown
+    void AddCounter(PerfCounter counter, u64 value);
+
+    /// Returns the number of system frames since the stats were created
+    u64 GetTotalSystemFrames() const;
+
+    /**
+     * Returns the number of system frames per walltime second since the stats were created. When
+     * running unthrottled, this is the throughput of the emulator.
+     */
+    double GetOverallSystemFps() const;
+
 private:
     mutable std::mutex object_mutex;
 
@@ -76,12 +158,39 @@ private:
     /// Cumulative number of game frames (GSP frame submissions) since last reset
     u32 game_frames = 0;
 
+    /// Point when the stats were created
+    const Clock::time_point creation_point = reset_point;
+    /// Number of system frames since the stats were created
+    u64 total_system_frames = 0;
+
     /// Point when the previous system frame ended
     Clock::time_point previous_frame_end = reset_point;
     /// Point when the current system frame began
     Clock::time_point frame_begin = reset_point;
     /// Total visible duration (including frame-limiting, etc.) of the previous system frame
     Clock::duration previous_frame_length = Clock::duration::zero();
+
+    /// Writes the breakdown of the frame that just ended, including the wait that followed it
+    void WriteFrameBreakdown(Clock::time_point now);
+
+    std::string breakdown_path;
+    u64 breakdown_max_file_size = MaxBreakdownFileSize;
+    FileUtil::IOFile breakdown_file;
+    std::atomic_bool breakdown_enabled{false};
+    /// Host time of each category since the last breakdown line, in nanoseconds
+    std::array<std::atomic<u64>, static_cast<std::size_t>(PerfCategory::NumCategories)>
+        category_time_ns{};
+    /// Value of each counter since the last breakdown line
+    std::array<std::atomic<u64>, static_cast<std::size_t>(PerfCounter::NumCounters)>
+        counter_values{};
+    /// Number of system frames since the breakdown started
+    u64 breakdown_frames = 0;
+    /// Whether a system frame ended since the last breakdown line
+    bool breakdown_frame_ended = false;
+    /// Duration of the last system frame, excluding waits
+    Clock::duration last_frame_time = Clock::duration::zero();
+    /// Point when the last breakdown line was written
+    Clock::time_point last_breakdown_point = reset_point;
 };
 
 class FrameLimiter {
@@ -99,6 +208,9 @@ public:
     void AdvanceFrame();
     void WaitOnce();
 
+    /// Sets whether to run as fast as possible, e.g. while a movie seeks to a frame
+    void SetFastForwarding(bool value);
+
 private:
     /// Emulated system time (in microseconds) at the last limiter invocation
     std::chrono::microseconds previous_system_time_us{0};
@@ -113,6 +225,9 @@ private:
 
     /// Event to advance the frame when frame advancing is enabled
     Common::Event frame_advance_event;
+
+    /// Whether frame limiting is suspended
+    std::atomic_bool fast_forwarding{false};
 };
 
 } // namespace Core
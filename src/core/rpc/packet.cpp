@@ -5,11 +5,14 @@
 
 namespace RPC {
 
-Packet::Packet(const PacketHeader& header, u8* data,
-               std::function<void(Packet&)> send_reply_callback)
-    : header(header), send_reply_callback(std::move(send_reply_callback)) {
+Packet::Packet(const PacketHeader& header, const u8* data, u32 max_data_size,
+               std::function<void(Packet&)> send_reply_callback, Client client)
+    : header(header), max_data_size(max_data_size),
+      send_reply_callback(std::move(send_reply_callback)), client(std::move(client)) {
 
-    std::memcpy(packet_data.data(), data, std::min(header.packet_size, MAX_PACKET_DATA_SIZE));
+    const u32 size = std::min(header.packet_size, max_data_size);
+    packet_data.resize(std::max(size, MAX_PACKET_DATA_SIZE));
+    std::memcpy(packet_data.data(), data, size);
 }
 
 }; // namespace RPC
@@ -4,8 +4,9 @@
 
 #pragma once
 
-#include <array>
 #include <functional>
+#include <string>
+#include <vector>
 #include "common/common_types.h"
 
 namespace RPC {
@@ -14,6 +15,10 @@ enum class PacketType {
     Undefined = 0,
     ReadMemory,
     WriteMemory,
+    // Version 2
+    ReadMemoryBulk,
+    WatchMemory,
+    WatchUpdate,
 };
 
 struct PacketHeader {
@@ -23,15 +28,47 @@ struct PacketHeader {
     u32 packet_size;
 };
 
-constexpr u32 CURRENT_VERSION = 1;
+/// A range of guest memory, as found in the data of ReadMemoryBulk and WatchMemory packets
+struct MemoryRange {
+    u32 address;
+    u32 size;
+};
+
+constexpr u32 CURRENT_VERSION = 2;
+constexpr u16 SERVER_PORT = 45987;
 constexpr u32 MIN_PACKET_SIZE = sizeof(PacketHeader);
+/// Maximum data size of version 1 packets
 constexpr u32 MAX_PACKET_DATA_SIZE = 32;
 constexpr u32 MAX_PACKET_SIZE = MIN_PACKET_SIZE + MAX_PACKET_DATA_SIZE;
 constexpr u32 MAX_READ_SIZE = MAX_PACKET_DATA_SIZE;
+/// Maximum data size of version 2 packets sent over UDP, fitting in a single datagram
+constexpr u32 MAX_DATAGRAM_DATA_SIZE = 0x8000;
+constexpr u32 MAX_DATAGRAM_SIZE = MIN_PACKET_SIZE + MAX_DATAGRAM_DATA_SIZE;
+/// Maximum data size of packets sent over TCP
+constexpr u32 MAX_STREAM_DATA_SIZE = 0x100000;
+
+/// Where a request came from. Request IDs are picked by the clients, so they are only unique per
+/// client.
+struct Client {
+    /// Transport and address of the client, e.g. "udp:127.0.0.1:50000"
+    std::string name;
+    /// Returns whether the client is still connected. Empty for connectionless clients, which are
+    /// never known to be gone. May be called from any thread.
+    std::function<bool()> is_connected;
+};
 
 class Packet {
 public:
-    Packet(const PacketHeader& header, u8* data, std::function<void(Packet&)> send_reply_callback);
+    /**
+     * @param header Header of the request
+     * @param data Data of the request, of header.packet_size bytes
+     * @param max_data_size Maximum data size of a reply on the transport the request came from
+     * @param send_reply_callback Sends the packet back to where the request came from. It may be
+     * called any number of times, and from any thread.
+     * @param client The client that sent the request
+     */
+    Packet(const PacketHeader& header, const u8* data, u32 max_data_size,
+           std::function<void(Packet&)> send_reply_callback, Client client);
 
     u32 GetVersion() const {
         return header.version;
@@ -53,12 +90,28 @@ public:
         return header;
     }
 
-    std::array<u8, MAX_PACKET_DATA_SIZE>& GetPacketData() {
+    u32 GetMaxPacketDataSize() const {
+        return max_data_size;
+    }
+
+    const Client& GetClient() const {
+        return client;
+    }
+
+    /// Data of the packet. Holds at least MAX_PACKET_DATA_SIZE bytes.
+    std::vector<u8>& GetPacketData() {
         return packet_data;
     }
 
+    void SetPacketType(PacketType type) {
+        header.packet_type = type;
+    }
+
     void SetPacketDataSize(u32 size) {
         header.packet_size = size;
+        if (packet_data.size() < size) {
+            packet_data.resize(size);
+        }
     }
 
     void SendReply() {
@@ -66,13 +119,12 @@ public:
     }
 
 private:
-    void HandleReadMemory(u32 address, u32 data_size);
-    void HandleWriteMemory(u32 address, const u8* data, u32 data_size);
-
     struct PacketHeader header;
-    std::array<u8, MAX_PACKET_DATA_SIZE> packet_data;
+    std::vector<u8> packet_data;
+    u32 max_data_size;
 
     std::function<void(Packet&)> send_reply_callback;
+    Client client;
 };
 
 } // namespace RPC
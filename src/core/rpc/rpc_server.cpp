@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cstring>
 #include "common/logging/log.h"
 #include "core/arm/arm_interface.h"
 #include "core/core.h"
@@ -8,7 +10,18 @@
 
 namespace RPC {
 
-RPCServer::RPCServer() : server(*this) {
+/// Watch lists set up beyond this many are refused
+constexpr std::size_t MAX_WATCH_SUBSCRIPTIONS = 32;
+/// Watch lists of connectionless clients are dropped unless they are set up again within this
+constexpr auto WATCH_TIMEOUT = std::chrono::seconds(30);
+
+static std::vector<MemoryRange> ParseRanges(Packet& packet) {
+    std::vector<MemoryRange> ranges(packet.GetPacketDataSize() / sizeof(MemoryRange));
+    std::memcpy(ranges.data(), packet.GetPacketData().data(), ranges.size() * sizeof(MemoryRange));
+    return ranges;
+}
+
+RPCServer::RPCServer(Core::System& system) : system(system), server(*this) {
     LOG_INFO(RPC_Server, "Starting RPC server ...");
 
     Start();
@@ -25,15 +38,10 @@ RPCServer::~RPCServer() {
 }
 
 void RPCServer::HandleReadMemory(Packet& packet, u32 address, u32 data_size) {
-    if (data_size > MAX_READ_SIZE) {
-        return;
-    }
-
-    // Note: Memory read occurs asynchronously from the state of the emulator
-    Core::System::GetInstance().Memory().ReadBlock(
-        *Core::System::GetInstance().Kernel().GetCurrentProcess(), address,
-        packet.GetPacketData().data(), data_size);
     packet.SetPacketDataSize(data_size);
+    // Note: Memory read occurs asynchronously from the state of the emulator
+    system.Memory().ReadBlock(*system.Kernel().GetCurrentProcess(), address,
+                              packet.GetPacketData().data(), data_size);
     packet.SendReply();
 }
 
@@ -43,58 +51,227 @@ void RPCServer::HandleWriteMemory(Packet& packet, u32 address, const u8* data, u
         (address >= Memory::HEAP_VADDR && address <= Memory::HEAP_VADDR_END) ||
         (address >= Memory::N3DS_EXTRA_RAM_VADDR && address <= Memory::N3DS_EXTRA_RAM_VADDR_END)) {
         // Note: Memory write occurs asynchronously from the state of the emulator
-        Core::System::GetInstance().Memory().WriteBlock(
-            *Core::System::GetInstance().Kernel().GetCurrentProcess(), address, data, data_size);
+        system.Memory().WriteBlock(*system.Kernel().GetCurrentProcess(), address, data, data_size);
         // If the memory happens to be executable code, make sure the changes become visible
 
         // Is current core correct here?
-        Core::System::GetInstance().InvalidateCacheRange(address, data_size);
+        system.InvalidateCacheRange(address, data_size);
     }
     packet.SetPacketDataSize(0);
     packet.SendReply();
 }
 
-bool RPCServer::ValidatePacket(const PacketHeader& packet_header) {
-    if (packet_header.version <= CURRENT_VERSION) {
-        switch (packet_header.packet_type) {
-        case PacketType::ReadMemory:
-        case PacketType::WriteMemory:
-            if (packet_header.packet_size >= (sizeof(u32) * 2)) {
-                return true;
+void RPCServer::HandleReadMemoryBulk(Packet& packet, const std::vector<MemoryRange>& ranges) {
+    u32 data_size = 0;
+    for (const auto& range : ranges) {
+        data_size += range.size;
+    }
+    packet.SetPacketDataSize(data_size);
+
+    // Note: Memory read occurs asynchronously from the state of the emulator
+    const auto process = system.Kernel().GetCurrentProcess();
+    u8* data = packet.GetPacketData().data();
+    for (const auto& range : ranges) {
+        system.Memory().ReadBlock(*process, range.address, data, range.size);
+        data += range.size;
+    }
+    packet.SendReply();
+}
+
+void RPCServer::HandleWatchMemory(std::unique_ptr<Packet> packet,
+                                  std::vector<MemoryRange> ranges) {
+    std::lock_guard lock(watch_mutex);
+    RemoveStaleSubscriptions();
+    const WatchKey key{packet->GetClient().name, packet->GetId()};
+    if (ranges.empty()) {
+        watch_subscriptions.erase(key);
+    } else if (watch_subscriptions.size() >= MAX_WATCH_SUBSCRIPTIONS &&
+               watch_subscriptions.count(key) == 0) {
+        LOG_WARNING(RPC_Server, "Too many watch lists, refusing id={} of {}", key.second,
+                    key.first);
+        packet->SetPacketDataSize(0);
+        packet->SendReply();
+        return;
+    }
+
+    // Acknowledge with the number of ranges now watched
+    const auto num_ranges = static_cast<u32>(ranges.size());
+    packet->SetPacketDataSize(sizeof(num_ranges));
+    std::memcpy(packet->GetPacketData().data(), &num_ranges, sizeof(num_ranges));
+    packet->SendReply();
+
+    if (!ranges.empty()) {
+        WatchSubscription& subscription = watch_subscriptions[key];
+        subscription.packet = std::move(packet);
+        subscription.packet->SetPacketType(PacketType::WatchUpdate);
+        subscription.expiry = std::chrono::steady_clock::now() + WATCH_TIMEOUT;
+
+        // Renewing a watch list with the same ranges only sends what changed since the last update
+        const bool same_ranges = std::equal(
+            ranges.begin(), ranges.end(), subscription.ranges.begin(), subscription.ranges.end(),
+            [](const MemoryRange& a, const MemoryRange& b) {
+                return a.address == b.address && a.size == b.size;
+            });
+        if (!same_ranges) {
+            subscription.ranges = std::move(ranges);
+            subscription.sent_once = false;
+        }
+    }
+}
+
+void RPCServer::RemoveStaleSubscriptions() {
+    const auto now = std::chrono::steady_clock::now();
+    for (auto it = watch_subscriptions.begin(); it != watch_subscriptions.end();) {
+        const Client& client = it->second.packet->GetClient();
+        const bool stale = client.is_connected ? !client.is_connected() : now >= it->second.expiry;
+        if (stale) {
+            LOG_DEBUG(RPC_Server, "Dropping watch list id={} of {}", it->first.second,
+                      it->first.first);
+            it = watch_subscriptions.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void RPCServer::HandleFrame() {
+    frame_count++;
+
+    std::lock_guard lock(watch_mutex);
+    RemoveStaleSubscriptions();
+    if (watch_subscriptions.empty()) {
+        return;
+    }
+    const auto process = system.Kernel().GetCurrentProcess();
+    if (!process) {
+        return;
+    }
+
+    // Updates hold the frame count, then the index and contents of each range that changed
+    std::vector<u8> contents;
+    for (auto& [key, subscription] : watch_subscriptions) {
+        std::size_t update_size = sizeof(u32);
+        std::size_t contents_size = 0;
+        for (const auto& range : subscription.ranges) {
+            update_size += sizeof(u32) + range.size;
+            contents_size += range.size;
+        }
+        contents.resize(contents_size);
+        std::size_t offset = 0;
+        for (const auto& range : subscription.ranges) {
+            system.Memory().ReadBlock(*process, range.address, contents.data() + offset,
+                                      range.size);
+            offset += range.size;
+        }
+
+        Packet& packet = *subscription.packet;
+        packet.SetPacketDataSize(static_cast<u32>(update_size));
+        u8* data = packet.GetPacketData().data();
+        std::memcpy(data, &frame_count, sizeof(frame_count));
+        std::size_t data_size = sizeof(frame_count);
+        offset = 0;
+        for (u32 i = 0; i < subscription.ranges.size(); ++i) {
+            const u32 size = subscription.ranges[i].size;
+            if (!subscription.sent_once || std::memcmp(contents.data() + offset,
+                                                       subscription.last_contents.data() + offset,
+                                                       size) != 0) {
+                std::memcpy(data + data_size, &i, sizeof(i));
+                std::memcpy(data + data_size + sizeof(i), contents.data() + offset, size);
+                data_size += sizeof(i) + size;
             }
-            break;
-        default:
-            break;
+            offset += size;
+        }
+
+        if (data_size > sizeof(frame_count)) {
+            packet.SetPacketDataSize(static_cast<u32>(data_size));
+            packet.SendReply();
         }
+        subscription.last_contents.swap(contents);
+        subscription.sent_once = true;
+    }
+}
+
+bool RPCServer::ValidatePacket(const PacketHeader& packet_header) {
+    if (packet_header.version > CURRENT_VERSION) {
+        return false;
+    }
+    if (packet_header.version < 2 && packet_header.packet_size > MAX_PACKET_DATA_SIZE) {
+        return false;
+    }
+    switch (packet_header.packet_type) {
+    case PacketType::ReadMemory:
+    case PacketType::WriteMemory:
+        return packet_header.packet_size >= (sizeof(u32) * 2);
+    case PacketType::ReadMemoryBulk:
+        return packet_header.version >= 2 && packet_header.packet_size > 0 &&
+               packet_header.packet_size % sizeof(MemoryRange) == 0;
+    case PacketType::WatchMemory:
+        return packet_header.version >= 2 &&
+               packet_header.packet_size % sizeof(MemoryRange) == 0;
+    default:
+        return false;
     }
-    return false;
 }
 
 void RPCServer::HandleSingleRequest(std::unique_ptr<Packet> request_packet) {
     bool success = false;
 
     if (ValidatePacket(request_packet->GetHeader())) {
-        // Currently, all request types use the address/data_size wire format
-        u32 address = 0;
-        u32 data_size = 0;
-        std::memcpy(&address, request_packet->GetPacketData().data(), sizeof(address));
-        std::memcpy(&data_size, request_packet->GetPacketData().data() + sizeof(address),
-                    sizeof(data_size));
+        // Version 1 clients only have room for replies as large as their requests could be
+        const u32 max_read_size = request_packet->GetVersion() >= 2
+                                      ? request_packet->GetMaxPacketDataSize()
+                                      : MAX_READ_SIZE;
 
         switch (request_packet->GetPacketType()) {
         case PacketType::ReadMemory:
-            if (data_size > 0 && data_size <= MAX_READ_SIZE) {
-                HandleReadMemory(*request_packet, address, data_size);
+        case PacketType::WriteMemory: {
+            u32 address = 0;
+            u32 data_size = 0;
+            std::memcpy(&address, request_packet->GetPacketData().data(), sizeof(address));
+            std::memcpy(&data_size, request_packet->GetPacketData().data() + sizeof(address),
+                        sizeof(data_size));
+
+            if (request_packet->GetPacketType() == PacketType::ReadMemory) {
+                if (data_size > 0 && data_size <= max_read_size) {
+                    HandleReadMemory(*request_packet, address, data_size);
+                    success = true;
+                }
+            } else if (data_size > 0 &&
+                       data_size <= request_packet->GetPacketDataSize() - (sizeof(u32) * 2)) {
+                const u8* data = request_packet->GetPacketData().data() + (sizeof(u32) * 2);
+                HandleWriteMemory(*request_packet, address, data, data_size);
                 success = true;
             }
             break;
-        case PacketType::WriteMemory:
-            if (data_size > 0 && data_size <= MAX_PACKET_DATA_SIZE - (sizeof(u32) * 2)) {
-                const u8* data = request_packet->GetPacketData().data() + (sizeof(u32) * 2);
-                HandleWriteMemory(*request_packet, address, data, data_size);
+        }
+        case PacketType::ReadMemoryBulk: {
+            const auto ranges = ParseRanges(*request_packet);
+            u64 data_size = 0;
+            bool valid = true;
+            for (const auto& range : ranges) {
+                data_size += range.size;
+                valid = valid && range.size > 0;
+            }
+            if (valid && data_size <= max_read_size) {
+                HandleReadMemoryBulk(*request_packet, ranges);
+                success = true;
+            }
+            break;
+        }
+        case PacketType::WatchMemory: {
+            auto ranges = ParseRanges(*request_packet);
+            u64 update_size = sizeof(u32);
+            bool valid = true;
+            for (const auto& range : ranges) {
+                update_size += sizeof(u32) + range.size;
+                valid = valid && range.size > 0;
+            }
+            if (valid && update_size <= max_read_size) {
+                HandleWatchMemory(std::move(request_packet), std::move(ranges));
                 success = true;
             }
             break;
+        }
         default:
             break;
         }
@@ -4,37 +4,74 @@
 
 #pragma once
 
+#include <chrono>
 #include <condition_variable>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <thread>
+#include <utility>
+#include <vector>
 #include "common/threadsafe_queue.h"
+#include "core/rpc/packet.h"
 #include "core/rpc/server.h"
 
-namespace RPC {
+namespace Core {
+class System;
+}
 
-class Packet;
-struct PacketHeader;
+namespace RPC {
 
 class RPCServer {
 public:
-    RPCServer();
+    explicit RPCServer(Core::System& system);
     ~RPCServer();
 
     void QueueRequest(std::unique_ptr<RPC::Packet> request);
 
+    /**
+     * Sends the watched ranges that changed since the previous frame to their subscribers.
+     * Called from the emulation thread at the end of each emulated frame.
+     */
+    void HandleFrame();
+
 private:
+    /// A watch list set up by a WatchMemory request, whose packet is reused for the updates
+    struct WatchSubscription {
+        std::unique_ptr<Packet> packet;
+        std::vector<MemoryRange> ranges;
+        /// Contents of the ranges as of the last update, one after the other
+        std::vector<u8> last_contents;
+        bool sent_once = false;
+        /// Connectionless clients have to renew the watch list before this
+        std::chrono::steady_clock::time_point expiry;
+    };
+
+    /// Name of the client and ID of the request that set up a watch list
+    using WatchKey = std::pair<std::string, u32>;
+
     void Start();
     void Stop();
     void HandleReadMemory(Packet& packet, u32 address, u32 data_size);
     void HandleWriteMemory(Packet& packet, u32 address, const u8* data, u32 data_size);
+    void HandleReadMemoryBulk(Packet& packet, const std::vector<MemoryRange>& ranges);
+    void HandleWatchMemory(std::unique_ptr<Packet> packet, std::vector<MemoryRange> ranges);
+    /// Drops the watch lists of disconnected clients, and those that were not renewed in time
+    void RemoveStaleSubscriptions();
     bool ValidatePacket(const PacketHeader& packet_header);
     void HandleSingleRequest(std::unique_ptr<Packet> request);
     void HandleRequestsLoop();
 
+    Core::System& system;
     Server server;
-    Common::SPSCQueue<std::unique_ptr<Packet>> request_queue;
+    /// Requests come from both the UDP and the TCP server threads
+    Common::MPSCQueue<std::unique_ptr<Packet>> request_queue;
     std::thread request_handler_thread;
+
+    std::mutex watch_mutex;
+    std::map<WatchKey, WatchSubscription> watch_subscriptions;
+    u32 frame_count = 0;
 };
 
 } // namespace RPC
@@ -0,0 +1,182 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+#include "common/common_types.h"
+#include "common/logging/log.h"
+#include "core/rpc/packet.h"
+#include "core/rpc/tcp_server.h"
+
+namespace RPC {
+
+namespace {
+
+using boost::asio::ip::tcp;
+
+/// Replies queued for a client beyond this are dropped, so that a stalled client cannot make the
+/// server buffer watch updates forever
+constexpr std::size_t MAX_PENDING_REPLY_BYTES = 64 * 1024 * 1024;
+
+class Session : public std::enable_shared_from_this<Session> {
+public:
+    Session(tcp::socket socket_, std::function<void(std::unique_ptr<Packet>)> new_request_callback_)
+        : socket(std::move(socket_)), new_request_callback(std::move(new_request_callback_)) {}
+
+    void Start() {
+        boost::system::error_code error;
+        socket.set_option(tcp::no_delay(true), error);
+        const auto endpoint = socket.remote_endpoint(error);
+        name = fmt::format("tcp:{}:{}", endpoint.address().to_string(), endpoint.port());
+        ReadHeader();
+    }
+
+    /// Queues a reply to be sent. Can be called from any thread.
+    void SendReply(Packet& reply_packet) {
+        std::vector<u8> reply_buffer(MIN_PACKET_SIZE + reply_packet.GetPacketDataSize());
+        const auto reply_header = reply_packet.GetHeader();
+        std::memcpy(reply_buffer.data(), &reply_header, sizeof(reply_header));
+        std::memcpy(reply_buffer.data() + MIN_PACKET_SIZE, reply_packet.GetPacketData().data(),
+                    reply_packet.GetPacketDataSize());
+
+        boost::asio::post(socket.get_executor(),
+                          [this, self = shared_from_this(),
+                           reply_buffer = std::move(reply_buffer)]() mutable {
+                              QueueWrite(std::move(reply_buffer));
+                          });
+    }
+
+private:
+    void ReadHeader() {
+        boost::asio::async_read(
+            socket, boost::asio::buffer(&header, sizeof(header)),
+            [this, self = shared_from_this()](const boost::system::error_code& error,
+                                              std::size_t) {
+                if (error) {
+                    // The client closed the connection
+                    return;
+                }
+                if (header.packet_size > MAX_STREAM_DATA_SIZE) {
+                    LOG_WARNING(RPC_Server, "Received message with wrong size: {}",
+                                header.packet_size);
+                    socket.close();
+                    return;
+                }
+                ReadData();
+            });
+    }
+
+    void ReadData() {
+        request_data.resize(header.packet_size);
+        boost::asio::async_read(
+            socket, boost::asio::buffer(request_data),
+            [this, self = shared_from_this()](const boost::system::error_code& error,
+                                              std::size_t) {
+                if (error) {
+                    return;
+                }
+                std::weak_ptr<Session> weak_self = self;
+                std::function<void(Packet&)> send_reply_callback = [weak_self](Packet& reply) {
+                    if (auto session = weak_self.lock()) {
+                        session->SendReply(reply);
+                    }
+                };
+                // The session goes away once the connection is closed
+                Client client{name, [weak_self] { return !weak_self.expired(); }};
+                new_request_callback(std::make_unique<Packet>(
+                    header, request_data.data(), MAX_STREAM_DATA_SIZE, send_reply_callback,
+                    std::move(client)));
+                ReadHeader();
+            });
+    }
+
+    void QueueWrite(std::vector<u8> reply_buffer) {
+        if (pending_bytes + reply_buffer.size() > MAX_PENDING_REPLY_BYTES) {
+            LOG_WARNING(RPC_Server, "Client is not keeping up, dropping a reply");
+            return;
+        }
+        pending_bytes += reply_buffer.size();
+        write_queue.push_back(std::move(reply_buffer));
+        if (write_queue.size() == 1) {
+            WriteFront();
+        }
+    }
+
+    void WriteFront() {
+        boost::asio::async_write(
+            socket, boost::asio::buffer(write_queue.front()),
+            [this, self = shared_from_this()](const boost::system::error_code& error,
+                                              std::size_t) {
+                pending_bytes -= write_queue.front().size();
+                write_queue.pop_front();
+                if (error) {
+                    LOG_WARNING(RPC_Server, "Failed to send reply: {}", error.message());
+                    write_queue.clear();
+                    pending_bytes = 0;
+                    socket.close();
+                    return;
+                }
+                if (!write_queue.empty()) {
+                    WriteFront();
+                }
+            });
+    }
+
+    tcp::socket socket;
+    std::function<void(std::unique_ptr<Packet>)> new_request_callback;
+    std::string name;
+
+    PacketHeader header{};
+    std::vector<u8> request_data;
+
+    std::deque<std::vector<u8>> write_queue;
+    std::size_t pending_bytes = 0;
+};
+
+} // Anonymous namespace
+
+class TCPServer::Impl {
+public:
+    explicit Impl(std::function<void(std::unique_ptr<Packet>)> new_request_callback)
+        : acceptor(io_context, tcp::endpoint(tcp::v4(), SERVER_PORT)),
+          new_request_callback(std::move(new_request_callback)) {
+
+        StartAccept();
+        worker_thread = std::thread([this] { io_context.run(); });
+    }
+
+    ~Impl() {
+        io_context.stop();
+        worker_thread.join();
+    }
+
+private:
+    void StartAccept() {
+        acceptor.async_accept([this](const boost::system::error_code& error, tcp::socket socket) {
+            if (error) {
+                LOG_WARNING(RPC_Server, "Failed to accept TCP connection: {}", error.message());
+            } else {
+                std::make_shared<Session>(std::move(socket), new_request_callback)->Start();
+            }
+            StartAccept();
+        });
+    }
+
+    std::thread worker_thread;
+
+    boost::asio::io_context io_context;
+    tcp::acceptor acceptor;
+
+    std::function<void(std::unique_ptr<Packet>)> new_request_callback;
+};
+
+TCPServer::TCPServer(std::function<void(std::unique_ptr<Packet>)> new_request_callback)
+    : impl(std::make_unique<Impl>(new_request_callback)) {}
+
+TCPServer::~TCPServer() = default;
+
+} // namespace RPC
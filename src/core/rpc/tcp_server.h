@@ -0,0 +1,28 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <functional>
+#include <memory>
+
+namespace RPC {
+
+class Packet;
+
+/**
+ * Serves the RPC protocol over TCP, for transfers too large for a datagram. Packets have the same
+ * header as over UDP, and follow each other on the stream.
+ */
+class TCPServer {
+public:
+    explicit TCPServer(std::function<void(std::unique_ptr<Packet>)> new_request_callback);
+    ~TCPServer();
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> impl;
+};
+
+} // namespace RPC
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <mutex>
 #include <thread>
 #include <boost/asio.hpp>
 #include "common/common_types.h"
@@ -16,7 +17,8 @@ public:
     explicit Impl(std::function<void(std::unique_ptr<Packet>)> new_request_callback)
         // Use a random high port
         // TODO: Make configurable or increment port number on failure
-        : socket(io_context, boost::asio::ip::udp::endpoint(boost::asio::ip::udp::v4(), 45987)),
+        : socket(io_context,
+                 boost::asio::ip::udp::endpoint(boost::asio::ip::udp::v4(), SERVER_PORT)),
           new_request_callback(std::move(new_request_callback)) {
 
         StartReceive();
@@ -39,15 +41,22 @@ private:
     void HandleReceive(const boost::system::error_code& error, std::size_t size) {
         if (error) {
             LOG_WARNING(RPC_Server, "Failed to receive data on UDP socket: {}", error.message());
-        } else if (size >= MIN_PACKET_SIZE && size <= MAX_PACKET_SIZE) {
+        } else if (size >= MIN_PACKET_SIZE && size <= MAX_DATAGRAM_SIZE) {
             PacketHeader header;
             std::memcpy(&header, request_buffer.data(), sizeof(header));
-            if ((size - MIN_PACKET_SIZE) == header.packet_size) {
+            // Version 1 clients expect replies no larger than their requests could be
+            const u32 max_data_size =
+                header.version >= 2 ? MAX_DATAGRAM_DATA_SIZE : MAX_PACKET_DATA_SIZE;
+            if ((size - MIN_PACKET_SIZE) == header.packet_size &&
+                header.packet_size <= max_data_size) {
                 u8* data = request_buffer.data() + MIN_PACKET_SIZE;
                 std::function<void(Packet&)> send_reply_callback =
                     std::bind(&Impl::SendReply, this, remote_endpoint, std::placeholders::_1);
-                std::unique_ptr<Packet> new_packet =
-                    std::make_unique<Packet>(header, data, send_reply_callback);
+                Client client{fmt::format("udp:{}:{}", remote_endpoint.address().to_string(),
+                                          remote_endpoint.port()),
+                              nullptr};
+                std::unique_ptr<Packet> new_packet = std::make_unique<Packet>(
+                    header, data, max_data_size, send_reply_callback, std::move(client));
 
                 // Send the request to the upper layer for handling
                 new_request_callback(std::move(new_packet));
@@ -66,15 +75,19 @@ private:
         std::memcpy(reply_buffer.data() + (4 * sizeof(u32)), reply_packet.GetPacketData().data(),
                     reply_packet.GetPacketDataSize());
 
+        // Watch updates are sent from the emulation thread, other replies from the RPC thread
         boost::system::error_code error;
-        socket.send_to(boost::asio::buffer(reply_buffer), endpoint, 0, error);
+        {
+            std::lock_guard lock(send_mutex);
+            socket.send_to(boost::asio::buffer(reply_buffer), endpoint, 0, error);
+        }
 
         if (error) {
             LOG_WARNING(RPC_Server, "Failed to send reply: {}", error.message());
         } else {
-            LOG_INFO(RPC_Server, "Sent reply version({}) id=({}) type=({}) size=({})",
-                     reply_packet.GetVersion(), reply_packet.GetId(), reply_packet.GetPacketType(),
-                     reply_packet.GetPacketDataSize());
+            LOG_DEBUG(RPC_Server, "Sent reply version({}) id=({}) type=({}) size=({})",
+                      reply_packet.GetVersion(), reply_packet.GetId(), reply_packet.GetPacketType(),
+                      reply_packet.GetPacketDataSize());
         }
     }
 
@@ -82,7 +95,8 @@ private:
 
     boost::asio::io_context io_context;
     boost::asio::ip::udp::socket socket;
-    std::array<u8, MAX_PACKET_SIZE> request_buffer;
+    std::mutex send_mutex;
+    std::array<u8, MAX_DATAGRAM_SIZE> request_buffer;
     boost::asio::ip::udp::endpoint remote_endpoint;
 
     std::function<void(std::unique_ptr<Packet>)> new_request_callback;
@@ -88,15 +88,31 @@ std::vector<SaveStateInfo> ListSaveStates(u64 program_id) {
     return result;
 }
 
-void System::SaveState(u32 slot) const {
+std::vector<u8> System::SaveStateBuffer() const {
     std::ostringstream sstream{std::ios_base::binary};
     // Serialize
     oarchive oa{sstream};
     oa&* this;
 
     const std::string& str{sstream.str()};
-    auto buffer = Common::Compression::CompressDataZSTDDefault(
-        reinterpret_cast<const u8*>(str.data()), str.size());
+    return Common::Compression::CompressDataZSTDDefault(reinterpret_cast<const u8*>(str.data()),
+                                                        str.size());
+}
+
+void System::LoadStateBuffer(const std::vector<u8>& buffer) {
+    std::vector<u8> decompressed = Common::Compression::DecompressDataZSTD(buffer);
+    std::istringstream sstream{
+        std::string{reinterpret_cast<char*>(decompressed.data()), decompressed.size()},
+        std::ios_base::binary};
+    decompressed.clear();
+
+    // Deserialize
+    iarchive ia{sstream};
+    ia&* this;
+}
+
+void System::SaveState(u32 slot) const {
+    const auto buffer = SaveStateBuffer();
 
     const auto path = GetSaveStatePath(title_id, slot);
     if (!FileUtil::CreateFullPath(path)) {
@@ -132,25 +148,15 @@ void System::LoadState(u32 slot) {
 
     const auto path = GetSaveStatePath(title_id, slot);
 
-    std::vector<u8> decompressed;
+    std::vector<u8> buffer(FileUtil::GetSize(path) - sizeof(CSTHeader));
     {
-        std::vector<u8> buffer(FileUtil::GetSize(path) - sizeof(CSTHeader));
-
         FileUtil::IOFile file(path, "rb");
         file.Seek(sizeof(CSTHeader), SEEK_SET); // Skip header
         if (file.ReadBytes(buffer.data(), buffer.size()) != buffer.size()) {
             throw std::runtime_error("Could not read from file at " + path);
         }
-        decompressed = Common::Compression::DecompressDataZSTD(buffer);
     }
-    std::istringstream sstream{
-        std::string{reinterpret_cast<char*>(decompressed.data()), decompressed.size()},
-        std::ios_base::binary};
-    decompressed.clear();
-
-    // Deserialize
-    iarchive ia{sstream};
-    ia&* this;
+    LoadStateBuffer(buffer);
 }
 
 } // namespace Core
@@ -33,8 +33,8 @@ void Apply() {
     VideoCore::g_hw_shader_accurate_mul = values.shaders_accurate_mul;
     VideoCore::g_use_disk_shader_cache = values.use_disk_shader_cache;
 
-    if (VideoCore::g_renderer) {
-        VideoCore::g_renderer->UpdateCurrentFramebufferLayout();
+    if (auto* renderer = VideoCore::GetRenderer()) {
+        renderer->UpdateCurrentFramebufferLayout();
     }
 
     VideoCore::g_renderer_bg_color_update_requested = true;
@@ -45,8 +45,8 @@ void Apply() {
     auto& system = Core::System::GetInstance();
     if (system.IsPoweredOn()) {
         system.CoreTiming().UpdateClockSpeed(values.cpu_clock_percentage);
-        Core::DSP().SetSink(values.sink_id, values.audio_device_id);
-        Core::DSP().EnableStretching(values.enable_audio_stretching);
+        Core::DSP().SetSink(GetAudioSinkID(), values.audio_device_id);
+        Core::DSP().EnableStretching(values.enable_audio_stretching && !values.max_throughput);
 
         auto hid = Service::HID::GetModule(system);
         if (hid) {
@@ -78,16 +78,22 @@ void LogSettings() {
     LOG_INFO(Config, "Citra Configuration:");
     log_setting("Core_UseCpuJit", values.use_cpu_jit);
     log_setting("Core_CPUClockPercentage", values.cpu_clock_percentage);
+    log_setting("Core_EnableCpuMultithread", values.enable_cpu_multithread);
+    log_setting("Core_SkipIdleLoops", values.skip_idle_loops);
     log_setting("Renderer_UseGLES", values.use_gles);
+    log_setting("Renderer_UseNullRenderer", values.use_null_renderer);
     log_setting("Renderer_UseHwRenderer", values.use_hw_renderer);
     log_setting("Renderer_UseHwShader", values.use_hw_shader);
     log_setting("Renderer_SeparableShader", values.separable_shader);
     log_setting("Renderer_ShadersAccurateMul", values.shaders_accurate_mul);
     log_setting("Renderer_UseShaderJit", values.use_shader_jit);
+    log_setting("Renderer_UseAsynchronousGpuEmulation", values.use_asynchronous_gpu_emulation);
     log_setting("Renderer_UseResolutionFactor", values.resolution_factor);
     log_setting("Renderer_FrameLimit", values.frame_limit);
     log_setting("Renderer_UseFrameLimitAlternate", values.use_frame_limit_alternate);
     log_setting("Renderer_FrameLimitAlternate", values.frame_limit_alternate);
+    log_setting("Renderer_MaxThroughput", values.max_throughput);
+    log_setting("Renderer_MaxThroughputPresentInterval", values.max_throughput_present_interval);
     log_setting("Renderer_VSyncNew", values.use_vsync_new);
     log_setting("Renderer_PostProcessingShader", values.pp_shader_name);
     log_setting("Renderer_FilterMode", values.filter_mode);
@@ -99,6 +105,8 @@ void LogSettings() {
     log_setting("Layout_UprightScreen", values.upright_screen);
     log_setting("Utility_DumpTextures", values.dump_textures);
     log_setting("Utility_CustomTextures", values.custom_textures);
+    log_setting("Utility_PreloadTextures", values.preload_textures);
+    log_setting("Utility_CustomTexturesMemoryBudget", values.custom_textures_memory_budget);
     log_setting("Utility_UseDiskShaderCache", values.use_disk_shader_cache);
     log_setting("Audio_EnableDspLle", values.enable_dsp_lle);
     log_setting("Audio_EnableDspLleMultithread", values.enable_dsp_lle_multithread);
@@ -122,10 +130,15 @@ void LogSettings() {
     log_setting("DataStorage_NandDir", values.nand_dir);
     log_setting("System_IsNew3ds", values.is_new_3ds);
     log_setting("System_RegionValue", values.region_value);
+    log_setting("Debugging_PerfBreakdownFile", values.perf_breakdown_file);
     log_setting("Debugging_UseGdbstub", values.use_gdbstub);
     log_setting("Debugging_GdbstubPort", values.gdbstub_port);
 }
 
+std::string GetAudioSinkID() {
+    return values.max_throughput ? "null" : values.sink_id;
+}
+
 void LoadProfile(int index) {
     Settings::values.current_input_profile = Settings::values.input_profiles[index];
     Settings::values.current_input_profile_index = index;
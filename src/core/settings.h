@@ -137,6 +137,8 @@ struct Values {
     // Core
     bool use_cpu_jit;
     int cpu_clock_percentage;
+    bool enable_cpu_multithread;
+    bool skip_idle_loops;
 
     // Data Storage
     bool use_virtual_sd;
@@ -150,16 +152,20 @@ struct Values {
 
     // Renderer
     bool use_gles;
+    bool use_null_renderer;
     bool use_hw_renderer;
     bool use_hw_shader;
     bool separable_shader;
     bool use_disk_shader_cache;
     bool shaders_accurate_mul;
     bool use_shader_jit;
+    bool use_asynchronous_gpu_emulation;
     u16 resolution_factor;
     bool use_frame_limit_alternate;
     u16 frame_limit;
     u16 frame_limit_alternate;
+    bool max_throughput;
+    u16 max_throughput_present_interval;
     std::string texture_filter_name;
 
     LayoutOption layout_option;
@@ -188,6 +194,8 @@ struct Values {
     bool dump_textures;
     bool custom_textures;
     bool preload_textures;
+    /// Memory in MiB for custom textures loaded on demand, 0 for no limit
+    u32 custom_textures_memory_budget;
 
     bool use_vsync_new;
 
@@ -208,9 +216,12 @@ struct Values {
 
     // Debugging
     bool record_frame_times;
+    std::string perf_breakdown_file;
     bool use_gdbstub;
     u16 gdbstub_port;
     std::string log_filter;
+    bool log_deferred_formatting;
+    bool log_binary;
     std::unordered_map<std::string, bool> lle_modules;
 
     // WebService
@@ -226,6 +237,7 @@ struct Values {
     std::string video_encoder;
     std::string video_encoder_options;
     u64 video_bitrate;
+    u32 video_frame_queue_depth;
 
     std::string audio_encoder;
     std::string audio_encoder_options;
@@ -239,6 +251,9 @@ static constexpr int REGION_VALUE_AUTO_SELECT = -1;
 void Apply();
 void LogSettings();
 
+/// Returns the ID of the audio sink to output to. Max throughput mode discards the audio.
+std::string GetAudioSinkID();
+
 // Input profiles
 void LoadProfile(int index);
 void SaveProfile(int index);
@@ -0,0 +1,52 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include "common/logging/backend.h"
+#include "common/logging/binary_log.h"
+#include "common/logging/text_formatter.h"
+
+static void PrintHelp(const char* argv0) {
+    std::cout << "Usage: " << argv0
+              << " <binary log> [output]\n"
+                 "Converts a log written by the binary_file backend to the text log format.\n"
+                 "Writes to stdout if no output file is given.\n";
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2 || argc > 3) {
+        PrintHelp(argv[0]);
+        return 1;
+    }
+
+    Log::BinaryLog::Reader reader(argv[1]);
+    if (!reader.IsValid()) {
+        std::cerr << "Unable to open " << argv[1] << " as a binary log\n";
+        return 1;
+    }
+
+    std::FILE* out = stdout;
+    if (argc == 3) {
+        out = std::fopen(argv[2], "w");
+        if (out == nullptr) {
+            std::cerr << "Unable to open " << argv[2] << " for writing\n";
+            return 1;
+        }
+    }
+
+    std::size_t count = 0;
+    while (const auto entry = reader.ReadEntry()) {
+        const std::string line = Log::FormatLogMessage(*entry).append(1, '\n');
+        std::fputs(line.c_str(), out);
+        count++;
+    }
+
+    if (out != stdout) {
+        std::fclose(out);
+    }
+    std::cerr << "Decoded " << count << " entries\n";
+    return 0;
+}
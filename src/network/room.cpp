@@ -4,13 +4,17 @@
 
 #include <algorithm>
 #include <atomic>
+#include <cstring>
 #include <iomanip>
 #include <mutex>
+#include <optional>
 #include <random>
 #include <regex>
 #include <sstream>
 #include <thread>
+#include <unordered_map>
 #include "common/logging/log.h"
+#include "common/threadsafe_queue.h"
 #include "enet/enet.h"
 #include "network/packet.h"
 #include "network/room.h"
@@ -48,6 +52,41 @@ public:
     mutable std::mutex member_mutex; ///< Mutex for locking the members list
     /// This should be a std::shared_mutex as soon as C++17 is supported
 
+    struct MacAddressHash {
+        std::size_t operator()(const MacAddress& address) const {
+            u64 value = 0;
+            std::memcpy(&value, address.data(), address.size());
+            return std::hash<u64>()(value);
+        }
+    };
+    /// Peer of the member owning each MAC address, to route unicast Wi-Fi packets. Locked by
+    /// member_mutex, and kept in sync with the members list.
+    std::unordered_map<MacAddress, ENetPeer*, MacAddressHash> mac_routes;
+
+    /// A join request that passed the checks of the room and is waiting for the user data.
+    struct PendingJoin {
+        ENetPeer* peer = nullptr;
+        /// ENet reuses the peers of closed connections, so this tells whether the peer still
+        /// belongs to the client that asked to join.
+        enet_uint32 connect_id = 0;
+        Member member;
+        std::string token;
+        std::string ip;
+    };
+
+    /// Join requests for the verification thread, which stops when it receives an empty one.
+    Common::SPSCQueue<std::optional<PendingJoin>> join_requests;
+    /// Join requests whose user data has been loaded, to be finished by the room thread.
+    Common::SPSCQueue<PendingJoin> verified_joins;
+
+    struct PendingJoinState {
+        enet_uint32 connect_id;
+        /// Game info sent by the client while it was waiting to join
+        std::optional<GameInfo> game_info;
+    };
+    /// Peers with a join request in flight. Only accessed by the room thread.
+    std::unordered_map<ENetPeer*, PendingJoinState> pending_joins;
+
     UsernameBanList username_ban_list; ///< List of banned usernames
     IPBanList ip_ban_list;             ///< List of banned IP addresses
     mutable std::mutex ban_list_mutex; ///< Mutex for the ban lists
@@ -61,10 +100,22 @@ public:
     /// Verification backend of the room
     std::unique_ptr<VerifyUser::Backend> verify_backend;
 
+    /**
+     * Thread that loads the user data of joining clients. The backend may have to query the web
+     * service, and doing this on the room thread would stall the packet relay.
+     */
+    std::unique_ptr<std::thread> verify_thread;
+
     /// Thread function that will receive and dispatch messages until the room is destroyed.
     void ServerLoop();
     void StartLoop();
 
+    /// Dispatches a received ENet event to its handler.
+    void HandleEvent(ENetEvent* event);
+
+    /// Thread function that will load the user data of join requests until the room is destroyed.
+    void VerifyLoop();
+
     /**
      * Parses and answers a room join request from a client.
      * Validates the uniqueness of the username and assigns the MAC address
@@ -72,6 +123,12 @@ public:
      */
     void HandleJoinRequest(const ENetEvent* event);
 
+    /**
+     * Adds a client whose user data has been loaded to the room, after checking that it is still
+     * connected and that the room did not change in a way that prevents it from joining.
+     */
+    void FinishJoinRequest(PendingJoin join);
+
     /**
      * Parses and answers a kick request from a client.
      * Validates the permissions and that the given user exists and then kicks the member.
@@ -223,7 +280,7 @@ public:
     MacAddress GenerateMacAddress();
 
     /**
-     * Broadcasts this packet to all members except the sender.
+     * Relays this packet to its destination member, or to all members except the sender.
      * @param event The ENet event containing the data
      */
     void HandleWifiPacket(const ENetEvent* event);
@@ -250,54 +307,89 @@ public:
 // RoomImpl
 void Room::RoomImpl::ServerLoop() {
     while (state != State::Closed) {
+        // Poll more often while join requests are being verified, so that they are not delayed
+        const enet_uint32 timeout = pending_joins.empty() ? 50 : 5;
+
+        // Handle all the events that arrived since the last wakeup before sending anything, so
+        // that the packets relayed to each member go out together.
         ENetEvent event;
-        if (enet_host_service(server, &event, 50) > 0) {
-            switch (event.type) {
-            case ENET_EVENT_TYPE_RECEIVE:
-                switch (event.packet->data[0]) {
-                case IdJoinRequest:
-                    HandleJoinRequest(&event);
-                    break;
-                case IdSetGameInfo:
-                    HandleGameNamePacket(&event);
-                    break;
-                case IdWifiPacket:
-                    HandleWifiPacket(&event);
-                    break;
-                case IdChatMessage:
-                    HandleChatPacket(&event);
-                    break;
-                // Moderation
-                case IdModKick:
-                    HandleModKickPacket(&event);
-                    break;
-                case IdModBan:
-                    HandleModBanPacket(&event);
-                    break;
-                case IdModUnban:
-                    HandleModUnbanPacket(&event);
-                    break;
-                case IdModGetBanList:
-                    HandleModGetBanListPacket(&event);
-                    break;
-                }
-                enet_packet_destroy(event.packet);
-                break;
-            case ENET_EVENT_TYPE_DISCONNECT:
-                HandleClientDisconnection(event.peer);
-                break;
-            case ENET_EVENT_TYPE_NONE:
-            case ENET_EVENT_TYPE_CONNECT:
-                break;
-            }
+        int result = enet_host_service(server, &event, timeout);
+        while (result > 0) {
+            HandleEvent(&event);
+            result = enet_host_check_events(server, &event);
         }
+
+        PendingJoin join;
+        while (verified_joins.Pop(join)) {
+            FinishJoinRequest(std::move(join));
+        }
+
+        enet_host_flush(server);
     }
     // Close the connection to all members:
     SendCloseMessage();
 }
 
+void Room::RoomImpl::HandleEvent(ENetEvent* event) {
+    switch (event->type) {
+    case ENET_EVENT_TYPE_RECEIVE:
+        switch (event->packet->data[0]) {
+        case IdJoinRequest:
+            HandleJoinRequest(event);
+            break;
+        case IdSetGameInfo:
+            HandleGameNamePacket(event);
+            break;
+        case IdWifiPacket:
+            HandleWifiPacket(event);
+            break;
+        case IdChatMessage:
+            HandleChatPacket(event);
+            break;
+        // Moderation
+        case IdModKick:
+            HandleModKickPacket(event);
+            break;
+        case IdModBan:
+            HandleModBanPacket(event);
+            break;
+        case IdModUnban:
+            HandleModUnbanPacket(event);
+            break;
+        case IdModGetBanList:
+            HandleModGetBanListPacket(event);
+            break;
+        }
+        // Relayed packets are still referenced by the peers they are queued on, and are freed by
+        // ENet once sent
+        if (event->packet->referenceCount == 0) {
+            enet_packet_destroy(event->packet);
+        }
+        break;
+    case ENET_EVENT_TYPE_DISCONNECT:
+        HandleClientDisconnection(event->peer);
+        break;
+    case ENET_EVENT_TYPE_NONE:
+    case ENET_EVENT_TYPE_CONNECT:
+        break;
+    }
+}
+
 void Room::RoomImpl::StartLoop() {
     room_thread = std::make_unique<std::thread>(&Room::RoomImpl::ServerLoop, this);
+    verify_thread = std::make_unique<std::thread>(&Room::RoomImpl::VerifyLoop, this);
+}
+
+void Room::RoomImpl::VerifyLoop() {
+    while (auto join = join_requests.PopWait()) {
+        std::string uid;
+        {
+            std::lock_guard lock(verify_UID_mutex);
+            uid = verify_UID;
+        }
+        join->member.user_data = verify_backend->LoadUserData(uid, join->token);
+        verified_joins.Push(std::move(*join));
+    }
 }
 
 void Room::RoomImpl::HandleJoinRequest(const ENetEvent* event) {
@@ -339,15 +431,10 @@ void Room::RoomImpl::HandleJoinRequest(const ENetEvent* event) {
         return;
     }
 
-    if (preferred_mac != NoPreferredMac) {
-        // Verify if the preferred mac is available
-        if (!IsValidMacAddress(preferred_mac)) {
-            SendMacCollision(event->peer);
-            return;
-        }
-    } else {
-        // Assign a MAC address of this client automatically
-        preferred_mac = GenerateMacAddress();
+    // Verify if the preferred mac is available
+    if (preferred_mac != NoPreferredMac && !IsValidMacAddress(preferred_mac)) {
+        SendMacCollision(event->peer);
+        return;
     }
 
     if (!IsValidConsoleId(console_id_hash)) {
@@ -360,58 +447,108 @@ void Room::RoomImpl::HandleJoinRequest(const ENetEvent* event) {
         return;
     }
 
-    // At this point the client is ready to be added to the room.
-    Member member{};
-    member.mac_address = preferred_mac;
-    member.console_id_hash = console_id_hash;
-    member.nickname = nickname;
-    member.peer = event->peer;
-
-    std::string uid;
+    char ip_raw[256];
+    enet_address_get_host_ip(&event->peer->address, ip_raw, sizeof(ip_raw) - 1);
+    const std::string ip = ip_raw;
     {
-        std::lock_guard lock(verify_UID_mutex);
-        uid = verify_UID;
+        std::lock_guard lock(ban_list_mutex);
+
+        // Check IP ban
+        if (std::find(ip_ban_list.begin(), ip_ban_list.end(), ip) != ip_ban_list.end()) {
+            SendUserBanned(event->peer);
+            return;
+        }
+    }
+
+    if (pending_joins.count(event->peer)) {
+        return; // This client is already waiting to join
+    }
+
+    // At this point the client is ready to be added to the room, once its user data is loaded.
+    // The MAC address is assigned then if the client has no preference, so that it does not
+    // collide with the ones of the clients that join in the meantime.
+    PendingJoin join;
+    join.peer = event->peer;
+    join.connect_id = event->peer->connectID;
+    join.member.mac_address = preferred_mac;
+    join.member.console_id_hash = console_id_hash;
+    join.member.nickname = nickname;
+    join.member.peer = event->peer;
+    join.token = std::move(token);
+    join.ip = ip;
+
+    pending_joins.emplace(event->peer, PendingJoinState{event->peer->connectID, std::nullopt});
+    join_requests.Push(std::move(join));
+}
+
+void Room::RoomImpl::FinishJoinRequest(PendingJoin join) {
+    ENetPeer* peer = join.peer;
+    const auto pending = pending_joins.find(peer);
+    if (pending == pending_joins.end() || pending->second.connect_id != join.connect_id ||
+        peer->connectID != join.connect_id) {
+        return; // The client disconnected while its user data was being loaded
+    }
+    if (pending->second.game_info) {
+        join.member.game_info = std::move(*pending->second.game_info);
     }
-    member.user_data = verify_backend->LoadUserData(uid, token);
+    pending_joins.erase(pending);
 
-    std::string ip;
     {
         std::lock_guard lock(ban_list_mutex);
 
         // Check username ban
-        if (!member.user_data.username.empty() &&
-            std::find(username_ban_list.begin(), username_ban_list.end(),
-                      member.user_data.username) != username_ban_list.end()) {
+        const auto& username = join.member.user_data.username;
+        if (!username.empty() && std::find(username_ban_list.begin(), username_ban_list.end(),
+                                           username) != username_ban_list.end()) {
 
-            SendUserBanned(event->peer);
+            SendUserBanned(peer);
             return;
         }
+    }
 
-        // Check IP ban
-        char ip_raw[256];
-        enet_address_get_host_ip(&event->peer->address, ip_raw, sizeof(ip_raw) - 1);
-        ip = ip_raw;
-
-        if (std::find(ip_ban_list.begin(), ip_ban_list.end(), ip) != ip_ban_list.end()) {
-            SendUserBanned(event->peer);
+    // Other clients may have joined while the user data was being loaded
+    {
+        std::lock_guard lock(member_mutex);
+        if (members.size() >= room_information.member_slots) {
+            SendRoomIsFull(peer);
+            return;
+        }
+    }
+    if (!IsValidNickname(join.member.nickname)) {
+        SendNameCollision(peer);
+        return;
+    }
+    if (join.member.mac_address != NoPreferredMac) {
+        if (!IsValidMacAddress(join.member.mac_address)) {
+            SendMacCollision(peer);
             return;
         }
+    } else {
+        // Assign a MAC address of this client automatically
+        join.member.mac_address = GenerateMacAddress();
+    }
+    if (!IsValidConsoleId(join.member.console_id_hash)) {
+        SendConsoleIdCollision(peer);
+        return;
     }
 
     // Notify everyone that the user has joined.
-    SendStatusMessage(IdMemberJoin, member.nickname, member.user_data.username, ip);
+    SendStatusMessage(IdMemberJoin, join.member.nickname, join.member.user_data.username,
+                      join.ip);
 
+    const MacAddress mac_address = join.member.mac_address;
     {
         std::lock_guard lock(member_mutex);
-        members.push_back(std::move(member));
+        mac_routes[mac_address] = peer;
+        members.push_back(std::move(join.member));
     }
 
     // Notify everyone that the room information has changed.
     BroadcastRoomInformation();
-    if (HasModPermission(event->peer)) {
-        SendJoinSuccessAsMod(event->peer, preferred_mac);
+    if (HasModPermission(peer)) {
+        SendJoinSuccessAsMod(peer, mac_address);
     } else {
-        SendJoinSuccess(event->peer, preferred_mac);
+        SendJoinSuccess(peer, mac_address);
     }
 }
 
@@ -449,6 +586,7 @@ void Room::RoomImpl::HandleModKickPacket(const ENetEvent* event) {
         ip = ip_raw;
 
         enet_peer_disconnect(target_member->peer, 0);
+        mac_routes.erase(target_member->mac_address);
         members.erase(target_member);
     }
 
@@ -492,6 +630,7 @@ void Room::RoomImpl::HandleModBanPacket(const ENetEvent* event) {
         ip = ip_raw;
 
         enet_peer_disconnect(target_member->peer, 0);
+        mac_routes.erase(target_member->mac_address);
         members.erase(target_member);
     }
 
@@ -579,8 +718,7 @@ bool Room::RoomImpl::IsValidNickname(const std::string& nickname) const {
 bool Room::RoomImpl::IsValidMacAddress(const MacAddress& address) const {
     // A MAC address is valid if it is not already taken by anybody else in the room.
     std::lock_guard lock(member_mutex);
-    return std::all_of(members.begin(), members.end(),
-                       [&address](const auto& member) { return member.mac_address != address; });
+    return mac_routes.count(address) == 0;
 }
 
 bool Room::RoomImpl::IsValidConsoleId(const std::string& console_id_hash) const {
@@ -847,51 +985,40 @@ MacAddress Room::RoomImpl::GenerateMacAddress() {
 }
 
 void Room::RoomImpl::HandleWifiPacket(const ENetEvent* event) {
-    Packet in_packet;
-    in_packet.Append(event->packet->data, event->packet->dataLength);
-    in_packet.IgnoreBytes(sizeof(u8));         // Message type
-    in_packet.IgnoreBytes(sizeof(u8));         // WifiPacket Type
-    in_packet.IgnoreBytes(sizeof(u8));         // WifiPacket Channel
-    in_packet.IgnoreBytes(sizeof(MacAddress)); // WifiPacket Transmitter Address
+    // The destination address follows the message type, the WifiPacket type and channel and the
+    // transmitter address
+    constexpr std::size_t destination_offset = 3 * sizeof(u8) + sizeof(MacAddress);
+    ENetPacket* enet_packet = event->packet;
+    if (enet_packet->dataLength < destination_offset + sizeof(MacAddress)) {
+        return;
+    }
     MacAddress destination_address;
-    in_packet >> destination_address;
+    std::memcpy(destination_address.data(), enet_packet->data + destination_offset,
+                destination_address.size());
 
-    Packet out_packet;
-    out_packet.Append(event->packet->data, event->packet->dataLength);
-    ENetPacket* enet_packet = enet_packet_create(out_packet.GetData(), out_packet.GetDataSize(),
-                                                 ENET_PACKET_FLAG_RELIABLE);
+    // The received packet is relayed as is. ENet reference counts it, so every destination shares
+    // it instead of getting its own copy.
+    enet_packet->flags |= ENET_PACKET_FLAG_RELIABLE;
 
+    std::lock_guard lock(member_mutex);
     if (destination_address == BroadcastMac) { // Send the data to everyone except the sender
-        std::lock_guard lock(member_mutex);
-        bool sent_packet = false;
         for (const auto& member : members) {
             if (member.peer != event->peer) {
-                sent_packet = true;
                 enet_peer_send(member.peer, 0, enet_packet);
             }
         }
-
-        if (!sent_packet) {
-            enet_packet_destroy(enet_packet);
-        }
     } else { // Send the data only to the destination client
-        std::lock_guard lock(member_mutex);
-        auto member = std::find_if(members.begin(), members.end(),
-                                   [destination_address](const Member& member) -> bool {
-                                       return member.mac_address == destination_address;
-                                   });
-        if (member != members.end()) {
-            enet_peer_send(member->peer, 0, enet_packet);
+        const auto route = mac_routes.find(destination_address);
+        if (route != mac_routes.end()) {
+            enet_peer_send(route->second, 0, enet_packet);
         } else {
             LOG_ERROR(Network,
                       "Attempting to send to unknown MAC address: "
                       "{:02X}:{:02X}:{:02X}:{:02X}:{:02X}:{:02X}",
                       destination_address[0], destination_address[1], destination_address[2],
                       destination_address[3], destination_address[4], destination_address[5]);
-            enet_packet_destroy(enet_packet);
         }
     }
-    enet_host_flush(server);
 }
 
 void Room::RoomImpl::HandleChatPacket(const ENetEvent* event) {
@@ -934,8 +1061,6 @@ void Room::RoomImpl::HandleChatPacket(const ENetEvent* event) {
         enet_packet_destroy(enet_packet);
     }
 
-    enet_host_flush(server);
-
     if (sending_member->user_data.username.empty()) {
         LOG_INFO(Network, "{}: {}", sending_member->nickname, message);
     } else {
@@ -972,12 +1097,21 @@ void Room::RoomImpl::HandleGameNamePacket(const ENetEvent* event) {
             } else {
                 LOG_INFO(Network, "{} is playing {}", display_name, game_info.name);
             }
+        } else {
+            // Keep the game info of a client that is still joining for when it joins
+            const auto pending = pending_joins.find(event->peer);
+            if (pending != pending_joins.end()) {
+                pending->second.game_info = std::move(game_info);
+            }
+            return;
         }
     }
     BroadcastRoomInformation();
 }
 
 void Room::RoomImpl::HandleClientDisconnection(ENetPeer* client) {
+    pending_joins.erase(client);
+
     // Remove the client from the members list.
     std::string nickname, username, ip;
     {
@@ -993,6 +1127,7 @@ void Room::RoomImpl::HandleClientDisconnection(ENetPeer* client) {
             enet_address_get_host_ip(&member->peer->address, ip_raw, sizeof(ip_raw) - 1);
             ip = ip_raw;
 
+            mac_routes.erase(member->mac_address);
             members.erase(member);
         }
     }
@@ -1094,6 +1229,12 @@ void Room::Destroy() {
     room_impl->state = State::Closed;
     room_impl->room_thread->join();
     room_impl->room_thread.reset();
+    room_impl->join_requests.Push(std::nullopt);
+    room_impl->verify_thread->join();
+    room_impl->verify_thread.reset();
+    room_impl->join_requests.Clear();
+    room_impl->verified_joins.Clear();
+    room_impl->pending_joins.clear();
 
     if (room_impl->server) {
         enet_host_destroy(room_impl->server);
@@ -1103,6 +1244,7 @@ void Room::Destroy() {
     {
         std::lock_guard lock(room_impl->member_mutex);
         room_impl->members.clear();
+        room_impl->mac_routes.clear();
     }
     room_impl->room_information.member_slots = 0;
     room_impl->room_information.name.clear();
@@ -0,0 +1,360 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+// Simulates clients of a multiplayer room that exchange Wi-Fi packets, and reports how long the
+// room takes to relay them. By default the room is hosted by this process, on loopback.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+#include "common/scm_rev.h"
+#include "enet/enet.h"
+#include "network/network.h"
+#include "network/packet.h"
+#include "network/room.h"
+#include "network/room_member.h"
+#include "network/verify_user.h"
+
+#undef _UNICODE
+#include <getopt.h>
+#ifndef _MSC_VER
+#include <unistd.h>
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+/// How long to wait for the clients to join, and for the last packets to arrive
+constexpr auto ConnectionTimeout = std::chrono::seconds(5);
+/// Offset of the payload of a relayed WifiPacket: message type, packet type, channel, the two
+/// addresses and the payload size
+constexpr std::size_t PayloadOffset = 3 * sizeof(u8) + 2 * sizeof(Network::MacAddress) + 4;
+/// The payload starts with the send time and the index of the sending client
+constexpr std::size_t MinPayloadSize = sizeof(s64) + sizeof(u32);
+
+struct Client {
+    ENetPeer* peer = nullptr;
+    Network::MacAddress mac_address{};
+    bool joined = false;
+};
+
+static void PrintHelp(const char* argv0) {
+    std::cout << "Usage: " << argv0
+              << " [options]\n"
+                 "-c, --clients       The number of simulated clients (default: 8)\n"
+                 "-n, --packets       The number of packets sent by each client (default: 1000)\n"
+                 "-r, --rate          The packets sent by each client per second (default: 60)\n"
+                 "-s, --size          The payload size of each packet in bytes (default: 256)\n"
+                 "-u, --unicast       Send each packet to one client instead of broadcasting it\n"
+                 "-a, --address       The address of the room to test. Without it, a room is\n"
+                 "                    hosted by this process on loopback\n"
+                 "-p, --port          The port of the room\n"
+                 "-w, --password      The password of the room\n"
+                 "-h, --help          Display this help and exit\n"
+                 "-v, --version       Output version information and exit\n";
+}
+
+static void PrintVersion() {
+    std::cout << "Citra room load generator " << Common::g_scm_branch << " " << Common::g_scm_desc
+              << " Libnetwork: " << Network::network_version << std::endl;
+}
+
+static void Send(ENetPeer* peer, const Network::Packet& packet) {
+    ENetPacket* enet_packet =
+        enet_packet_create(packet.GetData(), packet.GetDataSize(), ENET_PACKET_FLAG_RELIABLE);
+    enet_peer_send(peer, 0, enet_packet);
+}
+
+static std::size_t FindClient(const std::vector<Client>& clients, const ENetPeer* peer) {
+    return std::find_if(clients.begin(), clients.end(),
+                        [peer](const Client& client) { return client.peer == peer; }) -
+           clients.begin();
+}
+
+/// Connects the clients to the room and waits for all of them to join.
+static bool JoinRoom(ENetHost* host, std::vector<Client>& clients, const std::string& address,
+                     u16 port, const std::string& password) {
+    ENetAddress room_address;
+    enet_address_set_host(&room_address, address.c_str());
+    room_address.port = port;
+    for (auto& client : clients) {
+        client.peer = enet_host_connect(host, &room_address, Network::NumChannels, 0);
+        if (!client.peer) {
+            std::cout << "Failed to create an ENet peer\n";
+            return false;
+        }
+    }
+
+    std::size_t joined = 0;
+    const auto deadline = Clock::now() + ConnectionTimeout;
+    while (joined < clients.size() && Clock::now() < deadline) {
+        ENetEvent event;
+        if (enet_host_service(host, &event, 10) <= 0) {
+            continue;
+        }
+        const std::size_t index = FindClient(clients, event.peer);
+        switch (event.type) {
+        case ENET_EVENT_TYPE_CONNECT: {
+            Network::Packet packet;
+            packet << static_cast<u8>(Network::IdJoinRequest);
+            packet << "loadgen-" + std::to_string(index);
+            packet << "loadgen-console-" + std::to_string(index);
+            packet << Network::NoPreferredMac;
+            packet << Network::network_version;
+            packet << password;
+            packet << std::string{}; // token
+            Send(event.peer, packet);
+            break;
+        }
+        case ENET_EVENT_TYPE_RECEIVE: {
+            const u8 message_type = event.packet->data[0];
+            if (message_type == Network::IdJoinSuccess ||
+                message_type == Network::IdJoinSuccessAsMod) {
+                Network::Packet packet;
+                packet.Append(event.packet->data, event.packet->dataLength);
+                packet.IgnoreBytes(sizeof(u8)); // Ignore the message type
+                packet >> clients[index].mac_address;
+                clients[index].joined = true;
+                ++joined;
+            } else if (message_type != Network::IdRoomInformation &&
+                       message_type != Network::IdStatusMessage) {
+                std::cout << "Client " << index << " could not join the room (message "
+                          << static_cast<int>(message_type) << ")\n";
+                enet_packet_destroy(event.packet);
+                return false;
+            }
+            enet_packet_destroy(event.packet);
+            break;
+        }
+        case ENET_EVENT_TYPE_DISCONNECT:
+            std::cout << "Client " << index << " was disconnected from the room\n";
+            return false;
+        case ENET_EVENT_TYPE_NONE:
+            break;
+        }
+    }
+    if (joined < clients.size()) {
+        std::cout << "Only " << joined << " of " << clients.size() << " clients joined the room\n";
+        return false;
+    }
+    return true;
+}
+
+/// Handles the events of the clients until the deadline, recording the latency of the relayed
+/// Wi-Fi packets in microseconds.
+static void ReceiveUntil(ENetHost* host, Clock::time_point deadline, std::vector<double>& latencies,
+                         u64 expected) {
+    while (latencies.size() < expected) {
+        const auto now = Clock::now();
+        if (now >= deadline) {
+            return;
+        }
+        const auto timeout = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now);
+        ENetEvent event;
+        if (enet_host_service(host, &event, static_cast<enet_uint32>(timeout.count())) <= 0) {
+            continue;
+        }
+        do {
+            if (event.type != ENET_EVENT_TYPE_RECEIVE) {
+                continue;
+            }
+            if (event.packet->data[0] == Network::IdWifiPacket &&
+                event.packet->dataLength >= PayloadOffset + MinPayloadSize) {
+                s64 send_time;
+                std::memcpy(&send_time, event.packet->data + PayloadOffset, sizeof(send_time));
+                const auto latency = Clock::now().time_since_epoch().count() - send_time;
+                latencies.push_back(
+                    std::chrono::duration<double, std::micro>(Clock::duration(latency)).count());
+            }
+            enet_packet_destroy(event.packet);
+        } while (enet_host_check_events(host, &event) > 0);
+    }
+}
+
+static double Percentile(const std::vector<double>& sorted, double percentile) {
+    const auto rank = static_cast<std::size_t>(std::ceil(percentile / 100.0 * sorted.size()));
+    return sorted[std::clamp<std::size_t>(rank, 1, sorted.size()) - 1];
+}
+
+/// Application entry point
+int main(int argc, char** argv) {
+    int option_index = 0;
+    char* endarg;
+
+    u32 num_clients = 8;
+    u32 num_packets = 1000;
+    u32 rate = 60;
+    u32 payload_size = 256;
+    bool unicast = false;
+    std::string address;
+    u32 port = Network::DefaultRoomPort;
+    std::string password;
+
+    static struct option long_options[] = {
+        {"clients", required_argument, 0, 'c'}, {"packets", required_argument, 0, 'n'},
+        {"rate", required_argument, 0, 'r'},    {"size", required_argument, 0, 's'},
+        {"unicast", no_argument, 0, 'u'},       {"address", required_argument, 0, 'a'},
+        {"port", required_argument, 0, 'p'},    {"password", required_argument, 0, 'w'},
+        {"help", no_argument, 0, 'h'},          {"version", no_argument, 0, 'v'},
+        {0, 0, 0, 0},
+    };
+
+    while (optind < argc) {
+        int arg = getopt_long(argc, argv, "c:n:r:s:ua:p:w:hv", long_options, &option_index);
+        if (arg != -1) {
+            switch (static_cast<char>(arg)) {
+            case 'c':
+                num_clients = strtoul(optarg, &endarg, 0);
+                break;
+            case 'n':
+                num_packets = strtoul(optarg, &endarg, 0);
+                break;
+            case 'r':
+                rate = strtoul(optarg, &endarg, 0);
+                break;
+            case 's':
+                payload_size = strtoul(optarg, &endarg, 0);
+                break;
+            case 'u':
+                unicast = true;
+                break;
+            case 'a':
+                address.assign(optarg);
+                break;
+            case 'p':
+                port = strtoul(optarg, &endarg, 0);
+                break;
+            case 'w':
+                password.assign(optarg);
+                break;
+            case 'h':
+                PrintHelp(argv[0]);
+                return 0;
+            case 'v':
+                PrintVersion();
+                return 0;
+            }
+        } else {
+            PrintHelp(argv[0]);
+            return -1;
+        }
+    }
+
+    if (num_clients > Network::MaxConcurrentConnections || num_clients < 2) {
+        std::cout << "clients needs to be in the range 2 - " << Network::MaxConcurrentConnections
+                  << "!\n\n";
+        PrintHelp(argv[0]);
+        return -1;
+    }
+    if (rate == 0) {
+        std::cout << "rate needs to be at least 1!\n\n";
+        PrintHelp(argv[0]);
+        return -1;
+    }
+    if (port > 65535) {
+        std::cout << "port needs to be in the range 0 - 65535!\n\n";
+        PrintHelp(argv[0]);
+        return -1;
+    }
+    payload_size = std::max<u32>(payload_size, MinPayloadSize);
+
+    Network::Init();
+    std::shared_ptr<Network::Room> room;
+    if (address.empty()) {
+        address = "127.0.0.1";
+        room = Network::GetRoom().lock();
+        if (!room || !room->Create("Load test", "", address, static_cast<u16>(port), password,
+                                   num_clients, "", "", 0,
+                                   std::make_unique<Network::VerifyUser::NullBackend>())) {
+            std::cout << "Failed to create room\n";
+            Network::Shutdown();
+            return -1;
+        }
+    }
+
+    ENetHost* host = enet_host_create(nullptr, num_clients, Network::NumChannels, 0, 0);
+    if (!host) {
+        std::cout << "Failed to create the ENet host of the clients\n";
+        Network::Shutdown();
+        return -1;
+    }
+
+    int result = 0;
+    std::vector<Client> clients(num_clients);
+    if (JoinRoom(host, clients, address, static_cast<u16>(port), password)) {
+        std::cout << num_clients << " clients joined the room, sending " << num_packets << " "
+                  << (unicast ? "unicast" : "broadcast") << " packets of " << payload_size
+                  << " bytes each at " << rate << " packets/s per client\n";
+
+        const u64 expected = static_cast<u64>(num_packets) * num_clients *
+                             (unicast ? 1 : (num_clients - 1));
+        std::vector<double> latencies;
+        latencies.reserve(expected);
+
+        std::vector<u8> payload(payload_size);
+        const auto interval = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(1.0 / rate));
+        auto next_send = Clock::now();
+        for (u32 round = 0; round < num_packets; ++round) {
+            for (u32 index = 0; index < num_clients; ++index) {
+                const auto& destination = unicast ? clients[(index + 1) % num_clients].mac_address
+                                                  : Network::BroadcastMac;
+                const s64 send_time = Clock::now().time_since_epoch().count();
+                std::memcpy(payload.data(), &send_time, sizeof(send_time));
+                std::memcpy(payload.data() + sizeof(send_time), &index, sizeof(index));
+
+                Network::Packet packet;
+                packet << static_cast<u8>(Network::IdWifiPacket);
+                packet << static_cast<u8>(Network::WifiPacket::PacketType::Data);
+                packet << static_cast<u8>(1); // channel
+                packet << clients[index].mac_address;
+                packet << destination;
+                packet << payload;
+                Send(clients[index].peer, packet);
+            }
+            enet_host_flush(host);
+
+            next_send += interval;
+            ReceiveUntil(host, next_send, latencies, expected);
+        }
+        ReceiveUntil(host, Clock::now() + ConnectionTimeout, latencies, expected);
+
+        std::sort(latencies.begin(), latencies.end());
+        std::cout << "Received " << latencies.size() << " of " << expected << " relayed packets\n";
+        if (!latencies.empty()) {
+            std::cout << std::fixed << std::setprecision(3)
+                      << "Relay latency (ms): p50 " << Percentile(latencies, 50) / 1000
+                      << ", p90 " << Percentile(latencies, 90) / 1000 << ", p99 "
+                      << Percentile(latencies, 99) / 1000 << ", p99.9 "
+                      << Percentile(latencies, 99.9) / 1000 << ", max "
+                      << latencies.back() / 1000 << "\n";
+        }
+        if (latencies.size() < expected) {
+            result = -1;
+        }
+    } else {
+        result = -1;
+    }
+
+    for (const auto& client : clients) {
+        if (client.peer) {
+            enet_peer_disconnect(client.peer, 0);
+        }
+    }
+    enet_host_flush(host);
+    enet_host_destroy(host);
+
+    if (room) {
+        room->Destroy();
+        room.reset();
+    }
+    Network::Shutdown();
+    return result;
+}
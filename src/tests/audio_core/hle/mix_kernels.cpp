@@ -0,0 +1,104 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <random>
+#include <catch2/catch.hpp>
+#include "audio_core/hle/mix_kernels.h"
+
+namespace AudioCore::HLE {
+
+namespace {
+
+/// Fills frames with random data, including values that saturate when mixed.
+struct MixKernelFixture {
+    std::mt19937 rng{0x3D5};
+
+    QuadFrame32 RandomQuad(s32 range) {
+        std::uniform_int_distribution<s32> dist(-range, range);
+        QuadFrame32 frame;
+        for (auto& sample : frame) {
+            for (auto& channel : sample) {
+                channel = dist(rng);
+            }
+        }
+        return frame;
+    }
+
+    StereoFrame16 RandomStereo() {
+        std::uniform_int_distribution<s32> dist(-32768, 32767);
+        StereoFrame16 frame;
+        for (auto& sample : frame) {
+            sample = {static_cast<s16>(dist(rng)), static_cast<s16>(dist(rng))};
+        }
+        return frame;
+    }
+
+    float RandomGain() {
+        return std::uniform_real_distribution<float>(-2.0f, 2.0f)(rng);
+    }
+};
+
+constexpr std::array<s32, 3> ranges{1000, 40000, 1 << 24};
+
+} // Anonymous namespace
+
+TEST_CASE_METHOD(MixKernelFixture, "MixKernels::DownmixStereoAndMix is bit-exact",
+                 "[audio_core][hle]") {
+    for (s32 range : ranges) {
+        const QuadFrame32 samples = RandomQuad(range);
+        const float gain = RandomGain();
+        StereoFrame16 expected = RandomStereo();
+        StereoFrame16 actual = expected;
+
+        MixKernels::Reference::DownmixStereoAndMix(expected, samples, gain);
+        MixKernels::DownmixStereoAndMix(actual, samples, gain);
+        REQUIRE(actual == expected);
+    }
+}
+
+TEST_CASE_METHOD(MixKernelFixture, "MixKernels::DownmixMonoAndMix is bit-exact",
+                 "[audio_core][hle]") {
+    for (s32 range : ranges) {
+        const QuadFrame32 samples = RandomQuad(range);
+        const float gain = RandomGain();
+        StereoFrame16 expected = RandomStereo();
+        StereoFrame16 actual = expected;
+
+        MixKernels::Reference::DownmixMonoAndMix(expected, samples, gain);
+        MixKernels::DownmixMonoAndMix(actual, samples, gain);
+        REQUIRE(actual == expected);
+    }
+}
+
+TEST_CASE_METHOD(MixKernelFixture, "MixKernels::MixStereoIntoQuad is bit-exact",
+                 "[audio_core][hle]") {
+    const StereoFrame16 samples = RandomStereo();
+    const std::array<float, 4> gains{RandomGain(), RandomGain(), RandomGain(), RandomGain()};
+    QuadFrame32 expected = RandomQuad(1 << 20);
+    QuadFrame32 actual = expected;
+
+    MixKernels::Reference::MixStereoIntoQuad(expected, samples, gains);
+    MixKernels::MixStereoIntoQuad(actual, samples, gains);
+    REQUIRE(actual == expected);
+}
+
+TEST_CASE_METHOD(MixKernelFixture, "MixKernels layout conversions round-trip",
+                 "[audio_core][hle]") {
+    const QuadFrame32 original = RandomQuad(1 << 30);
+
+    MixKernels::QuadFrame32ChannelMajor channel_major;
+    MixKernels::QuadToChannelMajor(channel_major, original);
+    for (std::size_t sample = 0; sample < samples_per_frame; sample++) {
+        for (std::size_t channel = 0; channel < 4; channel++) {
+            REQUIRE(channel_major[channel][sample] == original[sample][channel]);
+        }
+    }
+
+    QuadFrame32 round_trip;
+    MixKernels::ChannelMajorToQuad(round_trip, channel_major);
+    REQUIRE(round_trip == original);
+}
+
+} // namespace AudioCore::HLE
@@ -0,0 +1,62 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "audio_core/sample_ring.h"
+
+namespace AudioCore {
+
+TEST_CASE("SampleRing: Push and Pop preserve interleaved frames", "[audio_core]") {
+    SampleRing ring;
+    const std::array<s16, 6> in{1, -1, 2, -2, 3, -3};
+    REQUIRE(ring.Push(in.data(), 3) == 3);
+    REQUIRE(ring.Size() == 3);
+
+    std::array<s16, 6> out{};
+    REQUIRE(ring.Pop(out.data(), 3) == 3);
+    REQUIRE(out == in);
+    REQUIRE(ring.Size() == 0);
+    REQUIRE(ring.GetUnderrunCount() == 0);
+    REQUIRE(ring.GetOverrunCount() == 0);
+}
+
+TEST_CASE("SampleRing: Short pops are counted as underruns", "[audio_core]") {
+    SampleRing ring;
+    const std::array<s16, 4> in{1, 1, 2, 2};
+    ring.Push(in.data(), 2);
+
+    std::array<s16, 10> out{};
+    REQUIRE(ring.Pop(out.data(), 5) == 2);
+    REQUIRE(ring.GetUnderrunCount() == 1);
+    REQUIRE(ring.GetUnderrunFrames() == 3);
+}
+
+TEST_CASE("SampleRing: Pushes beyond capacity are counted as overruns", "[audio_core]") {
+    SampleRing ring;
+    std::vector<s16> in(2 * (SampleRing::capacity + 10), 7);
+    REQUIRE(ring.Push(in.data(), SampleRing::capacity + 10) == SampleRing::capacity);
+    REQUIRE(ring.GetOverrunCount() == 1);
+    REQUIRE(ring.GetOverrunFrames() == 10);
+}
+
+TEST_CASE("StagingBuffer: Frames dropped while staging are counted as overruns", "[audio_core]") {
+    SampleRing ring;
+    StagingBuffer staging;
+    std::vector<s16> in(2 * (SampleRing::capacity - 4), 5);
+    REQUIRE(staging.Stage(in.data(), SampleRing::capacity - 4, ring) == SampleRing::capacity - 4);
+    REQUIRE(ring.GetOverrunCount() == 0);
+
+    REQUIRE(staging.Stage(in.data(), 10, ring) == 4);
+    REQUIRE(staging.Size() == SampleRing::capacity);
+    REQUIRE(ring.GetOverrunCount() == 1);
+    REQUIRE(ring.GetOverrunFrames() == 6);
+
+    staging.Clear();
+    REQUIRE(staging.Stage(in.data(), 10, ring) == 10);
+    REQUIRE(ring.GetOverrunFrames() == 6);
+}
+
+} // namespace AudioCore
@@ -0,0 +1,44 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <string>
+#include <catch2/catch.hpp>
+#include "common/logging/backend.h"
+#include "common/logging/log.h"
+
+namespace Log {
+
+template <typename... Args>
+static std::string FormatThroughRecord(const char* format, const Args&... args) {
+    Detail::DeferredRecord record;
+    record.args_size = 0;
+    REQUIRE((Detail::EncodeArg(record, args) && ...));
+    return FormatDeferredMessage(format, record.args.data(), record.args_size);
+}
+
+TEST_CASE("Log: Deferred arguments format like immediate ones", "[common]") {
+    const std::string str = "string";
+    const char* c_str = "c_str";
+    const u8 small = 0xAB;
+    const s32 negative = -42;
+    const u64 big = 0xFEDCBA9876543210;
+
+    REQUIRE(FormatThroughRecord("{} {} {}", str, c_str, std::string_view("view")) ==
+            fmt::format("{} {} {}", str, c_str, std::string_view("view")));
+    REQUIRE(FormatThroughRecord("{:02X} {:08x} {}", small, negative, big) ==
+            fmt::format("{:02X} {:08x} {}", small, negative, big));
+    REQUIRE(FormatThroughRecord("{} {} {:.3f} {}", true, 'c', 1.25, 0.1f) ==
+            fmt::format("{} {} {:.3f} {}", true, 'c', 1.25, 0.1f));
+    REQUIRE(FormatThroughRecord("no arguments") == "no arguments");
+}
+
+TEST_CASE("Log: Oversized deferred arguments are rejected", "[common]") {
+    Detail::DeferredRecord record;
+    record.args_size = 0;
+    const std::string huge(Detail::DeferredRecord::ArgBufferSize, 'x');
+    REQUIRE_FALSE(Detail::EncodeArg(record, huge));
+    REQUIRE(record.args_size == 0);
+}
+
+} // namespace Log
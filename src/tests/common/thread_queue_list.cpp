@@ -0,0 +1,195 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <deque>
+#include <sstream>
+#include <vector>
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <catch2/catch.hpp>
+#include "common/thread_queue_list.h"
+
+namespace {
+
+constexpr unsigned int NUM_PRIORITIES = 64;
+using Queue = Common::ThreadQueueList<int, NUM_PRIORITIES>;
+
+/// The save state layout of the ready queue, which has to stay readable by older versions
+struct SavedLayout {
+    /// The first used level, then for each level the next used one (-2 ends, -1 is unused)
+    std::vector<s64> links;
+    /// The threads of each level
+    std::vector<std::deque<int>> levels;
+
+    template <class Archive>
+    void serialize(Archive& ar, const unsigned int) {
+        links.resize(NUM_PRIORITIES + 1);
+        levels.resize(NUM_PRIORITIES);
+        ar& links[0];
+        for (unsigned int i = 0; i < NUM_PRIORITIES; ++i) {
+            ar& links[i + 1];
+            ar& levels[i];
+        }
+    }
+};
+
+std::string Save(const Queue& queue) {
+    std::ostringstream stream;
+    boost::archive::binary_oarchive ar(stream);
+    ar << queue;
+    return stream.str();
+}
+
+} // Anonymous namespace
+
+TEST_CASE("ThreadQueueList pops the lowest priority level first", "[common]") {
+    Queue queue;
+    queue.prepare(10);
+    queue.prepare(40);
+    queue.prepare(63);
+
+    REQUIRE(queue.get_first() == 0);
+    REQUIRE(queue.pop_first() == 0);
+
+    queue.push_back(40, 1);
+    queue.push_back(63, 2);
+    queue.push_back(10, 3);
+    queue.push_back(10, 4);
+    queue.push_front(10, 5);
+
+    REQUIRE(queue.contains(2) == 63);
+    REQUIRE(queue.get_first() == 5);
+
+    // Nothing is better than level 10
+    REQUIRE(queue.pop_first_better(10) == 0);
+    REQUIRE(queue.pop_first_better(11) == 5);
+
+    queue.rotate(10);
+    REQUIRE(queue.pop_first() == 4);
+    REQUIRE(queue.pop_first() == 3);
+    REQUIRE(queue.empty(10));
+    REQUIRE(queue.pop_first() == 1);
+
+    queue.move(2, 63, 0);
+    REQUIRE(queue.empty(63));
+    REQUIRE(queue.pop_first() == 2);
+    REQUIRE(queue.pop_first() == 0);
+}
+
+TEST_CASE("ThreadQueueList grows and removes threads in the middle of a level", "[common]") {
+    Queue queue;
+    queue.prepare(20);
+    for (int i = 1; i <= 5; ++i) {
+        queue.push_back(20, i);
+    }
+    for (int i = 1; i <= 3; ++i) {
+        REQUIRE(queue.pop_first() == i);
+    }
+
+    // The contents wrap around the end of the buffer while it grows
+    for (int i = 6; i <= 100; ++i) {
+        queue.push_back(20, i);
+    }
+    for (int i = 4; i <= 100; i += 2) {
+        queue.remove(20, i);
+    }
+    for (int i = 5; i <= 100; i += 2) {
+        REQUIRE(queue.pop_first() == i);
+    }
+    REQUIRE(queue.empty(20));
+    REQUIRE(queue.pop_first() == 0);
+}
+
+TEST_CASE("ThreadQueueList keeps the save state layout", "[common]") {
+    Queue queue;
+    queue.prepare(5);
+    queue.prepare(2);
+    queue.prepare(30);
+    queue.push_back(5, 7);
+    queue.push_back(5, 8);
+    queue.push_back(30, 9);
+
+    SavedLayout layout;
+    {
+        std::istringstream stream(Save(queue));
+        boost::archive::binary_iarchive ar(stream);
+        ar >> layout;
+    }
+    REQUIRE(layout.links[0] == 2);
+    for (unsigned int i = 0; i < NUM_PRIORITIES; ++i) {
+        const s64 expected = i == 2 ? 5 : i == 5 ? 30 : i == 30 ? -2 : -1;
+        REQUIRE(layout.links[i + 1] == expected);
+    }
+    REQUIRE(layout.levels[5] == std::deque<int>{7, 8});
+    REQUIRE(layout.levels[30] == std::deque<int>{9});
+
+    Queue loaded;
+    {
+        std::istringstream stream(Save(queue));
+        boost::archive::binary_iarchive ar(stream);
+        ar >> loaded;
+    }
+    REQUIRE(Save(loaded) == Save(queue));
+    REQUIRE(loaded.pop_first() == 7);
+    REQUIRE(loaded.pop_first() == 8);
+    REQUIRE(loaded.pop_first() == 9);
+}
+
+namespace {
+
+/// The previous ready queue: a deque per level, walked in order to find the first thread
+struct DequeQueue {
+    std::array<std::deque<int>, NUM_PRIORITIES> levels;
+
+    void push_back(unsigned int priority, int thread) {
+        levels[priority].push_back(thread);
+    }
+    int pop_first() {
+        for (auto& level : levels) {
+            if (!level.empty()) {
+                const int thread = level.front();
+                level.pop_front();
+                return thread;
+            }
+        }
+        return 0;
+    }
+};
+
+/// Wakes and reschedules threads spread over the low-priority levels, like SVC-heavy titles do
+template <typename ReadyQueue>
+double MeasureChurn(ReadyQueue& queue) {
+    constexpr int NUM_THREADS = 32;
+    constexpr int NUM_ROUNDS = 200000;
+
+    for (int i = 1; i <= NUM_THREADS; ++i) {
+        queue.push_back(24 + i % 40, i);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    int checksum = 0;
+    for (int round = 0; round < NUM_ROUNDS; ++round) {
+        const int thread = queue.pop_first();
+        checksum += thread;
+        queue.push_back(24 + (thread + round) % 40, thread);
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    REQUIRE(checksum != 0);
+    return std::chrono::duration<double, std::nano>(elapsed).count() / NUM_ROUNDS;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("ThreadQueueList scheduling churn", "[.][benchmark]") {
+    Queue queue;
+    for (unsigned int i = 0; i < NUM_PRIORITIES; ++i) {
+        queue.prepare(i);
+    }
+    DequeQueue deque_queue;
+
+    const double deque_ns = MeasureChurn(deque_queue);
+    const double bitmap_ns = MeasureChurn(queue);
+    WARN("deque walk: " << deque_ns << " ns per pick, bitmap: " << bitmap_ns << " ns per pick");
+}
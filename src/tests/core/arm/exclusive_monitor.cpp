@@ -0,0 +1,54 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <thread>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "core/arm/exclusive_monitor.h"
+
+TEST_CASE("ExclusiveMonitor - Only one core stores", "[core][arm]") {
+    ExclusiveMonitor monitor(2);
+    u32 value = 0;
+    u32 loaded0 = 0;
+    u32 loaded1 = 0;
+
+    monitor.Load(0, 0x1004, [&] { loaded0 = value; });
+    monitor.Load(1, 0x1000, [&] { loaded1 = value; });
+    REQUIRE(monitor.Store(1, 0x1000, [&] { value = loaded1 + 1; }));
+    // The store of core 1 cleared the reservation of core 0 on the same granule
+    REQUIRE(!monitor.Store(0, 0x1004, [&] { value = loaded0 + 1; }));
+    REQUIRE(value == 1);
+
+    // A store needs a reservation on its own granule
+    monitor.Load(0, 0x1000, [] {});
+    REQUIRE(!monitor.Store(0, 0x1008, [] {}));
+    REQUIRE(!monitor.Store(0, 0x1000, [] {}));
+
+    monitor.Load(0, 0x1000, [] {});
+    monitor.Clear(0);
+    REQUIRE(!monitor.Store(0, 0x1000, [] {}));
+}
+
+TEST_CASE("ExclusiveMonitor - Increments from parallel cores", "[core][arm]") {
+    constexpr std::size_t NumCores = 4;
+    constexpr u32 Increments = 10000;
+    ExclusiveMonitor monitor(NumCores);
+    u32 counter = 0;
+
+    std::vector<std::thread> threads;
+    for (std::size_t core_id = 0; core_id < NumCores; ++core_id) {
+        threads.emplace_back([&, core_id] {
+            for (u32 i = 0; i < Increments; ++i) {
+                u32 loaded;
+                do {
+                    monitor.Load(core_id, 0x2000, [&] { loaded = counter; });
+                } while (!monitor.Store(core_id, 0x2000, [&] { counter = loaded + 1; }));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    REQUIRE(counter == NumCores * Increments);
+}
@@ -0,0 +1,172 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <map>
+#include <memory>
+#include <string>
+#include <catch2/catch.hpp>
+#include "common/file_util.h"
+#include "common/scope_exit.h"
+#include "core/arm/arm_interface.h"
+#include "core/arm/idle_loop_detector.h"
+#include "core/core.h"
+#include "core/settings.h"
+#include "tests/core/system_test_common.h"
+
+namespace {
+
+/// Polls a flag: ldr r1, [r0]; cmp r1, #0; beq 0x100
+const std::map<VAddr, u32> polling_loop{
+    {0x100, 0xE5901000},
+    {0x104, 0xE3510000},
+    {0x108, 0x0AFFFFFC},
+};
+
+/// Waits on a flag and clears it: ldr r1, [r0]; str r2, [r0]; cmp r1, #0; beq 0x200
+const std::map<VAddr, u32> storing_loop{
+    {0x200, 0xE5901000},
+    {0x204, 0xE5802000},
+    {0x208, 0xE3510000},
+    {0x20C, 0x0AFFFFFB},
+};
+
+IdleLoopDetector::CodeReader Reader(const std::map<VAddr, u32>& code) {
+    return [&code](VAddr addr) { return code.at(addr); };
+}
+
+/// Boots a program that polls a flag which is never set, and returns the idle loop hits of core 0
+u64 RunPollingProgram(const std::string& path) {
+    auto system = std::make_unique<Core::System>();
+    SystemTests::NullWindow window;
+    Core::System::SetCurrentInstance(system.get());
+
+    REQUIRE(system->Load(window, path) == Core::System::ResultStatus::Success);
+    for (u32 slice = 0; slice < 60; ++slice) {
+        REQUIRE(system->RunLoop() == Core::System::ResultStatus::Success);
+    }
+    const u64 hits = system->GetCore(0).GetIdleLoopDetector().GetHitCount();
+    system->Shutdown();
+
+    Core::System::SetCurrentInstance(nullptr);
+    return hits;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("IdleLoopDetector decodes short backward branches", "[core][arm]") {
+    REQUIRE(IdleLoopDetector::GetLoopStart(0x108, 0x0AFFFFFC) == 0x100u);
+    // b .
+    REQUIRE(IdleLoopDetector::GetLoopStart(0x108, 0xEAFFFFFE) == 0x108u);
+    // bl, blx, forward and far branches
+    REQUIRE(!IdleLoopDetector::GetLoopStart(0x108, 0x0BFFFFFC));
+    REQUIRE(!IdleLoopDetector::GetLoopStart(0x108, 0xFAFFFFFC));
+    REQUIRE(!IdleLoopDetector::GetLoopStart(0x108, 0x0A000000));
+    REQUIRE(!IdleLoopDetector::GetLoopStart(0x108, 0x0AFFFF00));
+    // Not a branch
+    REQUIRE(!IdleLoopDetector::GetLoopStart(0x108, 0xE3510000));
+
+    // ldr, ldm, ldrh, mul, movw and yield
+    for (const u32 inst : {0xE5901000, 0xE8900006, 0xE1D010B0, 0xE0020191, 0xE3000001,
+                           0xE320F001}) {
+        REQUIRE(IdleLoopDetector::IsSideEffectFree(inst));
+    }
+    // svc, str, strh, swp, sev, bx lr, mov pc, lr, ldr pc, ldm with pc and mcr
+    for (const u32 inst : {0xEF000028, 0xE5801000, 0xE1C010B0, 0xE1001091, 0xE320F004,
+                           0xE12FFF1E, 0xE1A0F00E, 0xE590F000, 0xE8908006, 0xEE070F15}) {
+        REQUIRE(!IdleLoopDetector::IsSideEffectFree(inst));
+    }
+}
+
+TEST_CASE("IdleLoopDetector only accepts loops without side effects", "[core][arm]") {
+    IdleLoopDetector detector;
+    REQUIRE(detector.IsCandidate(0x108, polling_loop.at(0x108), Reader(polling_loop)));
+    REQUIRE(!detector.IsCandidate(0x20C, storing_loop.at(0x20C), Reader(storing_loop)));
+    REQUIRE(detector.IsCandidate(0x300, 0xEAFFFFFE, Reader({})));
+
+    // The result is cached until the code is invalidated
+    std::map<VAddr, u32> modified = polling_loop;
+    modified[0x104] = 0xE5801000;
+    REQUIRE(detector.IsCandidate(0x108, modified.at(0x108), Reader(modified)));
+    detector.Invalidate();
+    REQUIRE(!detector.IsCandidate(0x108, modified.at(0x108), Reader(modified)));
+}
+
+TEST_CASE("IdleLoopDetector hits when an iteration changes nothing", "[core][arm]") {
+    IdleLoopDetector detector;
+    std::array<u32, 16> regs{};
+    regs[0] = 0x10000000;
+    regs[15] = 0x108;
+    constexpr u32 nzcv = 0x40000000;
+
+    REQUIRE(!detector.OnBranchTaken(0x108, 0x100, regs, nzcv, 100));
+    REQUIRE(detector.OnBranchTaken(0x108, 0x100, regs, nzcv, 103));
+    REQUIRE(detector.OnBranchTaken(0x108, 0x100, regs, nzcv, 106));
+    REQUIRE(detector.GetHitCount() == 2);
+
+    // A register changed during the iteration
+    regs[1] = 1;
+    REQUIRE(!detector.OnBranchTaken(0x108, 0x100, regs, nzcv, 109));
+    REQUIRE(detector.OnBranchTaken(0x108, 0x100, regs, nzcv, 112));
+
+    // Other code ran since the branch was last taken
+    REQUIRE(!detector.OnBranchTaken(0x108, 0x100, regs, nzcv, 200));
+    REQUIRE(!detector.OnBranchTaken(0x208, 0x200, regs, nzcv, 203));
+
+    // Flags are part of the state
+    REQUIRE(!detector.OnBranchTaken(0x208, 0x200, regs, 0, 206));
+    REQUIRE(detector.GetHitCount() == 3);
+}
+
+TEST_CASE("Idle loops are not skipped while cores run in parallel", "[core][arm]") {
+    const bool use_cpu_jit = Settings::values.use_cpu_jit;
+    const bool enable_cpu_multithread = Settings::values.enable_cpu_multithread;
+    const bool skip_idle_loops = Settings::values.skip_idle_loops;
+    const int cpu_clock_percentage = Settings::values.cpu_clock_percentage;
+    const bool is_new_3ds = Settings::values.is_new_3ds;
+    const bool use_null_renderer = Settings::values.use_null_renderer;
+    const bool use_hw_renderer = Settings::values.use_hw_renderer;
+    const std::string sink_id = Settings::values.sink_id;
+    SCOPE_EXIT({
+        Settings::values.use_cpu_jit = use_cpu_jit;
+        Settings::values.enable_cpu_multithread = enable_cpu_multithread;
+        Settings::values.skip_idle_loops = skip_idle_loops;
+        Settings::values.cpu_clock_percentage = cpu_clock_percentage;
+        Settings::values.is_new_3ds = is_new_3ds;
+        Settings::values.use_null_renderer = use_null_renderer;
+        Settings::values.use_hw_renderer = use_hw_renderer;
+        Settings::values.sink_id = sink_id;
+    });
+    Settings::values.use_cpu_jit = true;
+    Settings::values.skip_idle_loops = true;
+    Settings::values.cpu_clock_percentage = 100;
+    Settings::values.is_new_3ds = false;
+    Settings::values.use_null_renderer = true;
+    Settings::values.use_hw_renderer = false;
+    Settings::values.sink_id = "null";
+
+    const std::string path = "./idle_loop_detector_test.elf";
+    {
+        const auto elf = SystemTests::BuildProgram(
+            {
+                0xE59F0008, // ldr r0, =DATA_ADDRESS
+                0xE5901000, // loop: ldr r1, [r0]
+                0xE3510000, // cmp r1, #0
+                0x0AFFFFFC, // beq loop
+                SystemTests::DATA_ADDRESS,
+            },
+            {});
+        FileUtil::IOFile file(path, "wb");
+        file.WriteBytes(elf.data(), elf.size());
+    }
+    SCOPE_EXIT({ FileUtil::Delete(path); });
+
+    // Core 0 runs on the emulation thread
+    Settings::values.enable_cpu_multithread = false;
+    REQUIRE(RunPollingProgram(path) > 0);
+
+    // Core 0 runs on a thread of its own, as does every other core
+    Settings::values.enable_cpu_multithread = true;
+    REQUIRE(RunPollingProgram(path) == 0);
+}
@@ -0,0 +1,122 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <string>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "core/cheats/gateway_cheat.h"
+#include "core/cheats/gateway_program.h"
+
+namespace Cheats {
+
+using Opcode = GatewayProgram::Opcode;
+
+static GatewayProgram Compile(const std::vector<std::string>& code) {
+    std::vector<GatewayCheat::CheatLine> lines;
+    for (const auto& line : code) {
+        lines.emplace_back(line);
+    }
+    return GatewayProgram::Compile(lines);
+}
+
+TEST_CASE("GatewayProgram folds known offsets into addresses", "[core][cheats]") {
+    const auto program = Compile({
+        "00100000 00000001", // word[0x100000] = 1
+        "D3000000 00200000", // offset = 0x200000
+        "10000010 00000002", // half[0x200010] = 2
+        "B0000004 00000000", // offset = word[0x200004]
+        "20000000 00000003", // byte[offset] = 3
+        "D2000000 00000000", // offset = 0
+        "D5000000 12345678", // reg = 0x12345678
+        "D6000000 00300000", // word[0x300000] = reg, offset += 4
+        "D9000000 00300000", // reg = word[0x300004]
+    });
+    const auto& insts = program.GetInstructions();
+    REQUIRE(insts.size() == 10);
+    REQUIRE(insts[0].opcode == Opcode::Begin);
+
+    REQUIRE(insts[1].opcode == Opcode::Write32);
+    REQUIRE(insts[1].static_address);
+    REQUIRE(insts[1].address == 0x100000);
+
+    REQUIRE(insts[3].opcode == Opcode::Write16);
+    REQUIRE(insts[3].static_address);
+    REQUIRE(insts[3].address == 0x200010);
+
+    REQUIRE(insts[4].opcode == Opcode::LoadOffset);
+    REQUIRE(insts[4].static_address);
+    REQUIRE(insts[4].address == 0x200004);
+
+    REQUIRE(insts[5].opcode == Opcode::Write8);
+    REQUIRE(!insts[5].static_address);
+    REQUIRE(insts[5].address == 0);
+
+    REQUIRE(insts[8].opcode == Opcode::IncrementiveWrite32);
+    REQUIRE(insts[8].static_address);
+    REQUIRE(insts[8].address == 0x300000);
+
+    REQUIRE(insts[9].opcode == Opcode::Load32);
+    REQUIRE(insts[9].static_address);
+    REQUIRE(insts[9].address == 0x300004);
+}
+
+TEST_CASE("GatewayProgram forgets offsets changed in conditional blocks", "[core][cheats]") {
+    const auto program = Compile({
+        "50100000 00000001", // if word[0x100000] == 1
+        "DC000000 00000010", //   offset += 0x10
+        "D0000000 00000000", // endif
+        "00100000 00000001", // word[0x100000 + offset] = 1
+        "D2000000 00000000", // offset = 0
+        "50100000 00000001", // if word[0x100000] == 1
+        "00100004 00000002", //   word[0x100004] = 2
+        "D0000000 00000000", // endif
+        "00100008 00000003", // word[0x100008] = 3
+        "C0000000 00000002", // loop 2 times
+        "0010000C 00000004", //   word[0x10000C + offset] = 4
+        "DC000000 00000004", //   offset += 4
+        "D1000000 00000000", // endloop
+    });
+    const auto& insts = program.GetInstructions();
+    REQUIRE(insts.size() == 14);
+    REQUIRE(insts[1].static_address);
+    REQUIRE(!insts[4].static_address);
+    REQUIRE(insts[4].address == 0x100000);
+    REQUIRE(insts[6].static_address);
+    REQUIRE(insts[7].static_address);
+    REQUIRE(insts[7].address == 0x100004);
+    REQUIRE(insts[9].static_address);
+    REQUIRE(insts[9].address == 0x100008);
+    REQUIRE(insts[10].opcode == Opcode::Loop);
+    REQUIRE(!insts[11].static_address);
+}
+
+TEST_CASE("GatewayProgram extracts patch data", "[core][cheats]") {
+    const auto program = Compile({
+        "E0100000 0000000A", // copy 10 bytes to 0x100000
+        "11223344 55667788",
+        "99AABBCC DDEEFF00",
+        "XX invalid line",
+        "00100010 00000001",
+    });
+    const auto& insts = program.GetInstructions();
+    REQUIRE(insts.size() == 3);
+    REQUIRE(insts[1].opcode == Opcode::Patch);
+    REQUIRE(insts[1].address == 0x100000);
+    REQUIRE(insts[1].value == 10);
+    REQUIRE(insts[1].data_offset == 0);
+    REQUIRE(program.GetPatchData() == std::vector<u8>{0x44, 0x33, 0x22, 0x11, 0x88, 0x77, 0x66,
+                                                      0x55, 0xCC, 0xBB});
+    REQUIRE(insts[2].opcode == Opcode::Write32);
+
+    // Programs of several cheats keep their own patch data
+    GatewayProgram batch;
+    batch.Append(program);
+    batch.Append(program);
+    REQUIRE(batch.GetInstructions().size() == 6);
+    REQUIRE(batch.GetInstructions()[3].opcode == Opcode::Begin);
+    REQUIRE(batch.GetInstructions()[4].data_offset == 10);
+    REQUIRE(batch.GetPatchData().size() == 20);
+}
+
+} // namespace Cheats
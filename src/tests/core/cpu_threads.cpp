@@ -0,0 +1,197 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/file_util.h"
+#include "common/scope_exit.h"
+#include "core/core.h"
+#include "core/memory.h"
+#include "core/settings.h"
+#include "tests/core/system_test_common.h"
+
+namespace {
+
+constexpr u32 NUM_SLICES = 120;
+constexpr VAddr COUNTER_ADDRESS = SystemTests::DATA_ADDRESS;
+constexpr VAddr SHARED_COUNTER_ADDRESS = SystemTests::DATA_ADDRESS + 8;
+constexpr VAddr STACK_TOP = SystemTests::DATA_ADDRESS + SystemTests::DATA_SIZE;
+constexpr VAddr THREAD_ENTRY = SystemTests::CODE_ADDRESS + 0x20;
+
+/**
+ * Builds an ELF executable whose main thread starts a second thread on core 1. Each thread keeps
+ * incrementing a counter of its own and calls svcGetSystemTick in between, so that both cores
+ * call into the emulation thread while they run.
+ */
+std::vector<u8> BuildTwoCoreProgram() {
+    return SystemTests::BuildProgram(
+        {
+            0xE3A00030, // mov r0, #0x30 (priority)
+            0xE59F102C, // ldr r1, =THREAD_ENTRY
+            0xE3A02000, // mov r2, #0
+            0xE59F3028, // ldr r3, =STACK_TOP
+            0xE3A04001, // mov r4, #1 (processor id)
+            0xEF000008, // svc CreateThread
+            0xE59F6020, // ldr r6, =COUNTER_ADDRESS
+            0xEA000000, // b count
+            0xE59F601C, // thread: ldr r6, =COUNTER_ADDRESS + 4
+            0xE3A05000, // count: mov r5, #0
+            0xE2855001, // loop: add r5, r5, #1
+            0xE5865000, // str r5, [r6]
+            0xEF000028, // svc GetSystemTick
+            0xEAFFFFFB, // b loop
+            THREAD_ENTRY,
+            STACK_TOP,
+            COUNTER_ADDRESS,
+            COUNTER_ADDRESS + 4,
+        },
+        {});
+}
+
+/**
+ * Builds an ELF executable whose two threads, one per core, keep incrementing a shared counter with
+ * LDREX/STREX. Each thread also counts its successful increments in a counter of its own.
+ */
+std::vector<u8> BuildExclusiveProgram() {
+    return SystemTests::BuildProgram(
+        {
+            0xE3A00030, // mov r0, #0x30 (priority)
+            0xE59F1040, // ldr r1, =THREAD_ENTRY
+            0xE3A02000, // mov r2, #0
+            0xE59F303C, // ldr r3, =STACK_TOP
+            0xE3A04001, // mov r4, #1 (processor id)
+            0xEF000008, // svc CreateThread
+            0xE59F6034, // ldr r6, =COUNTER_ADDRESS
+            0xEA000000, // b count
+            0xE59F6030, // thread: ldr r6, =COUNTER_ADDRESS + 4
+            0xE59F7030, // count: ldr r7, =SHARED_COUNTER_ADDRESS
+            0xE3A05000, // mov r5, #0
+            0xE1971F9F, // loop: ldrex r1, [r7]
+            0xE2811001, // add r1, r1, #1
+            0xE1872F91, // strex r2, r1, [r7]
+            0xE3520000, // cmp r2, #0
+            0x1AFFFFFA, // bne loop
+            0xE2855001, // add r5, r5, #1
+            0xE5865000, // str r5, [r6]
+            0xEAFFFFF7, // b loop
+            THREAD_ENTRY,
+            STACK_TOP,
+            COUNTER_ADDRESS,
+            COUNTER_ADDRESS + 4,
+            SHARED_COUNTER_ADDRESS,
+        },
+        {});
+}
+
+struct RunResult {
+    Core::System::ResultStatus load_status = Core::System::ResultStatus::ErrorUnknown;
+    Core::System::ResultStatus run_status = Core::System::ResultStatus::ErrorUnknown;
+    std::array<u32, 2> counters{};
+    u32 shared_counter = 0;
+};
+
+RunResult RunProgram(const std::string& path) {
+    RunResult result;
+    auto system = std::make_unique<Core::System>();
+    SystemTests::NullWindow window;
+    Core::System::SetCurrentInstance(system.get());
+
+    result.load_status = system->Load(window, path);
+    if (result.load_status == Core::System::ResultStatus::Success) {
+        result.run_status = Core::System::ResultStatus::Success;
+        for (u32 slice = 0; slice < NUM_SLICES; ++slice) {
+            result.run_status = system->RunLoop();
+            if (result.run_status != Core::System::ResultStatus::Success) {
+                break;
+            }
+        }
+        result.counters[0] = system->Memory().Read32(COUNTER_ADDRESS);
+        result.counters[1] = system->Memory().Read32(COUNTER_ADDRESS + 4);
+        result.shared_counter = system->Memory().Read32(SHARED_COUNTER_ADDRESS);
+        system->Shutdown();
+    }
+
+    Core::System::SetCurrentInstance(nullptr);
+    return result;
+}
+
+/// Sets up a two core system with the null renderer, restoring the settings when it ends
+struct ParallelSettings {
+    ParallelSettings() {
+        Settings::values.use_cpu_jit = true;
+        Settings::values.enable_cpu_multithread = true;
+        Settings::values.cpu_clock_percentage = 100;
+        Settings::values.is_new_3ds = false;
+        Settings::values.use_null_renderer = true;
+        Settings::values.use_hw_renderer = false;
+        Settings::values.sink_id = "null";
+    }
+
+    ~ParallelSettings() {
+        Settings::values.use_cpu_jit = use_cpu_jit;
+        Settings::values.enable_cpu_multithread = enable_cpu_multithread;
+        Settings::values.cpu_clock_percentage = cpu_clock_percentage;
+        Settings::values.is_new_3ds = is_new_3ds;
+        Settings::values.use_null_renderer = use_null_renderer;
+        Settings::values.use_hw_renderer = use_hw_renderer;
+        Settings::values.sink_id = sink_id;
+    }
+
+    const bool use_cpu_jit = Settings::values.use_cpu_jit;
+    const bool enable_cpu_multithread = Settings::values.enable_cpu_multithread;
+    const int cpu_clock_percentage = Settings::values.cpu_clock_percentage;
+    const bool is_new_3ds = Settings::values.is_new_3ds;
+    const bool use_null_renderer = Settings::values.use_null_renderer;
+    const bool use_hw_renderer = Settings::values.use_hw_renderer;
+    const std::string sink_id = Settings::values.sink_id;
+};
+
+void WriteProgram(const std::string& path, const std::vector<u8>& elf) {
+    FileUtil::IOFile file(path, "wb");
+    file.WriteBytes(elf.data(), elf.size());
+}
+
+} // Anonymous namespace
+
+TEST_CASE("CPUThreads runs cores in parallel and deterministically", "[core]") {
+    ParallelSettings settings;
+
+    const std::string path = "./cpu_threads_test.elf";
+    WriteProgram(path, BuildTwoCoreProgram());
+    SCOPE_EXIT({ FileUtil::Delete(path); });
+
+    const RunResult first = RunProgram(path);
+    REQUIRE(first.load_status == Core::System::ResultStatus::Success);
+    REQUIRE(first.run_status == Core::System::ResultStatus::Success);
+    // Both cores ran their thread
+    REQUIRE(first.counters[0] != 0);
+    REQUIRE(first.counters[1] != 0);
+
+    // Every core counts ticks of its own, so the host scheduling of the cores does not matter
+    const RunResult second = RunProgram(path);
+    REQUIRE(second.run_status == Core::System::ResultStatus::Success);
+    REQUIRE(second.counters == first.counters);
+}
+
+TEST_CASE("CPUThreads keeps exclusive accesses exclusive across cores", "[core]") {
+    ParallelSettings settings;
+
+    const std::string path = "./cpu_threads_exclusive_test.elf";
+    WriteProgram(path, BuildExclusiveProgram());
+    SCOPE_EXIT({ FileUtil::Delete(path); });
+
+    const RunResult result = RunProgram(path);
+    REQUIRE(result.load_status == Core::System::ResultStatus::Success);
+    REQUIRE(result.run_status == Core::System::ResultStatus::Success);
+    REQUIRE(result.counters[0] != 0);
+    REQUIRE(result.counters[1] != 0);
+
+    // No increment is lost. A core may have stopped between its STREX and storing its own count.
+    const u32 increments = result.counters[0] + result.counters[1];
+    REQUIRE(result.shared_counter >= increments);
+    REQUIRE(result.shared_counter <= increments + 2);
+}
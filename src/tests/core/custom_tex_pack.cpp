@@ -0,0 +1,86 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/file_util.h"
+#include "core/custom_tex_cache.h"
+#include "core/custom_tex_pack.h"
+
+namespace Core {
+
+constexpr char PACK_PATH[] = "custom_tex_pack_test.pack";
+
+static CustomTexInfo MakeTexture(u32 width, u32 height, u8 seed) {
+    CustomTexInfo tex_info{width, height, std::vector<u8>(width * height * 4)};
+    for (std::size_t i = 0; i < tex_info.tex.size(); ++i) {
+        tex_info.tex[i] = static_cast<u8>(seed + i / 7);
+    }
+    return tex_info;
+}
+
+TEST_CASE("CustomTexPack round trip", "[core]") {
+    const auto texture_a = MakeTexture(16, 8, 1);
+    const auto texture_b = MakeTexture(4, 4, 2);
+    REQUIRE(CustomTexPack::Write(PACK_PATH, {CustomTexPack::CompressTexture(0xB, texture_b, 3),
+                                             CustomTexPack::CompressTexture(0xA, texture_a, 3)}));
+
+    {
+        CustomTexPack pack;
+        REQUIRE(pack.Open(PACK_PATH));
+        REQUIRE(pack.GetHashes() == std::vector<u64>{0xA, 0xB});
+        REQUIRE(pack.Contains(0xB));
+        REQUIRE(!pack.Contains(0xC));
+
+        CustomTexInfo tex_info;
+        REQUIRE(pack.ReadTexture(0xA, tex_info));
+        REQUIRE(tex_info.width == 16);
+        REQUIRE(tex_info.height == 8);
+        REQUIRE(tex_info.tex == texture_a.tex);
+        REQUIRE(pack.ReadTexture(0xB, tex_info));
+        REQUIRE(tex_info.tex == texture_b.tex);
+        REQUIRE(!pack.ReadTexture(0xC, tex_info));
+    }
+
+    // Packs cut short keep the textures that are still complete
+    const u64 size = FileUtil::GetSize(PACK_PATH);
+    {
+        FileUtil::IOFile file(PACK_PATH, "r+b");
+        REQUIRE(file.Resize(size - 1));
+    }
+    {
+        CustomTexPack pack;
+        REQUIRE(pack.Open(PACK_PATH));
+        REQUIRE(pack.GetHashes().size() == 1);
+    }
+
+    FileUtil::Delete(PACK_PATH);
+}
+
+TEST_CASE("CustomTexCache evicts the least recently used textures", "[core]") {
+    CustomTexCache cache;
+    const std::size_t texture_size = 4 * 4 * 4;
+    cache.SetMemoryBudget(texture_size * 2);
+
+    cache.CacheTexture(1, MakeTexture(4, 4, 1));
+    cache.CacheTexture(2, MakeTexture(4, 4, 2));
+    REQUIRE(cache.LookupTexture(1).tex[0] == 1);
+    cache.CacheTexture(3, MakeTexture(4, 4, 3));
+    REQUIRE(cache.IsTextureCached(1));
+    REQUIRE(!cache.IsTextureCached(2));
+    REQUIRE(cache.IsTextureCached(3));
+
+    // A texture larger than the budget is still kept on its own
+    cache.CacheTexture(4, MakeTexture(8, 8, 4));
+    REQUIRE(!cache.IsTextureCached(1));
+    REQUIRE(!cache.IsTextureCached(3));
+    REQUIRE(cache.IsTextureCached(4));
+
+    cache.SetMemoryBudget(0);
+    cache.CacheTexture(5, MakeTexture(8, 8, 5));
+    REQUIRE(cache.IsTextureCached(4));
+    REQUIRE(cache.IsTextureCached(5));
+}
+
+} // namespace Core
@@ -0,0 +1,43 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <future>
+#include <catch2/catch.hpp>
+#include "core/dumping/backend.h"
+
+namespace VideoDumper {
+
+TEST_CASE("FramePool reuses released buffers", "[core][dumping]") {
+    FramePool pool(2);
+
+    auto first = pool.Acquire(16);
+    REQUIRE(first->size() == 16);
+    const u8* first_data = first->data();
+    first.reset();
+
+    // The released buffer is handed out again, resized to the new size
+    auto second = pool.Acquire(8);
+    REQUIRE(second->data() == first_data);
+    REQUIRE(second->size() == 8);
+}
+
+TEST_CASE("FramePool waits while all the buffers are in use", "[core][dumping]") {
+    auto pool = std::make_unique<FramePool>(1);
+    auto buffer = pool->Acquire(4);
+
+    auto blocked_acquire = std::async(std::launch::async, [&pool] { return pool->Acquire(4); });
+    REQUIRE(blocked_acquire.wait_for(std::chrono::milliseconds(100)) ==
+            std::future_status::timeout);
+
+    buffer.reset();
+    auto acquired = blocked_acquire.get();
+    REQUIRE(acquired->size() == 4);
+
+    // Buffers can outlive their pool
+    pool.reset();
+    acquired.reset();
+}
+
+} // namespace VideoDumper
@@ -0,0 +1,111 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <map>
+#include <mutex>
+#include <catch2/catch.hpp>
+#include "core/dumping/image_dumper.h"
+#include "core/frontend/image_interface.h"
+
+namespace Core {
+
+namespace {
+
+class TestImageInterface : public Frontend::ImageInterface {
+public:
+    bool DecodePNG(std::vector<u8>& dst, u32& width, u32& height,
+                   const std::string& path) override {
+        return false;
+    }
+
+    bool EncodePNG(const std::string& path, const std::vector<u8>& src, u32 width,
+                   u32 height) override {
+        {
+            std::unique_lock lock{mutex};
+            release.wait(lock, [this] { return !blocked; });
+            written[path] = src;
+        }
+        return path != "fail";
+    }
+
+    void SetBlocked(bool blocked_) {
+        {
+            std::lock_guard lock{mutex};
+            blocked = blocked_;
+        }
+        release.notify_all();
+    }
+
+    std::mutex mutex;
+    std::condition_variable release;
+    bool blocked = false;
+    std::map<std::string, std::vector<u8>> written;
+};
+
+ImageDumper::Image MakeImage(std::string path, std::vector<u8> pixels, u32 width, u32 height) {
+    ImageDumper::Image image;
+    image.path = std::move(path);
+    image.pixels = std::move(pixels);
+    image.width = width;
+    image.height = height;
+    return image;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("ImageDumper converts and writes images", "[core][dumping]") {
+    auto image_interface = std::make_shared<TestImageInterface>();
+    ImageDumper dumper(image_interface, 2);
+
+    dumper.Queue(MakeImage("rgba", {1, 2, 3, 4, 5, 6, 7, 8}, 1, 2));
+
+    auto flipped = MakeImage("flipped", {1, 2, 3, 4, 5, 6, 7, 8}, 1, 2);
+    flipped.flip = true;
+    dumper.Queue(std::move(flipped));
+
+    auto bgrx = MakeImage("bgrx", {1, 2, 3, 4}, 1, 1);
+    bgrx.format = ImageDumper::PixelFormat::BGRX8;
+    dumper.Queue(std::move(bgrx));
+
+    std::atomic<int> results{0};
+    auto failing = MakeImage("fail", {0, 0, 0, 0}, 1, 1);
+    failing.callback = [&results](bool success) { results += success ? 1 : 10; };
+    dumper.Queue(std::move(failing));
+
+    dumper.Flush();
+    REQUIRE(image_interface->written.size() == 4);
+    REQUIRE(image_interface->written["rgba"] == std::vector<u8>{1, 2, 3, 4, 5, 6, 7, 8});
+    REQUIRE(image_interface->written["flipped"] == std::vector<u8>{5, 6, 7, 8, 1, 2, 3, 4});
+    REQUIRE(image_interface->written["bgrx"] == std::vector<u8>{3, 2, 1, 0xFF});
+    REQUIRE(results == 10);
+}
+
+TEST_CASE("ImageDumper applies backpressure and drains on destruction", "[core][dumping]") {
+    auto image_interface = std::make_shared<TestImageInterface>();
+    image_interface->SetBlocked(true);
+    {
+        ImageDumper dumper(image_interface, 1, 8);
+
+        // The writer takes the first image, then the queue fills up with the next two
+        dumper.Queue(MakeImage("a", std::vector<u8>(4), 1, 1));
+        dumper.Queue(MakeImage("b", std::vector<u8>(4), 1, 1));
+        dumper.Queue(MakeImage("c", std::vector<u8>(4), 1, 1));
+        auto blocked_queue = std::async(std::launch::async, [&dumper] {
+            dumper.Queue(MakeImage("d", std::vector<u8>(4), 1, 1));
+            dumper.Queue(MakeImage("e", std::vector<u8>(4), 1, 1));
+        });
+        REQUIRE(blocked_queue.wait_for(std::chrono::milliseconds(100)) ==
+                std::future_status::timeout);
+
+        image_interface->SetBlocked(false);
+        blocked_queue.get();
+    }
+    REQUIRE(image_interface->written.size() == 5);
+}
+
+} // namespace Core
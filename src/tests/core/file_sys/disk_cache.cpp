@@ -0,0 +1,166 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/file_util.h"
+#include "core/file_sys/disk_cache.h"
+
+namespace FileSys {
+
+namespace {
+
+constexpr std::size_t PageSize = CachedFile::PageSize;
+
+void WriteHostFile(const std::string& path, const std::vector<u8>& data) {
+    FileUtil::IOFile file(path, "wb");
+    file.WriteBytes(data.data(), data.size());
+}
+
+std::vector<u8> ReadHostFile(const std::string& path) {
+    FileUtil::IOFile file(path, "rb");
+    std::vector<u8> data(file.GetSize());
+    file.ReadBytes(data.data(), data.size());
+    return data;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("DiskCache - Write back", "[core][file_sys]") {
+    const std::string path = "./disk_cache_test";
+    std::vector<u8> contents(4 * PageSize);
+    std::iota(contents.begin(), contents.end(), u8{0});
+    WriteHostFile(path, contents);
+
+    auto disk_cache = std::make_shared<DiskCache>("test");
+    {
+        FileUtil::IOFile writer_file(path, "r+b");
+        FileUtil::IOFile reader_file(path, "rb");
+        auto writer = disk_cache->Open(path, writer_file.GetSize());
+        auto reader = disk_cache->Open(path, reader_file.GetSize());
+        REQUIRE(writer == reader);
+
+        const std::vector<u8> data(PageSize + 16, 0xAB);
+        REQUIRE(writer->Write(writer_file, PageSize - 8, data.size(), data.data()) == data.size());
+        REQUIRE(writer->HasDirtyPages());
+
+        // Another handle on the file sees the write before it reaches the host file
+        std::vector<u8> read(PageSize * 2);
+        REQUIRE(reader->Read(reader_file, PageSize - 16, 32, read.data()) == 32);
+        REQUIRE(read[7] == contents[PageSize - 9]);
+        REQUIRE(read[8] == 0xAB);
+        REQUIRE(ReadHostFile(path) == contents);
+
+        // Writing past the end grows the file, the gap reads as zeroes
+        const u8 last = 0xCD;
+        REQUIRE(writer->Write(writer_file, 6 * PageSize, 1, &last) == 1);
+        REQUIRE(reader->GetSize() == 6 * PageSize + 1);
+        REQUIRE(reader->Read(reader_file, 5 * PageSize, 2, read.data()) == 2);
+        REQUIRE(read[0] == 0);
+        REQUIRE(reader->Read(reader_file, 6 * PageSize, 2, read.data()) == 1);
+        REQUIRE(read[0] == 0xCD);
+
+        REQUIRE(writer->Flush(writer_file));
+        REQUIRE(!writer->HasDirtyPages());
+        writer_file.Flush();
+
+        std::vector<u8> expected = contents;
+        expected.resize(6 * PageSize + 1);
+        std::fill_n(expected.begin() + PageSize - 8, data.size(), 0xAB);
+        expected.back() = 0xCD;
+        REQUIRE(ReadHostFile(path) == expected);
+
+        // Shrinking drops the cached tail, growing again reads zeroes
+        REQUIRE(writer->SetSize(writer_file, PageSize + 4));
+        REQUIRE(writer->Write(writer_file, PageSize + 8, 1, &last) == 1);
+        REQUIRE(reader->Read(reader_file, PageSize, 9, read.data()) == 9);
+        REQUIRE(read[3] == 0xAB);
+        REQUIRE(read[4] == 0);
+        REQUIRE(read[8] == 0xCD);
+    }
+
+    FileUtil::Delete(path);
+}
+
+TEST_CASE("DiskCache - Shared across archives", "[core][file_sys]") {
+    const std::string path = "./disk_cache_test";
+    std::vector<u8> contents(2 * PageSize);
+    std::iota(contents.begin(), contents.end(), u8{0});
+    WriteHostFile(path, contents);
+
+    // Each archive has a DiskCache of its own, reopening an archive must not see stale pages
+    auto first_archive = std::make_shared<DiskCache>("first");
+    auto second_archive = std::make_shared<DiskCache>("second");
+    {
+        FileUtil::IOFile writer_file(path, "r+b");
+        FileUtil::IOFile reader_file(path, "rb");
+        auto writer = first_archive->Open(path, writer_file.GetSize());
+        auto reader = second_archive->Open(path, reader_file.GetSize());
+        REQUIRE(writer == reader);
+        // Save states keep the path, so that restored handles share the cache again
+        REQUIRE(writer->GetPath() == path);
+
+        std::vector<u8> read(PageSize);
+        REQUIRE(reader->Read(reader_file, 0, 16, read.data()) == 16);
+        const u8 value = 0xAB;
+        REQUIRE(writer->Write(writer_file, 4, 1, &value) == 1);
+        REQUIRE(writer->Write(writer_file, 3 * PageSize, 1, &value) == 1);
+        REQUIRE(reader->Read(reader_file, 0, 16, read.data()) == 16);
+        REQUIRE(read[4] == 0xAB);
+        REQUIRE(reader->GetSize() == 3 * PageSize + 1);
+
+        // A deleted path is no longer shared with the handles opened after it
+        second_archive->Detach(path);
+        REQUIRE(first_archive->Open(path, writer_file.GetSize()) != writer);
+    }
+
+    FileUtil::Delete(path);
+}
+
+TEST_CASE("DiskCache - Prefetch and direct transfers", "[core][file_sys]") {
+    const std::string path = "./disk_cache_test";
+    std::vector<u8> contents(128 * PageSize);
+    std::iota(contents.begin(), contents.end(), u8{0});
+    WriteHostFile(path, contents);
+
+    auto disk_cache = std::make_shared<DiskCache>("test");
+    {
+        FileUtil::IOFile file(path, "r+b");
+        auto cache = disk_cache->Open(path, file.GetSize());
+        const DiskCacheStats& stats = disk_cache->GetStats();
+
+        // Sequential reads are served by the pages loaded ahead of them
+        std::vector<u8> read(CachedFile::DirectTransferSize);
+        for (std::size_t offset = 0; offset < 32 * PageSize; offset += 0x200) {
+            REQUIRE(cache->Read(file, offset, 0x200, read.data()) == 0x200);
+            REQUIRE(std::equal(read.begin(), read.begin() + 0x200, contents.begin() + offset));
+        }
+        REQUIRE(stats.read_requests == 32 * PageSize / 0x200);
+        REQUIRE(stats.host_reads < 8);
+        REQUIRE(stats.prefetched_pages > 0);
+
+        // Large reads bypass the cache, but still see the dirty pages
+        const u8 value = 0xEE;
+        REQUIRE(cache->Write(file, 3 * PageSize, 1, &value) == 1);
+        const u64 host_writes = stats.host_writes;
+        REQUIRE(cache->Read(file, 0, read.size(), read.data()) == read.size());
+        REQUIRE(read[3 * PageSize] == 0xEE);
+        REQUIRE(read[3 * PageSize + 1] == contents[3 * PageSize + 1]);
+        REQUIRE(stats.host_writes == host_writes);
+
+        // Large writes go to the host file and update the cached pages
+        const std::vector<u8> data(CachedFile::DirectTransferSize, 0x11);
+        REQUIRE(cache->Write(file, 0, data.size(), data.data()) == data.size());
+        REQUIRE(stats.host_writes == host_writes + 1);
+        REQUIRE(cache->Read(file, 3 * PageSize, 1, read.data()) == 1);
+        REQUIRE(read[0] == 0x11);
+    }
+
+    FileUtil::Delete(path);
+}
+
+} // namespace FileSys
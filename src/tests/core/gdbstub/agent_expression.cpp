@@ -0,0 +1,47 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+#include "core/gdbstub/agent_expression.h"
+
+namespace GDBStub {
+
+static std::optional<u64> Evaluate(std::vector<u8> bytecode) {
+    const auto read_register = [](u32 id) -> u64 { return id * 0x10; };
+    const auto read_memory = [](VAddr addr, u32 size) -> std::optional<u64> {
+        if (addr != 0x1000) {
+            return std::nullopt;
+        }
+        return 0xFFEEDDCCBBAA9988 & (size == 8 ? ~u64{0} : (u64{1} << (size * 8)) - 1);
+    };
+    return AgentExpression(std::move(bytecode)).Evaluate(read_register, read_memory);
+}
+
+TEST_CASE("AgentExpression evaluates conditions", "[core][gdbstub]") {
+    // $r2 == 0x20
+    REQUIRE(Evaluate({0x26, 0x00, 0x02, 0x22, 0x20, 0x13, 0x27}) == 1);
+    // *(u16*)0x1000 < 0x9988, unsigned
+    REQUIRE(Evaluate({0x23, 0x10, 0x00, 0x18, 0x23, 0x99, 0x88, 0x15, 0x27}) == 0);
+    // (s8)*(u8*)0x1000 < 0, after sign extension
+    REQUIRE(Evaluate({0x23, 0x10, 0x00, 0x17, 0x16, 0x08, 0x22, 0x00, 0x14, 0x27}) == 1);
+    // Big endian immediates, and 7 - 2 * 3
+    REQUIRE(Evaluate({0x24, 0x12, 0x34, 0x56, 0x78, 0x27}) == 0x12345678);
+    REQUIRE(Evaluate({0x22, 0x07, 0x22, 0x02, 0x22, 0x03, 0x04, 0x03, 0x27}) == 1);
+    // if_goto skips the push of 5
+    REQUIRE(Evaluate({0x22, 0x01, 0x20, 0x00, 0x07, 0x22, 0x05, 0x22, 0x09, 0x27}) == 9);
+}
+
+TEST_CASE("AgentExpression fails on invalid expressions", "[core][gdbstub]") {
+    // Stack underflow, division by zero, unreadable memory and a missing end
+    REQUIRE(!Evaluate({0x02, 0x27}));
+    REQUIRE(!Evaluate({0x22, 0x01, 0x22, 0x00, 0x06, 0x27}));
+    REQUIRE(!Evaluate({0x22, 0x10, 0x19, 0x27}));
+    REQUIRE(!Evaluate({0x22, 0x01}));
+    // Floating point is not supported
+    REQUIRE(!Evaluate({0x22, 0x01, 0x1e, 0x27}));
+    // An infinite loop is stopped
+    REQUIRE(!Evaluate({0x21, 0x00, 0x00}));
+}
+
+} // namespace GDBStub
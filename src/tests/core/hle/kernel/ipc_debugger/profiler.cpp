@@ -0,0 +1,67 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <catch2/catch.hpp>
+#include "core/hle/kernel/ipc_debugger/profiler.h"
+
+using namespace std::chrono_literals;
+
+TEST_CASE("IPC LatencyHistogram buckets samples by power of two", "[core][kernel]") {
+    IPCDebugger::LatencyHistogram histogram;
+    histogram.Record(0ns);
+    histogram.Record(1ns);
+    histogram.Record(3ns);
+    histogram.Record(1000ns);
+    histogram.Record(10s);
+
+    REQUIRE(histogram.Count() == 5);
+    REQUIRE(histogram.TotalNs() == 10'000'001'004);
+    REQUIRE(histogram.MaxNs() == 10'000'000'000);
+    REQUIRE(histogram.BucketCount(0) == 2);
+    REQUIRE(histogram.BucketCount(1) == 1);
+    REQUIRE(histogram.BucketCount(9) == 1);
+    // Anything past the last bucket is clamped into it
+    REQUIRE(histogram.BucketCount(IPCDebugger::LatencyHistogram::NumBuckets - 1) == 1);
+
+    REQUIRE(histogram.PercentileNs(0.5) == 2);
+    REQUIRE(histogram.PercentileNs(0.8) == 1024);
+    REQUIRE(histogram.PercentileNs(1.0) == 10'000'000'000);
+
+    histogram.Reset();
+    REQUIRE(histogram.Count() == 0);
+    REQUIRE(histogram.PercentileNs(0.5) == 0);
+}
+
+TEST_CASE("IPC Profiler keys commands by service and header", "[core][kernel]") {
+    IPCDebugger::Profiler profiler;
+    REQUIRE(profiler.DumpJson() == R"({"services":[]})");
+
+    auto& open_file = profiler.GetCommandStats("fs:USER", 0x080201C2, "OpenFile");
+    auto& initialize = profiler.GetCommandStats("fs:USER", 0x08010002, "Initialize");
+    auto& gpu = profiler.GetCommandStats("gsp::Gpu", 0x00010082, "WriteHWRegs");
+    REQUIRE(&profiler.GetCommandStats("fs:USER", 0x080201C2, "OpenFile") == &open_file);
+    REQUIRE(open_file.microprofile_token == initialize.microprofile_token);
+
+    open_file.handler.Record(100ns);
+    open_file.handler.Record(300ns);
+    open_file.translate.Record(20ns);
+    gpu.sleep.Record(2us);
+
+    const std::string json = profiler.DumpJson();
+    REQUIRE(json.rfind(R"({"services":[{"name":"fs:USER","commands":[)", 0) == 0);
+    REQUIRE(json.find(R"({"header":"0x08010002","name":"Initialize","calls":0,)") !=
+            std::string::npos);
+    REQUIRE(json.find(R"({"header":"0x080201c2","name":"OpenFile","calls":2,)") !=
+            std::string::npos);
+    REQUIRE(json.find(R"("handler":{"count":2,"total_ns":400,"mean_ns":200,"max_ns":300,)") !=
+            std::string::npos);
+    REQUIRE(json.find(R"(]},{"name":"gsp::Gpu","commands":[)") != std::string::npos);
+    REQUIRE(json.find(R"("sleep":{"count":1,"total_ns":2000,)") != std::string::npos);
+    REQUIRE(json.substr(json.size() - 5) == "}]}]}");
+
+    profiler.Reset();
+    REQUIRE(open_file.handler.Count() == 0);
+    REQUIRE(&profiler.GetCommandStats("fs:USER", 0x080201C2, "OpenFile") == &open_file);
+}
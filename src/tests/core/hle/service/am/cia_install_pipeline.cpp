@@ -0,0 +1,141 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <string>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <cryptopp/aes.h>
+#include <cryptopp/modes.h>
+#include <cryptopp/sha.h>
+#include "common/file_util.h"
+#include "core/hle/service/am/cia_install_pipeline.h"
+
+using Service::AM::CIAInstallPipeline;
+
+namespace {
+
+constexpr char CIA_PATH[] = "cia_install_pipeline_test.cia";
+constexpr char PLAIN_OUTPUT_PATH[] = "cia_install_pipeline_test_0.app";
+constexpr char ENCRYPTED_OUTPUT_PATH[] = "cia_install_pipeline_test_1.app";
+
+constexpr std::array<u8, 16> KEY{0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+                                 0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF};
+constexpr std::array<u8, 16> IV{0x00, 0x01};
+
+std::vector<u8> MakeData(std::size_t size, u8 seed) {
+    std::vector<u8> data(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<u8>(i * 7 + seed);
+    }
+    return data;
+}
+
+std::array<u8, 0x20> Hash(const std::vector<u8>& data) {
+    std::array<u8, 0x20> hash;
+    CryptoPP::SHA256().CalculateDigest(hash.data(), data.data(), data.size());
+    return hash;
+}
+
+std::vector<u8> ReadAll(const std::string& path) {
+    FileUtil::IOFile file(path, "rb");
+    std::vector<u8> data(file.GetSize());
+    file.ReadBytes(data.data(), data.size());
+    return data;
+}
+
+/// Writes a fake CIA with a plain and an encrypted content, both spanning several blocks
+std::vector<CIAInstallPipeline::Content> MakeCIA(const std::vector<u8>& plain,
+                                                 const std::vector<u8>& secret) {
+    std::vector<u8> encrypted(secret.size());
+    CryptoPP::CBC_Mode<CryptoPP::AES>::Encryption encryption;
+    encryption.SetKeyWithIV(KEY.data(), KEY.size(), IV.data());
+    encryption.ProcessData(encrypted.data(), secret.data(), secret.size());
+
+    const std::vector<u8> header(0x40, 0xFF);
+    FileUtil::IOFile file(CIA_PATH, "wb");
+    file.WriteBytes(header.data(), header.size());
+    file.WriteBytes(plain.data(), plain.size());
+    file.WriteBytes(encrypted.data(), encrypted.size());
+
+    std::vector<CIAInstallPipeline::Content> contents(2);
+    contents[0].offset = header.size();
+    contents[0].size = plain.size();
+    contents[0].output_path = PLAIN_OUTPUT_PATH;
+    contents[0].hash = Hash(plain);
+    contents[1].offset = header.size() + plain.size();
+    contents[1].size = secret.size();
+    contents[1].output_path = ENCRYPTED_OUTPUT_PATH;
+    contents[1].key = KEY;
+    contents[1].iv = IV;
+    contents[1].hash = Hash(secret);
+    return contents;
+}
+
+void CleanUp() {
+    FileUtil::Delete(CIA_PATH);
+    FileUtil::Delete(PLAIN_OUTPUT_PATH);
+    FileUtil::Delete(ENCRYPTED_OUTPUT_PATH);
+}
+
+} // Anonymous namespace
+
+TEST_CASE("CIAInstallPipeline installs and decrypts contents", "[core][am]") {
+    const auto plain = MakeData(CIAInstallPipeline::BlockSize * 2 + 0x123, 1);
+    const auto secret = MakeData(CIAInstallPipeline::BlockSize * 3 + 0x40, 2);
+
+    CIAInstallPipeline pipeline(MakeCIA(plain, secret));
+    std::size_t last_written = 0;
+    std::size_t last_total = 0;
+    {
+        FileUtil::IOFile file(CIA_PATH, "rb");
+        const auto status = pipeline.Run(file, [&](std::size_t written, std::size_t total) {
+            last_written = written;
+            last_total = total;
+        });
+        REQUIRE(status == CIAInstallPipeline::Status::Success);
+    }
+
+    REQUIRE(ReadAll(PLAIN_OUTPUT_PATH) == plain);
+    REQUIRE(ReadAll(ENCRYPTED_OUTPUT_PATH) == secret);
+    REQUIRE(last_written == plain.size() + secret.size());
+    REQUIRE(last_total == plain.size() + secret.size());
+    REQUIRE(pipeline.GetStatistics().content_bytes == plain.size() + secret.size());
+
+    CleanUp();
+}
+
+TEST_CASE("CIAInstallPipeline installs contents that do not match the TMD hash", "[core][am]") {
+    const auto plain = MakeData(CIAInstallPipeline::BlockSize + 0x10, 3);
+    const auto secret = MakeData(0x1000, 4);
+
+    auto contents = MakeCIA(plain, secret);
+    contents[1].hash[0] ^= 1;
+
+    // The hashes were never enforced, so a mismatch is only logged
+    CIAInstallPipeline pipeline(std::move(contents));
+    {
+        FileUtil::IOFile file(CIA_PATH, "rb");
+        REQUIRE(pipeline.Run(file) == CIAInstallPipeline::Status::Success);
+    }
+    REQUIRE(ReadAll(ENCRYPTED_OUTPUT_PATH) == secret);
+
+    CleanUp();
+}
+
+TEST_CASE("CIAInstallPipeline reports truncated files", "[core][am]") {
+    const auto plain = MakeData(0x1000, 5);
+    const auto secret = MakeData(0x1000, 6);
+
+    auto contents = MakeCIA(plain, secret);
+    contents[1].size += CIAInstallPipeline::BlockSize;
+
+    CIAInstallPipeline pipeline(std::move(contents));
+    {
+        FileUtil::IOFile file(CIA_PATH, "rb");
+        REQUIRE(pipeline.Run(file) == CIAInstallPipeline::Status::ReadError);
+    }
+
+    CleanUp();
+}
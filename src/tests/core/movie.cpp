@@ -0,0 +1,99 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <catch2/catch.hpp>
+#include "common/file_util.h"
+#include "core/hle/service/hid/hid.h"
+#include "core/movie.h"
+
+namespace Core {
+
+namespace {
+
+/// Stands in for a save state of the system, of which the movie is the only part here
+std::vector<u8> SaveMovieState() {
+    std::ostringstream stream{std::ios_base::binary};
+    {
+        boost::archive::binary_oarchive ar(stream);
+        ar << Movie::GetInstance();
+    }
+    const std::string str = stream.str();
+    return {str.begin(), str.end()};
+}
+
+void LoadMovieState(const std::vector<u8>& state) {
+    std::istringstream stream{std::string{state.begin(), state.end()}, std::ios_base::binary};
+    boost::archive::binary_iarchive ar(stream);
+    ar >> Movie::GetInstance();
+}
+
+/// Records or plays back the input of a frame, returning the circle pad position
+s16 HandleFrame(s16 value) {
+    Service::HID::PadState pad_state{};
+    s16 circle_pad_x = value;
+    s16 circle_pad_y = -value;
+    Movie::GetInstance().HandlePadAndCircleStatus(pad_state, circle_pad_x, circle_pad_y);
+    Movie::GetInstance().HandleFrame();
+    REQUIRE(circle_pad_y == -circle_pad_x);
+    return circle_pad_x;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("Movie - Seekable movie round trip", "[core]") {
+    const std::string path = "./movie_test.ctm";
+    const std::string keyframe_path = path + ".keyframes";
+    constexpr u64 NumFrames = 3 * Movie::KeyframeInterval + 100;
+    Movie& movie = Movie::GetInstance();
+
+    movie.StartRecording(path);
+    REQUIRE(movie.IsRecordingInput());
+    for (u64 frame = 0; frame < NumFrames; ++frame) {
+        if (movie.IsKeyframeDue()) {
+            movie.RecordKeyframe(SaveMovieState);
+        }
+        HandleFrame(static_cast<s16>(frame));
+    }
+
+    // The keyframes wait on disk while recording, and are moved into the movie when it is saved
+    REQUIRE(FileUtil::GetSize(keyframe_path) > 0);
+    movie.Shutdown();
+    REQUIRE(!FileUtil::Exists(keyframe_path));
+
+    movie.StartPlayback(path);
+    REQUIRE(movie.IsPlayingInput());
+    for (u64 frame = 0; frame < 10; ++frame) {
+        REQUIRE(HandleFrame(0) == static_cast<s16>(frame));
+    }
+
+    // Seeking forward loads the last keyframe before the frame, then plays up to it
+    const u64 target = 2 * Movie::KeyframeInterval + 50;
+    movie.SeekToFrame(target, LoadMovieState);
+    REQUIRE(movie.GetCurrentFrame() == 2 * Movie::KeyframeInterval);
+    while (movie.GetCurrentFrame() < target) {
+        const u64 frame = movie.GetCurrentFrame();
+        REQUIRE(HandleFrame(0) == static_cast<s16>(frame));
+    }
+
+    // Seeking backward goes back to the first keyframe
+    movie.SeekToFrame(100, LoadMovieState);
+    REQUIRE(movie.GetCurrentFrame() == 0);
+    REQUIRE(HandleFrame(0) == 0);
+
+    // Seeking to a frame that is already between its keyframe and the frame keeps playing
+    movie.SeekToFrame(100, LoadMovieState);
+    REQUIRE(movie.GetCurrentFrame() == 1);
+    REQUIRE(HandleFrame(0) == 1);
+
+    movie.Shutdown();
+    REQUIRE(!movie.IsPlayingInput());
+    FileUtil::Delete(path);
+}
+
+} // namespace Core
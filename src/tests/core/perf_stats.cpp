@@ -0,0 +1,136 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/file_util.h"
+#include "common/string_util.h"
+#include "core/perf_stats.h"
+
+namespace Core {
+
+namespace {
+
+constexpr char BREAKDOWN_PATH[] = "perf_stats_test_breakdown.txt";
+constexpr char ROLLED_BREAKDOWN_PATH[] = "perf_stats_test_breakdown.txt.1";
+
+using BreakdownLine = std::map<std::string, std::string>;
+
+/// Parses the key=value pairs of each line of a breakdown file
+std::vector<BreakdownLine> ReadBreakdown(const std::string& path) {
+    std::string text;
+    FileUtil::ReadFileToString(true, path, text);
+    std::vector<std::string> lines;
+    Common::SplitString(text, '\n', lines);
+
+    std::vector<BreakdownLine> result;
+    for (const std::string& line : lines) {
+        std::vector<std::string> pairs;
+        Common::SplitString(line, ' ', pairs);
+        BreakdownLine& values = result.emplace_back();
+        for (const std::string& pair : pairs) {
+            const std::size_t equals = pair.find('=');
+            REQUIRE(equals != std::string::npos);
+            values.emplace(pair.substr(0, equals), pair.substr(equals + 1));
+        }
+    }
+    return result;
+}
+
+/// Ends the current system frame and begins the next one, which writes the ended frame
+void NextFrame(PerfStats& stats) {
+    stats.EndSystemFrame();
+    stats.BeginSystemFrame();
+}
+
+} // Anonymous namespace
+
+TEST_CASE("PerfStats - Writes the frame breakdown", "[core]") {
+    FileUtil::Delete(BREAKDOWN_PATH);
+    {
+        PerfStats stats(0);
+        REQUIRE(!stats.IsBreakdownEnabled());
+        stats.StartFrameBreakdown(BREAKDOWN_PATH);
+        REQUIRE(stats.IsBreakdownEnabled());
+
+        stats.BeginSystemFrame();
+        stats.AddCategoryTime(PerfCategory::Cpu, std::chrono::microseconds(3000));
+        stats.AddCategoryTime(PerfCategory::Idle, std::chrono::microseconds(2000));
+        stats.AddCategoryTime(PerfCategory::Idle, std::chrono::microseconds(500));
+        stats.AddCounter(PerfCounter::PicaDraws, 5);
+        stats.AddCounter(PerfCounter::HostDraws, 2);
+        NextFrame(stats);
+        stats.AddCounter(PerfCounter::PicaDraws, 1);
+        NextFrame(stats);
+        NextFrame(stats);
+    }
+
+    const std::vector<BreakdownLine> lines = ReadBreakdown(BREAKDOWN_PATH);
+    REQUIRE(lines.size() == 3);
+    for (const BreakdownLine& line : lines) {
+        for (const char* key : {"interval_us", "frametime_us", "cpu_us", "hle_us", "gpu_us",
+                                "rasterizer_us", "audio_us", "present_us", "idle_us",
+                                "limiter_us", "pica_draws", "host_draws"}) {
+            REQUIRE(line.count(key) == 1);
+        }
+    }
+
+    REQUIRE(lines[0].at("frame") == "0");
+    REQUIRE(lines[0].at("cpu_us") == "3000");
+    REQUIRE(lines[0].at("idle_us") == "2500");
+    REQUIRE(lines[0].at("hle_us") == "0");
+    REQUIRE(lines[0].at("pica_draws") == "5");
+    REQUIRE(lines[0].at("host_draws") == "2");
+
+    // Times and counters are reset after each line
+    REQUIRE(lines[1].at("frame") == "1");
+    REQUIRE(lines[1].at("cpu_us") == "0");
+    REQUIRE(lines[1].at("idle_us") == "0");
+    REQUIRE(lines[1].at("pica_draws") == "1");
+    REQUIRE(lines[1].at("host_draws") == "0");
+
+    REQUIRE(lines[2].at("frame") == "2");
+    REQUIRE(lines[2].at("pica_draws") == "0");
+
+    FileUtil::Delete(BREAKDOWN_PATH);
+}
+
+TEST_CASE("PerfStats - Rolls the frame breakdown file over", "[core]") {
+    REQUIRE(PerfStats::MaxBreakdownFileSize == 64 * 1024 * 1024);
+
+    FileUtil::Delete(BREAKDOWN_PATH);
+    FileUtil::Delete(ROLLED_BREAKDOWN_PATH);
+    {
+        // A line is longer than half of this, so every second line rolls the file over
+        constexpr u64 MaxFileSize = 200;
+        PerfStats stats(0);
+        stats.StartFrameBreakdown(BREAKDOWN_PATH, MaxFileSize);
+        stats.BeginSystemFrame();
+        for (int i = 0; i < 3; ++i) {
+            NextFrame(stats);
+        }
+        REQUIRE(FileUtil::Exists(ROLLED_BREAKDOWN_PATH));
+        const std::vector<BreakdownLine> rolled = ReadBreakdown(ROLLED_BREAKDOWN_PATH);
+        REQUIRE(rolled.size() == 2);
+        REQUIRE(rolled[0].at("frame") == "0");
+        REQUIRE(rolled[1].at("frame") == "1");
+
+        // The next rollover replaces the previous file
+        NextFrame(stats);
+    }
+
+    const std::vector<BreakdownLine> rolled = ReadBreakdown(ROLLED_BREAKDOWN_PATH);
+    REQUIRE(rolled.size() == 2);
+    REQUIRE(rolled[0].at("frame") == "2");
+    REQUIRE(rolled[1].at("frame") == "3");
+    REQUIRE(ReadBreakdown(BREAKDOWN_PATH).empty());
+
+    FileUtil::Delete(BREAKDOWN_PATH);
+    FileUtil::Delete(ROLLED_BREAKDOWN_PATH);
+}
+
+} // namespace Core
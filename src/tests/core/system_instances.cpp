@@ -0,0 +1,359 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/file_util.h"
+#include "common/scope_exit.h"
+#include "core/core.h"
+#include "core/frontend/emu_window.h"
+#include "core/hw/gpu.h"
+#include "core/hw/hw.h"
+#include "core/hw/lcd.h"
+#include "core/memory.h"
+#include "core/settings.h"
+#include "tests/core/system_test_common.h"
+#include "video_core/pica_state.h"
+#include "video_core/renderer_base.h"
+#include "video_core/swrasterizer/framebuffer.h"
+
+namespace {
+
+constexpr std::size_t NUM_INSTANCES = 4;
+constexpr u32 NUM_ITERATIONS = 2000;
+constexpr u32 NUM_FRAMES = 60;
+
+constexpr u32 GPU_FB_ADDRESS =
+    HW::VADDR_GPU + 4 * GPU_REG_INDEX(framebuffer_config[0].address_left1);
+constexpr u32 LCD_BACKLIGHT = HW::VADDR_LCD + 4 * LCD_REG_INDEX(backlight_top);
+constexpr u32 LCD_COLOR_FILL = HW::VADDR_LCD + 4 * LCD_REG_INDEX(color_fill_top);
+
+constexpr u32 NUM_SLICES = 120;
+constexpr VAddr TAG_ADDRESS = SystemTests::RODATA_ADDRESS;
+constexpr VAddr COUNTER_ADDRESS = SystemTests::DATA_ADDRESS;
+
+/// Writes a value derived from the instance id through each per-instance register file, then
+/// checks that no other instance overwrote it.
+void Exercise(Core::System& system, u32 id, std::atomic<u32>& errors) {
+    Core::System::SetCurrentInstance(&system);
+
+    if (&Core::System::GetInstance() != &system || &Pica::GetState() != &system.PicaState() ||
+        &GPU::GetState() != &system.GPUState() || &LCD::GetRegs() != &system.LCDRegs()) {
+        ++errors;
+    }
+
+    for (u32 i = 0; i < NUM_ITERATIONS; ++i) {
+        const u32 value = (id << 24) | i;
+
+        GPU::Write<u32>(GPU_FB_ADDRESS, value);
+        LCD::Write<u32>(LCD_BACKLIGHT, value);
+        Pica::GetState().regs.reg_array[0x100] = value;
+        std::this_thread::yield();
+
+        u32 gpu_value = 0;
+        u32 lcd_value = 0;
+        GPU::Read<u32>(gpu_value, GPU_FB_ADDRESS);
+        LCD::Read<u32>(lcd_value, LCD_BACKLIGHT);
+        if (gpu_value != value || lcd_value != value ||
+            Pica::GetState().regs.reg_array[0x100] != value) {
+            ++errors;
+        }
+    }
+
+    Core::System::SetCurrentInstance(nullptr);
+}
+
+/// Blocks the threads of the instances until all of them reach it
+class Barrier {
+public:
+    explicit Barrier(std::size_t count) : count(count) {}
+
+    void Wait() {
+        std::unique_lock lock(mutex);
+        const std::size_t current_generation = generation;
+        if (++waiting == count) {
+            waiting = 0;
+            ++generation;
+            cv.notify_all();
+        } else {
+            cv.wait(lock, [&] { return generation != current_generation; });
+        }
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::size_t count;
+    std::size_t waiting = 0;
+    std::size_t generation = 0;
+};
+
+/**
+ * Runs frames in lockstep with the other instances. Each frame sets up the screen and the PICA
+ * framebuffer of the instance and draws to it with the software rasterizer. Once every instance
+ * has done so, each one checks that its state is still that of its own frame.
+ */
+void RunFrames(Core::System& system, u32 id, Barrier& barrier, std::atomic<u32>& errors) {
+    Core::System::SetCurrentInstance(&system);
+
+    // Each instance draws in its own format and size
+    constexpr u32 width = 16;
+    const u32 height = 8 * (id + 1);
+    using ColorFormat = Pica::FramebufferRegs::ColorFormat;
+    const ColorFormat format = id % 2 == 0 ? ColorFormat::RGBA8 : ColorFormat::RGB8;
+    std::vector<u8> color_buffer(width * height * 4);
+
+    for (u32 frame = 0; frame < NUM_FRAMES; ++frame) {
+        const u32 value = (id << 24) | frame;
+        const Common::Vec4<u8> color{static_cast<u8>(id), static_cast<u8>(frame), 0x80, 0xFF};
+
+        GPU::Write<u32>(GPU_FB_ADDRESS, value);
+        LCD::Write<u32>(LCD_COLOR_FILL, value & 0xFFFFFF);
+
+        auto& framebuffer_regs = Pica::GetState().regs.framebuffer;
+        framebuffer_regs.framebuffer.width.Assign(width);
+        framebuffer_regs.framebuffer.height.Assign(height - 1);
+        framebuffer_regs.framebuffer.color_format.Assign(format);
+        const Pica::Rasterizer::FramebufferTarget target{framebuffer_regs, color_buffer.data(),
+                                                         nullptr};
+        for (u32 y = 0; y < height; ++y) {
+            for (u32 x = 0; x < width; ++x) {
+                Pica::Rasterizer::DrawPixel(target, x, y, color);
+            }
+        }
+
+        barrier.Wait();
+
+        u32 gpu_value = 0;
+        u32 lcd_value = 0;
+        GPU::Read<u32>(gpu_value, GPU_FB_ADDRESS);
+        LCD::Read<u32>(lcd_value, LCD_COLOR_FILL);
+        if (gpu_value != value || lcd_value != (value & 0xFFFFFF) ||
+            framebuffer_regs.framebuffer.height != height - 1 ||
+            framebuffer_regs.framebuffer.color_format != format) {
+            ++errors;
+        }
+        for (u32 y = 0; y < height; ++y) {
+            for (u32 x = 0; x < width; ++x) {
+                const auto pixel = Pica::Rasterizer::GetPixel(target, x, y);
+                if (pixel.x != color.x || pixel.y != color.y || pixel.z != color.z ||
+                    pixel.w != color.w) {
+                    ++errors;
+                }
+            }
+        }
+
+        barrier.Wait();
+    }
+
+    Core::System::SetCurrentInstance(nullptr);
+}
+
+/**
+ * Builds an ELF executable that keeps adding increment to a counter in its data segment. Its
+ * read-only data segment holds the tag.
+ */
+std::vector<u8> BuildCounterProgram(u8 increment, u32 tag) {
+    return SystemTests::BuildProgram(
+        {
+            0xE3A00000,             // mov r0, #0
+            0xE59F1008,             // ldr r1, =COUNTER_ADDRESS
+            0xE2800000 | increment, // loop: add r0, r0, #increment
+            0xE5810000,             // str r0, [r1]
+            0xEAFFFFFC,             // b loop
+            COUNTER_ADDRESS,
+        },
+        {tag});
+}
+
+struct RunResult {
+    Core::System::ResultStatus load_status = Core::System::ResultStatus::ErrorUnknown;
+    Core::System::ResultStatus run_status = Core::System::ResultStatus::ErrorUnknown;
+    u32 counter = 0;
+    u32 tag = 0;
+    int frames = 0;
+};
+
+/**
+ * Boots the program in the instance, then runs it in lockstep with the other instances. Booting and
+ * shutting down are serialized, as they set up process-wide state like the AES keys and the input
+ * factories.
+ */
+void BootAndRun(Core::System& system, Frontend::EmuWindow& window, const std::string& path,
+                std::mutex& boot_mutex, Barrier& barrier, RunResult& result) {
+    Core::System::SetCurrentInstance(&system);
+
+    {
+        std::lock_guard lock{boot_mutex};
+        result.load_status = system.Load(window, path);
+    }
+    barrier.Wait();
+
+    if (result.load_status == Core::System::ResultStatus::Success) {
+        result.run_status = Core::System::ResultStatus::Success;
+        for (u32 slice = 0; slice < NUM_SLICES; ++slice) {
+            result.run_status = system.RunLoop();
+            if (result.run_status != Core::System::ResultStatus::Success) {
+                break;
+            }
+        }
+        result.counter = system.Memory().Read32(COUNTER_ADDRESS);
+        result.tag = system.Memory().Read32(TAG_ADDRESS);
+        result.frames = system.Renderer().GetCurrentFrame();
+
+        std::lock_guard lock{boot_mutex};
+        system.Shutdown();
+    }
+
+    Core::System::SetCurrentInstance(nullptr);
+}
+
+} // Anonymous namespace
+
+TEST_CASE("System instances are bound per thread", "[core]") {
+    Core::System& default_instance = Core::System::GetInstance();
+    auto system = std::make_unique<Core::System>();
+
+    Core::System::SetCurrentInstance(system.get());
+    REQUIRE(&Core::System::GetInstance() == system.get());
+    REQUIRE(&Pica::GetState() == &system->PicaState());
+
+    Core::System* seen_by_other_thread = nullptr;
+    std::thread([&] { seen_by_other_thread = &Core::System::GetInstance(); }).join();
+    REQUIRE(seen_by_other_thread == &default_instance);
+
+    Core::System::SetCurrentInstance(nullptr);
+    REQUIRE(&Core::System::GetInstance() == &default_instance);
+}
+
+TEST_CASE("System instances keep independent MMIO and PICA state", "[core]") {
+    std::array<std::unique_ptr<Core::System>, NUM_INSTANCES> systems;
+    for (auto& system : systems) {
+        system = std::make_unique<Core::System>();
+    }
+
+    std::atomic<u32> errors{0};
+    std::vector<std::thread> threads;
+    for (u32 id = 0; id < NUM_INSTANCES; ++id) {
+        threads.emplace_back([&, id] { Exercise(*systems[id], id, errors); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    REQUIRE(errors == 0);
+
+    for (u32 id = 0; id < NUM_INSTANCES; ++id) {
+        const u32 expected = (id << 24) | (NUM_ITERATIONS - 1);
+        REQUIRE(systems[id]->GPUState().regs.framebuffer_config[0].address_left1 == expected);
+        REQUIRE(systems[id]->LCDRegs().backlight_top == expected);
+        REQUIRE(systems[id]->PicaState().regs.reg_array[0x100] == expected);
+    }
+}
+
+TEST_CASE("System instances keep their state separate across frames", "[core]") {
+    constexpr u32 num_instances = 2;
+    std::array<std::unique_ptr<Core::System>, num_instances> systems;
+    for (auto& system : systems) {
+        system = std::make_unique<Core::System>();
+    }
+
+    Barrier barrier(num_instances);
+    std::atomic<u32> errors{0};
+    std::vector<std::thread> threads;
+    for (u32 id = 0; id < num_instances; ++id) {
+        threads.emplace_back([&, id] { RunFrames(*systems[id], id, barrier, errors); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    REQUIRE(errors == 0);
+
+    for (u32 id = 0; id < num_instances; ++id) {
+        const u32 expected = (id << 24) | (NUM_FRAMES - 1);
+        REQUIRE(systems[id]->GPUState().regs.framebuffer_config[0].address_left1 == expected);
+        REQUIRE(systems[id]->LCDRegs().color_fill_top.raw == (expected & 0xFFFFFF));
+        REQUIRE(systems[id]->PicaState().regs.framebuffer.framebuffer.height == 8 * (id + 1) - 1);
+    }
+}
+
+TEST_CASE("System instances boot and run programs side by side", "[core]") {
+    const bool use_cpu_jit = Settings::values.use_cpu_jit;
+    const int cpu_clock_percentage = Settings::values.cpu_clock_percentage;
+    const bool is_new_3ds = Settings::values.is_new_3ds;
+    const bool use_null_renderer = Settings::values.use_null_renderer;
+    const bool use_hw_renderer = Settings::values.use_hw_renderer;
+    const std::string sink_id = Settings::values.sink_id;
+    SCOPE_EXIT({
+        Settings::values.use_cpu_jit = use_cpu_jit;
+        Settings::values.cpu_clock_percentage = cpu_clock_percentage;
+        Settings::values.is_new_3ds = is_new_3ds;
+        Settings::values.use_null_renderer = use_null_renderer;
+        Settings::values.use_hw_renderer = use_hw_renderer;
+        Settings::values.sink_id = sink_id;
+    });
+    // The interpreter's translation cache is shared by all instances, so they need the JIT
+    Settings::values.use_cpu_jit = true;
+    Settings::values.cpu_clock_percentage = 100;
+    Settings::values.is_new_3ds = false;
+    Settings::values.use_null_renderer = true;
+    Settings::values.use_hw_renderer = false;
+    Settings::values.sink_id = "null";
+
+    constexpr u32 num_instances = 2;
+    constexpr std::array<u8, num_instances> increments{3, 5};
+    constexpr std::array<u32, num_instances> tags{0xC0DE0000, 0xC0DE0001};
+
+    std::array<std::string, num_instances> paths;
+    for (u32 id = 0; id < num_instances; ++id) {
+        paths[id] = "./system_instances_test_" + std::to_string(id) + ".elf";
+        const auto elf = BuildCounterProgram(increments[id], tags[id]);
+        FileUtil::IOFile file(paths[id], "wb");
+        file.WriteBytes(elf.data(), elf.size());
+    }
+    SCOPE_EXIT({
+        for (const auto& path : paths) {
+            FileUtil::Delete(path);
+        }
+    });
+
+    // Windows register their touch device when they are created, so create them up front
+    std::array<std::unique_ptr<Core::System>, num_instances> systems;
+    std::array<std::unique_ptr<SystemTests::NullWindow>, num_instances> windows;
+    for (u32 id = 0; id < num_instances; ++id) {
+        systems[id] = std::make_unique<Core::System>();
+        windows[id] = std::make_unique<SystemTests::NullWindow>();
+    }
+
+    std::mutex boot_mutex;
+    Barrier barrier(num_instances);
+    std::array<RunResult, num_instances> results;
+    std::vector<std::thread> threads;
+    for (u32 id = 0; id < num_instances; ++id) {
+        threads.emplace_back([&, id] {
+            BootAndRun(*systems[id], *windows[id], paths[id], boot_mutex, barrier, results[id]);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (u32 id = 0; id < num_instances; ++id) {
+        const RunResult& result = results[id];
+        REQUIRE(result.load_status == Core::System::ResultStatus::Success);
+        REQUIRE(result.run_status == Core::System::ResultStatus::Success);
+        // Each instance ran its own program on its own memory
+        REQUIRE(result.tag == tags[id]);
+        REQUIRE(result.counter != 0);
+        REQUIRE(result.counter % increments[id] == 0);
+        // and went through vblanks on its own timing and renderer
+        REQUIRE(result.frames > 0);
+    }
+}
@@ -0,0 +1,69 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <cstring>
+#include "tests/core/system_test_common.h"
+
+namespace SystemTests {
+
+std::vector<u8> BuildProgram(const std::vector<u32>& code, const std::vector<u32>& rodata) {
+    constexpr std::size_t code_offset = 0x100;
+    const std::size_t rodata_offset = code_offset + code.size() * 4;
+    std::vector<u8> elf(rodata_offset + rodata.size() * 4);
+    const auto write = [&elf](std::size_t offset, u32 value, std::size_t size = 4) {
+        std::memcpy(&elf[offset], &value, size);
+    };
+
+    // ELF header: 32-bit little-endian ARM executable with three program headers
+    write(0x00, 0x464C457F);
+    write(0x04, 0x00010101);
+    write(0x10, 2, 2);  // e_type: ET_EXEC
+    write(0x12, 40, 2); // e_machine: ARM
+    write(0x14, 1);     // e_version
+    write(0x18, CODE_ADDRESS);
+    write(0x1C, 0x34);    // e_phoff
+    write(0x28, 0x34, 2); // e_ehsize
+    write(0x2A, 0x20, 2); // e_phentsize
+    write(0x2C, 3, 2);    // e_phnum
+    write(0x2E, 0x28, 2); // e_shentsize
+
+    // Code (R+X), read-only data (R) and data (R+W) segments. The data has no bytes in the file.
+    struct Segment {
+        u32 offset;
+        VAddr address;
+        u32 file_size;
+        u32 memory_size;
+        u32 flags;
+    };
+    const auto code_size = static_cast<u32>(code.size() * 4);
+    const auto rodata_size = static_cast<u32>(rodata.size() * 4);
+    const std::array<Segment, 3> segments{{
+        {code_offset, CODE_ADDRESS, code_size, code_size, 5},
+        {static_cast<u32>(rodata_offset), RODATA_ADDRESS, rodata_size, rodata_size, 4},
+        {static_cast<u32>(elf.size()), DATA_ADDRESS, 0, DATA_SIZE, 6},
+    }};
+    for (std::size_t i = 0; i < segments.size(); ++i) {
+        const auto& [offset, address, file_size, memory_size, flags] = segments[i];
+        const std::size_t header = 0x34 + i * 0x20;
+        write(header + 0x00, 1); // PT_LOAD
+        write(header + 0x04, offset);
+        write(header + 0x08, address);
+        write(header + 0x0C, address);
+        write(header + 0x10, file_size);
+        write(header + 0x14, memory_size);
+        write(header + 0x18, flags);
+        write(header + 0x1C, 0x1000);
+    }
+
+    for (std::size_t i = 0; i < code.size(); ++i) {
+        write(code_offset + i * 4, code[i]);
+    }
+    for (std::size_t i = 0; i < rodata.size(); ++i) {
+        write(rodata_offset + i * 4, rodata[i]);
+    }
+    return elf;
+}
+
+} // namespace SystemTests
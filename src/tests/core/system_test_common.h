@@ -0,0 +1,32 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <vector>
+#include "common/common_types.h"
+#include "core/frontend/emu_window.h"
+
+namespace SystemTests {
+
+constexpr VAddr CODE_ADDRESS = 0x00100000;
+constexpr VAddr RODATA_ADDRESS = 0x00101000;
+constexpr VAddr DATA_ADDRESS = 0x00102000;
+constexpr u32 DATA_SIZE = 0x1000;
+
+/// Window of the instances under test, which use the null renderer
+class NullWindow : public Frontend::EmuWindow {
+public:
+    void PollEvents() override {}
+    void MakeCurrent() override {}
+    void DoneCurrent() override {}
+};
+
+/**
+ * Builds an ELF executable which starts at CODE_ADDRESS. Its read-only data segment at
+ * RODATA_ADDRESS holds rodata, and its data segment at DATA_ADDRESS is DATA_SIZE bytes of zeros.
+ */
+std::vector<u8> BuildProgram(const std::vector<u32>& code, const std::vector<u32>& rodata);
+
+} // namespace SystemTests
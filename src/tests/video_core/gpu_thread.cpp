@@ -0,0 +1,68 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <memory>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "core/core.h"
+#include "core/frontend/emu_window.h"
+#include "video_core/gpu_thread.h"
+
+namespace {
+
+class NullContext final : public Frontend::GraphicsContext {
+public:
+    void MakeCurrent() override {}
+    void DoneCurrent() override {}
+};
+
+} // Anonymous namespace
+
+TEST_CASE("GPUThread runs commands in order and reaches their fences", "[video_core]") {
+    auto system = std::make_unique<Core::System>();
+    VideoCore::GPUThread gpu_thread(*system, std::make_unique<NullContext>());
+
+    std::vector<int> order;
+    bool ran_on_gpu_thread = true;
+    bool bound_to_system = true;
+    u64 fence = 0;
+    for (int i = 0; i < 100; ++i) {
+        fence = gpu_thread.Submit([&, i] {
+            order.push_back(i);
+            ran_on_gpu_thread &= gpu_thread.IsGPUThread();
+            bound_to_system &= &Core::System::GetInstance() == system.get();
+        });
+    }
+    REQUIRE(fence == 100);
+
+    gpu_thread.WaitForFence(fence);
+    REQUIRE(order.size() == 100);
+    for (int i = 0; i < 100; ++i) {
+        REQUIRE(order[i] == i);
+    }
+    REQUIRE(ran_on_gpu_thread);
+    REQUIRE(bound_to_system);
+    REQUIRE(!gpu_thread.IsGPUThread());
+
+    int value = 0;
+    gpu_thread.SubmitAndWait([&] { value = 42; });
+    REQUIRE(value == 42);
+}
+
+TEST_CASE("GPUThread hands callbacks to the emulation thread", "[video_core]") {
+    auto system = std::make_unique<Core::System>();
+    VideoCore::GPUThread gpu_thread(*system, std::make_unique<NullContext>());
+
+    std::vector<int> completions;
+    for (int i = 0; i < 3; ++i) {
+        gpu_thread.Submit(
+            [&, i] { gpu_thread.PostCallback([&, i] { completions.push_back(i); }); });
+    }
+    gpu_thread.WaitIdle();
+
+    // Callbacks only run when the emulation thread asks for them
+    REQUIRE(completions.empty());
+    gpu_thread.RunCallbacks();
+    REQUIRE(completions == std::vector<int>{0, 1, 2});
+}
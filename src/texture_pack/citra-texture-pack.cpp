@@ -0,0 +1,208 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+// Compiles a directory of custom textures, named like the texture dumps, into a texture pack that
+// can be loaded without decoding PNG files.
+
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include <lodepng.h>
+#include "common/common_paths.h"
+#include "common/common_types.h"
+#include "common/file_util.h"
+#include "common/scm_rev.h"
+#include "common/texture.h"
+#include "core/custom_tex_cache.h"
+#include "core/custom_tex_pack.h"
+
+#undef _UNICODE
+#include <getopt.h>
+#ifndef _MSC_VER
+#include <unistd.h>
+#endif
+
+static void PrintHelp(const char* argv0) {
+    std::cout << "Usage: " << argv0
+              << " [options] <texture directory> [output file]\n"
+                 "Packs the tex1_*.png files of a directory and its subdirectories. The pack is\n"
+                 "written to textures.pack in the directory by default.\n\n"
+                 "-l, --level         The zstd compression level, from 1 to 22 (default: 9)\n"
+                 "-j, --threads       The number of threads (default: the number of CPU cores)\n"
+                 "-h, --help          Display this help and exit\n"
+                 "-v, --version       Output version information and exit\n";
+}
+
+static void PrintVersion() {
+    std::cout << "Citra texture pack compiler " << Common::g_scm_branch << " "
+              << Common::g_scm_desc << std::endl;
+}
+
+struct SourceTexture {
+    std::string path;
+    u64 hash;
+};
+
+/// Finds the custom textures in a directory, the same way the emulator does.
+static std::vector<SourceTexture> FindTextures(const std::string& directory) {
+    FileUtil::FSTEntry texture_dir;
+    std::vector<FileUtil::FSTEntry> files;
+    // 64 nested folders should be plenty for most cases
+    FileUtil::ScanDirectoryTree(directory, texture_dir, 64);
+    FileUtil::GetAllFilesFromNestedEntries(texture_dir, files);
+
+    std::vector<SourceTexture> textures;
+    std::unordered_set<u64> hashes;
+    for (const auto& file : files) {
+        if (file.isDirectory || file.virtualName.substr(0, 5) != "tex1_") {
+            continue;
+        }
+        u32 width;
+        u32 height;
+        u64 hash;
+        u32 format; // unused
+        if (std::sscanf(file.virtualName.c_str(), "tex1_%ux%u_%llX_%u.png", &width, &height,
+                        &hash, &format) != 4) {
+            continue;
+        }
+        if (!hashes.insert(hash).second) {
+            std::cout << "Skipping " << file.physicalName << ", its hash is already used\n";
+            continue;
+        }
+        textures.push_back({file.physicalName, hash});
+    }
+    return textures;
+}
+
+/// Application entry point
+int main(int argc, char** argv) {
+    int option_index = 0;
+    char* endarg;
+
+    s32 compression_level = 9;
+    u32 num_threads = std::max(1U, std::thread::hardware_concurrency());
+
+    static struct option long_options[] = {
+        {"level", required_argument, 0, 'l'}, {"threads", required_argument, 0, 'j'},
+        {"help", no_argument, 0, 'h'},        {"version", no_argument, 0, 'v'},
+        {0, 0, 0, 0},
+    };
+
+    std::vector<std::string> arguments;
+    while (optind < argc) {
+        int arg = getopt_long(argc, argv, "l:j:hv", long_options, &option_index);
+        if (arg != -1) {
+            switch (static_cast<char>(arg)) {
+            case 'l':
+                compression_level = static_cast<s32>(strtol(optarg, &endarg, 0));
+                break;
+            case 'j':
+                num_threads = std::max(1UL, strtoul(optarg, &endarg, 0));
+                break;
+            case 'h':
+                PrintHelp(argv[0]);
+                return 0;
+            case 'v':
+                PrintVersion();
+                return 0;
+            }
+        } else {
+            arguments.emplace_back(argv[optind++]);
+        }
+    }
+
+    if (arguments.empty() || arguments.size() > 2) {
+        PrintHelp(argv[0]);
+        return -1;
+    }
+    if (compression_level < 1 || compression_level > 22) {
+        std::cout << "level needs to be in the range 1 - 22!\n\n";
+        PrintHelp(argv[0]);
+        return -1;
+    }
+
+    std::string directory = arguments[0];
+    if (directory.back() != '/' && directory.back() != '\\') {
+        directory += DIR_SEP;
+    }
+    const std::string output_path =
+        arguments.size() > 1 ? arguments[1] : directory + Core::CustomTexPack::FileName;
+
+    const std::vector<SourceTexture> sources = FindTextures(directory);
+    if (sources.empty()) {
+        std::cout << "No custom textures found in " << directory << "\n";
+        return -1;
+    }
+    std::cout << "Packing " << sources.size() << " textures\n";
+
+    std::vector<std::optional<Core::CustomTexPack::CompressedTexture>> results(sources.size());
+    std::atomic<std::size_t> next_texture{0};
+    std::atomic<u64> decoded_size{0};
+    std::mutex output_mutex;
+    const auto worker = [&] {
+        std::size_t i;
+        while ((i = next_texture++) < sources.size()) {
+            const auto& source = sources[i];
+            Core::CustomTexInfo tex_info;
+            const u32 error =
+                lodepng::decode(tex_info.tex, tex_info.width, tex_info.height, source.path);
+            if (error) {
+                std::lock_guard lock{output_mutex};
+                std::cout << "Failed to decode " << source.path << ": "
+                          << lodepng_error_text(error) << "\n";
+                continue;
+            }
+
+            const std::bitset<32> width_bits(tex_info.width);
+            const std::bitset<32> height_bits(tex_info.height);
+            if (width_bits.count() != 1 || height_bits.count() != 1) {
+                std::lock_guard lock{output_mutex};
+                std::cout << "Skipping " << source.path << ", its size is not a power of 2\n";
+                continue;
+            }
+
+            Common::FlipRGBA8Texture(tex_info.tex, tex_info.width, tex_info.height);
+            decoded_size += tex_info.tex.size();
+            results[i] =
+                Core::CustomTexPack::CompressTexture(source.hash, tex_info, compression_level);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    const std::size_t thread_count = std::min<std::size_t>(num_threads, sources.size());
+    for (std::size_t i = 1; i < thread_count; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<Core::CustomTexPack::CompressedTexture> textures;
+    u64 packed_size = 0;
+    for (auto& result : results) {
+        if (result) {
+            packed_size += result->data.size();
+            textures.push_back(std::move(*result));
+        }
+    }
+    const std::size_t num_packed = textures.size();
+
+    if (!Core::CustomTexPack::Write(output_path, std::move(textures))) {
+        std::cout << "Failed to write " << output_path << "\n";
+        return -1;
+    }
+    std::cout << "Wrote " << num_packed << " textures to " << output_path << ", "
+              << decoded_size / (1024 * 1024) << " MiB decoded, " << packed_size / (1024 * 1024)
+              << " MiB packed\n";
+    return num_packed == sources.size() ? 0 : -1;
+}
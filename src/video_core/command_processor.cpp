@@ -14,6 +14,7 @@
 #include "core/hle/service/gsp/gsp.h"
 #include "core/hw/gpu.h"
 #include "core/memory.h"
+#include "core/perf_stats.h"
 #include "core/tracer/recorder.h"
 #include "video_core/command_processor.h"
 #include "video_core/debug_utils/debug_utils.h"
@@ -39,11 +40,70 @@ constexpr std::array<u32, 16> expand_bits_to_bytes{
 
 MICROPROFILE_DEFINE(GPU_Drawing, "GPU", "Drawing", MP_RGB(50, 50, 240));
 
+/// Shader configurations of the hardware renderer that each register is built into, as a mask of
+/// State::ShaderConfig. They must cover every register read by the Pica*Config constructors.
+static const std::array<u8, Regs::NUM_REGS> shader_config_regs = [] {
+    std::array<u8, Regs::NUM_REGS> configs{};
+    constexpr u8 fs = State::FragmentShaderConfig;
+    constexpr u8 vs = State::VertexShaderConfig;
+    constexpr u8 gs = State::GeometryShaderConfig;
+
+    configs[PICA_REG_INDEX(rasterizer.scissor_test.mode)] |= fs;
+    configs[PICA_REG_INDEX(rasterizer.depthmap_enable)] |= fs;
+    configs[PICA_REG_INDEX(framebuffer.output_merger.fragment_operation_mode)] |= fs;
+    configs[PICA_REG_INDEX(framebuffer.output_merger.alpha_test)] |= fs;
+    configs[PICA_REG_INDEX(texturing.main_config)] |= fs;
+    configs[PICA_REG_INDEX(texturing.texture0.type)] |= fs;
+    configs[PICA_REG_INDEX(texturing.shadow)] |= fs;
+    configs[PICA_REG_INDEX(texturing.proctex)] |= fs;
+    configs[PICA_REG_INDEX(texturing.proctex_lut)] |= fs;
+    configs[PICA_REG_INDEX(texturing.proctex_lut_offset)] |= fs;
+    // This also holds fog_mode and fog_flip
+    configs[PICA_REG_INDEX(texturing.tev_combiner_buffer_input)] |= fs;
+
+    // The constant color of the TEV stages is a uniform
+    for (const std::size_t stage :
+         {PICA_REG_INDEX(texturing.tev_stage0), PICA_REG_INDEX(texturing.tev_stage1),
+          PICA_REG_INDEX(texturing.tev_stage2), PICA_REG_INDEX(texturing.tev_stage3),
+          PICA_REG_INDEX(texturing.tev_stage4), PICA_REG_INDEX(texturing.tev_stage5)}) {
+        const std::size_t base = PICA_REG_INDEX(texturing.tev_stage0);
+        configs[stage + PICA_REG_INDEX(texturing.tev_stage0.color_source1) - base] |= fs;
+        configs[stage + PICA_REG_INDEX(texturing.tev_stage0.color_modifier1) - base] |= fs;
+        configs[stage + PICA_REG_INDEX(texturing.tev_stage0.color_op) - base] |= fs;
+        configs[stage + PICA_REG_INDEX(texturing.tev_stage0.color_scale) - base] |= fs;
+    }
+
+    configs[PICA_REG_INDEX(lighting.disable)] |= fs;
+    configs[PICA_REG_INDEX(lighting.max_light_index)] |= fs;
+    configs[PICA_REG_INDEX(lighting.config0)] |= fs;
+    configs[PICA_REG_INDEX(lighting.config1)] |= fs;
+    configs[PICA_REG_INDEX(lighting.abs_lut_input)] |= fs;
+    configs[PICA_REG_INDEX(lighting.lut_input)] |= fs;
+    configs[PICA_REG_INDEX(lighting.lut_scale)] |= fs;
+    configs[PICA_REG_INDEX(lighting.light_enable)] |= fs;
+    const std::size_t light_stride =
+        PICA_REG_INDEX(lighting.light[1]) - PICA_REG_INDEX(lighting.light[0]);
+    for (std::size_t light = 0; light < 8; ++light) {
+        configs[PICA_REG_INDEX(lighting.light[0].config) + light * light_stride] |= fs;
+    }
+
+    // The program code and swizzle data are marked dirty when they are uploaded
+    configs[PICA_REG_INDEX(vs.main_offset)] |= vs;
+    configs[PICA_REG_INDEX(vs.output_mask)] |= vs | gs;
+
+    configs[PICA_REG_INDEX(rasterizer.vs_output_total)] |= gs;
+    for (std::size_t attrib = 0; attrib < 7; ++attrib) {
+        configs[PICA_REG_INDEX(rasterizer.vs_output_attributes[0]) + attrib] |= gs;
+    }
+
+    return configs;
+}();
+
 static const char* GetShaderSetupTypeName(Shader::ShaderSetup& setup) {
-    if (&setup == &g_state.vs) {
+    if (&setup == &GetState().vs) {
         return "vertex shader";
     }
-    if (&setup == &g_state.gs) {
+    if (&setup == &GetState().gs) {
         return "geometry shader";
     }
     return "unknown shader";
@@ -113,8 +173,9 @@ static void WriteUniformFloatReg(ShaderRegs& config, Shader::ShaderSetup& setup,
     }
 }
 
-static void WritePicaReg(u32 id, u32 value, u32 mask) {
-    auto& regs = g_state.regs;
+static void WritePicaReg(State& state, VideoCore::RasterizerInterface& rasterizer,
+                         Memory::MemorySystem& memory, u32 id, u32 value, u32 mask) {
+    auto& regs = state.regs;
 
     if (id >= Regs::NUM_REGS) {
         LOG_ERROR(
@@ -128,8 +189,16 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     u32 old_value = regs.reg_array[id];
 
     const u32 write_mask = expand_bits_to_bytes[mask];
+    const u32 new_value = (old_value & ~write_mask) | (value & write_mask);
+
+    rasterizer.NotifyPicaRegisterWrite(id, new_value);
+
+    regs.reg_array[id] = new_value;
 
-    regs.reg_array[id] = (old_value & ~write_mask) | (value & write_mask);
+    // Games rewrite most of the state before each draw, so only actual changes are tracked
+    if (regs.reg_array[id] != old_value) {
+        state.dirty_shader_configs |= shader_config_regs[id];
+    }
 
     // Double check for is_pica_tracing to avoid call overhead
     if (DebugUtils::IsPicaTracing()) {
@@ -143,21 +212,22 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     switch (id) {
     // Trigger IRQ
     case PICA_REG_INDEX(trigger_irq):
+        rasterizer.NotifyCommandListEnd();
         Service::GSP::SignalInterrupt(Service::GSP::InterruptId::P3D);
         break;
 
     case PICA_REG_INDEX(pipeline.triangle_topology):
-        g_state.primitive_assembler.Reconfigure(regs.pipeline.triangle_topology);
+        state.primitive_assembler.Reconfigure(regs.pipeline.triangle_topology);
         break;
 
     case PICA_REG_INDEX(pipeline.restart_primitive):
-        g_state.primitive_assembler.Reset();
+        state.primitive_assembler.Reset();
         break;
 
     case PICA_REG_INDEX(pipeline.vs_default_attributes_setup.index):
-        g_state.immediate.current_attribute = 0;
-        g_state.immediate.reset_geometry_pipeline = true;
-        g_state.default_attr_counter = 0;
+        state.immediate.current_attribute = 0;
+        state.immediate.reset_geometry_pipeline = true;
+        state.default_attr_counter = 0;
         break;
 
     // Load default vertex input attributes
@@ -166,14 +236,14 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     case PICA_REG_INDEX(pipeline.vs_default_attributes_setup.set_value[2]): {
         // TODO: Does actual hardware indeed keep an intermediate buffer or does
         //       it directly write the values?
-        g_state.default_attr_write_buffer[g_state.default_attr_counter++] = value;
+        state.default_attr_write_buffer[state.default_attr_counter++] = value;
 
         // Default attributes are written in a packed format such that four float24 values are
         // encoded in
         // three 32-bit numbers. We write to internal memory once a full such vector is
         // written.
-        if (g_state.default_attr_counter >= 3) {
-            g_state.default_attr_counter = 0;
+        if (state.default_attr_counter >= 3) {
+            state.default_attr_counter = 0;
 
             auto& setup = regs.pipeline.vs_default_attributes_setup;
 
@@ -185,12 +255,12 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
             Common::Vec4<float24> attribute;
 
             // NOTE: The destination component order indeed is "backwards"
-            attribute.w = float24::FromRaw(g_state.default_attr_write_buffer[0] >> 8);
-            attribute.z = float24::FromRaw(((g_state.default_attr_write_buffer[0] & 0xFF) << 16) |
-                                           ((g_state.default_attr_write_buffer[1] >> 16) & 0xFFFF));
-            attribute.y = float24::FromRaw(((g_state.default_attr_write_buffer[1] & 0xFFFF) << 8) |
-                                           ((g_state.default_attr_write_buffer[2] >> 24) & 0xFF));
-            attribute.x = float24::FromRaw(g_state.default_attr_write_buffer[2] & 0xFFFFFF);
+            attribute.w = float24::FromRaw(state.default_attr_write_buffer[0] >> 8);
+            attribute.z = float24::FromRaw(((state.default_attr_write_buffer[0] & 0xFF) << 16) |
+                                           ((state.default_attr_write_buffer[1] >> 16) & 0xFFFF));
+            attribute.y = float24::FromRaw(((state.default_attr_write_buffer[1] & 0xFFFF) << 8) |
+                                           ((state.default_attr_write_buffer[2] >> 24) & 0xFF));
+            attribute.x = float24::FromRaw(state.default_attr_write_buffer[2] & 0xFFFFFF);
 
             LOG_TRACE(HW_GPU, "Set default VS attribute {:x} to ({} {} {} {})", (int)setup.index,
                       attribute.x.ToFloat32(), attribute.y.ToFloat32(), attribute.z.ToFloat32(),
@@ -198,15 +268,15 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 
             // TODO: Verify that this actually modifies the register!
             if (setup.index < 15) {
-                g_state.input_default_attributes.attr[setup.index] = attribute;
+                state.input_default_attributes.attr[setup.index] = attribute;
                 setup.index++;
             } else {
                 // Put each attribute into an immediate input buffer.  When all specified immediate
                 // attributes are present, the Vertex Shader is invoked and everything is sent to
                 // the primitive assembler.
 
-                auto& immediate_input = g_state.immediate.input_vertex;
-                auto& immediate_attribute_id = g_state.immediate.current_attribute;
+                auto& immediate_input = state.immediate.input_vertex;
+                auto& immediate_attribute_id = state.immediate.current_attribute;
 
                 immediate_input.attr[immediate_attribute_id] = attribute;
 
@@ -219,7 +289,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
                     Shader::OutputVertex::ValidateSemantics(regs.rasterizer);
 
                     auto* shader_engine = Shader::GetEngine();
-                    shader_engine->SetupBatch(g_state.vs, regs.vs.main_offset);
+                    shader_engine->SetupBatch(state.vs, regs.vs.main_offset);
 
                     // Send to vertex shader
                     if (g_debug_context)
@@ -229,22 +299,22 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
                     Shader::AttributeBuffer output{};
 
                     shader_unit.LoadInput(regs.vs, immediate_input);
-                    shader_engine->Run(g_state.vs, shader_unit);
+                    shader_engine->Run(state.vs, shader_unit);
                     shader_unit.WriteOutput(regs.vs, output);
 
                     // Send to geometry pipeline
-                    if (g_state.immediate.reset_geometry_pipeline) {
-                        g_state.geometry_pipeline.Reconfigure();
-                        g_state.immediate.reset_geometry_pipeline = false;
+                    if (state.immediate.reset_geometry_pipeline) {
+                        state.geometry_pipeline.Reconfigure();
+                        state.immediate.reset_geometry_pipeline = false;
                     }
-                    ASSERT(!g_state.geometry_pipeline.NeedIndexInput());
-                    g_state.geometry_pipeline.Setup(shader_engine);
-                    g_state.geometry_pipeline.SubmitVertex(output);
+                    ASSERT(!state.geometry_pipeline.NeedIndexInput());
+                    state.geometry_pipeline.Setup(shader_engine);
+                    state.geometry_pipeline.SubmitVertex(output);
 
                     // TODO: If drawing after every immediate mode triangle kills performance,
                     // change it to flush triangles whenever a drawing config register changes
                     // See: https://github.com/citra-emu/citra/pull/2866#issuecomment-327011550
-                    VideoCore::g_renderer->Rasterizer()->DrawTriangles();
+                    rasterizer.DrawTriangles();
                     if (g_debug_context) {
                         g_debug_context->OnEvent(DebugContext::Event::FinishedPrimitiveBatch,
                                                  nullptr);
@@ -263,10 +333,10 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     case PICA_REG_INDEX(pipeline.command_buffer.trigger[1]): {
         unsigned index =
             static_cast<unsigned>(id - PICA_REG_INDEX(pipeline.command_buffer.trigger[0]));
-        u32* head_ptr = (u32*)VideoCore::g_memory->GetPhysicalPointer(
+        u32* head_ptr = (u32*)memory.GetPhysicalPointer(
             regs.pipeline.command_buffer.GetPhysicalAddress(index));
-        g_state.cmd_list.head_ptr = g_state.cmd_list.current_ptr = head_ptr;
-        g_state.cmd_list.length = regs.pipeline.command_buffer.GetSize(index) / sizeof(u32);
+        state.cmd_list.head_ptr = state.cmd_list.current_ptr = head_ptr;
+        state.cmd_list.length = regs.pipeline.command_buffer.GetSize(index) / sizeof(u32);
         break;
     }
 
@@ -281,7 +351,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         if (g_debug_context)
             g_debug_context->OnEvent(DebugContext::Event::IncomingPrimitiveBatch, nullptr);
 
-        PrimitiveAssembler<Shader::OutputVertex>& primitive_assembler = g_state.primitive_assembler;
+        PrimitiveAssembler<Shader::OutputVertex>& primitive_assembler = state.primitive_assembler;
 
         bool accelerate_draw = VideoCore::g_hw_shader_enabled && primitive_assembler.IsEmpty();
 
@@ -303,25 +373,26 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 
         bool is_indexed = (id == PICA_REG_INDEX(pipeline.trigger_draw_indexed));
 
-        if (accelerate_draw &&
-            VideoCore::g_renderer->Rasterizer()->AccelerateDrawBatch(is_indexed)) {
+        if (accelerate_draw && rasterizer.AccelerateDrawBatch(is_indexed)) {
             if (g_debug_context) {
                 g_debug_context->OnEvent(DebugContext::Event::FinishedPrimitiveBatch, nullptr);
             }
             break;
         }
 
+        // Timed as a whole, as a timer per triangle would cost about as much as small ones take
+        Core::PerfTimer perf_timer{Core::PerfCategory::Rasterizer};
+
         // Processes information about internal vertex attributes to figure out how a vertex is
         // loaded.
         // Later, these can be compiled and cached.
         const u32 base_address = regs.pipeline.vertex_attributes.GetPhysicalBaseAddress();
-        VertexLoader loader(regs.pipeline);
+        VertexLoader loader(regs.pipeline, state.input_default_attributes, memory);
         Shader::OutputVertex::ValidateSemantics(regs.rasterizer);
 
         // Load vertices
         const auto& index_info = regs.pipeline.index_array;
-        const u8* index_address_8 =
-            VideoCore::g_memory->GetPhysicalPointer(base_address + index_info.offset);
+        const u8* index_address_8 = memory.GetPhysicalPointer(base_address + index_info.offset);
         const u16* index_address_16 = reinterpret_cast<const u16*>(index_address_8);
         bool index_u16 = index_info.format != 0;
 
@@ -331,8 +402,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
                 if (!texture.enabled)
                     continue;
 
-                u8* texture_data =
-                    VideoCore::g_memory->GetPhysicalPointer(texture.config.GetPhysicalAddress());
+                u8* texture_data = memory.GetPhysicalPointer(texture.config.GetPhysicalAddress());
                 g_debug_context->recorder->MemoryAccessed(
                     texture_data,
                     Pica::TexturingRegs::NibblesPerPixel(texture.format) * texture.config.width /
@@ -356,11 +426,11 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         auto* shader_engine = Shader::GetEngine();
         Shader::UnitState shader_unit;
 
-        shader_engine->SetupBatch(g_state.vs, regs.vs.main_offset);
+        shader_engine->SetupBatch(state.vs, regs.vs.main_offset);
 
-        g_state.geometry_pipeline.Reconfigure();
-        g_state.geometry_pipeline.Setup(shader_engine);
-        if (g_state.geometry_pipeline.NeedIndexInput())
+        state.geometry_pipeline.Reconfigure();
+        state.geometry_pipeline.Setup(shader_engine);
+        if (state.geometry_pipeline.NeedIndexInput())
             ASSERT(is_indexed);
 
         for (unsigned int index = 0; index < regs.pipeline.num_vertices; ++index) {
@@ -372,8 +442,8 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
             bool vertex_cache_hit = false;
 
             if (is_indexed) {
-                if (g_state.geometry_pipeline.NeedIndexInput()) {
-                    g_state.geometry_pipeline.SubmitIndex(vertex);
+                if (state.geometry_pipeline.NeedIndexInput()) {
+                    state.geometry_pipeline.SubmitIndex(vertex);
                     continue;
                 }
 
@@ -402,7 +472,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
                     g_debug_context->OnEvent(DebugContext::Event::VertexShaderInvocation,
                                              (void*)&input);
                 shader_unit.LoadInput(regs.vs, input);
-                shader_engine->Run(g_state.vs, shader_unit);
+                shader_engine->Run(state.vs, shader_unit);
                 shader_unit.WriteOutput(regs.vs, vs_output);
 
                 if (is_indexed) {
@@ -414,15 +484,15 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
             }
 
             // Send to geometry pipeline
-            g_state.geometry_pipeline.SubmitVertex(vs_output);
+            state.geometry_pipeline.SubmitVertex(vs_output);
         }
 
         for (auto& range : memory_accesses.ranges) {
             g_debug_context->recorder->MemoryAccessed(
-                VideoCore::g_memory->GetPhysicalPointer(range.first), range.second, range.first);
+                memory.GetPhysicalPointer(range.first), range.second, range.first);
         }
 
-        VideoCore::g_renderer->Rasterizer()->DrawTriangles();
+        rasterizer.DrawTriangles();
         if (g_debug_context) {
             g_debug_context->OnEvent(DebugContext::Event::FinishedPrimitiveBatch, nullptr);
         }
@@ -431,7 +501,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     }
 
     case PICA_REG_INDEX(gs.bool_uniforms):
-        WriteUniformBoolReg(g_state.gs, g_state.regs.gs.bool_uniforms.Value());
+        WriteUniformBoolReg(state.gs, state.regs.gs.bool_uniforms.Value());
         break;
 
     case PICA_REG_INDEX(gs.int_uniforms[0]):
@@ -440,7 +510,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     case PICA_REG_INDEX(gs.int_uniforms[3]): {
         unsigned index = (id - PICA_REG_INDEX(gs.int_uniforms[0]));
         auto values = regs.gs.int_uniforms[index];
-        WriteUniformIntReg(g_state.gs, index,
+        WriteUniformIntReg(state.gs, index,
                            Common::Vec4<u8>(values.x, values.y, values.z, values.w));
         break;
     }
@@ -453,8 +523,8 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     case PICA_REG_INDEX(gs.uniform_setup.set_value[5]):
     case PICA_REG_INDEX(gs.uniform_setup.set_value[6]):
     case PICA_REG_INDEX(gs.uniform_setup.set_value[7]): {
-        WriteUniformFloatReg(g_state.regs.gs, g_state.gs, g_state.gs_float_regs_counter,
-                             g_state.gs_uniform_write_buffer, value);
+        WriteUniformFloatReg(state.regs.gs, state.gs, state.gs_float_regs_counter,
+                             state.gs_uniform_write_buffer, value);
         break;
     }
 
@@ -466,12 +536,12 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     case PICA_REG_INDEX(gs.program.set_word[5]):
     case PICA_REG_INDEX(gs.program.set_word[6]):
     case PICA_REG_INDEX(gs.program.set_word[7]): {
-        u32& offset = g_state.regs.gs.program.offset;
+        u32& offset = state.regs.gs.program.offset;
         if (offset >= 4096) {
             LOG_ERROR(HW_GPU, "Invalid GS program offset {}", offset);
         } else {
-            g_state.gs.program_code[offset] = value;
-            g_state.gs.MarkProgramCodeDirty();
+            state.gs.program_code[offset] = value;
+            state.gs.MarkProgramCodeDirty();
             offset++;
         }
         break;
@@ -485,12 +555,12 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     case PICA_REG_INDEX(gs.swizzle_patterns.set_word[5]):
     case PICA_REG_INDEX(gs.swizzle_patterns.set_word[6]):
     case PICA_REG_INDEX(gs.swizzle_patterns.set_word[7]): {
-        u32& offset = g_state.regs.gs.swizzle_patterns.offset;
-        if (offset >= g_state.gs.swizzle_data.size()) {
+        u32& offset = state.regs.gs.swizzle_patterns.offset;
+        if (offset >= state.gs.swizzle_data.size()) {
             LOG_ERROR(HW_GPU, "Invalid GS swizzle pattern offset {}", offset);
         } else {
-            g_state.gs.swizzle_data[offset] = value;
-            g_state.gs.MarkSwizzleDataDirty();
+            state.gs.swizzle_data[offset] = value;
+            state.gs.MarkSwizzleDataDirty();
             offset++;
         }
         break;
@@ -498,7 +568,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 
     case PICA_REG_INDEX(vs.bool_uniforms):
         // TODO (wwylele): does regs.pipeline.gs_unit_exclusive_configuration affect this?
-        WriteUniformBoolReg(g_state.vs, g_state.regs.vs.bool_uniforms.Value());
+        WriteUniformBoolReg(state.vs, state.regs.vs.bool_uniforms.Value());
         break;
 
     case PICA_REG_INDEX(vs.int_uniforms[0]):
@@ -508,7 +578,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         // TODO (wwylele): does regs.pipeline.gs_unit_exclusive_configuration affect this?
         unsigned index = (id - PICA_REG_INDEX(vs.int_uniforms[0]));
         auto values = regs.vs.int_uniforms[index];
-        WriteUniformIntReg(g_state.vs, index,
+        WriteUniformIntReg(state.vs, index,
                            Common::Vec4<u8>(values.x, values.y, values.z, values.w));
         break;
     }
@@ -522,8 +592,8 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     case PICA_REG_INDEX(vs.uniform_setup.set_value[6]):
     case PICA_REG_INDEX(vs.uniform_setup.set_value[7]): {
         // TODO (wwylele): does regs.pipeline.gs_unit_exclusive_configuration affect this?
-        WriteUniformFloatReg(g_state.regs.vs, g_state.vs, g_state.vs_float_regs_counter,
-                             g_state.vs_uniform_write_buffer, value);
+        WriteUniformFloatReg(state.regs.vs, state.vs, state.vs_float_regs_counter,
+                             state.vs_uniform_write_buffer, value);
         break;
     }
 
@@ -535,15 +605,16 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     case PICA_REG_INDEX(vs.program.set_word[5]):
     case PICA_REG_INDEX(vs.program.set_word[6]):
     case PICA_REG_INDEX(vs.program.set_word[7]): {
-        u32& offset = g_state.regs.vs.program.offset;
+        u32& offset = state.regs.vs.program.offset;
         if (offset >= 512) {
             LOG_ERROR(HW_GPU, "Invalid VS program offset {}", offset);
         } else {
-            g_state.vs.program_code[offset] = value;
-            g_state.vs.MarkProgramCodeDirty();
-            if (!g_state.regs.pipeline.gs_unit_exclusive_configuration) {
-                g_state.gs.program_code[offset] = value;
-                g_state.gs.MarkProgramCodeDirty();
+            state.vs.program_code[offset] = value;
+            state.vs.MarkProgramCodeDirty();
+            state.dirty_shader_configs |= State::VertexShaderConfig;
+            if (!state.regs.pipeline.gs_unit_exclusive_configuration) {
+                state.gs.program_code[offset] = value;
+                state.gs.MarkProgramCodeDirty();
             }
             offset++;
         }
@@ -558,15 +629,16 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     case PICA_REG_INDEX(vs.swizzle_patterns.set_word[5]):
     case PICA_REG_INDEX(vs.swizzle_patterns.set_word[6]):
     case PICA_REG_INDEX(vs.swizzle_patterns.set_word[7]): {
-        u32& offset = g_state.regs.vs.swizzle_patterns.offset;
-        if (offset >= g_state.vs.swizzle_data.size()) {
+        u32& offset = state.regs.vs.swizzle_patterns.offset;
+        if (offset >= state.vs.swizzle_data.size()) {
             LOG_ERROR(HW_GPU, "Invalid VS swizzle pattern offset {}", offset);
         } else {
-            g_state.vs.swizzle_data[offset] = value;
-            g_state.vs.MarkSwizzleDataDirty();
-            if (!g_state.regs.pipeline.gs_unit_exclusive_configuration) {
-                g_state.gs.swizzle_data[offset] = value;
-                g_state.gs.MarkSwizzleDataDirty();
+            state.vs.swizzle_data[offset] = value;
+            state.vs.MarkSwizzleDataDirty();
+            state.dirty_shader_configs |= State::VertexShaderConfig;
+            if (!state.regs.pipeline.gs_unit_exclusive_configuration) {
+                state.gs.swizzle_data[offset] = value;
+                state.gs.MarkSwizzleDataDirty();
             }
             offset++;
         }
@@ -585,7 +657,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 
         ASSERT_MSG(lut_config.index < 256, "lut_config.index exceeded maximum value of 255!");
 
-        g_state.lighting.luts[lut_config.type][lut_config.index].raw = value;
+        state.lighting.luts[lut_config.type][lut_config.index].raw = value;
         lut_config.index.Assign(lut_config.index + 1);
         break;
     }
@@ -598,7 +670,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     case PICA_REG_INDEX(texturing.fog_lut_data[5]):
     case PICA_REG_INDEX(texturing.fog_lut_data[6]):
     case PICA_REG_INDEX(texturing.fog_lut_data[7]): {
-        g_state.fog.lut[regs.texturing.fog_lut_offset % 128].raw = value;
+        state.fog.lut[regs.texturing.fog_lut_offset % 128].raw = value;
         regs.texturing.fog_lut_offset.Assign(regs.texturing.fog_lut_offset + 1);
         break;
     }
@@ -612,7 +684,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     case PICA_REG_INDEX(texturing.proctex_lut_data[6]):
     case PICA_REG_INDEX(texturing.proctex_lut_data[7]): {
         auto& index = regs.texturing.proctex_lut_config.index;
-        auto& pt = g_state.proctex;
+        auto& pt = state.proctex;
 
         switch (regs.texturing.proctex_lut_config.ref_table.Value()) {
         case TexturingRegs::ProcTexLutTable::Noise:
@@ -638,7 +710,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         break;
     }
 
-    VideoCore::g_renderer->Rasterizer()->NotifyPicaRegisterChanged(id);
+    rasterizer.NotifyPicaRegisterChanged(id);
 
     if (g_debug_context)
         g_debug_context->OnEvent(DebugContext::Event::PicaCommandProcessed,
@@ -646,33 +718,40 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 }
 
 void ProcessCommandList(PAddr list, u32 size) {
+    // Looked up once per list rather than per register write
+    State& state = GetState();
+    VideoCore::RasterizerInterface& rasterizer = *VideoCore::GetRenderer()->Rasterizer();
+    Memory::MemorySystem& memory = VideoCore::GetMemory();
 
-    u32* buffer = (u32*)VideoCore::g_memory->GetPhysicalPointer(list);
+    u32* buffer = (u32*)memory.GetPhysicalPointer(list);
 
     if (Pica::g_debug_context && Pica::g_debug_context->recorder) {
         Pica::g_debug_context->recorder->MemoryAccessed((u8*)buffer, size, list);
     }
 
-    g_state.cmd_list.addr = list;
-    g_state.cmd_list.head_ptr = g_state.cmd_list.current_ptr = buffer;
-    g_state.cmd_list.length = size / sizeof(u32);
+    state.cmd_list.addr = list;
+    state.cmd_list.head_ptr = state.cmd_list.current_ptr = buffer;
+    state.cmd_list.length = size / sizeof(u32);
 
-    while (g_state.cmd_list.current_ptr < g_state.cmd_list.head_ptr + g_state.cmd_list.length) {
+    while (state.cmd_list.current_ptr < state.cmd_list.head_ptr + state.cmd_list.length) {
 
         // Align read pointer to 8 bytes
-        if ((g_state.cmd_list.head_ptr - g_state.cmd_list.current_ptr) % 2 != 0)
-            ++g_state.cmd_list.current_ptr;
+        if ((state.cmd_list.head_ptr - state.cmd_list.current_ptr) % 2 != 0)
+            ++state.cmd_list.current_ptr;
 
-        u32 value = *g_state.cmd_list.current_ptr++;
-        const CommandHeader header = {*g_state.cmd_list.current_ptr++};
+        u32 value = *state.cmd_list.current_ptr++;
+        const CommandHeader header = {*state.cmd_list.current_ptr++};
 
-        WritePicaReg(header.cmd_id, value, header.parameter_mask);
+        WritePicaReg(state, rasterizer, memory, header.cmd_id, value, header.parameter_mask);
 
         for (unsigned i = 0; i < header.extra_data_length; ++i) {
             u32 cmd = header.cmd_id + (header.group_commands ? i + 1 : 0);
-            WritePicaReg(cmd, *g_state.cmd_list.current_ptr++, header.parameter_mask);
+            WritePicaReg(state, rasterizer, memory, cmd, *state.cmd_list.current_ptr++,
+                         header.parameter_mask);
         }
     }
+
+    rasterizer.NotifyCommandListEnd();
 }
 
 } // namespace Pica::CommandProcessor
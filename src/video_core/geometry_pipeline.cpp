@@ -89,7 +89,7 @@ private:
     Common::Vec4<float24>* buffer_end;
     unsigned int vs_output_num;
 
-    GeometryPipeline_Point() : regs(g_state.regs), unit(g_state.gs_unit) {}
+    GeometryPipeline_Point() : regs(GetState().regs), unit(GetState().gs_unit) {}
 
     template <typename Class, class Archive>
     static void serialize_common(Class* self, Archive& ar, const unsigned int version) {
@@ -186,7 +186,7 @@ private:
     Common::Vec4<float24>* buffer_cur;
     unsigned int vs_output_num;
 
-    GeometryPipeline_VariablePrimitive() : regs(g_state.regs), setup(g_state.gs) {}
+    GeometryPipeline_VariablePrimitive() : regs(GetState().regs), setup(GetState().gs) {}
 
     template <typename Class, class Archive>
     static void serialize_common(Class* self, Archive& ar, const unsigned int version) {
@@ -262,7 +262,7 @@ private:
     Common::Vec4<float24>* buffer_end;
     unsigned int vs_output_num;
 
-    GeometryPipeline_FixedPrimitive() : regs(g_state.regs), setup(g_state.gs) {}
+    GeometryPipeline_FixedPrimitive() : regs(GetState().regs), setup(GetState().gs) {}
 
     template <typename Class, class Archive>
     static void serialize_common(Class* self, Archive& ar, const unsigned int version) {
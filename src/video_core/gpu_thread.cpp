@@ -0,0 +1,101 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/assert.h"
+#include "common/microprofile.h"
+#include "common/thread.h"
+#include "core/core.h"
+#include "core/frontend/emu_window.h"
+#include "core/frontend/scope_acquire_context.h"
+#include "video_core/gpu_thread.h"
+
+namespace VideoCore {
+
+GPUThread::GPUThread(Core::System& system, std::unique_ptr<Frontend::GraphicsContext> context)
+    : system(system), context(std::move(context)) {
+    thread = std::thread([this] { ThreadLoop(); });
+}
+
+GPUThread::~GPUThread() {
+    // An empty command stops the thread once everything before it has run
+    Submit({});
+    thread.join();
+}
+
+u64 GPUThread::Submit(std::function<void()> command) {
+    std::lock_guard lock{submit_mutex};
+    commands.Push(Command{std::move(command), ++last_fence});
+    return last_fence;
+}
+
+void GPUThread::SubmitAndWait(std::function<void()> command) {
+    if (IsGPUThread()) {
+        command();
+        return;
+    }
+    WaitForFence(Submit(std::move(command)));
+}
+
+void GPUThread::WaitForFence(u64 fence) {
+    if (completed_fence >= fence) {
+        return;
+    }
+    std::unique_lock lock{fence_mutex};
+    fence_cv.wait(lock, [this, fence] { return completed_fence >= fence; });
+}
+
+void GPUThread::WaitIdle() {
+    u64 fence;
+    {
+        std::lock_guard lock{submit_mutex};
+        fence = last_fence;
+    }
+    WaitForFence(fence);
+}
+
+bool GPUThread::IsGPUThread() const {
+    return std::this_thread::get_id() == thread.get_id();
+}
+
+void GPUThread::PostCallback(std::function<void()> callback) {
+    DEBUG_ASSERT(IsGPUThread());
+    callbacks.Push(std::move(callback));
+}
+
+void GPUThread::RunCallbacks() {
+    std::function<void()> callback;
+    while (callbacks.Pop(callback)) {
+        callback();
+    }
+}
+
+void GPUThread::ThreadLoop() {
+    Common::SetCurrentThreadName("GPU");
+    MicroProfileOnThreadCreate("GPU");
+    Core::System::SetCurrentInstance(&system);
+
+    {
+        Frontend::ScopeAcquireContext scope{*context};
+        while (true) {
+            Command command = commands.PopWait();
+            if (command.func) {
+                command.func();
+            }
+
+            {
+                std::lock_guard lock{fence_mutex};
+                completed_fence = command.fence;
+            }
+            fence_cv.notify_all();
+
+            if (!command.func) {
+                break;
+            }
+        }
+    }
+
+    MicroProfileOnThreadExit();
+}
+
+} // namespace VideoCore
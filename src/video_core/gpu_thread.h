@@ -0,0 +1,94 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "common/common_types.h"
+#include "common/threadsafe_queue.h"
+
+namespace Core {
+class System;
+}
+
+namespace Frontend {
+class GraphicsContext;
+}
+
+namespace VideoCore {
+
+/**
+ * Runs the PICA command processor and the renderer on a thread of their own, so that CPU emulation
+ * does not stall while draws are processed. The GPU thread owns a graphics context, and every call
+ * into the renderer has to be made from it.
+ *
+ * Commands run in the order they were submitted. Each one is identified by a fence, the number of
+ * commands submitted up to and including it, which other threads can wait for.
+ *
+ * The emulation thread keeps ownership of the GPU and LCD registers and of the kernel. Work that
+ * finishes on the GPU thread reports back through callbacks, which the emulation thread runs from
+ * GPU::Update.
+ */
+class GPUThread {
+public:
+    GPUThread(Core::System& system, std::unique_ptr<Frontend::GraphicsContext> context);
+    ~GPUThread();
+
+    GPUThread(const GPUThread&) = delete;
+    GPUThread& operator=(const GPUThread&) = delete;
+
+    /**
+     * Queues a command to run on the GPU thread.
+     * @returns The fence that is reached once the command has run.
+     */
+    u64 Submit(std::function<void()> command);
+
+    /// Runs a command on the GPU thread and waits until it has finished
+    void SubmitAndWait(std::function<void()> command);
+
+    /// Waits until the command with the given fence has run
+    void WaitForFence(u64 fence);
+
+    /// Waits until every command submitted so far has run
+    void WaitIdle();
+
+    /// Returns whether the calling thread is the GPU thread
+    bool IsGPUThread() const;
+
+    /// Queues a call to run on the emulation thread. Must be called from the GPU thread.
+    void PostCallback(std::function<void()> callback);
+
+    /// Runs the calls posted by the GPU thread. Must be called from the emulation thread.
+    void RunCallbacks();
+
+private:
+    struct Command {
+        std::function<void()> func;
+        u64 fence = 0;
+    };
+
+    void ThreadLoop();
+
+    Core::System& system;
+    std::unique_ptr<Frontend::GraphicsContext> context;
+
+    std::mutex submit_mutex;
+    Common::SPSCQueue<Command> commands;
+    u64 last_fence = 0;
+
+    std::mutex fence_mutex;
+    std::condition_variable fence_cv;
+    std::atomic<u64> completed_fence{0};
+
+    Common::SPSCQueue<std::function<void()>> callbacks;
+
+    std::thread thread;
+};
+
+} // namespace VideoCore
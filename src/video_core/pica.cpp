@@ -4,6 +4,7 @@
 
 #include <cstring>
 #include <type_traits>
+#include "core/core.h"
 #include "core/global.h"
 #include "video_core/geometry_pipeline.h"
 #include "video_core/pica.h"
@@ -14,16 +15,18 @@
 namespace Core {
 template <>
 Pica::State& Global() {
-    return Pica::g_state;
+    return Pica::GetState();
 }
 } // namespace Core
 
 namespace Pica {
 
-State g_state;
+State& GetState() {
+    return Core::System::GetInstance().PicaState();
+}
 
 void Init() {
-    g_state.Reset();
+    GetState().Reset();
 }
 
 void Shutdown() {
@@ -42,7 +45,7 @@ State::State() : geometry_pipeline(*this) {
         using Pica::Shader::OutputVertex;
         auto AddTriangle = [this](const OutputVertex& v0, const OutputVertex& v1,
                                   const OutputVertex& v2) {
-            VideoCore::g_renderer->Rasterizer()->AddTriangle(v0, v1, v2);
+            VideoCore::GetRenderer()->Rasterizer()->AddTriangle(v0, v1, v2);
         };
         primitive_assembler.SubmitVertex(
             Shader::OutputVertex::FromAttributeBuffer(regs.rasterizer, vertex), AddTriangle);
@@ -50,8 +53,8 @@ State::State() : geometry_pipeline(*this) {
 
     auto SetWinding = [this]() { primitive_assembler.SetWinding(); };
 
-    g_state.gs_unit.SetVertexHandler(SubmitVertex, SetWinding);
-    g_state.geometry_pipeline.SetVertexHandler(SubmitVertex);
+    gs_unit.SetVertexHandler(SubmitVertex, SetWinding);
+    geometry_pipeline.SetVertexHandler(SubmitVertex);
 }
 
 void State::Reset() {
@@ -67,5 +70,6 @@ void State::Reset() {
     gs_uniform_write_buffer.fill(0);
     default_attr_counter = 0;
     default_attr_write_buffer.fill(0);
+    dirty_shader_configs = AllShaderConfigs;
 }
 } // namespace Pica
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <array>
+#include <memory>
 #include <boost/serialization/array.hpp>
 #include <boost/serialization/split_member.hpp>
 #include "common/bit_field.h"
@@ -206,6 +207,30 @@ struct State {
     int default_attr_counter = 0;
     std::array<u32, 3> default_attr_write_buffer{};
 
+    /// Shader JIT engine, created on first use. Compiled programs are not shared between instances.
+    std::unique_ptr<Shader::ShaderEngine> jit_engine;
+
+    /// Shader configurations that the hardware renderer builds from the registers
+    enum ShaderConfig : u8 {
+        FragmentShaderConfig = 1 << 0,
+        VertexShaderConfig = 1 << 1,
+        GeometryShaderConfig = 1 << 2,
+        AllShaderConfigs = FragmentShaderConfig | VertexShaderConfig | GeometryShaderConfig,
+    };
+
+    /**
+     * Shader configurations whose registers changed value since the renderer last built them. The
+     * command processor sets them on register writes, and the renderer clears them.
+     */
+    u8 dirty_shader_configs = AllShaderConfigs;
+
+    /// Returns whether the given shader configuration is dirty, and marks it clean
+    bool TakeDirtyShaderConfig(ShaderConfig config) {
+        const bool dirty = (dirty_shader_configs & config) != 0;
+        dirty_shader_configs &= ~config;
+        return dirty;
+    }
+
 private:
     friend class boost::serialization::access;
     template <class Archive>
@@ -245,11 +270,13 @@ private:
         u32 offset{};
         ar >> offset;
         cmd_list.head_ptr =
-            reinterpret_cast<u32*>(VideoCore::g_memory->GetPhysicalPointer(cmd_list.addr));
+            reinterpret_cast<u32*>(VideoCore::GetMemory().GetPhysicalPointer(cmd_list.addr));
         cmd_list.current_ptr = cmd_list.head_ptr + offset;
+        dirty_shader_configs = AllShaderConfigs;
     }
 };
 
-extern State g_state; ///< Current Pica state
+/// Returns the Pica state of the current System instance
+State& GetState();
 
 } // namespace Pica
@@ -39,9 +39,16 @@ public:
     /// Draw the current batch of triangles
     virtual void DrawTriangles() = 0;
 
+    /// Notify rasterizer that the specified PICA register is about to be written with a value
+    virtual void NotifyPicaRegisterWrite(u32 id, u32 value) {}
+
     /// Notify rasterizer that the specified PICA register has been changed
     virtual void NotifyPicaRegisterChanged(u32 id) = 0;
 
+    /// Notify rasterizer that the command list ended or is about to signal an interrupt, so any
+    /// work it deferred must be done before the CPU can look at the results
+    virtual void NotifyCommandListEnd() {}
+
     /// Notify rasterizer that all caches should be flushed to 3DS memory
     virtual void FlushAll() = 0;
 
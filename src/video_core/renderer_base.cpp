@@ -2,8 +2,11 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <memory>
+#include "common/logging/log.h"
 #include "core/frontend/emu_window.h"
+#include "core/settings.h"
 #include "video_core/renderer_base.h"
 #include "video_core/renderer_opengl/gl_rasterizer.h"
 #include "video_core/swrasterizer/swrasterizer.h"
@@ -16,8 +19,30 @@ void RendererBase::UpdateCurrentFramebufferLayout() {
     render_window.UpdateCurrentFramebufferLayout(layout.width, layout.height);
 }
 
+void RendererBase::RequestScreenshot(void* data, std::function<void()> callback,
+                                     const Layout::FramebufferLayout& layout) {
+    if (screenshot_requested) {
+        LOG_ERROR(Render, "A screenshot is already requested or in progress, ignoring the request");
+        return;
+    }
+    screenshot_bits = data;
+    screenshot_complete_callback = std::move(callback);
+    screenshot_framebuffer_layout = layout;
+    screenshot_requested = true;
+}
+
+bool RendererBase::IsFramePresented() const {
+    if (!Settings::values.max_throughput) {
+        return true;
+    }
+    const int interval = std::max<int>(Settings::values.max_throughput_present_interval, 1);
+    return m_current_frame % interval == 0;
+}
+
 void RendererBase::RefreshRasterizerSetting() {
-    bool hw_renderer_enabled = VideoCore::g_hw_renderer_enabled;
+    // The null renderer has no graphics context to run the hardware rasterizer in
+    bool hw_renderer_enabled =
+        VideoCore::g_hw_renderer_enabled && !Settings::values.use_null_renderer;
     if (rasterizer == nullptr || opengl_rasterizer_active != hw_renderer_enabled) {
         opengl_rasterizer_active = hw_renderer_enabled;
 
@@ -4,8 +4,14 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <functional>
 #include <memory>
 #include "common/common_types.h"
+#include "core/frontend/framebuffer_layout.h"
+#include "core/hw/gpu.h"
+#include "core/hw/lcd.h"
 #include "video_core/rasterizer_interface.h"
 #include "video_core/video_core.h"
 
@@ -24,8 +30,14 @@ public:
     /// Shutdown the renderer
     virtual void ShutDown() = 0;
 
+    /// Screen configuration of a frame, copied from the GPU and LCD registers when the frame ends
+    struct FrameConfig {
+        std::array<GPU::Regs::FramebufferConfig, 2> framebuffers;
+        std::array<LCD::Regs::ColorFill, 2> color_fills;
+    };
+
     /// Finalize rendering the guest frame and draw into the presentation texture
-    virtual void SwapBuffers() = 0;
+    virtual void SwapBuffers(const FrameConfig& config) = 0;
 
     /// Draws the latest frame to the window waiting timeout_ms for a frame to arrive (Renderer
     /// specific implementation)
@@ -40,6 +52,10 @@ public:
     /// Updates the framebuffer layout of the contained render window handle.
     void UpdateCurrentFramebufferLayout();
 
+    /// Request a screenshot of the next frame
+    void RequestScreenshot(void* data, std::function<void()> callback,
+                           const Layout::FramebufferLayout& layout);
+
     // Getter/setter functions:
     // ------------------------
 
@@ -67,11 +83,20 @@ public:
     void Sync();
 
 protected:
+    /// Returns whether the current frame is presented. Max throughput mode skips most frames.
+    bool IsFramePresented() const;
+
     Frontend::EmuWindow& render_window; ///< Reference to the render window handle.
     std::unique_ptr<VideoCore::RasterizerInterface> rasterizer;
     f32 m_current_fps = 0.0f; ///< Current framerate, should be set by the renderer
     int m_current_frame = 0;  ///< Current frame, should be set by the renderer
 
+    // Screenshot
+    std::atomic<bool> screenshot_requested{false};
+    void* screenshot_bits = nullptr;
+    std::function<void()> screenshot_complete_callback;
+    Layout::FramebufferLayout screenshot_framebuffer_layout;
+
 private:
     bool opengl_rasterizer_active = false;
 };
@@ -0,0 +1,36 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/logging/log.h"
+#include "core/core.h"
+#include "core/core_timing.h"
+#include "video_core/renderer_null/renderer_null.h"
+#include "video_core/swrasterizer/swrasterizer.h"
+
+namespace VideoCore {
+
+RendererNull::RendererNull(Frontend::EmuWindow& window) : RendererBase{window} {}
+RendererNull::~RendererNull() = default;
+
+ResultStatus RendererNull::Init() {
+    rasterizer = std::make_unique<SWRasterizer>();
+    return ResultStatus::Success;
+}
+
+void RendererNull::SwapBuffers(const FrameConfig& config) {
+    if (screenshot_requested) {
+        LOG_ERROR(Render, "The null renderer cannot take screenshots");
+        screenshot_requested = false;
+        screenshot_complete_callback();
+    }
+
+    m_current_frame++;
+
+    auto& system = Core::System::GetInstance();
+    system.perf_stats->EndSystemFrame();
+    system.frame_limiter.DoFrameLimiting(system.CoreTiming().GetGlobalTimeUs());
+    system.perf_stats->BeginSystemFrame();
+}
+
+} // namespace VideoCore
@@ -0,0 +1,28 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "video_core/renderer_base.h"
+
+namespace VideoCore {
+
+/**
+ * Renderer that emulates the GPU with the software rasterizer but never presents anything. It needs
+ * no graphics context, for headless runs and tests.
+ */
+class RendererNull : public RendererBase {
+public:
+    explicit RendererNull(Frontend::EmuWindow& window);
+    ~RendererNull() override;
+
+    ResultStatus Init() override;
+    void ShutDown() override {}
+    void SwapBuffers(const FrameConfig& config) override;
+    void TryPresent(int timeout_ms) override {}
+    void PrepareVideoDumping() override {}
+    void CleanupVideoDumping() override {}
+};
+
+} // namespace VideoCore
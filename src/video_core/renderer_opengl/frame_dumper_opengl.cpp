@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <cstring>
 #include <glad/glad.h>
 #include "core/frontend/emu_window.h"
 #include "core/frontend/scope_acquire_context.h"
@@ -66,10 +67,11 @@ void FrameDumperOpenGL::PresentLoop() {
         // Bind the previous PBO and read the pixels
         glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[next_pbo].handle);
         GLubyte* pixels = static_cast<GLubyte*>(glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY));
-        VideoDumper::VideoFrame frame_data{layout.width, layout.height, pixels};
-        video_dumper.AddVideoFrame(std::move(frame_data));
+        auto frame_data = video_dumper.AcquireVideoFrame(layout.width, layout.height);
+        std::memcpy(frame_data.data->data(), pixels, frame_data.data->size());
         glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
         glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        video_dumper.AddVideoFrame(std::move(frame_data));
 
         current_pbo = (current_pbo + 1) % 2;
         next_pbo = (current_pbo + 1) % 2;
@@ -47,7 +47,9 @@ public:
     void AddTriangle(const Pica::Shader::OutputVertex& v0, const Pica::Shader::OutputVertex& v1,
                      const Pica::Shader::OutputVertex& v2) override;
     void DrawTriangles() override;
+    void NotifyPicaRegisterWrite(u32 id, u32 value) override;
     void NotifyPicaRegisterChanged(u32 id) override;
+    void NotifyCommandListEnd() override;
     void FlushAll() override;
     void FlushRegion(PAddr addr, u32 size) override;
     void InvalidateRegion(PAddr addr, u32 size) override;
@@ -240,6 +242,12 @@ private:
     /// Generic draw function for DrawTriangles and AccelerateDrawBatch
     bool Draw(bool accelerate, bool is_indexed);
 
+    /// Whether the triangles of the current PICA draw can wait to be drawn with the next ones
+    bool CanDeferDraw() const;
+
+    /// Draws the triangles of the PICA draws that were deferred to be merged, if any
+    void FlushPendingDraws();
+
     /// Internal implementation for AccelerateDrawBatch
     bool AccelerateDrawBatchInternal(bool is_indexed);
 
@@ -262,6 +270,10 @@ private:
     /// Setup geometry shader for AccelerateDrawBatch
     bool SetupGeometryShader();
 
+    /// PICA state of the instance this rasterizer draws for, looked up once as it is read on every
+    /// register write
+    Pica::State& pica_state;
+
     bool is_amd;
 
     OpenGLState state;
@@ -270,8 +282,8 @@ private:
     RasterizerCacheOpenGL res_cache;
 
     std::vector<HardwareVertex> vertex_batch;
-
-    bool shader_dirty = true;
+    /// Number of PICA draws whose triangles are in vertex_batch waiting to be drawn
+    std::size_t pending_draws = 0;
 
     struct {
         UniformData data;
@@ -22,10 +22,10 @@
 #include "common/math_util.h"
 #include "common/microprofile.h"
 #include "common/scope_exit.h"
-#include "common/texture.h"
 #include "common/vector_math.h"
 #include "core/core.h"
 #include "core/custom_tex_cache.h"
+#include "core/dumping/image_dumper.h"
 #include "core/frontend/emu_window.h"
 #include "core/hle/kernel/process.h"
 #include "core/memory.h"
@@ -233,7 +233,7 @@ static void MortonCopy(u32 stride, u32 height, u8* gl_buffer, PAddr base, PAddr
         }
     };
 
-    u8* tile_buffer = VideoCore::g_memory->GetPhysicalPointer(start);
+    u8* tile_buffer = VideoCore::GetMemory().GetPhysicalPointer(start);
 
     if (start < aligned_start && !morton_to_gl) {
         std::array<u8, tile_size> tmp_buf;
@@ -250,8 +250,8 @@ static void MortonCopy(u32 stride, u32 height, u8* gl_buffer, PAddr base, PAddr
     while (tile_buffer < buffer_end) {
         // Pokemon Super Mystery Dungeon will try to use textures that go beyond
         // the end address of VRAM. Stop reading if reaches invalid address
-        if (!VideoCore::g_memory->IsValidPhysicalAddress(current_paddr) ||
-            !VideoCore::g_memory->IsValidPhysicalAddress(current_paddr + tile_size)) {
+        if (!VideoCore::GetMemory().IsValidPhysicalAddress(current_paddr) ||
+            !VideoCore::GetMemory().IsValidPhysicalAddress(current_paddr + tile_size)) {
             LOG_ERROR(Render_OpenGL, "Out of bound texture");
             break;
         }
@@ -596,7 +596,7 @@ void CachedSurface::LoadGLBuffer(PAddr load_start, PAddr load_end) {
     const bool need_swap =
         GLES && (pixel_format == PixelFormat::RGBA8 || pixel_format == PixelFormat::RGB8);
 
-    const u8* const texture_src_data = VideoCore::g_memory->GetPhysicalPointer(addr);
+    const u8* const texture_src_data = VideoCore::GetMemory().GetPhysicalPointer(addr);
     if (texture_src_data == nullptr)
         return;
 
@@ -669,7 +669,7 @@ void CachedSurface::LoadGLBuffer(PAddr load_start, PAddr load_end) {
 
 MICROPROFILE_DEFINE(OpenGL_SurfaceFlush, "OpenGL", "Surface Flush", MP_RGB(128, 192, 64));
 void CachedSurface::FlushGLBuffer(PAddr flush_start, PAddr flush_end) {
-    u8* const dst_buffer = VideoCore::g_memory->GetPhysicalPointer(addr);
+    u8* const dst_buffer = VideoCore::GetMemory().GetPhysicalPointer(addr);
     if (dst_buffer == nullptr)
         return;
 
@@ -725,24 +725,10 @@ bool CachedSurface::LoadCustomTexture(u64 tex_hash) {
         return false;
     }
 
-    const auto& path_info = custom_tex_cache.LookupTexturePathInfo(tex_hash);
-    if (!image_interface->DecodePNG(custom_tex_info.tex, custom_tex_info.width,
-                                    custom_tex_info.height, path_info.path)) {
-        LOG_ERROR(Render_OpenGL, "Failed to load custom texture {}", path_info.path);
+    if (!custom_tex_cache.DecodeTexture(tex_hash, *image_interface, custom_tex_info)) {
         return false;
     }
-
-    const std::bitset<32> width_bits(custom_tex_info.width);
-    const std::bitset<32> height_bits(custom_tex_info.height);
-    if (width_bits.count() != 1 || height_bits.count() != 1) {
-        LOG_ERROR(Render_OpenGL, "Texture {} size is not a power of 2", path_info.path);
-        return false;
-    }
-
-    LOG_DEBUG(Render_OpenGL, "Loaded custom texture from {}", path_info.path);
-    Common::FlipRGBA8Texture(custom_tex_info.tex, custom_tex_info.width, custom_tex_info.height);
-    custom_tex_cache.CacheTexture(tex_hash, custom_tex_info.tex, custom_tex_info.width,
-                                  custom_tex_info.height);
+    custom_tex_cache.CacheTexture(tex_hash, custom_tex_info);
     return true;
 }
 
@@ -757,8 +743,7 @@ void CachedSurface::DumpTexture(GLuint target_tex, u64 tex_hash) {
         return;
     }
 
-    // Dump texture to RGBA8 and encode as PNG
-    const auto& image_interface = Core::System::GetInstance().GetImageInterface();
+    // Dump texture to RGBA8. It is encoded as PNG and written in the background.
     auto& custom_tex_cache = Core::System::GetInstance().CustomTexCache();
     std::string dump_path =
         fmt::format("{}textures/{:016X}/", FileUtil::GetUserPath(FileUtil::UserPath::DumpDir),
@@ -792,9 +777,14 @@ void CachedSurface::DumpTexture(GLuint target_tex, u64 tex_hash) {
         GetTexImageOES(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, height, width, 0,
                        &decoded_texture[0], decoded_texture.size());
         glBindTexture(GL_TEXTURE_2D, 0);
-        Common::FlipRGBA8Texture(decoded_texture, width, height);
-        if (!image_interface->EncodePNG(dump_path, decoded_texture, width, height))
-            LOG_ERROR(Render_OpenGL, "Failed to save decoded texture");
+
+        Core::ImageDumper::Image image;
+        image.path = std::move(dump_path);
+        image.pixels = std::move(decoded_texture);
+        image.width = width;
+        image.height = height;
+        image.flip = true;
+        Core::System::GetInstance().ImageDumper().Queue(std::move(image));
     }
 }
 
@@ -1465,7 +1455,7 @@ const CachedTextureCube& RasterizerCacheOpenGL::GetTextureCube(const TextureCube
 
 SurfaceSurfaceRect_Tuple RasterizerCacheOpenGL::GetFramebufferSurfaces(
     bool using_color_fb, bool using_depth_fb, const Common::Rectangle<s32>& viewport_rect) {
-    const auto& regs = Pica::g_state.regs;
+    const auto& regs = Pica::GetState().regs;
     const auto& config = regs.framebuffer.framebuffer;
 
     // update resolution_scale_factor and reset cache if changed
@@ -1795,7 +1785,8 @@ void RasterizerCacheOpenGL::ClearAll(bool flush) {
         const PAddr interval_end_addr = boost::icl::last_next(interval) << Memory::PAGE_BITS;
         const u32 interval_size = interval_end_addr - interval_start_addr;
 
-        VideoCore::g_memory->RasterizerMarkRegionCached(interval_start_addr, interval_size, false);
+        VideoCore::GetMemory().RasterizerMarkRegionCached(interval_start_addr, interval_size,
+                                                          false);
     }
 
     // Remove the whole cache without really looking at it.
@@ -1955,11 +1946,11 @@ void RasterizerCacheOpenGL::UpdatePagesCachedCount(PAddr addr, u32 size, int del
         const u32 interval_size = interval_end_addr - interval_start_addr;
 
         if (delta > 0 && count == delta)
-            VideoCore::g_memory->RasterizerMarkRegionCached(interval_start_addr, interval_size,
-                                                            true);
+            VideoCore::GetMemory().RasterizerMarkRegionCached(interval_start_addr, interval_size,
+                                                              true);
         else if (delta < 0 && count == -delta)
-            VideoCore::g_memory->RasterizerMarkRegionCached(interval_start_addr, interval_size,
-                                                            false);
+            VideoCore::GetMemory().RasterizerMarkRegionCached(interval_start_addr, interval_size,
+                                                              false);
         else
             ASSERT(count >= 0);
     }
@@ -3,10 +3,15 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <atomic>
+#include <functional>
+#include <numeric>
+#include <optional>
 #include <thread>
 #include <unordered_map>
 #include <boost/functional/hash.hpp>
 #include <boost/variant.hpp>
+#include "common/microprofile.h"
 #include "core/core.h"
 #include "video_core/renderer_opengl/gl_shader_disk_cache.h"
 #include "video_core/renderer_opengl/gl_shader_manager.h"
@@ -14,6 +19,11 @@
 
 namespace OpenGL {
 
+// These count how often the shader configurations are rebuilt from the registers
+MICROPROFILE_DEFINE(OpenGL_VSConfig, "OpenGL", "VS Config Build", MP_RGB(192, 96, 96));
+MICROPROFILE_DEFINE(OpenGL_GSConfig, "OpenGL", "GS Config Build", MP_RGB(96, 192, 96));
+MICROPROFILE_DEFINE(OpenGL_FSConfig, "OpenGL", "FS Config Build", MP_RGB(96, 96, 192));
+
 static u64 GetUniqueIdentifier(const Pica::Regs& regs, const ProgramCode& code) {
     std::size_t hash = 0;
     u64 regs_uid = Common::ComputeHash64(regs.reg_array.data(), Pica::Regs::NUM_REGS * sizeof(u32));
@@ -25,6 +35,14 @@ static u64 GetUniqueIdentifier(const Pica::Regs& regs, const ProgramCode& code)
     return static_cast<u64>(hash);
 }
 
+/// Reports a fragment shader using the unimplemented gas fog mode to the telemetry of the instance
+static void ReportGasMode(const PicaFSConfig& config) {
+    if (config.state.fog_mode == Pica::TexturingRegs::FogMode::Gas) {
+        Core::System::GetInstance().TelemetrySession().AddField(
+            Common::Telemetry::FieldType::Session, "VideoCore_Pica_UseGasMode", true);
+    }
+}
+
 static OGLProgram GeneratePrecompiledProgram(const ShaderDiskCacheDump& dump,
                                              const std::set<GLenum>& supported_formats) {
 
@@ -229,6 +247,19 @@ public:
         return {cached_shader.GetHandle(), std::move(result)};
     }
 
+    /// Like Get, but with the code generated ahead of time, so that it can be done on a worker
+    std::tuple<GLuint, std::optional<ShaderDecompiler::ProgramResult>> Build(
+        const KeyConfigType& config, ShaderDecompiler::ProgramResult program) {
+        auto [iter, new_shader] = shaders.emplace(config, OGLShaderStage{separable});
+        OGLShaderStage& cached_shader = iter->second;
+        std::optional<ShaderDecompiler::ProgramResult> result{};
+        if (new_shader) {
+            cached_shader.Create(program.code.c_str(), ShaderType);
+            result = std::move(program);
+        }
+        return {cached_shader.GetHandle(), std::move(result)};
+    }
+
     void Inject(const KeyConfigType& key, OGLProgram&& program) {
         OGLShaderStage stage{separable};
         stage.Inject(std::move(program));
@@ -254,25 +285,9 @@ public:
     explicit ShaderDoubleCache(bool separable) : separable(separable) {}
     std::tuple<GLuint, std::optional<ShaderDecompiler::ProgramResult>> Get(
         const KeyConfigType& key, const Pica::Shader::ShaderSetup& setup) {
-        std::optional<ShaderDecompiler::ProgramResult> result{};
         auto map_it = shader_map.find(key);
         if (map_it == shader_map.end()) {
-            auto program_opt = CodeGenerator(setup, key, separable);
-            if (!program_opt) {
-                shader_map[key] = nullptr;
-                return {0, std::nullopt};
-            }
-
-            std::string& program = program_opt->code;
-            auto [iter, new_shader] = shader_cache.emplace(program, OGLShaderStage{separable});
-            OGLShaderStage& cached_shader = iter->second;
-            if (new_shader) {
-                result.emplace();
-                result->code = program;
-                cached_shader.Create(program.c_str(), ShaderType);
-            }
-            shader_map[key] = &cached_shader;
-            return {cached_shader.GetHandle(), std::move(result)};
+            return Build(key, CodeGenerator(setup, key, separable));
         }
 
         if (map_it->second == nullptr) {
@@ -282,6 +297,30 @@ public:
         return {map_it->second->GetHandle(), std::nullopt};
     }
 
+    /**
+     * Like Get, but with the code generated ahead of time, so that it can be done on a worker.
+     * program_opt is empty if the PICA shader couldn't be translated.
+     */
+    std::tuple<GLuint, std::optional<ShaderDecompiler::ProgramResult>> Build(
+        const KeyConfigType& key, std::optional<ShaderDecompiler::ProgramResult> program_opt) {
+        if (!program_opt) {
+            shader_map[key] = nullptr;
+            return {0, std::nullopt};
+        }
+
+        std::optional<ShaderDecompiler::ProgramResult> result{};
+        std::string& program = program_opt->code;
+        auto [iter, new_shader] = shader_cache.emplace(program, OGLShaderStage{separable});
+        OGLShaderStage& cached_shader = iter->second;
+        if (new_shader) {
+            result.emplace();
+            result->code = program;
+            cached_shader.Create(program.c_str(), ShaderType);
+        }
+        shader_map[key] = &cached_shader;
+        return {cached_shader.GetHandle(), std::move(result)};
+    }
+
     void Inject(const KeyConfigType& key, std::string decomp, OGLProgram&& program) {
         OGLShaderStage stage{separable};
         stage.Inject(std::move(program));
@@ -343,6 +382,11 @@ public:
 
     ShaderTuple current;
 
+    /// Shaders selected from the last built configurations, reused until they are dirty
+    std::optional<GLuint> programmable_vs;
+    bool programmable_vs_accurate_mul = false;
+    std::optional<GLuint> fixed_gs;
+
     ProgrammableVertexShaders programmable_vertex_shaders;
     TrivialVertexShader trivial_vertex_shader;
 
@@ -360,9 +404,22 @@ ShaderProgramManager::ShaderProgramManager(bool separable, bool is_amd)
 ShaderProgramManager::~ShaderProgramManager() = default;
 
 bool ShaderProgramManager::UseProgrammableVertexShader(const Pica::Regs& regs,
-                                                       Pica::Shader::ShaderSetup& setup) {
+                                                       Pica::Shader::ShaderSetup& setup,
+                                                       bool config_dirty) {
+    // The accurate multiplication setting is part of the configuration but not of the registers
+    if (!config_dirty && impl->programmable_vs &&
+        impl->programmable_vs_accurate_mul == VideoCore::g_hw_shader_accurate_mul) {
+        if (*impl->programmable_vs == 0)
+            return false;
+        impl->current.vs = *impl->programmable_vs;
+        return true;
+    }
+
+    MICROPROFILE_SCOPE(OpenGL_VSConfig);
     PicaVSConfig config{regs.vs, setup};
     auto [handle, result] = impl->programmable_vertex_shaders.Get(config, setup);
+    impl->programmable_vs = handle;
+    impl->programmable_vs_accurate_mul = config.state.sanitize_mul;
     if (handle == 0)
         return false;
     impl->current.vs = handle;
@@ -384,9 +441,16 @@ void ShaderProgramManager::UseTrivialVertexShader() {
     impl->current.vs = impl->trivial_vertex_shader.Get();
 }
 
-void ShaderProgramManager::UseFixedGeometryShader(const Pica::Regs& regs) {
+void ShaderProgramManager::UseFixedGeometryShader(const Pica::Regs& regs, bool config_dirty) {
+    if (!config_dirty && impl->fixed_gs) {
+        impl->current.gs = *impl->fixed_gs;
+        return;
+    }
+
+    MICROPROFILE_SCOPE(OpenGL_GSConfig);
     PicaFixedGSConfig gs_config(regs);
     auto [handle, _] = impl->fixed_geometry_shaders.Get(gs_config);
+    impl->fixed_gs = handle;
     impl->current.gs = handle;
 }
 
@@ -395,11 +459,13 @@ void ShaderProgramManager::UseTrivialGeometryShader() {
 }
 
 void ShaderProgramManager::UseFragmentShader(const Pica::Regs& regs) {
+    MICROPROFILE_SCOPE(OpenGL_FSConfig);
     PicaFSConfig config = PicaFSConfig::BuildFromRegs(regs);
     auto [handle, result] = impl->fragment_shaders.Get(config);
     impl->current.fs = handle;
     // Save FS to the disk cache if its a new shader
     if (result) {
+        ReportGasMode(config);
         auto& disk_cache = impl->disk_cache;
         u64 unique_identifier = GetUniqueIdentifier(regs, {});
         ShaderDiskCacheRaw raw{unique_identifier, ProgramType::FS, regs, {}};
@@ -435,6 +501,52 @@ void ShaderProgramManager::ApplyTo(OpenGLState& state) {
     }
 }
 
+namespace {
+
+/// A transferable cache entry, with what the compilation on the GL thread needs
+struct PreparedShader {
+    std::optional<PicaVSConfig> vs_config;
+    std::optional<PicaFSConfig> fs_config;
+    /// Whether the binary of the shader is loaded from the precompiled cache
+    bool precompiled = false;
+    /// Generated code, when the shader is built from source. Empty if the translation failed.
+    std::optional<ShaderDecompiler::ProgramResult> program;
+};
+
+/**
+ * Calls work with each of the indices on a pool of threads, the calling thread included. progress
+ * is called on the calling thread with the number of indices done so far.
+ */
+void RunOnWorkers(const std::vector<std::size_t>& indices, const std::atomic_bool& stop_loading,
+                  const std::function<void(std::size_t)>& work,
+                  const std::function<void(std::size_t)>& progress) {
+    std::atomic<std::size_t> next{0};
+    std::atomic<std::size_t> done{0};
+    const auto worker = [&](bool report) {
+        std::size_t i;
+        while (!stop_loading && (i = next++) < indices.size()) {
+            work(indices[i]);
+            const std::size_t now_done = ++done;
+            if (report && progress) {
+                progress(now_done);
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    const std::size_t thread_count =
+        std::min<std::size_t>(std::max(1U, std::thread::hardware_concurrency()), indices.size());
+    for (std::size_t i = 1; i < thread_count; ++i) {
+        threads.emplace_back(worker, false);
+    }
+    worker(true);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+} // Anonymous namespace
+
 void ShaderProgramManager::LoadDiskCache(const std::atomic_bool& stop_loading,
                                          const VideoCore::DiskResourceLoadCallback& callback) {
     if (!impl->separable) {
@@ -449,167 +561,178 @@ void ShaderProgramManager::LoadDiskCache(const std::atomic_bool& stop_loading,
     }
     const auto& raws = *transferable;
 
-    auto [decompiled, dumps] = disk_cache.LoadPrecompiled();
+    auto precompiled_cache = disk_cache.LoadPrecompiled();
+    const auto& decompiled = precompiled_cache.first;
+    auto& dumps = precompiled_cache.second;
+
+    if (stop_loading) {
+        return;
+    }
+
+    const std::size_t total = raws.size();
+    std::vector<PreparedShader> prepared(total);
+    std::atomic_bool cache_invalid = false;
+    const auto prepare = [&](std::size_t i, bool allow_precompiled) {
+        const auto& raw{raws[i]};
+        const u64 unique_identifier{raw.GetUniqueIdentifier()};
+        auto& shader{prepared[i]};
+
+        const u64 calculated_hash =
+            GetUniqueIdentifier(raw.GetRawShaderConfig(), raw.GetProgramCode());
+        if (unique_identifier != calculated_hash) {
+            LOG_ERROR(Render_OpenGL,
+                      "Invalid hash in entry={:016x} (obtained hash={:016x}) - removing "
+                      "shader cache",
+                      raw.GetUniqueIdentifier(), calculated_hash);
+            cache_invalid = true;
+            return;
+        }
+
+        const auto decomp{decompiled.find(unique_identifier)};
+        shader.precompiled = allow_precompiled && decomp != decompiled.end() &&
+                             dumps.find(unique_identifier) != dumps.end();
+
+        if (raw.GetProgramType() == ProgramType::VS) {
+            auto [conf, setup] = BuildVSConfigFromRaw(raw);
+            // Only load this shader if its sanitize_mul setting matches
+            shader.precompiled =
+                shader.precompiled && decomp->second.sanitize_mul == conf.state.sanitize_mul;
+            if (!shader.precompiled) {
+                shader.program = GenerateVertexShader(setup, conf, impl->separable);
+            }
+            shader.vs_config.emplace(std::move(conf));
+        } else if (raw.GetProgramType() == ProgramType::FS) {
+            shader.fs_config = PicaFSConfig::BuildFromRegs(raw.GetRawShaderConfig());
+            if (!shader.precompiled) {
+                shader.program = GenerateFragmentShader(*shader.fs_config, impl->separable);
+            }
+        } else {
+            // Unsupported shader type got stored somehow so nuke the cache
+            LOG_ERROR(Frontend, "failed to load raw programtype {}", raw.GetProgramType());
+            cache_invalid = true;
+        }
+    };
 
+    // Rebuilding the configurations and generating the GLSL code doesn't need the GL context, so
+    // it is spread over a pool of threads. Only the compilation is left to this thread.
+    if (callback) {
+        callback(VideoCore::LoadCallbackStage::Decompile, 0, total);
+    }
+    std::vector<std::size_t> all_indices(total);
+    std::iota(all_indices.begin(), all_indices.end(), 0);
+    RunOnWorkers(all_indices, stop_loading, [&](std::size_t i) { prepare(i, true); },
+                 [&](std::size_t done) {
+                     if (callback) {
+                         callback(VideoCore::LoadCallbackStage::Decompile, done, total);
+                     }
+                 });
     if (stop_loading) {
         return;
     }
+    if (cache_invalid) {
+        disk_cache.InvalidateAll();
+        return;
+    }
+    // The workers fall back to the default instance, so telemetry is left to this thread
+    for (const auto& shader : prepared) {
+        if (shader.fs_config) {
+            ReportGasMode(*shader.fs_config);
+        }
+    }
 
-    std::set<GLenum> supported_formats = GetSupportedFormats();
+    if (callback) {
+        callback(VideoCore::LoadCallbackStage::Build, 0, total);
+    }
+    std::size_t built = 0;
 
     // Track if precompiled cache was altered during loading to know if we have to serialize the
     // virtual precompiled cache file back to the hard drive
     bool precompiled_cache_altered = false;
 
-    std::mutex mutex;
-    std::atomic_bool compilation_failed = false;
-    if (callback) {
-        callback(VideoCore::LoadCallbackStage::Decompile, 0, raws.size());
-    }
-    std::vector<std::size_t> load_raws_index;
-    // Loads both decompiled and precompiled shaders from the cache. If either one is missing for
-    const auto LoadPrecompiledWorker =
-        [&](std::size_t begin, std::size_t end, const std::vector<ShaderDiskCacheRaw>& raw_cache,
-            const ShaderDecompiledMap& decompiled_map, const ShaderDumpsMap& dump_map) {
-            for (std::size_t i = 0; i < end; ++i) {
-                if (stop_loading || compilation_failed) {
-                    return;
-                }
-                const auto& raw{raw_cache[i]};
-                const u64 unique_identifier{raw.GetUniqueIdentifier()};
-
-                const u64 calculated_hash =
-                    GetUniqueIdentifier(raw.GetRawShaderConfig(), raw.GetProgramCode());
-                if (unique_identifier != calculated_hash) {
-                    LOG_ERROR(Render_OpenGL,
-                              "Invalid hash in entry={:016x} (obtained hash={:016x}) - removing "
-                              "shader cache",
-                              raw.GetUniqueIdentifier(), calculated_hash);
-                    disk_cache.InvalidateAll();
-                    return;
-                }
-
-                const auto dump{dump_map.find(unique_identifier)};
-                const auto decomp{decompiled_map.find(unique_identifier)};
-
-                OGLProgram shader;
-
-                if (dump != dump_map.end() && decomp != decompiled_map.end()) {
-                    // Only load this shader if its sanitize_mul setting matches
-                    if (raw.GetProgramType() == ProgramType::VS &&
-                        decomp->second.sanitize_mul != VideoCore::g_hw_shader_accurate_mul) {
-                        continue;
-                    }
-
-                    // If the shader is dumped, attempt to load it
-                    shader = GeneratePrecompiledProgram(dump->second, supported_formats);
-                    if (shader.handle == 0) {
-                        // If any shader failed, stop trying to compile, delete the cache, and start
-                        // loading from raws
-                        compilation_failed = true;
-                        return;
-                    }
-                    // we have both the binary shader and the decompiled, so inject it into the
-                    // cache
-                    if (raw.GetProgramType() == ProgramType::VS) {
-                        auto [conf, setup] = BuildVSConfigFromRaw(raw);
-                        std::scoped_lock lock(mutex);
-
-                        impl->programmable_vertex_shaders.Inject(conf, decomp->second.result.code,
-                                                                 std::move(shader));
-                    } else if (raw.GetProgramType() == ProgramType::FS) {
-                        PicaFSConfig conf = PicaFSConfig::BuildFromRegs(raw.GetRawShaderConfig());
-                        std::scoped_lock lock(mutex);
-                        impl->fragment_shaders.Inject(conf, std::move(shader));
-                    } else {
-                        // Unsupported shader type got stored somehow so nuke the cache
-
-                        LOG_CRITICAL(Frontend, "failed to load raw programtype {}",
-                                     raw.GetProgramType());
-                        compilation_failed = true;
-                        return;
-                    }
-                } else {
-                    // Since precompiled didn't have the dump, we'll load them in the next phase
-                    std::scoped_lock lock(mutex);
-                    load_raws_index.push_back(i);
-                }
-                if (callback) {
-                    callback(VideoCore::LoadCallbackStage::Decompile, i, raw_cache.size());
-                }
-            }
-        };
+    // Load the shaders that have both a binary and their decompiled code
+    const std::set<GLenum> supported_formats = GetSupportedFormats();
+    bool precompiled_failed = false;
+    std::vector<std::size_t> not_loaded;
+    for (std::size_t i = 0; i < total; ++i) {
+        if (stop_loading) {
+            return;
+        }
+        auto& shader{prepared[i]};
+        if (!shader.precompiled) {
+            continue;
+        }
+        if (precompiled_failed) {
+            not_loaded.push_back(i);
+            continue;
+        }
 
-    LoadPrecompiledWorker(0, raws.size(), raws, decompiled, dumps);
+        const u64 unique_identifier{raws[i].GetUniqueIdentifier()};
+        OGLProgram program =
+            GeneratePrecompiledProgram(dumps.at(unique_identifier), supported_formats);
+        if (program.handle == 0) {
+            // If any shader failed, stop trying to load binaries and build from source instead
+            precompiled_failed = true;
+            not_loaded.push_back(i);
+            continue;
+        }
+        if (shader.vs_config) {
+            impl->programmable_vertex_shaders.Inject(
+                *shader.vs_config, decompiled.at(unique_identifier).result.code,
+                std::move(program));
+        } else {
+            impl->fragment_shaders.Inject(*shader.fs_config, std::move(program));
+        }
+        if (callback) {
+            callback(VideoCore::LoadCallbackStage::Build, ++built, total);
+        }
+    }
 
-    if (compilation_failed) {
-        // Invalidate the precompiled cache if a shader dumped shader was rejected
+    if (precompiled_failed) {
+        // Invalidate the precompiled cache if a dumped shader was rejected
         disk_cache.InvalidatePrecompiled();
         dumps.clear();
         precompiled_cache_altered = true;
-    }
 
-    if (callback) {
-        callback(VideoCore::LoadCallbackStage::Build, 0, raws.size());
+        // The shaders loaded so far stay, the others need their code to be generated
+        RunOnWorkers(not_loaded, stop_loading, [&](std::size_t i) { prepare(i, false); }, {});
     }
 
-    compilation_failed = false;
-
-    const auto LoadTransferable = [&](std::size_t begin, std::size_t end,
-                                      const std::vector<ShaderDiskCacheRaw>& raw_cache) {
-        for (std::size_t i = 0; i < end; ++i) {
-            if (stop_loading || compilation_failed) {
-                return;
-            }
-            const auto& raw{raw_cache[i]};
-            const u64 unique_identifier{raw.GetUniqueIdentifier()};
-
-            bool sanitize_mul = false;
-            GLuint handle{0};
-            std::optional<ShaderDecompiler::ProgramResult> result;
-            // Otherwise decompile and build the shader at boot and save the result to the
-            // precompiled file
-            if (raw.GetProgramType() == ProgramType::VS) {
-                // TODO: This isn't the ideal place to lock, since we really only want to
-                // lock access to the shared cache
-                auto [conf, setup] = BuildVSConfigFromRaw(raw);
-                std::scoped_lock lock(mutex);
-                auto [h, r] = impl->programmable_vertex_shaders.Get(conf, setup);
-                handle = h;
-                result = std::move(r);
-                sanitize_mul = conf.state.sanitize_mul;
-            } else if (raw.GetProgramType() == ProgramType::FS) {
-                PicaFSConfig conf = PicaFSConfig::BuildFromRegs(raw.GetRawShaderConfig());
-                std::scoped_lock lock(mutex);
-                auto [h, r] = impl->fragment_shaders.Get(conf);
-                handle = h;
-                result = std::move(r);
-            } else {
-                // Unsupported shader type got stored somehow so nuke the cache
-                LOG_ERROR(Frontend, "failed to load raw programtype {}", raw.GetProgramType());
-                compilation_failed = true;
-                return;
-            }
-            if (handle == 0) {
-                LOG_ERROR(Frontend, "compilation from raw failed {:x} {:x}",
-                          raw.GetProgramCode().at(0), raw.GetProgramCode().at(1));
-                compilation_failed = true;
-                return;
-            }
-            // If this is a new shader, add it the precompiled cache
-            if (result) {
-                disk_cache.SaveDecompiled(unique_identifier, *result, sanitize_mul);
-                disk_cache.SaveDump(unique_identifier, handle);
-                precompiled_cache_altered = true;
-            }
+    // Build the remaining shaders from source and save them to the precompiled cache
+    bool compilation_failed = false;
+    for (std::size_t i = 0; i < total && !stop_loading; ++i) {
+        auto& shader{prepared[i]};
+        if (shader.precompiled) {
+            continue;
+        }
 
-            if (callback) {
-                callback(VideoCore::LoadCallbackStage::Build, i, raw_cache.size());
-            }
+        const u64 unique_identifier{raws[i].GetUniqueIdentifier()};
+        bool sanitize_mul = false;
+        GLuint handle{0};
+        std::optional<ShaderDecompiler::ProgramResult> result;
+        if (shader.vs_config) {
+            std::tie(handle, result) = impl->programmable_vertex_shaders.Build(
+                *shader.vs_config, std::move(shader.program));
+            sanitize_mul = shader.vs_config->state.sanitize_mul;
+        } else {
+            std::tie(handle, result) =
+                impl->fragment_shaders.Build(*shader.fs_config, std::move(*shader.program));
+        }
+        if (handle == 0) {
+            LOG_ERROR(Frontend, "compilation from raw failed {:016x}", unique_identifier);
+            compilation_failed = true;
+            break;
+        }
+        // If this is a new shader, add it the precompiled cache
+        if (result) {
+            disk_cache.SaveDecompiled(unique_identifier, *result, sanitize_mul);
+            disk_cache.SaveDump(unique_identifier, handle);
+            precompiled_cache_altered = true;
         }
-    };
 
-    LoadTransferable(0, raws.size(), raws);
+        if (callback) {
+            callback(VideoCore::LoadCallbackStage::Build, ++built, total);
+        }
+    }
 
     if (compilation_failed) {
         disk_cache.InvalidateAll();
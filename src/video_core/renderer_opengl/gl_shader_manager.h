@@ -105,11 +105,18 @@ public:
     void LoadDiskCache(const std::atomic_bool& stop_loading,
                        const VideoCore::DiskResourceLoadCallback& callback);
 
-    bool UseProgrammableVertexShader(const Pica::Regs& config, Pica::Shader::ShaderSetup& setup);
+    /**
+     * Selects the vertex shader translated from the PICA vertex shader. Unless config_dirty is set,
+     * the shader selected by the previous call is reused without rebuilding its configuration.
+     * @returns false if the PICA vertex shader can't be translated
+     */
+    bool UseProgrammableVertexShader(const Pica::Regs& config, Pica::Shader::ShaderSetup& setup,
+                                     bool config_dirty = true);
 
     void UseTrivialVertexShader();
 
-    void UseFixedGeometryShader(const Pica::Regs& regs);
+    /// Selects the fixed geometry shader, reusing the previous one unless config_dirty is set
+    void UseFixedGeometryShader(const Pica::Regs& regs, bool config_dirty = true);
 
     void UseTrivialGeometryShader();
 
@@ -168,7 +168,8 @@ public:
     OpenGLState& ResetRenderbuffer(GLuint handle);
 
 private:
-    static OpenGLState cur_state;
+    // Each thread has its own GL context, so the cached state is per thread
+    static thread_local OpenGLState cur_state;
 };
 
 } // namespace OpenGL
@@ -22,7 +22,6 @@
 #include "core/frontend/emu_window.h"
 #include "core/frontend/framebuffer_layout.h"
 #include "core/hw/gpu.h"
-#include "core/hw/hw.h"
 #include "core/hw/lcd.h"
 #include "core/memory.h"
 #include "core/settings.h"
@@ -371,23 +370,29 @@ MICROPROFILE_DEFINE(OpenGL_RenderFrame, "OpenGL", "Render Frame", MP_RGB(128, 12
 MICROPROFILE_DEFINE(OpenGL_WaitPresent, "OpenGL", "Wait For Present", MP_RGB(128, 128, 128));
 
 /// Swap buffers (render frame)
-void RendererOpenGL::SwapBuffers() {
+void RendererOpenGL::SwapBuffers(const FrameConfig& config) {
+    // Skipped frames are still counted, so that the frame timing stays intact
+    const bool present = IsFramePresented() || screenshot_requested || frame_dumper.IsDumping();
+
     // Maintain the rasterizer's state as a priority
     OpenGLState prev_state = OpenGLState::GetCurState();
-    state.Apply();
+    if (present) {
+        Core::PerfTimer perf_timer{Core::PerfCategory::Present};
+        state.Apply();
 
-    PrepareRendertarget();
+        PrepareRendertarget(config);
 
-    RenderScreenshot();
+        RenderScreenshot();
 
-    const auto& layout = render_window.GetFramebufferLayout();
-    RenderToMailbox(layout, render_window.mailbox, false);
+        const auto& layout = render_window.GetFramebufferLayout();
+        RenderToMailbox(layout, render_window.mailbox, false);
 
-    if (frame_dumper.IsDumping()) {
-        try {
-            RenderToMailbox(frame_dumper.GetLayout(), frame_dumper.mailbox, true);
-        } catch (const OGLTextureMailboxException& exception) {
-            LOG_DEBUG(Render_OpenGL, "Frame dumper exception caught: {}", exception.what());
+        if (frame_dumper.IsDumping()) {
+            try {
+                RenderToMailbox(frame_dumper.GetLayout(), frame_dumper.mailbox, true);
+            } catch (const OGLTextureMailboxException& exception) {
+                LOG_DEBUG(Render_OpenGL, "Frame dumper exception caught: {}", exception.what());
+            }
         }
     }
 
@@ -395,13 +400,17 @@ void RendererOpenGL::SwapBuffers() {
 
     Core::System::GetInstance().perf_stats->EndSystemFrame();
 
-    render_window.PollEvents();
+    if (present) {
+        render_window.PollEvents();
+    }
 
     Core::System::GetInstance().frame_limiter.DoFrameLimiting(
         Core::System::GetInstance().CoreTiming().GetGlobalTimeUs());
     Core::System::GetInstance().perf_stats->BeginSystemFrame();
 
-    prev_state.Apply();
+    if (present) {
+        prev_state.Apply();
+    }
     RefreshRasterizerSetting();
 
     if (Pica::g_debug_context && Pica::g_debug_context->recorder) {
@@ -410,7 +419,7 @@ void RendererOpenGL::SwapBuffers() {
 }
 
 void RendererOpenGL::RenderScreenshot() {
-    if (VideoCore::g_renderer_screenshot_requested) {
+    if (screenshot_requested) {
         // Draw this frame to the screenshot framebuffer
         screenshot_framebuffer.Create();
         GLuint old_read_fb = state.draw.read_framebuffer;
@@ -418,7 +427,7 @@ void RendererOpenGL::RenderScreenshot() {
         state.draw.read_framebuffer = state.draw.draw_framebuffer = screenshot_framebuffer.handle;
         state.Apply();
 
-        Layout::FramebufferLayout layout{VideoCore::g_screenshot_framebuffer_layout};
+        Layout::FramebufferLayout layout{screenshot_framebuffer_layout};
 
         GLuint renderbuffer;
         glGenRenderbuffers(1, &renderbuffer);
@@ -430,7 +439,7 @@ void RendererOpenGL::RenderScreenshot() {
         DrawScreens(layout, false);
 
         glReadPixels(0, 0, layout.width, layout.height, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV,
-                     VideoCore::g_screenshot_bits);
+                     screenshot_bits);
 
         screenshot_framebuffer.Release();
         state.draw.read_framebuffer = old_read_fb;
@@ -438,22 +447,16 @@ void RendererOpenGL::RenderScreenshot() {
         state.Apply();
         glDeleteRenderbuffers(1, &renderbuffer);
 
-        VideoCore::g_screenshot_complete_callback();
-        VideoCore::g_renderer_screenshot_requested = false;
+        screenshot_complete_callback();
+        screenshot_requested = false;
     }
 }
 
-void RendererOpenGL::PrepareRendertarget() {
+void RendererOpenGL::PrepareRendertarget(const FrameConfig& config) {
     for (int i : {0, 1, 2}) {
         int fb_id = i == 2 ? 1 : 0;
-        const auto& framebuffer = GPU::g_regs.framebuffer_config[fb_id];
-
-        // Main LCD (0): 0x1ED02204, Sub LCD (1): 0x1ED02A04
-        u32 lcd_color_addr =
-            (fb_id == 0) ? LCD_REG_INDEX(color_fill_top) : LCD_REG_INDEX(color_fill_bottom);
-        lcd_color_addr = HW::VADDR_LCD + 4 * lcd_color_addr;
-        LCD::Regs::ColorFill color_fill = {0};
-        LCD::Read(color_fill.raw, lcd_color_addr);
+        const auto& framebuffer = config.framebuffers[fb_id];
+        const LCD::Regs::ColorFill& color_fill = config.color_fills[fb_id];
 
         if (color_fill.is_enabled) {
             LoadColorToActiveGLTexture(color_fill.color_r, color_fill.color_g, color_fill.color_b,
@@ -567,7 +570,7 @@ void RendererOpenGL::LoadFBToScreenInfo(const GPU::Regs::FramebufferConfig& fram
 
         Memory::RasterizerFlushRegion(framebuffer_addr, framebuffer.stride * framebuffer.height);
 
-        const u8* framebuffer_data = VideoCore::g_memory->GetPhysicalPointer(framebuffer_addr);
+        const u8* framebuffer_data = VideoCore::GetMemory().GetPhysicalPointer(framebuffer_addr);
 
         state.texture_units[0].texture_2d = screen_info.texture.resource.handle;
         state.Apply();
@@ -69,7 +69,7 @@ public:
     void ShutDown() override;
 
     /// Finalizes rendering the guest frame
-    void SwapBuffers() override;
+    void SwapBuffers(const FrameConfig& config) override;
 
     /// Draws the latest frame from texture mailbox to the currently bound draw framebuffer in this
     /// context
@@ -85,7 +85,7 @@ private:
     void InitOpenGLObjects();
     void ReloadSampler();
     void ReloadShader();
-    void PrepareRendertarget();
+    void PrepareRendertarget(const FrameConfig& config);
     void RenderScreenshot();
     void RenderToMailbox(const Layout::FramebufferLayout& layout,
                          std::unique_ptr<Frontend::TextureMailbox>& mailbox, bool flipped);
@@ -134,15 +134,13 @@ void GSUnitState::ConfigOutput(const ShaderRegs& config) {
 
 MICROPROFILE_DEFINE(GPU_Shader, "GPU", "Shader", MP_RGB(50, 50, 240));
 
-#ifdef ARCHITECTURE_x86_64
-static std::unique_ptr<JitX64Engine> jit_engine;
-#endif // ARCHITECTURE_x86_64
 static InterpreterEngine interpreter_engine;
 
 ShaderEngine* GetEngine() {
 #ifdef ARCHITECTURE_x86_64
     // TODO(yuriks): Re-initialize on each change rather than being persistent
     if (VideoCore::g_shader_jit_enabled) {
+        auto& jit_engine = GetState().jit_engine;
         if (jit_engine == nullptr) {
             jit_engine = std::make_unique<JitX64Engine>();
         }
@@ -154,9 +152,7 @@ ShaderEngine* GetEngine() {
 }
 
 void Shutdown() {
-#ifdef ARCHITECTURE_x86_64
-    jit_engine = nullptr;
-#endif // ARCHITECTURE_x86_64
+    GetState().jit_engine = nullptr;
 }
 
 } // namespace Pica::Shader
@@ -81,7 +81,7 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
     const auto& program_code = setup.program_code;
 
     // Placeholder for invalid inputs
-    static float24 dummy_vec4_float24[4];
+    static thread_local float24 dummy_vec4_float24[4];
 
     unsigned iteration = 0;
     bool exit_loop = false;
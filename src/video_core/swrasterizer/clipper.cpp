@@ -61,7 +61,7 @@ static void InitScreenCoordinates(Vertex& vtx) {
         float24 offset_z;
     } viewport;
 
-    const auto& regs = g_state.regs;
+    const auto& regs = GetState().regs;
     viewport.halfsize_x = float24::FromRaw(regs.rasterizer.viewport_size_x);
     viewport.halfsize_y = float24::FromRaw(regs.rasterizer.viewport_size_y);
     viewport.offset_x = float24::FromFloat32(static_cast<float>(regs.rasterizer.viewport_corner.x));
@@ -156,8 +156,8 @@ void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const Outpu
             return;
     }
 
-    if (g_state.regs.rasterizer.clip_enable) {
-        ClippingEdge custom_edge{g_state.regs.rasterizer.GetClipCoef()};
+    if (GetState().regs.rasterizer.clip_enable) {
+        ClippingEdge custom_edge{GetState().regs.rasterizer.GetClipCoef()};
         Clip(custom_edge);
 
         if (output_list->size() < 3)
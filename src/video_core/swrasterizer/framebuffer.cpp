@@ -10,17 +10,21 @@
 #include "common/vector_math.h"
 #include "core/hw/gpu.h"
 #include "core/memory.h"
-#include "video_core/pica_state.h"
+#include "video_core/pica_types.h"
 #include "video_core/regs_framebuffer.h"
 #include "video_core/swrasterizer/framebuffer.h"
 #include "video_core/utils.h"
-#include "video_core/video_core.h"
 
 namespace Pica::Rasterizer {
 
-void DrawPixel(int x, int y, const Common::Vec4<u8>& color) {
-    const auto& framebuffer = g_state.regs.framebuffer.framebuffer;
-    const PAddr addr = framebuffer.GetColorBufferPhysicalAddress();
+FramebufferTarget GetFramebufferTarget(const FramebufferRegs& regs, Memory::MemorySystem& memory) {
+    return {regs,
+            memory.GetPhysicalPointer(regs.framebuffer.GetColorBufferPhysicalAddress()),
+            memory.GetPhysicalPointer(regs.framebuffer.GetDepthBufferPhysicalAddress())};
+}
+
+void DrawPixel(const FramebufferTarget& target, int x, int y, const Common::Vec4<u8>& color) {
+    const auto& framebuffer = target.regs.framebuffer;
 
     // Similarly to textures, the render framebuffer is laid out from bottom to top, too.
     // NOTE: The framebuffer height register contains the actual FB height minus one.
@@ -31,7 +35,7 @@ void DrawPixel(int x, int y, const Common::Vec4<u8>& color) {
         GPU::Regs::BytesPerPixel(GPU::Regs::PixelFormat(framebuffer.color_format.Value()));
     u32 dst_offset = VideoCore::GetMortonOffset(x, y, bytes_per_pixel) +
                      coarse_y * framebuffer.width * bytes_per_pixel;
-    u8* dst_pixel = VideoCore::g_memory->GetPhysicalPointer(addr) + dst_offset;
+    u8* dst_pixel = target.color_buffer + dst_offset;
 
     switch (framebuffer.color_format) {
     case FramebufferRegs::ColorFormat::RGBA8:
@@ -61,9 +65,8 @@ void DrawPixel(int x, int y, const Common::Vec4<u8>& color) {
     }
 }
 
-const Common::Vec4<u8> GetPixel(int x, int y) {
-    const auto& framebuffer = g_state.regs.framebuffer.framebuffer;
-    const PAddr addr = framebuffer.GetColorBufferPhysicalAddress();
+const Common::Vec4<u8> GetPixel(const FramebufferTarget& target, int x, int y) {
+    const auto& framebuffer = target.regs.framebuffer;
 
     y = framebuffer.height - y;
 
@@ -72,7 +75,7 @@ const Common::Vec4<u8> GetPixel(int x, int y) {
         GPU::Regs::BytesPerPixel(GPU::Regs::PixelFormat(framebuffer.color_format.Value()));
     u32 src_offset = VideoCore::GetMortonOffset(x, y, bytes_per_pixel) +
                      coarse_y * framebuffer.width * bytes_per_pixel;
-    u8* src_pixel = VideoCore::g_memory->GetPhysicalPointer(addr) + src_offset;
+    u8* src_pixel = target.color_buffer + src_offset;
 
     switch (framebuffer.color_format) {
     case FramebufferRegs::ColorFormat::RGBA8:
@@ -99,10 +102,9 @@ const Common::Vec4<u8> GetPixel(int x, int y) {
     return {0, 0, 0, 0};
 }
 
-u32 GetDepth(int x, int y) {
-    const auto& framebuffer = g_state.regs.framebuffer.framebuffer;
-    const PAddr addr = framebuffer.GetDepthBufferPhysicalAddress();
-    u8* depth_buffer = VideoCore::g_memory->GetPhysicalPointer(addr);
+u32 GetDepth(const FramebufferTarget& target, int x, int y) {
+    const auto& framebuffer = target.regs.framebuffer;
+    u8* depth_buffer = target.depth_buffer;
 
     y = framebuffer.height - y;
 
@@ -128,10 +130,9 @@ u32 GetDepth(int x, int y) {
     }
 }
 
-u8 GetStencil(int x, int y) {
-    const auto& framebuffer = g_state.regs.framebuffer.framebuffer;
-    const PAddr addr = framebuffer.GetDepthBufferPhysicalAddress();
-    u8* depth_buffer = VideoCore::g_memory->GetPhysicalPointer(addr);
+u8 GetStencil(const FramebufferTarget& target, int x, int y) {
+    const auto& framebuffer = target.regs.framebuffer;
+    u8* depth_buffer = target.depth_buffer;
 
     y = framebuffer.height - y;
 
@@ -155,10 +156,9 @@ u8 GetStencil(int x, int y) {
     }
 }
 
-void SetDepth(int x, int y, u32 value) {
-    const auto& framebuffer = g_state.regs.framebuffer.framebuffer;
-    const PAddr addr = framebuffer.GetDepthBufferPhysicalAddress();
-    u8* depth_buffer = VideoCore::g_memory->GetPhysicalPointer(addr);
+void SetDepth(const FramebufferTarget& target, int x, int y, u32 value) {
+    const auto& framebuffer = target.regs.framebuffer;
+    u8* depth_buffer = target.depth_buffer;
 
     y = framebuffer.height - y;
 
@@ -190,10 +190,9 @@ void SetDepth(int x, int y, u32 value) {
     }
 }
 
-void SetStencil(int x, int y, u8 value) {
-    const auto& framebuffer = g_state.regs.framebuffer.framebuffer;
-    const PAddr addr = framebuffer.GetDepthBufferPhysicalAddress();
-    u8* depth_buffer = VideoCore::g_memory->GetPhysicalPointer(addr);
+void SetStencil(const FramebufferTarget& target, int x, int y, u8 value) {
+    const auto& framebuffer = target.regs.framebuffer;
+    u8* depth_buffer = target.depth_buffer;
 
     y = framebuffer.height - y;
 
@@ -375,10 +374,9 @@ static void EncodeX24S8Shadow(u8 stencil, u8* bytes) {
     bytes[3] = stencil;
 }
 
-void DrawShadowMapPixel(int x, int y, u32 depth, u8 stencil) {
-    const auto& framebuffer = g_state.regs.framebuffer.framebuffer;
-    const auto& shadow = g_state.regs.framebuffer.shadow;
-    const PAddr addr = framebuffer.GetColorBufferPhysicalAddress();
+void DrawShadowMapPixel(const FramebufferTarget& target, int x, int y, u32 depth, u8 stencil) {
+    const auto& framebuffer = target.regs.framebuffer;
+    const auto& shadow = target.regs.shadow;
 
     y = framebuffer.height - y;
 
@@ -386,7 +384,7 @@ void DrawShadowMapPixel(int x, int y, u32 depth, u8 stencil) {
     u32 bytes_per_pixel = 4;
     u32 dst_offset = VideoCore::GetMortonOffset(x, y, bytes_per_pixel) +
                      coarse_y * framebuffer.width * bytes_per_pixel;
-    u8* dst_pixel = VideoCore::g_memory->GetPhysicalPointer(addr) + dst_offset;
+    u8* dst_pixel = target.color_buffer + dst_offset;
 
     auto ref = DecodeD24S8Shadow(dst_pixel);
     u32 ref_z = ref.x;
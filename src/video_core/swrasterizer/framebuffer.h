@@ -8,14 +8,27 @@
 #include "common/vector_math.h"
 #include "video_core/regs_framebuffer.h"
 
+namespace Memory {
+class MemorySystem;
+}
+
 namespace Pica::Rasterizer {
 
-void DrawPixel(int x, int y, const Common::Vec4<u8>& color);
-const Common::Vec4<u8> GetPixel(int x, int y);
-u32 GetDepth(int x, int y);
-u8 GetStencil(int x, int y);
-void SetDepth(int x, int y, u32 value);
-void SetStencil(int x, int y, u8 value);
+/// The registers and the buffers of the framebuffer being drawn to, looked up once per triangle
+struct FramebufferTarget {
+    const FramebufferRegs& regs;
+    u8* color_buffer;
+    u8* depth_buffer;
+};
+
+FramebufferTarget GetFramebufferTarget(const FramebufferRegs& regs, Memory::MemorySystem& memory);
+
+void DrawPixel(const FramebufferTarget& target, int x, int y, const Common::Vec4<u8>& color);
+const Common::Vec4<u8> GetPixel(const FramebufferTarget& target, int x, int y);
+u32 GetDepth(const FramebufferTarget& target, int x, int y);
+u8 GetStencil(const FramebufferTarget& target, int x, int y);
+void SetDepth(const FramebufferTarget& target, int x, int y, u32 value);
+void SetStencil(const FramebufferTarget& target, int x, int y, u8 value);
 u8 PerformStencilAction(FramebufferRegs::StencilAction action, u8 old_stencil, u8 ref);
 
 Common::Vec4<u8> EvaluateBlendEquation(const Common::Vec4<u8>& src,
@@ -26,6 +39,6 @@ Common::Vec4<u8> EvaluateBlendEquation(const Common::Vec4<u8>& src,
 
 u8 LogicOp(u8 src, u8 dest, FramebufferRegs::LogicOp op);
 
-void DrawShadowMapPixel(int x, int y, u32 depth, u8 stencil);
+void DrawShadowMapPixel(const FramebufferTarget& target, int x, int y, u32 depth, u8 stencil);
 
 } // namespace Pica::Rasterizer
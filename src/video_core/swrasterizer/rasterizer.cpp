@@ -125,7 +125,8 @@ MICROPROFILE_DEFINE(GPU_Rasterization, "GPU", "Rasterization", MP_RGB(50, 50, 24
  */
 static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Vertex& v2,
                                     bool reversed = false) {
-    const auto& regs = g_state.regs;
+    const State& state = GetState();
+    const auto& regs = state.regs;
     MICROPROFILE_SCOPE(GPU_Rasterization);
 
     // vertex positions in rasterizer coordinates
@@ -216,9 +217,12 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
     auto tev_stages = regs.texturing.GetTevStages();
 
     bool stencil_action_enable =
-        g_state.regs.framebuffer.output_merger.stencil_test.enable &&
-        g_state.regs.framebuffer.framebuffer.depth_format == FramebufferRegs::DepthFormat::D24S8;
-    const auto stencil_test = g_state.regs.framebuffer.output_merger.stencil_test;
+        state.regs.framebuffer.output_merger.stencil_test.enable &&
+        state.regs.framebuffer.framebuffer.depth_format == FramebufferRegs::DepthFormat::D24S8;
+    const auto stencil_test = state.regs.framebuffer.output_merger.stencil_test;
+
+    Memory::MemorySystem& memory = VideoCore::GetMemory();
+    const FramebufferTarget target = GetFramebufferTarget(regs.framebuffer, memory);
 
     // Enter rasterization loop, starting at the center of the topleft bounding box corner.
     // TODO: Not sure if looping through x first might be faster
@@ -404,8 +408,7 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
                     t = texture.config.height - 1 -
                         GetWrappedTexCoord(texture.config.wrap_t, t, texture.config.height);
 
-                    const u8* texture_data =
-                        VideoCore::g_memory->GetPhysicalPointer(texture_address);
+                    const u8* texture_data = memory.GetPhysicalPointer(texture_address);
                     auto info =
                         Texture::TextureInfo::FromPicaRegister(texture.config, texture.format);
 
@@ -434,7 +437,7 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
             if (regs.texturing.main_config.texture3_enable) {
                 const auto& proctex_uv = uv[regs.texturing.main_config.texture3_coordinates];
                 texture_color[3] = ProcTex(proctex_uv.u().ToFloat32(), proctex_uv.v().ToFloat32(),
-                                           g_state.regs.texturing, g_state.proctex);
+                                           state.regs.texturing, state.proctex);
             }
 
             // Texture environment - consists of 6 stages of color and alpha combining.
@@ -456,7 +459,7 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
             Common::Vec4<u8> primary_fragment_color = {0, 0, 0, 0};
             Common::Vec4<u8> secondary_fragment_color = {0, 0, 0, 0};
 
-            if (!g_state.regs.lighting.disable) {
+            if (!state.regs.lighting.disable) {
                 Common::Quaternion<float> normquat =
                     Common::Quaternion<float>{
                         {GetInterpolatedAttribute(v0.quat.x, v1.quat.x, v2.quat.x).ToFloat32(),
@@ -472,7 +475,7 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
                     GetInterpolatedAttribute(v0.view.z, v1.view.z, v2.view.z).ToFloat32(),
                 };
                 std::tie(primary_fragment_color, secondary_fragment_color) = ComputeFragmentsColors(
-                    g_state.regs.lighting, g_state.lighting, normquat, view, texture_color);
+                    state.regs.lighting, state.lighting, normquat, view, texture_color);
             }
 
             for (unsigned tev_stage_index = 0; tev_stage_index < tev_stages.size();
@@ -581,7 +584,7 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
                 u32 depth_int = static_cast<u32>(depth * 0xFFFFFF);
                 // use green color as the shadow intensity
                 u8 stencil = combiner_output.y;
-                DrawShadowMapPixel(x >> 4, y >> 4, depth_int, stencil);
+                DrawShadowMapPixel(target, x >> 4, y >> 4, depth_int, stencil);
                 // skip the normal output merger pipeline if it is in shadow mode
                 continue;
             }
@@ -641,7 +644,7 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
 
                 // Get index into fog LUT
                 float fog_index;
-                if (g_state.regs.texturing.fog_flip) {
+                if (state.regs.texturing.fog_flip) {
                     fog_index = (1.0f - depth) * 128.0f;
                 } else {
                     fog_index = depth * 128.0f;
@@ -650,7 +653,7 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
                 // Generate clamped fog factor from LUT for given fog index
                 float fog_i = std::clamp(floorf(fog_index), 0.0f, 127.0f);
                 float fog_f = fog_index - fog_i;
-                const auto& fog_lut_entry = g_state.fog.lut[static_cast<unsigned int>(fog_i)];
+                const auto& fog_lut_entry = state.fog.lut[static_cast<unsigned int>(fog_i)];
                 float fog_factor = fog_lut_entry.ToFloat() + fog_lut_entry.DiffToFloat() * fog_f;
                 fog_factor = std::clamp(fog_factor, 0.0f, 1.0f);
 
@@ -663,18 +666,18 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
 
             u8 old_stencil = 0;
 
-            auto UpdateStencil = [stencil_test, x, y,
-                                  &old_stencil](Pica::FramebufferRegs::StencilAction action) {
+            auto UpdateStencil = [stencil_test, x, y, &old_stencil, &regs,
+                                  &target](Pica::FramebufferRegs::StencilAction action) {
                 u8 new_stencil =
                     PerformStencilAction(action, old_stencil, stencil_test.reference_value);
-                if (g_state.regs.framebuffer.framebuffer.allow_depth_stencil_write != 0)
-                    SetStencil(x >> 4, y >> 4,
+                if (regs.framebuffer.framebuffer.allow_depth_stencil_write != 0)
+                    SetStencil(target, x >> 4, y >> 4,
                                (new_stencil & stencil_test.write_mask) |
                                    (old_stencil & ~stencil_test.write_mask));
             };
 
             if (stencil_action_enable) {
-                old_stencil = GetStencil(x >> 4, y >> 4);
+                old_stencil = GetStencil(target, x >> 4, y >> 4);
                 u8 dest = old_stencil & stencil_test.input_mask;
                 u8 ref = stencil_test.reference_value & stencil_test.input_mask;
 
@@ -725,7 +728,7 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
             u32 z = (u32)(depth * ((1 << num_bits) - 1));
 
             if (output_merger.depth_test_enable) {
-                u32 ref_z = GetDepth(x >> 4, y >> 4);
+                u32 ref_z = GetDepth(target, x >> 4, y >> 4);
 
                 bool pass = false;
 
@@ -773,14 +776,14 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
             if (regs.framebuffer.framebuffer.allow_depth_stencil_write != 0 &&
                 output_merger.depth_write_enable) {
 
-                SetDepth(x >> 4, y >> 4, z);
+                SetDepth(target, x >> 4, y >> 4, z);
             }
 
             // The stencil depth_pass action is executed even if depth testing is disabled
             if (stencil_action_enable)
                 UpdateStencil(stencil_test.action_depth_pass);
 
-            auto dest = GetPixel(x >> 4, y >> 4);
+            auto dest = GetPixel(target, x >> 4, y >> 4);
             Common::Vec4<u8> blend_output = combiner_output;
 
             if (output_merger.alphablend_enable) {
@@ -886,7 +889,7 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
             };
 
             if (regs.framebuffer.framebuffer.allow_color_write != 0)
-                DrawPixel(x >> 4, y >> 4, result);
+                DrawPixel(target, x >> 4, y >> 4, result);
         }
     }
 }
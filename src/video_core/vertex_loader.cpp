@@ -8,18 +8,21 @@
 #include "common/vector_math.h"
 #include "core/memory.h"
 #include "video_core/debug_utils/debug_utils.h"
-#include "video_core/pica_state.h"
 #include "video_core/pica_types.h"
 #include "video_core/regs_pipeline.h"
 #include "video_core/shader/shader.h"
 #include "video_core/vertex_loader.h"
-#include "video_core/video_core.h"
 
 namespace Pica {
 
-void VertexLoader::Setup(const PipelineRegs& regs) {
+void VertexLoader::Setup(const PipelineRegs& regs,
+                         const Shader::AttributeBuffer& default_attributes_,
+                         Memory::MemorySystem& memory_) {
     ASSERT_MSG(!is_setup, "VertexLoader is not intended to be setup more than once.");
 
+    default_attributes = &default_attributes_;
+    memory = &memory_;
+
     const auto& attribute_config = regs.vertex_attributes;
     num_total_attributes = attribute_config.GetNumTotalAttributes();
 
@@ -97,7 +100,7 @@ void VertexLoader::LoadVertex(u32 base_address, int index, int vertex,
             switch (vertex_attribute_formats[i]) {
             case PipelineRegs::VertexAttributeFormat::BYTE: {
                 const s8* srcdata = reinterpret_cast<const s8*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
+                    memory->GetPhysicalPointer(source_addr));
                 for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
                     input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
                 }
@@ -105,7 +108,7 @@ void VertexLoader::LoadVertex(u32 base_address, int index, int vertex,
             }
             case PipelineRegs::VertexAttributeFormat::UBYTE: {
                 const u8* srcdata = reinterpret_cast<const u8*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
+                    memory->GetPhysicalPointer(source_addr));
                 for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
                     input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
                 }
@@ -113,7 +116,7 @@ void VertexLoader::LoadVertex(u32 base_address, int index, int vertex,
             }
             case PipelineRegs::VertexAttributeFormat::SHORT: {
                 const s16* srcdata = reinterpret_cast<const s16*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
+                    memory->GetPhysicalPointer(source_addr));
                 for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
                     input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
                 }
@@ -121,7 +124,7 @@ void VertexLoader::LoadVertex(u32 base_address, int index, int vertex,
             }
             case PipelineRegs::VertexAttributeFormat::FLOAT: {
                 const float* srcdata = reinterpret_cast<const float*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
+                    memory->GetPhysicalPointer(source_addr));
                 for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
                     input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
                 }
@@ -146,7 +149,7 @@ void VertexLoader::LoadVertex(u32 base_address, int index, int vertex,
                       input.attr[i][2].ToFloat32(), input.attr[i][3].ToFloat32());
         } else if (vertex_attribute_is_default[i]) {
             // Load the default attribute if we're configured to do so
-            input.attr[i] = g_state.input_default_attributes.attr[i];
+            input.attr[i] = default_attributes->attr[i];
             LOG_TRACE(
                 HW_GPU,
                 "Loaded default attribute {:x} for vertex {:x} (index {:x}): ({}, {}, {}, {})", i,
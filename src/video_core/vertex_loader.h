@@ -4,6 +4,10 @@
 #include "common/common_types.h"
 #include "video_core/regs_pipeline.h"
 
+namespace Memory {
+class MemorySystem;
+}
+
 namespace Pica {
 
 namespace DebugUtils {
@@ -17,11 +21,18 @@ struct AttributeBuffer;
 class VertexLoader {
 public:
     VertexLoader() = default;
-    explicit VertexLoader(const PipelineRegs& regs) {
-        Setup(regs);
+    VertexLoader(const PipelineRegs& regs, const Shader::AttributeBuffer& default_attributes,
+                 Memory::MemorySystem& memory) {
+        Setup(regs, default_attributes, memory);
     }
 
-    void Setup(const PipelineRegs& regs);
+    /**
+     * @param regs The vertex attribute configuration
+     * @param default_attributes Values of the attributes that aren't loaded from arrays
+     * @param memory Memory the vertex arrays are loaded from
+     */
+    void Setup(const PipelineRegs& regs, const Shader::AttributeBuffer& default_attributes,
+               Memory::MemorySystem& memory);
     void LoadVertex(u32 base_address, int index, int vertex, Shader::AttributeBuffer& input,
                     DebugUtils::MemoryAccessTracker& memory_accesses);
 
@@ -37,6 +48,8 @@ private:
     std::array<bool, 16> vertex_attribute_is_default;
     int num_total_attributes = 0;
     bool is_setup = false;
+    const Shader::AttributeBuffer* default_attributes = nullptr;
+    Memory::MemorySystem* memory = nullptr;
 };
 
 } // namespace Pica
@@ -5,10 +5,13 @@
 #include <memory>
 #include "common/archives.h"
 #include "common/logging/log.h"
+#include "core/core.h"
 #include "core/settings.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/pica.h"
 #include "video_core/pica_state.h"
 #include "video_core/renderer_base.h"
+#include "video_core/renderer_null/renderer_null.h"
 #include "video_core/renderer_opengl/gl_vars.h"
 #include "video_core/renderer_opengl/renderer_opengl.h"
 #include "video_core/video_core.h"
@@ -18,8 +21,6 @@
 
 namespace VideoCore {
 
-std::unique_ptr<RendererBase> g_renderer; ///< Renderer plugin
-
 std::atomic<bool> g_hw_renderer_enabled;
 std::atomic<bool> g_shader_jit_enabled;
 std::atomic<bool> g_hw_shader_enabled;
@@ -30,23 +31,59 @@ std::atomic<bool> g_renderer_bg_color_update_requested;
 std::atomic<bool> g_renderer_sampler_update_requested;
 std::atomic<bool> g_renderer_shader_update_requested;
 std::atomic<bool> g_texture_filter_update_requested;
-// Screenshot
-std::atomic<bool> g_renderer_screenshot_requested;
-void* g_screenshot_bits;
-std::function<void()> g_screenshot_complete_callback;
-Layout::FramebufferLayout g_screenshot_framebuffer_layout;
+RendererBase* GetRenderer() {
+    auto& system = Core::System::GetInstance();
+    return system.HasRenderer() ? &system.Renderer() : nullptr;
+}
 
-Memory::MemorySystem* g_memory;
+Memory::MemorySystem& GetMemory() {
+    return Core::System::GetInstance().Memory();
+}
 
-/// Initialize the video core
-ResultStatus Init(Frontend::EmuWindow& emu_window, Memory::MemorySystem& memory) {
-    g_memory = &memory;
-    Pica::Init();
+GPUThread* GetGPUThread() {
+    return Core::System::GetInstance().GetGPUThread();
+}
 
-    OpenGL::GLES = Settings::values.use_gles;
+void RunOnGPUThread(const std::function<void()>& func) {
+    if (GPUThread* gpu_thread = GetGPUThread()) {
+        gpu_thread->SubmitAndWait(func);
+    } else {
+        func();
+    }
+}
 
-    g_renderer = std::make_unique<OpenGL::RendererOpenGL>(emu_window);
-    ResultStatus result = g_renderer->Init();
+/// Initialize the video core
+ResultStatus Init(Frontend::EmuWindow& emu_window, std::unique_ptr<RendererBase>& renderer,
+                  std::unique_ptr<GPUThread>& gpu_thread) {
+    if (Settings::values.use_asynchronous_gpu_emulation && !Settings::values.use_null_renderer) {
+        if (auto context = emu_window.CreateSharedContext()) {
+            gpu_thread =
+                std::make_unique<GPUThread>(Core::System::GetInstance(), std::move(context));
+        } else {
+            LOG_WARNING(Render, "The frontend has no shared graphics context, the GPU will be "
+                                "emulated synchronously");
+        }
+    }
+
+    // With a GPU thread, every GL object is created on its context
+    ResultStatus result = ResultStatus::Success;
+    const auto init = [&] {
+        Pica::Init();
+
+        OpenGL::GLES = Settings::values.use_gles;
+
+        if (Settings::values.use_null_renderer) {
+            renderer = std::make_unique<RendererNull>(emu_window);
+        } else {
+            renderer = std::make_unique<OpenGL::RendererOpenGL>(emu_window);
+        }
+        result = renderer->Init();
+    };
+    if (gpu_thread) {
+        gpu_thread->SubmitAndWait(init);
+    } else {
+        init();
+    }
 
     if (result != ResultStatus::Success) {
         LOG_ERROR(Render, "initialization failed !");
@@ -58,32 +95,33 @@ ResultStatus Init(Frontend::EmuWindow& emu_window, Memory::MemorySystem& memory)
 }
 
 /// Shutdown the video core
-void Shutdown() {
-    Pica::Shutdown();
-
-    g_renderer->ShutDown();
-    g_renderer.reset();
+void Shutdown(std::unique_ptr<RendererBase>& renderer, std::unique_ptr<GPUThread>& gpu_thread) {
+    const auto shutdown = [&] {
+        Pica::Shutdown();
+
+        renderer->ShutDown();
+        renderer.reset();
+    };
+    if (gpu_thread) {
+        gpu_thread->SubmitAndWait(shutdown);
+        gpu_thread.reset();
+    } else {
+        shutdown();
+    }
 
     LOG_DEBUG(Render, "shutdown OK");
 }
 
 void RequestScreenshot(void* data, std::function<void()> callback,
                        const Layout::FramebufferLayout& layout) {
-    if (g_renderer_screenshot_requested) {
-        LOG_ERROR(Render, "A screenshot is already requested or in progress, ignoring the request");
-        return;
-    }
-    g_screenshot_bits = data;
-    g_screenshot_complete_callback = std::move(callback);
-    g_screenshot_framebuffer_layout = layout;
-    g_renderer_screenshot_requested = true;
+    GetRenderer()->RequestScreenshot(data, std::move(callback), layout);
 }
 
 u16 GetResolutionScaleFactor() {
     if (g_hw_renderer_enabled) {
         return Settings::values.resolution_factor
                    ? Settings::values.resolution_factor
-                   : g_renderer->GetRenderWindow().GetFramebufferLayout().GetScalingRatio();
+                   : GetRenderer()->GetRenderWindow().GetFramebufferLayout().GetScalingRatio();
     } else {
         // Software renderer always render at native resolution
         return 1;
@@ -92,7 +130,7 @@ u16 GetResolutionScaleFactor() {
 
 template <class Archive>
 void serialize(Archive& ar, const unsigned int) {
-    ar& Pica::g_state;
+    ar& Pica::GetState();
 }
 
 } // namespace VideoCore
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <atomic>
+#include <functional>
 #include <iostream>
 #include <memory>
 #include "core/frontend/emu_window.h"
@@ -24,7 +25,7 @@ class MemorySystem;
 
 namespace VideoCore {
 
-extern std::unique_ptr<RendererBase> g_renderer; ///< Renderer plugin
+class GPUThread;
 
 // TODO: Wrap these in a user settings struct along with any other graphics settings (often set from
 // qt ui)
@@ -38,25 +39,38 @@ extern std::atomic<bool> g_renderer_bg_color_update_requested;
 extern std::atomic<bool> g_renderer_sampler_update_requested;
 extern std::atomic<bool> g_renderer_shader_update_requested;
 extern std::atomic<bool> g_texture_filter_update_requested;
-// Screenshot
-extern std::atomic<bool> g_renderer_screenshot_requested;
-extern void* g_screenshot_bits;
-extern std::function<void()> g_screenshot_complete_callback;
-extern Layout::FramebufferLayout g_screenshot_framebuffer_layout;
-
-extern Memory::MemorySystem* g_memory;
-
 enum class ResultStatus {
     Success,
     ErrorGenericDrivers,
     ErrorBelowGL33,
 };
 
-/// Initialize the video core
-ResultStatus Init(Frontend::EmuWindow& emu_window, Memory::MemorySystem& memory);
+/// Returns the renderer of the current System instance, or nullptr if it has none
+RendererBase* GetRenderer();
+
+/// Returns the memory of the current System instance
+Memory::MemorySystem& GetMemory();
+
+/// Returns the GPU thread of the current System instance, or nullptr if the GPU runs synchronously
+GPUThread* GetGPUThread();
+
+/**
+ * Runs a call that uses the renderer on the thread that owns it, and waits for it to finish. That
+ * is the GPU thread with asynchronous GPU emulation, and the calling thread otherwise.
+ */
+void RunOnGPUThread(const std::function<void()>& func);
+
+/**
+ * Initialize the video core
+ * @param emu_window Window the renderer presents to
+ * @param renderer Receives the renderer of the System instance being initialized
+ * @param gpu_thread Receives the GPU thread, if asynchronous GPU emulation is enabled
+ */
+ResultStatus Init(Frontend::EmuWindow& emu_window, std::unique_ptr<RendererBase>& renderer,
+                  std::unique_ptr<GPUThread>& gpu_thread);
 
-/// Shutdown the video core
-void Shutdown();
+/// Shutdown the video core and destroy the renderer and the GPU thread
+void Shutdown(std::unique_ptr<RendererBase>& renderer, std::unique_ptr<GPUThread>& gpu_thread);
 
 /// Request a screenshot of the next frame
 void RequestScreenshot(void* data, std::function<void()> callback,